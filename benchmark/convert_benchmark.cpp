@@ -0,0 +1,163 @@
+// Measures the throughput of the PCM to float conversion of Buffer::addData
+// (audiobuffer/buffer.h) for each format, against the scalar division it
+// replaced, and checks that both give the same floats.
+//
+// The samples are added in chunks to a RELEASED buffer, the way
+// BufferStream::addData receives them, and released after each chunk.
+//
+//   convert_benchmark [--quick]
+//
+// --quick runs fewer rounds, to check that the benchmark runs.
+
+#include "enums.h"
+#include "audiobuffer/buffer.h"
+
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+namespace
+{
+    unsigned int seed = 1;
+
+    unsigned int nextRandom()
+    {
+        seed = seed * 1664525u + 1013904223u;
+        return seed;
+    }
+
+    /// The conversion of Buffer::addData before the SIMD kernels.
+    void convertScalar(BufferType format, const void *src, float *dst, size_t count)
+    {
+        switch (format)
+        {
+        case BufferType::PCM_S8:
+            for (size_t i = 0; i < count; i++)
+                dst[i] = reinterpret_cast<const int8_t *>(src)[i] / 128.0f;
+            break;
+        case BufferType::PCM_S16LE:
+            for (size_t i = 0; i < count; i++)
+                dst[i] = reinterpret_cast<const int16_t *>(src)[i] / 32768.0f;
+            break;
+        case BufferType::PCM_S32LE:
+            for (size_t i = 0; i < count; i++)
+                dst[i] = reinterpret_cast<const int32_t *>(src)[i] / 2147483648.0f;
+            break;
+        default:
+            memcpy(dst, src, count * sizeof(float));
+            break;
+        }
+    }
+
+    struct Format
+    {
+        const char *name;
+        BufferType type;
+        size_t bytesPerSample;
+    };
+
+    /// Adds [samples] samples to [buffer] in [chunk] sample chunks and
+    /// releases them. Returns the Msamples/s.
+    double timeAddData(Buffer &buffer, const Format &format, const std::vector<unsigned char> &data, size_t samples,
+                       size_t chunk, unsigned int rounds)
+    {
+        bool allDataAdded;
+        const auto start = std::chrono::steady_clock::now();
+        for (unsigned int r = 0; r < rounds; r++)
+            for (size_t from = 0; from < samples; from += chunk)
+            {
+                buffer.addData(format.type, data.data() + from * format.bytesPerSample, chunk, &allDataAdded);
+                buffer.removeData(chunk * sizeof(float));
+            }
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return (double)samples * rounds / seconds / 1e6;
+    }
+
+    double timeScalar(const Format &format, const std::vector<unsigned char> &data, std::vector<float> &out,
+                      size_t samples, size_t chunk, unsigned int rounds)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        for (unsigned int r = 0; r < rounds; r++)
+            for (size_t from = 0; from < samples; from += chunk)
+                convertScalar(format.type, data.data() + from * format.bytesPerSample, out.data() + from, chunk);
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return (double)samples * rounds / seconds / 1e6;
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    bool quick = false;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--quick") == 0)
+            quick = true;
+        else
+        {
+            printf("usage: %s [--quick]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    const Format formats[] = {
+        {"s8", BufferType::PCM_S8, 1},
+        {"s16le", BufferType::PCM_S16LE, 2},
+        {"s32le", BufferType::PCM_S32LE, 4},
+        {"f32le", BufferType::PCM_F32LE, 4},
+    };
+    // A chunk that stays in the caches, and one that doesn't.
+    const size_t chunks[] = {4096, 1 << 20};
+    const size_t samples = 1 << 22;
+    const unsigned int rounds = quick ? 1 : 20;
+
+    printf("%-6s %8s %14s %14s\n", "format", "chunk", "kernel Ms/s", "scalar Ms/s");
+    int failures = 0;
+    for (const Format &format : formats)
+    {
+        std::vector<unsigned char> data(samples * format.bytesPerSample);
+        for (unsigned char &byte : data)
+            byte = (unsigned char)(nextRandom() >> 24);
+        if (format.type == BufferType::PCM_F32LE)
+        {
+            // Finite floats in [-1, 1).
+            float *f = reinterpret_cast<float *>(data.data());
+            for (size_t i = 0; i < samples; i++)
+                f[i] = (int)(nextRandom() >> 8) / (float)(1 << 23) - 1.f;
+        }
+
+        for (size_t chunk : chunks)
+        {
+            Buffer buffer;
+            buffer.setBufferType(BufferingType::RELEASED);
+            buffer.setSizeInBytes(chunk * 2 * sizeof(float));
+            buffer.grow(chunk * 2);
+
+            // The floats read back must be the ones of the scalar division.
+            std::vector<float> expected(samples), actual(chunk);
+            convertScalar(format.type, data.data(), expected.data(), samples);
+            bool allDataAdded;
+            bool same = true;
+            for (size_t from = 0; from < samples && same; from += chunk)
+            {
+                buffer.addData(format.type, data.data() + from * format.bytesPerSample, chunk, &allDataAdded);
+                buffer.readFrames(actual.data(), 0, chunk, 1, chunk);
+                buffer.removeData(chunk * sizeof(float));
+                same = allDataAdded && memcmp(actual.data(), expected.data() + from, chunk * sizeof(float)) == 0;
+            }
+
+            const double kernel = timeAddData(buffer, format, data, samples, chunk, rounds);
+            const double scalar = timeScalar(format, data, expected, samples, chunk, rounds);
+            printf("%-6s %8zu ", format.name, chunk);
+            if (!same)
+            {
+                printf("%14s\n", "FAILED");
+                failures++;
+            }
+            else
+                printf("%14.0f %14.0f\n", kernel, scalar);
+            fflush(stdout);
+        }
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,223 @@
+// Checks the log2 and exp2 approximations of the dynamics filters, in
+// src/filters/fast_math.h, against libm computed in double precision: the
+// scalar versions, and the SSE or NEON ones 4 at a time.
+
+#include "fast_math.h"
+
+#include <stdio.h>
+#include <math.h>
+#include <vector>
+
+namespace
+{
+    enum Function
+    {
+        LOG2,
+        EXP2,
+        GAIN_TO_DB,
+        DB_TO_GAIN
+    };
+
+    struct Bound
+    {
+        const char *name;
+        Function function;
+        float from;
+        float to;
+        bool logSpaced;
+        bool relative;
+        double maxError;
+    };
+
+    // The bounds documented in fast_math.h.
+    const Bound bounds[] = {
+        {"fastLog2", LOG2, 1e-8f, 1e4f, true, false, 1.1e-6},
+        {"fastExp2", EXP2, -126.f, 126.f, false, true, 3e-7},
+        {"gainToDb", GAIN_TO_DB, 1e-8f, 1e4f, true, false, 2e-5},
+        {"dbToGain", DB_TO_GAIN, -160.f, 80.f, false, true, 1.5e-6},
+    };
+
+    double reference(Function function, double x)
+    {
+        switch (function)
+        {
+        case LOG2:
+            return log2(x);
+        case EXP2:
+            return exp2(x);
+        case GAIN_TO_DB:
+            return 20. * log10(x);
+        default:
+            return pow(10., x / 20.);
+        }
+    }
+
+    float scalar(Function function, float x)
+    {
+        switch (function)
+        {
+        case LOG2:
+            return FastMath::fastLog2(x);
+        case EXP2:
+            return FastMath::fastExp2(x);
+        case GAIN_TO_DB:
+            return FastMath::gainToDb(x);
+        default:
+            return FastMath::dbToGain(x);
+        }
+    }
+
+#if defined(SOLOUD_SSE_INTRINSICS)
+    __m128 vector(Function function, __m128 x)
+    {
+        switch (function)
+        {
+        case LOG2:
+            return FastMath::log2_ps(x);
+        case EXP2:
+            return FastMath::exp2_ps(x);
+        case GAIN_TO_DB:
+            return FastMath::gainToDb_ps(x);
+        default:
+            return FastMath::dbToGain_ps(x);
+        }
+    }
+#elif defined(SOLOUD_NEON_INTRINSICS)
+    float32x4_t vector(Function function, float32x4_t x)
+    {
+        switch (function)
+        {
+        case LOG2:
+            return FastMath::log2_ps(x);
+        case EXP2:
+            return FastMath::exp2_ps(x);
+        case GAIN_TO_DB:
+            return FastMath::gainToDb_ps(x);
+        default:
+            return FastMath::dbToGain_ps(x);
+        }
+    }
+#endif
+
+    const int kPoints = 1 << 20;
+
+    std::vector<float> inputs(const Bound &bound)
+    {
+        std::vector<float> x(kPoints);
+        for (int i = 0; i < kPoints; i++)
+        {
+            const double t = (double)i / (kPoints - 1);
+            x[i] = bound.logSpaced
+                       ? (float)(bound.from * pow((double)bound.to / bound.from, t))
+                       : (float)(bound.from + (bound.to - bound.from) * t);
+        }
+        return x;
+    }
+
+#if defined(SOLOUD_SSE_INTRINSICS) || defined(SOLOUD_NEON_INTRINSICS)
+    std::vector<float> vectorOutputs(Function function, const std::vector<float> &x)
+    {
+        std::vector<float> y(x.size());
+        for (size_t i = 0; i < x.size(); i += 4)
+#if defined(SOLOUD_SSE_INTRINSICS)
+            _mm_storeu_ps(&y[i], vector(function, _mm_loadu_ps(&x[i])));
+#else
+            vst1q_f32(&y[i], vector(function, vld1q_f32(&x[i])));
+#endif
+        return y;
+    }
+#endif
+
+    /// Returns true if all the values of [y] are within the bound.
+    bool check(const Bound &bound, const char *isa, const std::vector<float> &x, const std::vector<float> &y)
+    {
+        double maxError = 0.;
+        float worst = 0.f;
+        for (size_t i = 0; i < x.size(); i++)
+        {
+            const double expected = reference(bound.function, x[i]);
+            double error = fabs(y[i] - expected);
+            if (bound.relative)
+                error /= fabs(expected);
+            if (!(error <= maxError))
+            {
+                maxError = error;
+                worst = x[i];
+            }
+        }
+        const bool ok = maxError < bound.maxError;
+        printf("%-6s %-8s [%g, %g]: max %s error %.3g at %.9g, bound %.3g %s\n",
+               isa, bound.name, bound.from, bound.to, bound.relative ? "relative" : "absolute",
+               maxError, worst, bound.maxError, ok ? "ok" : "FAILED");
+        return ok;
+    }
+
+    /// Returns the number of special values with an unexpected result.
+    int checkSpecialValues()
+    {
+        const float minNormal = 1.17549435e-38f;
+        const struct
+        {
+            const char *name;
+            float value;
+            float expected;
+        } cases[] = {
+            {"fastLog2(0)", FastMath::fastLog2(0.f), -126.f},
+            {"fastLog2(-1)", FastMath::fastLog2(-1.f), -126.f},
+            {"fastLog2(NaN)", FastMath::fastLog2(NAN), -126.f},
+            {"fastLog2(1)", FastMath::fastLog2(1.f), 0.f},
+            {"fastExp2(0)", FastMath::fastExp2(0.f), 1.f},
+            {"fastExp2(-1000)", FastMath::fastExp2(-1000.f), minNormal},
+            {"fastExp2(1000)", FastMath::fastExp2(1000.f), ldexpf(1.f, 126)},
+        };
+        int failures = 0;
+        for (const auto &c : cases)
+        {
+            if (c.value != c.expected)
+            {
+                printf("%s = %.9g, expected %.9g\n", c.name, c.value, c.expected);
+                failures++;
+            }
+        }
+#if defined(SOLOUD_SSE_INTRINSICS) || defined(SOLOUD_NEON_INTRINSICS)
+        const float in[4] = {0.f, -1.f, NAN, 1.f};
+        float out[4];
+#if defined(SOLOUD_SSE_INTRINSICS)
+        _mm_storeu_ps(out, FastMath::log2_ps(_mm_loadu_ps(in)));
+#else
+        vst1q_f32(out, FastMath::log2_ps(vld1q_f32(in)));
+#endif
+        const float expected[4] = {-126.f, -126.f, -126.f, 0.f};
+        for (int i = 0; i < 4; i++)
+        {
+            if (out[i] != expected[i])
+            {
+                printf("log2_ps(%g) = %.9g, expected %.9g\n", in[i], out[i], expected[i]);
+                failures++;
+            }
+        }
+#endif
+        printf("special values: %s\n", failures ? "FAILED" : "ok");
+        return failures;
+    }
+} // namespace
+
+int main()
+{
+    int failures = 0;
+    for (const Bound &bound : bounds)
+    {
+        const std::vector<float> x = inputs(bound);
+        std::vector<float> y(x.size());
+        for (size_t i = 0; i < x.size(); i++)
+            y[i] = scalar(bound.function, x[i]);
+        failures += !check(bound, "scalar", x, y);
+#if defined(SOLOUD_SSE_INTRINSICS)
+        failures += !check(bound, "SSE", x, vectorOutputs(bound.function, x));
+#elif defined(SOLOUD_NEON_INTRINSICS)
+        failures += !check(bound, "NEON", x, vectorOutputs(bound.function, x));
+#endif
+    }
+    failures += checkSpecialValues();
+    return failures == 0 ? 0 : 1;
+}
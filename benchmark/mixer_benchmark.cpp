@@ -0,0 +1,210 @@
+// Renders scripted scenarios with the offline render mode of the player
+// (Player::initOffline and Player::renderOffline) and reports how many times
+// faster than realtime the mixer runs.
+//
+// Each scenario plays N looping voices of a 44.1 kHz stereo sound on a
+// 48 kHz engine, so every voice is resampled, at slightly different speeds:
+//   voices x filters x resampler x buffer size.
+//
+//   mixer_benchmark [--seconds S] [--threads N] [--quick]
+//
+// --threads renders the voices on N mix workers (Soloud::setMixThreadCount),
+// and fails a scenario if its output differs from the one without workers.
+// --quick renders a few short scenarios, to check that the benchmark runs.
+
+#include "player.h"
+
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+namespace
+{
+    const unsigned int kEngineRate = 48000;
+    const unsigned int kSoundRate = 44100;
+    const unsigned int kChannels = 2;
+
+    enum FilterSet
+    {
+        NO_FILTERS,
+        // biquad resonant and freeverb on the output
+        GLOBAL_FILTERS,
+        // biquad resonant and echo on every voice
+        VOICE_FILTERS
+    };
+
+    const char *filterSetNames[] = {"none", "global", "voice"};
+    const char *resamplerNames[] = {"point", "linear", "catmullrom"};
+
+    struct Scenario
+    {
+        unsigned int voices;
+        FilterSet filters;
+        unsigned int resampler;
+        unsigned int bufferSize;
+    };
+
+    void put16(std::vector<unsigned char> &out, unsigned int value)
+    {
+        out.push_back(value & 0xff);
+        out.push_back((value >> 8) & 0xff);
+    }
+
+    void put32(std::vector<unsigned char> &out, unsigned int value)
+    {
+        put16(out, value & 0xffff);
+        put16(out, value >> 16);
+    }
+
+    /// A 2 second 16 bit WAV of two detuned saws with some noise.
+    std::vector<unsigned char> makeWav()
+    {
+        const unsigned int frames = kSoundRate * 2;
+        const unsigned int dataSize = frames * kChannels * 2;
+        std::vector<unsigned char> wav;
+        wav.insert(wav.end(), {'R', 'I', 'F', 'F'});
+        put32(wav, 36 + dataSize);
+        wav.insert(wav.end(), {'W', 'A', 'V', 'E', 'f', 'm', 't', ' '});
+        put32(wav, 16);
+        put16(wav, 1);
+        put16(wav, kChannels);
+        put32(wav, kSoundRate);
+        put32(wav, kSoundRate * kChannels * 2);
+        put16(wav, kChannels * 2);
+        put16(wav, 16);
+        wav.insert(wav.end(), {'d', 'a', 't', 'a'});
+        put32(wav, dataSize);
+        unsigned int seed = 1;
+        for (unsigned int i = 0; i < frames; i++)
+        {
+            for (unsigned int c = 0; c < kChannels; c++)
+            {
+                const double phase = fmod(i * (110.0 + c * 0.7) / kSoundRate, 1.0);
+                seed = seed * 1664525u + 1013904223u;
+                const double noise = (int)(seed >> 8) / (double)(1 << 23) - 1.0;
+                put16(wav, (unsigned int)(short)((phase * 2.0 - 1.0) * 12000.0 + noise * 1000.0) & 0xffff);
+            }
+        }
+        return wav;
+    }
+
+    /// Renders [scenario] to [out] with [threads] mix workers. Returns the
+    /// realtime multiple, or a negative value on error.
+    double run(const Scenario &scenario, const std::vector<unsigned char> &wav, double seconds, unsigned int threads,
+               std::vector<float> &out)
+    {
+        Player player;
+        if (player.initOffline(kEngineRate, scenario.bufferSize, kChannels) != noError)
+            return -1.0;
+        if (player.setMixThreadCount(threads) != noError)
+            return -1.0;
+        player.setMaxActiveVoiceCount(scenario.voices);
+        player.soloud.setMainResampler(scenario.resampler);
+
+        // The player keeps its own copy of the data with LOAD_MODE_MEMORY.
+        std::vector<unsigned char> data(wav);
+        unsigned int hash;
+        if (player.loadMem("benchmark.wav", data.data(), (int)data.size(), LOAD_MODE_MEMORY, hash) != noError)
+            return -1.0;
+
+        if (scenario.filters == GLOBAL_FILTERS)
+        {
+            player.mFilters.addFilter(BiquadResonantFilter);
+            player.mFilters.addFilter(FreeverbFilter);
+        }
+        else if (scenario.filters == VOICE_FILTERS)
+        {
+            player.findByHash(hash)->filters->addFilter(BiquadResonantFilter);
+            player.findByHash(hash)->filters->addFilter(EchoFilter);
+        }
+
+        for (unsigned int i = 0; i < scenario.voices; i++)
+        {
+            unsigned int handle;
+            if (player.play(hash, handle, 1.0f / scenario.voices, 0.0f, false, true) != noError)
+                return -1.0;
+            player.soloud.setRelativePlaySpeed(handle, 0.9f + 0.2f * i / scenario.voices);
+        }
+
+        const unsigned int frames = (unsigned int)(seconds * kEngineRate);
+        out.assign((size_t)frames * kChannels, 0.f);
+        const auto start = std::chrono::steady_clock::now();
+        if (player.renderOffline(out.data(), frames) != noError)
+            return -1.0;
+        const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        player.dispose();
+
+        // Silence means the voices didn't play.
+        double energy = 0.0;
+        for (float sample : out)
+            energy += sample * sample;
+        if (!(energy > 0.0))
+            return -1.0;
+        return seconds / elapsed;
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    double seconds = 10.0;
+    unsigned int threads = 0;
+    bool quick = false;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--quick") == 0)
+            quick = true;
+        else if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc)
+            seconds = atof(argv[++i]);
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+            threads = (unsigned int)atoi(argv[++i]);
+        else
+        {
+            printf("usage: %s [--seconds S] [--threads N] [--quick]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (quick)
+        seconds = 0.5;
+
+    std::vector<unsigned int> voices = {1, 16, 64};
+    std::vector<unsigned int> bufferSizes = {256, 2048};
+    if (quick)
+    {
+        voices = {1, 16};
+        bufferSizes = {512};
+    }
+    std::vector<Scenario> scenarios;
+    for (unsigned int bufferSize : bufferSizes)
+        for (unsigned int resampler = 0; resampler < 3; resampler++)
+            for (int filters = NO_FILTERS; filters <= VOICE_FILTERS; filters++)
+                for (unsigned int count : voices)
+                    scenarios.push_back({count, (FilterSet)filters, resampler, bufferSize});
+
+    const std::vector<unsigned char> wav = makeWav();
+    printf("%.1f s at %u Hz per scenario, %u Hz stereo voices, %u mix workers\n", seconds, kEngineRate, kSoundRate,
+           threads);
+    printf("%6s %-10s %-7s %6s %12s\n", "buffer", "resampler", "filters", "voices", "realtime");
+    int failures = 0;
+    for (const Scenario &scenario : scenarios)
+    {
+        std::vector<float> out, serialOut;
+        double multiple = run(scenario, wav, seconds, threads, out);
+        // The workers must not change the output.
+        if (multiple >= 0.0 && threads > 0 && (run(scenario, wav, seconds, 0, serialOut) < 0.0 || out != serialOut))
+            multiple = -1.0;
+        printf("%6u %-10s %-7s %6u ", scenario.bufferSize, resamplerNames[scenario.resampler],
+               filterSetNames[scenario.filters], scenario.voices);
+        if (multiple < 0.0)
+        {
+            printf("%12s\n", "FAILED");
+            failures++;
+        }
+        else
+            printf("%11.1fx\n", multiple);
+        fflush(stdout);
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,190 @@
+// Compares the pitch shift of src/filters with the implementation it
+// replaced (legacy/smbPitchShift.cpp): the time to shift the same signal in
+// blocks of 512 samples, and how close the current output is to the old one.
+//
+// The signal is two steady tones. The SNR of the current output against the
+// old one is taken from 1 s to 4 s, whatever the length of the signal: the old
+// code sums the phases in floats without wrapping them, so its output drifts
+// away over time, which the SNR would count as an error of the new code.
+// The spectral SNR compares the average magnitude spectra over the whole
+// signal after the first second, which doesn't depend on the phases.
+//
+//   pitch_shift_benchmark [--seconds S] [--quick]
+//
+// Fails if an SNR is below kMinSnrDb. --quick shifts the shortest signal once.
+
+#include "filters/smbPitchShift.h"
+#include "legacy/smbPitchShift.h"
+#include "soloud_fft.h"
+
+#include <chrono>
+#include <math.h>
+#include <memory>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+namespace
+{
+    const float kSampleRate = 44100.f;
+    const long kBlockSize = 512;
+    const double kMinSnrDb = 30.0;
+    const double kSnrFrom = 1.0;
+    const double kSnrTo = 4.0;
+    const unsigned int kSpectrumSize = 4096;
+
+    struct Config
+    {
+        long frameSize;
+        long osamp;
+    };
+
+    // The sizes the filter uses with and without SSE.
+    const Config configs[] = {{4096, 16}, {2048, 8}};
+    const float shifts[] = {0.7f, 1.0f, 1.3f, 1.5f};
+
+    std::vector<float> makeSignal(double seconds)
+    {
+        std::vector<float> signal((size_t)(seconds * kSampleRate));
+        for (size_t i = 0; i < signal.size(); i++)
+            signal[i] = (float)(0.4 * sin(2.0 * M_PI * 440.0 * i / kSampleRate) +
+                                0.2 * sin(2.0 * M_PI * 1234.5 * i / kSampleRate));
+        return signal;
+    }
+
+    double now()
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    /// Shifts [in] to [out] and returns the best time of [repeats] runs, in seconds.
+    double runCurrent(const Config &config, float shift, const std::vector<float> &in, std::vector<float> &out, int repeats)
+    {
+        double best = 1e30;
+        for (int r = 0; r < repeats; r++)
+        {
+            CSmbPitchShift pitchShift(config.frameSize, config.osamp);
+            const double start = now();
+            for (size_t i = 0; i < in.size(); i += kBlockSize)
+            {
+                const long count = (long)(in.size() - i < (size_t)kBlockSize ? in.size() - i : kBlockSize);
+                pitchShift.smbPitchShift(shift, count, &in[i], &out[i]);
+            }
+            const double elapsed = now() - start;
+            best = elapsed < best ? elapsed : best;
+        }
+        return best;
+    }
+
+    double runLegacy(const Config &config, float shift, std::vector<float> &in, std::vector<float> &out, int repeats)
+    {
+        double best = 1e30;
+        for (int r = 0; r < repeats; r++)
+        {
+            // About 400 KB of state.
+            std::unique_ptr<LegacySmbPitchShift> pitchShift(new LegacySmbPitchShift());
+            const double start = now();
+            for (size_t i = 0; i < in.size(); i += kBlockSize)
+            {
+                const long count = (long)(in.size() - i < (size_t)kBlockSize ? in.size() - i : kBlockSize);
+                pitchShift->smbPitchShift(shift, count, config.frameSize, config.osamp, kSampleRate, &in[i], &out[i]);
+            }
+            const double elapsed = now() - start;
+            best = elapsed < best ? elapsed : best;
+        }
+        return best;
+    }
+
+    /// SNR of [actual] against [reference] from kSnrFrom to kSnrTo, in dB.
+    double snrDb(const std::vector<float> &reference, const std::vector<float> &actual)
+    {
+        double signal = 0.0, noise = 0.0;
+        for (size_t i = (size_t)(kSnrFrom * kSampleRate); i < (size_t)(kSnrTo * kSampleRate); i++)
+        {
+            signal += (double)reference[i] * reference[i];
+            noise += ((double)actual[i] - reference[i]) * ((double)actual[i] - reference[i]);
+        }
+        return noise > 0.0 ? 10.0 * log10(signal / noise) : INFINITY;
+    }
+
+    /// The magnitude spectrum of [x] after the first second, averaged over
+    /// Hann windowed frames of kSpectrumSize samples.
+    std::vector<double> spectrum(const std::vector<float> &x)
+    {
+        std::vector<double> average(kSpectrumSize / 2 + 1, 0.0);
+        std::vector<float> frame(kSpectrumSize * 2);
+        for (size_t start = (size_t)kSampleRate; start + kSpectrumSize <= x.size(); start += kSpectrumSize)
+        {
+            for (unsigned int i = 0; i < kSpectrumSize; i++)
+            {
+                frame[i * 2] = x[start + i] * (float)(0.5 - 0.5 * cos(2.0 * M_PI * i / kSpectrumSize));
+                frame[i * 2 + 1] = 0.f;
+            }
+            SoLoud::FFT::fft(frame.data(), kSpectrumSize * 2);
+            for (unsigned int k = 0; k < average.size(); k++)
+                average[k] += hypot(frame[k * 2], frame[k * 2 + 1]);
+        }
+        return average;
+    }
+
+    /// SNR of the average magnitude spectrum of [actual] against the one of [reference], in dB.
+    double spectralSnrDb(const std::vector<float> &reference, const std::vector<float> &actual)
+    {
+        const std::vector<double> expected = spectrum(reference);
+        const std::vector<double> measured = spectrum(actual);
+        double signal = 0.0, noise = 0.0;
+        for (size_t k = 0; k < expected.size(); k++)
+        {
+            signal += expected[k] * expected[k];
+            noise += (measured[k] - expected[k]) * (measured[k] - expected[k]);
+        }
+        return noise > 0.0 ? 10.0 * log10(signal / noise) : INFINITY;
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    double seconds = 10.0;
+    int repeats = 3;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--quick") == 0)
+        {
+            seconds = kSnrTo;
+            repeats = 1;
+        }
+        else if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc)
+            seconds = atof(argv[++i]);
+        else
+        {
+            printf("usage: %s [--seconds S] [--quick]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    if (seconds < kSnrTo)
+        seconds = kSnrTo;
+    std::vector<float> in = makeSignal(seconds);
+    std::vector<float> legacyOut(in.size()), currentOut(in.size());
+    printf("%.1f s at %.0f Hz in blocks of %ld, best of %d runs\n", seconds, kSampleRate, kBlockSize, repeats);
+    printf("%5s %5s %5s %10s %10s %8s %8s %13s\n", "frame", "osamp", "shift", "old ms", "new ms", "speedup", "SNR dB",
+           "spectral dB");
+    int failures = 0;
+    for (const Config &config : configs)
+    {
+        for (float shift : shifts)
+        {
+            const double legacyTime = runLegacy(config, shift, in, legacyOut, repeats);
+            const double currentTime = runCurrent(config, shift, in, currentOut, repeats);
+            const double snr = snrDb(legacyOut, currentOut);
+            const double spectralSnr = spectralSnrDb(legacyOut, currentOut);
+            const bool ok = snr >= kMinSnrDb && spectralSnr >= kMinSnrDb;
+            printf("%5ld %5ld %5.2f %10.1f %10.1f %7.2fx %8.1f %13.1f%s\n", config.frameSize, config.osamp, shift,
+                   legacyTime * 1000.0, currentTime * 1000.0, legacyTime / currentTime, snr, spectralSnr,
+                   ok ? "" : "  FAILED");
+            failures += !ok;
+        }
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,132 @@
+// Checks that the SSE, AVX2 and NEON resampler kernels of soloud_resample.h
+// give the same output as the scalar resamplers, bit for bit.
+//
+// The blocks are resampled the way Soloud::mixBus_internal does: aSrc is the
+// current block of SAMPLE_GRANULARITY samples, aSrc1 the previous one, and
+// the output stops before the position leaves the current block.
+
+#include "soloud_resample.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <vector>
+
+namespace
+{
+    struct Kernel
+    {
+        const char *name;
+        SoLoud::resampleFunction scalar;
+        SoLoud::resampleFunction vector;
+    };
+
+    unsigned int seed = 1;
+
+    float nextSample()
+    {
+        seed = seed * 1664525u + 1013904223u;
+        return (int)(seed >> 8) / (float)(1 << 23) - 1.f;
+    }
+
+    int samplesFor(int srcOffset, int stepFixed)
+    {
+        const int end = SAMPLE_GRANULARITY * FIXPOINT_FRAC_MUL;
+        if (srcOffset >= end)
+            return 0;
+        int count = (end - srcOffset) / stepFixed + 1;
+        if (((count * stepFixed + srcOffset) >> FIXPOINT_FRAC_BITS) >= SAMPLE_GRANULARITY)
+            count--;
+        return count;
+    }
+
+    /// Returns the number of mismatching samples.
+    int check(const Kernel &kernel, const char *isa)
+    {
+        // Source rate / output rate pairs of the mixer, plus odd ratios.
+        const double steps[] = {
+            22050. / 48000., 44100. / 48000., 48000. / 44100., 32000. / 48000.,
+            96000. / 44100., 8000. / 48000., 1., 0.5, 2., 0.3333, 3.7, 7.999};
+        std::vector<float> src(SAMPLE_GRANULARITY), src1(SAMPLE_GRANULARITY);
+        std::vector<float> expected(SAMPLE_GRANULARITY * 8 + 8), actual(SAMPLE_GRANULARITY * 8 + 8);
+        int mismatches = 0;
+        int blocks = 0;
+        for (double step : steps)
+        {
+            const int stepFixed = (int)floor(step * FIXPOINT_FRAC_MUL);
+            for (int run = 0; run < 64; run++)
+            {
+                for (int i = 0; i < SAMPLE_GRANULARITY; i++)
+                {
+                    src[i] = nextSample();
+                    src1[i] = nextSample();
+                }
+                // Offsets at the start of the block, inside the history of
+                // the catmull-rom resampler, and anywhere else.
+                int srcOffset;
+                if (run < 8)
+                    srcOffset = run * (FIXPOINT_FRAC_MUL / 2) + run;
+                else
+                    srcOffset = (int)(seed % (SAMPLE_GRANULARITY * FIXPOINT_FRAC_MUL / 4));
+                nextSample();
+                int count = samplesFor(srcOffset, stepFixed);
+                // Odd lengths leave a scalar tail.
+                if (run & 1)
+                    count -= count > 3 ? 3 : 0;
+
+                for (size_t i = 0; i < expected.size(); i++)
+                    expected[i] = actual[i] = -1000.f;
+                kernel.scalar(src.data(), src1.data(), expected.data(), srcOffset, count, stepFixed);
+                kernel.vector(src.data(), src1.data(), actual.data(), srcOffset, count, stepFixed);
+                blocks++;
+                for (size_t i = 0; i < expected.size(); i++)
+                {
+                    if (memcmp(&expected[i], &actual[i], sizeof(float)) != 0)
+                    {
+                        if (mismatches < 10)
+                            printf("  %s %s: step %.5f offset %d sample %zu: %.9g != %.9g\n",
+                                   isa, kernel.name, step, srcOffset, i, expected[i], actual[i]);
+                        mismatches++;
+                    }
+                }
+            }
+        }
+        printf("%-5s %-10s %4d blocks, %s\n", isa, kernel.name, blocks, mismatches ? "MISMATCH" : "bit-exact");
+        return mismatches;
+    }
+} // namespace
+
+int main()
+{
+    int failures = 0;
+#if defined(SOLOUD_SSE_INTRINSICS)
+    const Kernel sse[] = {
+        {"point", SoLoud::resample_point, SoLoud::resample_point_sse},
+        {"linear", SoLoud::resample_linear, SoLoud::resample_linear_sse},
+        {"catmullrom", SoLoud::resample_catmullrom, SoLoud::resample_catmullrom_sse}};
+    for (const Kernel &kernel : sse)
+        failures += check(kernel, "SSE") != 0;
+
+    const Kernel avx2[] = {
+        {"point", SoLoud::resample_point, SoLoud::resample_point_avx2},
+        {"linear", SoLoud::resample_linear, SoLoud::resample_linear_avx2},
+        {"catmullrom", SoLoud::resample_catmullrom, SoLoud::resample_catmullrom_avx2}};
+    if (SoLoud::cpuHasAvx2())
+    {
+        for (const Kernel &kernel : avx2)
+            failures += check(kernel, "AVX2") != 0;
+    }
+    else
+        printf("AVX2  skipped, not supported by this CPU\n");
+#elif defined(SOLOUD_NEON_INTRINSICS)
+    const Kernel neon[] = {
+        {"point", SoLoud::resample_point, SoLoud::resample_point_neon},
+        {"linear", SoLoud::resample_linear, SoLoud::resample_linear_neon},
+        {"catmullrom", SoLoud::resample_catmullrom, SoLoud::resample_catmullrom_neon}};
+    for (const Kernel &kernel : neon)
+        failures += check(kernel, "NEON") != 0;
+#else
+    printf("No vector resamplers in this build\n");
+#endif
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,125 @@
+// Times the sound lookups of the player (Player::findByHash) and the
+// disposal of sounds (Player::disposeSound) with 10 to 10000 sounds loaded.
+// Both go through the hash index, so their cost should not grow with the
+// number of sounds.
+//
+//   sound_lookup_benchmark [--quick]
+//
+// Fails if a lookup returns the wrong sound after some sounds have been
+// disposed. --quick runs fewer rounds, to check that the benchmark runs.
+
+#include "player.h"
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+namespace
+{
+    /// Loads [count] waveforms in [player] and returns their hashes.
+    bool loadSounds(Player &player, unsigned int count, std::vector<unsigned int> &hashes)
+    {
+        hashes.clear();
+        for (unsigned int i = 0; i < count; i++)
+        {
+            unsigned int hash;
+            if (player.loadWaveform(i % 4, false, 0.25f, 1.0f, hash) != noError)
+                return false;
+            hashes.push_back(hash);
+        }
+        return true;
+    }
+
+    /// Every hash of [hashes] must find its sound.
+    bool checkLookups(Player &player, const std::vector<unsigned int> &hashes)
+    {
+        for (unsigned int hash : hashes)
+        {
+            ActiveSound *sound = player.findByHash(hash);
+            if (sound == nullptr || sound->soundHash != hash)
+                return false;
+        }
+        return player.getSoundsCount() == (int)hashes.size();
+    }
+
+    /// Returns the ns per lookup and per dispose in [lookupNs] and
+    /// [disposeNs], or false if a check failed.
+    bool run(unsigned int count, unsigned int rounds, double &lookupNs, double &disposeNs)
+    {
+        Player player;
+        if (player.initOffline(48000, 512, 2) != noError)
+            return false;
+
+        std::vector<unsigned int> hashes;
+        if (!loadSounds(player, count, hashes))
+            return false;
+        if (!checkLookups(player, hashes))
+            return false;
+
+        std::mt19937 rng(count);
+        std::vector<unsigned int> order(hashes);
+        std::shuffle(order.begin(), order.end(), rng);
+        unsigned int found = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (unsigned int r = 0; r < rounds; r++)
+            for (unsigned int hash : order)
+                found += player.findByHash(hash) != nullptr;
+        lookupNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() /
+                   ((double)rounds * count);
+        if (found != rounds * count)
+            return false;
+
+        // Dispose half of the sounds in random order, then check that the
+        // others are still found and the disposed ones are not.
+        const unsigned int disposed = count / 2;
+        start = std::chrono::steady_clock::now();
+        for (unsigned int i = 0; i < disposed; i++)
+            player.disposeSound(order[i]);
+        disposeNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() /
+                    disposed;
+        for (unsigned int i = 0; i < disposed; i++)
+            if (player.findByHash(order[i]) != nullptr)
+                return false;
+        order.erase(order.begin(), order.begin() + disposed);
+        const bool ok = checkLookups(player, order);
+        player.dispose();
+        return ok;
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    bool quick = false;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--quick") == 0)
+            quick = true;
+        else
+        {
+            printf("usage: %s [--quick]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    // About the same number of lookups for every count.
+    const unsigned int lookups = quick ? 100000 : 2000000;
+    printf("%6s %14s %14s\n", "sounds", "lookup ns", "dispose ns");
+    int failures = 0;
+    for (unsigned int count : {10u, 100u, 1000u, 10000u})
+    {
+        double lookupNs = 0.0, disposeNs = 0.0;
+        printf("%6u ", count);
+        if (!run(count, std::max(1u, lookups / count), lookupNs, disposeNs))
+        {
+            printf("%14s\n", "FAILED");
+            failures++;
+        }
+        else
+            printf("%14.1f %14.1f\n", lookupNs, disposeNs);
+        fflush(stdout);
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -6,6 +6,7 @@ export 'src/bindings/audio_data.dart';
 export 'src/enums.dart' hide PlayerErrors, PlayerStateNotification;
 export 'src/exceptions/exceptions.dart';
 export 'src/filters/filters.dart' show FilterType;
+export 'src/helpers/perf_snapshot.dart';
 export 'src/helpers/playback_device.dart';
 export 'src/metadata.dart';
 export 'src/soloud.dart';
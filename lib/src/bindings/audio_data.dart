@@ -26,6 +26,14 @@ enum GetSamplesKind {
   /// [linear] rows. Each time the [AudioData.updateSamples] method is called,
   /// the last row is discarded and the new one will be the first.
   texture,
+
+  /// Get data in a 2D way like [texture], but the rows are never moved.
+  /// Each time the [AudioData.updateSamples] method is called, the new row
+  /// overwrites the oldest one and [AudioData.textureRingHead] becomes its
+  /// index. Row `(textureRingHead + i) % 256` is the one acquired `i` updates
+  /// ago, so a shader can scroll the rows by offsetting its coordinates.
+  /// This avoids copying the whole matrix on every update.
+  textureRing,
 }
 
 /// Class to manage audio samples.
@@ -108,6 +116,8 @@ class AudioData {
         _updateCallback = ctrl.textureCallback;
       case GetSamplesKind.texture:
         _updateCallback = ctrl.texture2DCallback;
+      case GetSamplesKind.textureRing:
+        _updateCallback = ctrl.texture2DRingCallback;
     }
   }
 
@@ -121,6 +131,9 @@ class AudioData {
   /// The current type of data to acquire.
   GetSamplesKind get getSamplesKind => _getSamplesKind;
 
+  /// The index of the newest row when using [GetSamplesKind.textureRing].
+  int get textureRingHead => ctrl.textureRingHead;
+
   /// The callback used to get new audio samples.
   /// This callback is used in [updateSamples] to avoid to
   /// do [GetSamplesKind] checks on every calls.
@@ -186,6 +199,7 @@ class AudioData {
       case GetSamplesKind.linear:
         return ctrl.getFftAndWave(alwaysReturnData: alwaysReturnData);
       case GetSamplesKind.texture:
+      case GetSamplesKind.textureRing:
         return ctrl.get2DTexture(alwaysReturnData: alwaysReturnData);
     }
   }
@@ -12,6 +12,10 @@ class AudioDataCtrl {
   final int _samplesPtr = 0;
   int get samplesPtr => _samplesPtr;
 
+  /// To reflect [AudioDataCtrl] for web. Not used with `dart:ffi`
+  final int _ringHeadPtr = 0;
+  int get ringHeadPtr => _ringHeadPtr;
+
   /// Where the FFT or wave data is stored.
   late Pointer<Pointer<Float>> samplesWave;
 
@@ -21,6 +25,9 @@ class AudioDataCtrl {
   /// Where the audio 1D data is stored.
   late Pointer<Pointer<Float>> samples1D;
 
+  /// Where the index of the newest row of the 2D ring is stored.
+  late Pointer<Int32> ringHead;
+
   final bool Function(AudioData) waveCallback =
       SoLoudController().soLoudFFI.getWave;
 
@@ -30,6 +37,9 @@ class AudioDataCtrl {
   final bool Function(AudioData) texture2DCallback =
       SoLoudController().soLoudFFI.getAudioTexture2D;
 
+  final bool Function(AudioData) texture2DRingCallback =
+      SoLoudController().soLoudFFI.getAudioTexture2DRing;
+
   late bool dataIsTheSameAsBefore;
 
   void allocSamples(AudioData audioData) {
@@ -37,6 +47,7 @@ class AudioDataCtrl {
     samples2D = calloc();
     samples1D = calloc();
     samplesWave = calloc();
+    ringHead = calloc();
   }
 
   void dispose(
@@ -45,11 +56,15 @@ class AudioDataCtrl {
     if (samplesWave != nullptr) calloc.free(samplesWave);
     if (samples1D != nullptr) calloc.free(samples1D);
     if (samples2D != nullptr) calloc.free(samples2D);
+    if (ringHead != nullptr) calloc.free(ringHead);
     samplesWave = nullptr;
     samples1D = nullptr;
     samples2D = nullptr;
+    ringHead = nullptr;
   }
 
+  int get textureRingHead => ringHead == nullptr ? 0 : ringHead.value;
+
   Float32List getWave({bool alwaysReturnData = true}) {
     final wavePtr = samplesWave.value;
     if (!alwaysReturnData && dataIsTheSameAsBefore || wavePtr == nullptr) {
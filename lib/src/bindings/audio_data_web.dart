@@ -13,6 +13,9 @@ class AudioDataCtrl {
 
   int _samplePtrPtr = 0;
 
+  int _ringHeadPtr = 0;
+  int get ringHeadPtr => _ringHeadPtr;
+
   final bool Function(AudioData) waveCallback =
       SoLoudController().soLoudFFI.getWave;
 
@@ -22,6 +25,9 @@ class AudioDataCtrl {
   final bool Function(AudioData) texture2DCallback =
       SoLoudController().soLoudFFI.getAudioTexture2D;
 
+  final bool Function(AudioData) texture2DRingCallback =
+      SoLoudController().soLoudFFI.getAudioTexture2DRing;
+
   late bool dataIsTheSameAsBefore;
 
   void allocSamples(AudioData audioData) {
@@ -31,6 +37,7 @@ class AudioDataCtrl {
     /// is needed when acquiring data with [get2DTexture] which is a matrix of
     /// 256 rows and 512 columns of floats (4 bytes each).
     _samplesPtr = wasmMalloc(512 * 256 * 4);
+    _ringHeadPtr = wasmMalloc(4);
 
     /// Initialize the pointer to the pointer of the samples. This can be done
     /// only after calling once the get* method.
@@ -41,6 +48,8 @@ class AudioDataCtrl {
         SoLoudController().soLoudFFI.getAudioTexture(audioData);
       case GetSamplesKind.texture:
         SoLoudController().soLoudFFI.getAudioTexture2D(audioData);
+      case GetSamplesKind.textureRing:
+        SoLoudController().soLoudFFI.getAudioTexture2DRing(audioData);
     }
     _samplePtrPtr = wasmGetI32Value(_samplesPtr, '*');
   }
@@ -51,8 +60,15 @@ class AudioDataCtrl {
     if (_samplesPtr != 0) {
       wasmFree(_samplesPtr);
     }
+    if (_ringHeadPtr != 0) {
+      wasmFree(_ringHeadPtr);
+      _ringHeadPtr = 0;
+    }
   }
 
+  int get textureRingHead =>
+      _ringHeadPtr == 0 ? 0 : wasmGetI32Value(_ringHeadPtr, 'i32');
+
   Float32List getWave({bool alwaysReturnData = true}) {
     if (!alwaysReturnData && dataIsTheSameAsBefore || _samplesPtr == 0) {
       return Float32List(0);
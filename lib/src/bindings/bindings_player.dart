@@ -6,6 +6,7 @@ import 'dart:typed_data';
 import 'package:flutter_soloud/src/bindings/audio_data.dart';
 import 'package:flutter_soloud/src/enums.dart';
 import 'package:flutter_soloud/src/filters/filters.dart';
+import 'package:flutter_soloud/src/helpers/perf_snapshot.dart';
 import 'package:flutter_soloud/src/helpers/playback_device.dart';
 import 'package:flutter_soloud/src/sound_handle.dart';
 import 'package:flutter_soloud/src/sound_hash.dart';
@@ -33,6 +34,16 @@ abstract class FlutterSoLoud {
   /// Listener for voices ended.
   Stream<int> get voiceEndedEvents => voiceEndedEventController.stream;
 
+  /// Controller to listen to the events telling that some voice ended
+  /// events have been lost, and that the voice handles must be checked.
+  /// Not used on the web.
+  late final StreamController<void> voicesResyncEventController =
+      StreamController.broadcast();
+
+  /// Listener for the lost voice ended events.
+  /// Not used on the web.
+  Stream<void> get voicesResyncEvents => voicesResyncEventController.stream;
+
   /// Controller to listen to file loaded events.
   /// Not used on the web.
   late final StreamController<Map<String, dynamic>> fileLoadedEventsController =
@@ -84,6 +95,32 @@ abstract class FlutterSoLoud {
     Channels channels,
   );
 
+  /// Initialize the player without an audio device. The audio is mixed only
+  /// by [renderOffline] and [renderOfflineToWav].
+  ///
+  /// [sampleRate] the sample rate of the rendered audio.
+  /// [bufferSize] the number of frames mixed at once.
+  /// [channels] mono, stereo, quad, 5.1, 7.1.
+  @mustBeOverridden
+  PlayerErrors initEngineOffline(
+    int sampleRate,
+    int bufferSize,
+    Channels channels,
+  );
+
+  /// Mix the next [frames] frames of audio of an offline engine.
+  ///
+  /// [buffer] receives [frames] * channels interleaved samples.
+  @mustBeOverridden
+  PlayerErrors renderOffline(Float32List buffer, int frames);
+
+  /// Mix the next [frames] frames of audio of an offline engine into a
+  /// 32 bit float WAV file.
+  ///
+  /// [path] the file to create or overwrite.
+  @mustBeOverridden
+  PlayerErrors renderOfflineToWav(String path, int frames);
+
   /// Change the playback device.
   ///
   /// [deviceId] the device ID. -1 for default OS output device.
@@ -106,7 +143,7 @@ abstract class FlutterSoLoud {
   /// Load a new sound to be played once or multiple times later.
   /// This is not supported on the web, use [loadMem] instead.
   ///
-  /// After loading the file, the "_fileLoadedCallback" will call the
+  /// After loading the file, a file loaded event is queued and read by the
   /// Dart function defined with "_setDartEventCallback" which gives back
   /// the error and the new hash.
   ///
@@ -116,7 +153,7 @@ abstract class FlutterSoLoud {
   /// when seeking/starting a sound (less CPU, more memory allocated).
   /// If `LoadMode.disk` is used, the audio data is loaded
   /// from the given file when needed (more CPU, less memory allocated).
-  /// See the [seek] note problem when using [LoadMode] = `LoadMode.disk`.
+  /// See the [seek] note about MP3s when using [LoadMode] = `LoadMode.disk`.
   /// `soundHash` return hash of the sound.
   @mustBeOverridden
   void loadFile(
@@ -316,6 +353,8 @@ abstract class FlutterSoLoud {
   /// the start of the stream. The loop start point can be set with this
   /// parameter, and current loop point can be queried with `getLoopingPoint()`
   /// and changed by `setLoopingPoint()`.
+  /// [bus] the handle of a bus created with [createBus] to play the sound
+  /// through. If null the sound is played directly.
   /// Return the error if any and a new `newHandle` of this sound.
   @mustBeOverridden
   ({PlayerErrors error, SoundHandle newHandle}) play(
@@ -325,6 +364,7 @@ abstract class FlutterSoLoud {
     bool paused = false,
     bool looping = false,
     Duration loopingStartAt = Duration.zero,
+    SoundHandle? bus,
   });
 
   /// Stop already loaded sound identified by [handle] and clear it.
@@ -417,6 +457,20 @@ abstract class FlutterSoLoud {
   @mustBeOverridden
   void setFftSmoothing(double smooth);
 
+  /// Set the number of points of the FFT used by [getAudioTexture] and
+  /// [getAudioTexture2D]. This many of the latest output samples are
+  /// analyzed and the resulting bins are reduced to 256 FFT values.
+  ///
+  /// [fftSize] must be a power of two between 256 and 8192. Default is 512.
+  @mustBeOverridden
+  PlayerErrors setFftSize(int fftSize);
+
+  /// Set the windowing algorithm applied to the wave data before the FFT.
+  ///
+  /// [window] the windowing algorithm. Default is [FftWindow.blackman].
+  @mustBeOverridden
+  PlayerErrors setFftWindow(FftWindow window);
+
   /// Return in [samples] a 512 float array.
   /// The first 256 floats represent the FFT frequencies data [>=0.0].
   /// The other 256 floats represent the wave data (amplitude) [-1.0~1.0].
@@ -438,6 +492,16 @@ abstract class FlutterSoLoud {
   @mustBeOverridden
   bool getAudioTexture2D(AudioData samples);
 
+  /// Return a floats matrix of 256x512 used as a ring of rows.
+  /// Every row are composed of 256 FFT values plus 256 of wave data.
+  /// Every time is called, a new row overwrites the oldest one and
+  /// becomes the head. Row `(head + i) % 256` is `i` rows old.
+  ///
+  /// [samples] on all platforms web excluded, the [samples] type is
+  /// `Pointer<Pointer<Float>>`. The head index is stored in its controller.
+  @mustBeOverridden
+  bool getAudioTexture2DRing(AudioData samples);
+
   /// Get the value in the texture2D matrix at the given coordinates.
   @mustBeOverridden
   double getTextureValue(int row, int column);
@@ -455,16 +519,9 @@ abstract class FlutterSoLoud {
   /// [handle] the sound handle.
   /// Returns [PlayerErrors.noError] if success.
   ///
-  /// NOTE: when seeking an MP3 file loaded using `mode`=`LoadMode.disk` the
-  /// seek operation is performed but there will be delays. This occurs because
-  /// the MP3 codec must compute each frame length to gain a new position.
-  /// The problem is explained in souloud_wavstream.cpp
-  /// in `WavStreamInstance::seek` function.
-  ///
-  /// This mode is useful ie for background music, not for a music player
-  /// where a seek slider for MP3s is a must.
-  /// If you need to seek MP3s without lags, please, use
-  /// `mode`=`LoadMode.memory` instead or other supported audio formats!
+  /// NOTE: MP3 files loaded using `mode`=`LoadMode.disk` are indexed when
+  /// loaded, so seeking only decodes a few frames from the closest index
+  /// point. See `WavStream::buildMp3SeekTable` in souloud_wavstream.cpp.
   @mustBeOverridden
   int seek(SoundHandle handle, Duration time);
 
@@ -536,7 +593,8 @@ abstract class FlutterSoLoud {
   int getActiveVoiceCount();
 
   /// Returns the number of concurrent sounds that are playing a
-  /// specific audio source.
+  /// specific audio source, or -1 if the audio source is shared with other
+  /// sounds by the content deduplication.
   @mustBeOverridden
   int countAudioSource(SoundHash soundHash);
 
@@ -593,6 +651,70 @@ abstract class FlutterSoLoud {
   @mustBeOverridden
   void setMaxActiveVoiceCount(int maxVoiceCount);
 
+  /// Set the number of worker threads that render the voices along with
+  /// the audio thread. 0 renders all the voices on the audio thread.
+  ///
+  /// [threadCount] the number of workers, up to 64.
+  @mustBeOverridden
+  PlayerErrors setMixThreadCount(int threadCount);
+
+  /// Decode a sound loaded with [LoadMode.disk] ahead of its voices on a
+  /// background thread. Only the voices started after this call are
+  /// prefetched.
+  ///
+  /// [soundHash] the hash of the sound.
+  /// [milliseconds] how much audio is kept decoded for each voice. 0 decodes
+  /// on the audio thread.
+  @mustBeOverridden
+  PlayerErrors setPrefetch(SoundHash soundHash, int milliseconds);
+
+  /// Get the number of times a prefetched voice played silence because its
+  /// audio was not decoded in time.
+  @mustBeOverridden
+  int getPrefetchUnderrunCount();
+
+  /// Share the audio data of the sounds loaded from the same bytes under
+  /// different names, instead of decoding them again.
+  ///
+  /// [enabled] whether to enable or disable.
+  @mustBeOverridden
+  void setContentDeduplicationEnabled(bool enabled);
+
+  /// Return true if the sounds are deduplicated by content.
+  @mustBeOverridden
+  bool getContentDeduplicationEnabled();
+
+  /// Enable or disable the timing of the audio callback, of the resampling
+  /// and of the filters.
+  ///
+  /// [enabled] whether to enable or disable.
+  @mustBeOverridden
+  void setPerfCountersEnabled(bool enabled);
+
+  /// Read the performance counters of the mixing.
+  ///
+  /// Returns null if the engine is not initialized or on the web.
+  @mustBeOverridden
+  PerfSnapshot? getPerfSnapshot();
+
+  /// Zero the performance counters.
+  @mustBeOverridden
+  void resetPerfCounters();
+
+  /////////////////////////////////////////
+  /// buses
+  /////////////////////////////////////////
+
+  /// Create a bus and start it. The sounds played on it are mixed together
+  /// and go through the filters of the bus once, instead of each voice
+  /// running its own filters.
+  ///
+  /// Return the error if any, the `soundHash` of the bus to add filters to
+  /// it, and the `handle` of the bus to play sounds on it and to set its
+  /// volume and filter parameters.
+  @mustBeOverridden
+  ({PlayerErrors error, SoundHash soundHash, SoundHandle handle}) createBus();
+
   /////////////////////////////////////////
   /// voice groups
   /////////////////////////////////////////
@@ -822,6 +944,8 @@ abstract class FlutterSoLoud {
   /// the start of the stream. The loop start point can be set with this
   /// parameter, and current loop point can be queried with `getLoopingPoint()`
   /// and changed by `setLoopingPoint()`.
+  /// [bus] the handle of a bus created with [createBus] to play the sound
+  /// through. If null the sound is played directly.
   /// Returns the handle of the sound, 0 if error.
   @mustBeOverridden
   ({PlayerErrors error, SoundHandle newHandle}) play3d(
@@ -836,6 +960,7 @@ abstract class FlutterSoLoud {
     bool paused = false,
     bool looping = false,
     Duration loopingStartAt = Duration.zero,
+    SoundHandle? bus,
   });
 
   /// Since SoLoud has no knowledge of the scale of your coordinates,
@@ -960,6 +1085,9 @@ abstract class FlutterSoLoud {
     double startTime = 0,
     double endTime = -1,
     bool average = false,
+    int threads = 1,
+    String? cacheDir,
+    bool buildCache = false,
   });
 
   /// See SoLoud.readSamplesFromMem for details.
@@ -970,6 +1098,9 @@ abstract class FlutterSoLoud {
     double startTime = 0,
     double endTime = -1,
     bool average = false,
+    int threads = 1,
+    String? cacheDir,
+    bool buildCache = false,
   });
 }
 
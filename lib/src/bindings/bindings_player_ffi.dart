@@ -11,47 +11,22 @@ import 'package:ffi/ffi.dart';
 import 'package:flutter_soloud/src/bindings/audio_data.dart';
 import 'package:flutter_soloud/src/bindings/bindings_player.dart';
 import 'package:flutter_soloud/src/bindings/native_metadata_ffi.dart';
+import 'package:flutter_soloud/src/bindings/perf_snapshot_ffi.dart';
+import 'package:flutter_soloud/src/bindings/player_events_ffi.dart';
 import 'package:flutter_soloud/src/enums.dart';
 import 'package:flutter_soloud/src/exceptions/exceptions.dart';
 import 'package:flutter_soloud/src/filters/filters.dart';
+import 'package:flutter_soloud/src/helpers/perf_snapshot.dart';
 import 'package:flutter_soloud/src/helpers/playback_device.dart';
 import 'package:flutter_soloud/src/sound_handle.dart';
 import 'package:flutter_soloud/src/sound_hash.dart';
 import 'package:logging/logging.dart';
 import 'package:meta/meta.dart';
 
-typedef DartVoiceEndedCallbackT
-    = ffi.Pointer<ffi.NativeFunction<DartVoiceEndedCallbackTFunction>>;
+typedef DartEventsReadyCallbackT
+    = ffi.Pointer<ffi.NativeFunction<DartEventsReadyCallbackTFunction>>;
 
-typedef DartVoiceEndedCallbackTFunction = ffi.Void Function(
-    ffi.Pointer<ffi.UnsignedInt>);
-
-typedef DartdartVoiceEndedCallbackTFunction = void Function(
-    ffi.Pointer<ffi.UnsignedInt>);
-
-typedef DartFileLoadedCallbackT
-    = ffi.Pointer<ffi.NativeFunction<DartFileLoadedCallbackTFunction>>;
-
-typedef DartFileLoadedCallbackTFunction = ffi.Void Function(
-    ffi.Pointer<ffi.Int32>,
-    ffi.Pointer<ffi.Char>,
-    ffi.Pointer<ffi.UnsignedInt>,
-    ffi.Pointer<ffi.Uint64>);
-
-typedef DartdartFileLoadedCallbackTFunction = void Function(
-    ffi.Pointer<ffi.Int32>,
-    ffi.Pointer<ffi.Char>,
-    ffi.Pointer<ffi.UnsignedInt>,
-    ffi.Pointer<ffi.Uint64>);
-
-typedef DartStateChangedCallbackT
-    = ffi.Pointer<ffi.NativeFunction<DartStateChangedCallbackTFunction>>;
-
-typedef DartStateChangedCallbackTFunction = ffi.Void Function(
-    ffi.Pointer<ffi.Int32>);
-
-typedef DartdartStateChangedCallbackTFunction = void Function(
-    ffi.Pointer<ffi.Int32>);
+typedef DartEventsReadyCallbackTFunction = ffi.Void Function();
 
 typedef OnMetadataCallbackTFunction = void Function(NativeAudioMetadata);
 
@@ -79,80 +54,95 @@ class FlutterSoLoudFfi extends FlutterSoLoud {
   // Callbacks impl
   // ////////////////////////////////////////////////
 
-  void _voiceEndedCallback(ffi.Pointer<ffi.UnsignedInt> handle) {
-    _log.finest(() => 'VOICE ENDED EVENT handle: ${handle.value}');
-    voiceEndedEventController.add(handle.value);
+  /// How many events are read with each `drainEvents` call.
+  static const int _eventsBufferSize = 256;
+
+  /// The buffer filled by `drainEvents`, allocated once.
+  late final ffi.Pointer<NativePlayerEvent> _eventsBuffer =
+      calloc<NativePlayerEvent>(_eventsBufferSize);
+
+  /// Called once when new events are queued on cpp, however many they are.
+  /// All the queued events are read in batches.
+  void _eventsReadyCallback() {
+    int count;
+    do {
+      count = _drainEvents(_eventsBuffer, _eventsBufferSize);
+      for (var i = 0; i < count; i++) {
+        final event = (_eventsBuffer + i).ref;
+        switch (NativePlayerEventType.fromValue(event.type)) {
+          case NativePlayerEventType.EVENT_VOICE_ENDED:
+            _voiceEndedEvent(event);
+          case NativePlayerEventType.EVENT_FILE_LOADED:
+            _fileLoadedEvent(event);
+          case NativePlayerEventType.EVENT_STATE_CHANGED:
+            _stateChangedEvent(event);
+          case NativePlayerEventType.EVENT_VOICES_RESYNC:
+            _voicesResyncEvent();
+        }
+      }
+    } while (count == _eventsBufferSize);
+  }
+
+  void _voiceEndedEvent(NativePlayerEvent event) {
+    _log.finest(() => 'VOICE ENDED EVENT handle: ${event.value}');
+    voiceEndedEventController.add(event.value);
+  }
+
+  void _voicesResyncEvent() {
+    _log.warning(() => 'VOICES RESYNC EVENT: some events were not read in '
+        'time and have been dropped');
+    voicesResyncEventController.add(null);
+  }
+
+  void _fileLoadedEvent(NativePlayerEvent event) {
+    final completeFileName =
+        event.completeFileName.cast<Utf8>().toDartString();
     // Must free a pointer made on cpp. On Windows this must be freed
     // there and cannot use `calloc.free(...)`
-    nativeFree(handle.cast<ffi.Void>());
-  }
-
-  ///
-  void _fileLoadedCallback(
-    ffi.Pointer<ffi.Int32> error,
-    ffi.Pointer<ffi.Char> completeFileName,
-    ffi.Pointer<ffi.UnsignedInt> hash,
-    ffi.Pointer<ffi.Uint64> timeStamp,
-  ) {
+    nativeFree(event.completeFileName.cast<ffi.Void>());
     _log.finest(() =>
-        'FILE LOADED EVENT error: ${PlayerErrors.values[error.value].name}  '
-        'hash: ${hash.value}  '
-        'file: ${completeFileName.cast<Utf8>().toDartString()}  '
-        'timeStamp: ${timeStamp.value}');
+        'FILE LOADED EVENT error: ${PlayerErrors.values[event.error].name}  '
+        'hash: ${event.value}  '
+        'file: $completeFileName  '
+        'timeStamp: ${event.timeStamp}');
     final result = <String, dynamic>{
-      'error': error.value,
-      'completeFileName': completeFileName.cast<Utf8>().toDartString(),
-      'hash': hash.value,
-      'timeStamp': timeStamp.value,
+      'error': event.error,
+      'completeFileName': completeFileName,
+      'hash': event.value,
+      'timeStamp': event.timeStamp,
     };
     fileLoadedEventsController.add(result);
-    // Must free a pointer made on cpp. On Windows this must be freed
-    // there and cannot use `calloc.free(...)`
-    nativeFree(error.cast<ffi.Void>());
-    nativeFree(completeFileName.cast<ffi.Void>());
-    nativeFree(hash.cast<ffi.Void>());
-    nativeFree(timeStamp.cast<ffi.Void>());
   }
 
-  void _stateChangedCallback(ffi.Pointer<ffi.Int32> state) {
-    final s = PlayerStateNotification.values[state.value];
-    // Must free a pointer made on cpp. On Windows this must be freed
-    // there and cannot use `calloc.free(state)`
-    nativeFree(state.cast<ffi.Void>());
+  void _stateChangedEvent(NativePlayerEvent event) {
+    final s = PlayerStateNotification.values[event.value];
     _log.finest(() => 'STATE CHANGED EVENT state: $s');
     stateChangedController.add(s);
   }
 
   @override
   Future<void> setDartEventCallbacks() async {
-    // Create a NativeCallable for the Dart functions
-    final nativeVoiceEndedCallable =
-        ffi.NativeCallable<DartVoiceEndedCallbackTFunction>.listener(
-      _voiceEndedCallback,
-    );
-    final nativeFileLoadedCallable =
-        ffi.NativeCallable<DartFileLoadedCallbackTFunction>.listener(
-      _fileLoadedCallback,
-    );
-    final nativeStateChangedCallable =
-        ffi.NativeCallable<DartStateChangedCallbackTFunction>.listener(
-      _stateChangedCallback,
+    // Create a NativeCallable for the Dart function
+    final nativeEventsReadyCallable =
+        ffi.NativeCallable<DartEventsReadyCallbackTFunction>.listener(
+      _eventsReadyCallback,
     );
 
-    _setDartEventCallback(
-      nativeVoiceEndedCallable.nativeFunction,
-      nativeFileLoadedCallable.nativeFunction,
-      nativeStateChangedCallable.nativeFunction,
-    );
+    _setDartEventCallback(nativeEventsReadyCallable.nativeFunction);
   }
 
   late final _setDartEventCallbackPtr = _lookup<
+          ffi.NativeFunction<ffi.Void Function(DartEventsReadyCallbackT)>>(
+      'setDartEventCallback');
+  late final _setDartEventCallback = _setDartEventCallbackPtr
+      .asFunction<void Function(DartEventsReadyCallbackT)>();
+
+  late final _drainEventsPtr = _lookup<
       ffi.NativeFunction<
-          ffi.Void Function(DartVoiceEndedCallbackT, DartFileLoadedCallbackT,
-              DartStateChangedCallbackT)>>('setDartEventCallback');
-  late final _setDartEventCallback = _setDartEventCallbackPtr.asFunction<
-      void Function(DartVoiceEndedCallbackT, DartFileLoadedCallbackT,
-          DartStateChangedCallbackT)>();
+          ffi.UnsignedInt Function(ffi.Pointer<NativePlayerEvent>,
+              ffi.UnsignedInt)>>('drainEvents');
+  late final _drainEvents = _drainEventsPtr
+      .asFunction<int Function(ffi.Pointer<NativePlayerEvent>, int)>();
 
   // ////////////////////////////////////////////////
   // Navtive bindings
@@ -208,6 +198,56 @@ class FlutterSoLoudFfi extends FlutterSoLoud {
   late final _initEngine =
       _initEnginePtr.asFunction<int Function(int, int, int, int)>();
 
+  @override
+  PlayerErrors initEngineOffline(
+    int sampleRate,
+    int bufferSize,
+    Channels channels,
+  ) {
+    final ret = _initEngineOffline(sampleRate, bufferSize, channels.count);
+    return PlayerErrors.values[ret];
+  }
+
+  late final _initEngineOfflinePtr = _lookup<
+      ffi.NativeFunction<
+          ffi.Int32 Function(ffi.UnsignedInt, ffi.UnsignedInt,
+              ffi.UnsignedInt)>>('initEngineOffline');
+  late final _initEngineOffline =
+      _initEngineOfflinePtr.asFunction<int Function(int, int, int)>();
+
+  @override
+  PlayerErrors renderOffline(Float32List buffer, int frames) {
+    final ffi.Pointer<ffi.Float> bufferPtr = calloc(buffer.lengthInBytes);
+    final ret = _renderOffline(bufferPtr, frames);
+    if (ret == PlayerErrors.noError.index) {
+      buffer.setAll(0, bufferPtr.asTypedList(buffer.length));
+    }
+    calloc.free(bufferPtr);
+    return PlayerErrors.values[ret];
+  }
+
+  late final _renderOfflinePtr = _lookup<
+      ffi.NativeFunction<
+          ffi.Int32 Function(
+              ffi.Pointer<ffi.Float>, ffi.UnsignedInt)>>('renderOffline');
+  late final _renderOffline = _renderOfflinePtr
+      .asFunction<int Function(ffi.Pointer<ffi.Float>, int)>();
+
+  @override
+  PlayerErrors renderOfflineToWav(String path, int frames) {
+    final ffi.Pointer<Utf8> cString = path.toNativeUtf8();
+    final ret = _renderOfflineToWav(cString, frames);
+    calloc.free(cString);
+    return PlayerErrors.values[ret];
+  }
+
+  late final _renderOfflineToWavPtr = _lookup<
+      ffi.NativeFunction<
+          ffi.Int32 Function(
+              ffi.Pointer<Utf8>, ffi.UnsignedInt)>>('renderOfflineToWav');
+  late final _renderOfflineToWav = _renderOfflineToWavPtr
+      .asFunction<int Function(ffi.Pointer<Utf8>, int)>();
+
   @override
   PlayerErrors changeDevice(int deviceId) {
     final ret = _changeDevice(deviceId);
@@ -329,9 +369,8 @@ class FlutterSoLoudFfi extends FlutterSoLoud {
   );
   late final _isInited = _isInitedPtr.asFunction<int Function()>();
 
-  /// After loading the file, the [_fileLoadedCallback] will call the
-  /// Dart function defined with [_setDartEventCallback] which gives back
-  /// the error and the new hash.
+  /// After loading the file, a file loaded event is queued and read by
+  /// [_eventsReadyCallback] which gives back the error and the new hash.
   @override
   void loadFile(
     String completeFileName,
@@ -343,7 +382,7 @@ class FlutterSoLoudFfi extends FlutterSoLoud {
     final ffi.Pointer<Utf8> cString = completeFileName.toNativeUtf8();
     _loadFile(
       cString,
-      mode == LoadMode.memory ? 1 : 0,
+      mode.value,
       timeStamp,
     );
     calloc
@@ -379,7 +418,7 @@ class FlutterSoLoudFfi extends FlutterSoLoud {
       cString,
       bufferPtr,
       buffer.length,
-      mode == LoadMode.memory ? 1 : 0,
+      mode.value,
       hash,
     );
     final soundHash = SoundHash(hash.value);
@@ -752,6 +791,7 @@ class FlutterSoLoudFfi extends FlutterSoLoud {
     bool paused = false,
     bool looping = false,
     Duration loopingStartAt = Duration.zero,
+    SoundHandle? bus,
   }) {
     final ffi.Pointer<ffi.UnsignedInt> handle = calloc();
     final hash = soundHash.hash;
@@ -762,6 +802,7 @@ class FlutterSoLoudFfi extends FlutterSoLoud {
       paused ? 1 : 0,
       looping ? 1 : 0,
       loopingStartAt.toDouble(),
+      bus?.id ?? 0,
       handle,
     );
     final ret =
@@ -772,10 +813,17 @@ class FlutterSoLoudFfi extends FlutterSoLoud {
 
   late final _playPtr = _lookup<
       ffi.NativeFunction<
-          ffi.Int32 Function(ffi.UnsignedInt, ffi.Float, ffi.Float, ffi.Int,
-              ffi.Int, ffi.Double, ffi.Pointer<ffi.UnsignedInt>)>>('play');
+          ffi.Int32 Function(
+              ffi.UnsignedInt,
+              ffi.Float,
+              ffi.Float,
+              ffi.Int,
+              ffi.Int,
+              ffi.Double,
+              ffi.UnsignedInt,
+              ffi.Pointer<ffi.UnsignedInt>)>>('play');
   late final _play = _playPtr.asFunction<
-      int Function(int, double, double, int, int, double,
+      int Function(int, double, double, int, int, double, int,
           ffi.Pointer<ffi.UnsignedInt>)>();
 
   @override
@@ -922,6 +970,26 @@ class FlutterSoLoudFfi extends FlutterSoLoud {
   late final _setFftSmoothing =
       _setFftSmoothingPtr.asFunction<void Function(double)>();
 
+  @override
+  PlayerErrors setFftSize(int fftSize) {
+    final ret = _setFftSize(fftSize);
+    return PlayerErrors.values[ret];
+  }
+
+  late final _setFftSizePtr =
+      _lookup<ffi.NativeFunction<ffi.Int32 Function(ffi.Int)>>('setFftSize');
+  late final _setFftSize = _setFftSizePtr.asFunction<int Function(int)>();
+
+  @override
+  PlayerErrors setFftWindow(FftWindow window) {
+    final ret = _setFftWindow(window.index);
+    return PlayerErrors.values[ret];
+  }
+
+  late final _setFftWindowPtr =
+      _lookup<ffi.NativeFunction<ffi.Int32 Function(ffi.Int)>>('setFftWindow');
+  late final _setFftWindow = _setFftWindowPtr.asFunction<int Function(int)>();
+
   @override
   bool getAudioTexture(AudioData samples) {
     final isTheSameAsBefore = calloc<ffi.Bool>();
@@ -958,6 +1026,29 @@ class FlutterSoLoudFfi extends FlutterSoLoud {
       int Function(
           ffi.Pointer<ffi.Pointer<ffi.Float>>, ffi.Pointer<ffi.Bool>)>();
 
+  @override
+  bool getAudioTexture2DRing(AudioData samples) {
+    final isTheSameAsBefore = calloc<ffi.Bool>();
+    _getAudioTexture2DRing(
+      samples.ctrl.samples2D,
+      samples.ctrl.ringHead,
+      isTheSameAsBefore,
+    );
+    final ret = isTheSameAsBefore.value;
+    calloc.free(isTheSameAsBefore);
+    return ret;
+  }
+
+  late final _getAudioTexture2DRingPtr = _lookup<
+      ffi.NativeFunction<
+          ffi.Void Function(
+              ffi.Pointer<ffi.Pointer<ffi.Float>>,
+              ffi.Pointer<ffi.Int32>,
+              ffi.Pointer<ffi.Bool>)>>('getAudioTexture2DRing');
+  late final _getAudioTexture2DRing = _getAudioTexture2DRingPtr.asFunction<
+      void Function(ffi.Pointer<ffi.Pointer<ffi.Float>>,
+          ffi.Pointer<ffi.Int32>, ffi.Pointer<ffi.Bool>)>();
+
   @override
   double getTextureValue(int row, int column) {
     return _getTextureValue(row, column);
@@ -1204,6 +1295,153 @@ class FlutterSoLoudFfi extends FlutterSoLoud {
   late final _setMaxActiveVoiceCount =
       _setMaxActiveVoiceCountPtr.asFunction<void Function(int)>();
 
+  @override
+  PlayerErrors setMixThreadCount(int threadCount) {
+    final ret = _setMixThreadCount(threadCount);
+    return PlayerErrors.values[ret];
+  }
+
+  late final _setMixThreadCountPtr =
+      _lookup<ffi.NativeFunction<ffi.Int32 Function(ffi.UnsignedInt)>>(
+          'setMixThreadCount');
+  late final _setMixThreadCount =
+      _setMixThreadCountPtr.asFunction<int Function(int)>();
+
+  @override
+  PlayerErrors setPrefetch(SoundHash soundHash, int milliseconds) {
+    final ret = _setPrefetch(soundHash.hash, milliseconds);
+    return PlayerErrors.values[ret];
+  }
+
+  late final _setPrefetchPtr = _lookup<
+      ffi.NativeFunction<
+          ffi.Int32 Function(ffi.UnsignedInt, ffi.UnsignedInt)>>('setPrefetch');
+  late final _setPrefetch =
+      _setPrefetchPtr.asFunction<int Function(int, int)>();
+
+  @override
+  int getPrefetchUnderrunCount() {
+    return _getPrefetchUnderrunCount();
+  }
+
+  late final _getPrefetchUnderrunCountPtr =
+      _lookup<ffi.NativeFunction<ffi.UnsignedInt Function()>>(
+          'getPrefetchUnderrunCount');
+  late final _getPrefetchUnderrunCount =
+      _getPrefetchUnderrunCountPtr.asFunction<int Function()>();
+
+  @override
+  void setContentDeduplicationEnabled(bool enabled) {
+    return _setContentDedup(enabled ? 1 : 0);
+  }
+
+  late final _setContentDedupPtr =
+      _lookup<ffi.NativeFunction<ffi.Void Function(ffi.Int)>>(
+    'setContentDedup',
+  );
+  late final _setContentDedup =
+      _setContentDedupPtr.asFunction<void Function(int)>();
+
+  @override
+  bool getContentDeduplicationEnabled() {
+    return _getContentDedup() == 1;
+  }
+
+  late final _getContentDedupPtr =
+      _lookup<ffi.NativeFunction<ffi.Int Function()>>('getContentDedup');
+  late final _getContentDedup =
+      _getContentDedupPtr.asFunction<int Function()>();
+
+  @override
+  void setPerfCountersEnabled(bool enabled) {
+    return _setPerfCountersEnabled(enabled);
+  }
+
+  late final _setPerfCountersEnabledPtr =
+      _lookup<ffi.NativeFunction<ffi.Void Function(ffi.Bool)>>(
+    'setPerfCountersEnabled',
+  );
+  late final _setPerfCountersEnabled =
+      _setPerfCountersEnabledPtr.asFunction<void Function(bool)>();
+
+  @override
+  PerfSnapshot? getPerfSnapshot() {
+    final snapshot = calloc<NativePerfSnapshot>();
+    try {
+      final ret = PlayerErrors.values[_getPerfSnapshot(snapshot)];
+      if (ret != PlayerErrors.noError) return null;
+      final s = snapshot.ref;
+      Duration ns(int value) => Duration(microseconds: value ~/ 1000);
+      return PerfSnapshot(
+        mixCount: s.mixCount,
+        mixTotal: ns(s.mixTotalNs),
+        mixMax: ns(s.mixMaxNs),
+        bufferTotal: ns(s.bufferTotalNs),
+        mixOverruns: s.mixOverruns,
+        lateMixes: s.lateMixes,
+        resampleTotal: ns(s.resampleTotalNs),
+        voiceFilterTotal: ns(s.voiceFilterTotalNs),
+        globalFilterTotal: List.generate(
+          perfFilterSlots,
+          (i) => ns(s.globalFilterTotalNs[i]),
+        ),
+        streamUnderruns: s.streamUnderruns,
+        lastLoad: s.lastLoad,
+        maxLoad: s.maxLoad,
+        activeVoices: s.activeVoices,
+        virtualVoices: s.virtualVoices,
+        mixHistogram:
+            List.generate(perfHistogramBuckets, (i) => s.mixHistogram[i]),
+      );
+    } finally {
+      calloc.free(snapshot);
+    }
+  }
+
+  late final _getPerfSnapshotPtr = _lookup<
+          ffi.NativeFunction<ffi.Int32 Function(ffi.Pointer<NativePerfSnapshot>)>>(
+      'getPerfSnapshot');
+  late final _getPerfSnapshot = _getPerfSnapshotPtr
+      .asFunction<int Function(ffi.Pointer<NativePerfSnapshot>)>();
+
+  @override
+  void resetPerfCounters() {
+    return _resetPerfCounters();
+  }
+
+  late final _resetPerfCountersPtr =
+      _lookup<ffi.NativeFunction<ffi.Void Function()>>('resetPerfCounters');
+  late final _resetPerfCounters =
+      _resetPerfCountersPtr.asFunction<void Function()>();
+
+  /////////////////////////////////////////
+  /// buses
+  /////////////////////////////////////////
+
+  @override
+  ({PlayerErrors error, SoundHash soundHash, SoundHandle handle}) createBus() {
+    final ffi.Pointer<ffi.UnsignedInt> hash = calloc();
+    final ffi.Pointer<ffi.UnsignedInt> handle = calloc();
+    final e = _createBus(hash, handle);
+    final ret = (
+      error: PlayerErrors.values[e],
+      soundHash: SoundHash(hash.value),
+      handle: SoundHandle(handle.value),
+    );
+    calloc
+      ..free(hash)
+      ..free(handle);
+    return ret;
+  }
+
+  late final _createBusPtr = _lookup<
+      ffi.NativeFunction<
+          ffi.Int32 Function(ffi.Pointer<ffi.UnsignedInt>,
+              ffi.Pointer<ffi.UnsignedInt>)>>('createBus');
+  late final _createBus = _createBusPtr.asFunction<
+      int Function(
+          ffi.Pointer<ffi.UnsignedInt>, ffi.Pointer<ffi.UnsignedInt>)>();
+
   /////////////////////////////////////////
   /// voice groups
   /////////////////////////////////////////
@@ -1619,6 +1857,7 @@ class FlutterSoLoudFfi extends FlutterSoLoud {
     bool paused = false,
     bool looping = false,
     Duration loopingStartAt = Duration.zero,
+    SoundHandle? bus,
   }) {
     final ffi.Pointer<ffi.UnsignedInt> handle = calloc();
     final e = _play3d(
@@ -1633,6 +1872,7 @@ class FlutterSoLoudFfi extends FlutterSoLoud {
       paused ? 1 : 0,
       looping ? 1 : 0,
       loopingStartAt.toDouble(),
+      bus?.id ?? 0,
       handle,
     );
     final ret =
@@ -1655,10 +1895,11 @@ class FlutterSoLoudFfi extends FlutterSoLoud {
               ffi.Int,
               ffi.Int,
               ffi.Double,
+              ffi.UnsignedInt,
               ffi.Pointer<ffi.UnsignedInt>)>>('play3d');
   late final _play3d = _play3dPtr.asFunction<
       int Function(int, double, double, double, double, double, double, double,
-          int, int, double, ffi.Pointer<ffi.UnsignedInt>)>();
+          int, int, double, int, ffi.Pointer<ffi.UnsignedInt>)>();
 
   @override
   void set3dSoundSpeed(double speed) {
@@ -1946,9 +2187,13 @@ class FlutterSoLoudFfi extends FlutterSoLoud {
     double startTime = 0,
     double endTime = -1,
     bool average = false,
+    int threads = 1,
+    String? cacheDir,
+    bool buildCache = false,
   }) {
     final pSamples =
         calloc<ffi.Float>(numSamplesNeeded * ffi.sizeOf<ffi.Float>());
+    final cacheDirPtr = cacheDir?.toNativeUtf8() ?? ffi.nullptr;
     final error = _readSamplesFromFile(
       completeFileName.toNativeUtf8(),
       startTime,
@@ -1956,7 +2201,11 @@ class FlutterSoLoudFfi extends FlutterSoLoud {
       numSamplesNeeded,
       average,
       pSamples,
+      threads,
+      cacheDirPtr,
+      buildCache,
     );
+    if (cacheDirPtr != ffi.nullptr) calloc.free(cacheDirPtr);
     final samples = pSamples.asTypedList(numSamplesNeeded).asUnmodifiableView();
 
     /// Seems freeing this pointer is not needed because "samples" gets
@@ -1978,10 +2227,13 @@ class FlutterSoLoudFfi extends FlutterSoLoud {
               ffi.Float,
               ffi.UnsignedLong,
               ffi.Bool,
-              ffi.Pointer<ffi.Float>)>>('readSamplesFromFile');
+              ffi.Pointer<ffi.Float>,
+              ffi.UnsignedInt,
+              ffi.Pointer<Utf8>,
+              ffi.Bool)>>('readSamplesFromFile');
   late final _readSamplesFromFile = _readSamplesFromFilePtr.asFunction<
       int Function(ffi.Pointer<Utf8>, double, double, int, bool,
-          ffi.Pointer<ffi.Float>)>();
+          ffi.Pointer<ffi.Float>, int, ffi.Pointer<Utf8>, bool)>();
 
   @override
   Float32List readSamplesFromMem(
@@ -1990,6 +2242,9 @@ class FlutterSoLoudFfi extends FlutterSoLoud {
     double startTime = 0,
     double endTime = -1,
     bool average = false,
+    int threads = 1,
+    String? cacheDir,
+    bool buildCache = false,
   }) {
     final pSamples =
         calloc<ffi.Float>(numSamplesNeeded * ffi.sizeOf<ffi.Float>());
@@ -1997,6 +2252,7 @@ class FlutterSoLoudFfi extends FlutterSoLoud {
     for (var i = 0; i < buffer.length; i++) {
       bufferPtr[i] = buffer[i];
     }
+    final cacheDirPtr = cacheDir?.toNativeUtf8() ?? ffi.nullptr;
     final error = _readSamplesFromMem(
       bufferPtr,
       buffer.length,
@@ -2005,7 +2261,11 @@ class FlutterSoLoudFfi extends FlutterSoLoud {
       numSamplesNeeded,
       average,
       pSamples,
+      threads,
+      cacheDirPtr,
+      buildCache,
     );
+    if (cacheDirPtr != ffi.nullptr) calloc.free(cacheDirPtr);
     final samples = pSamples.asTypedList(numSamplesNeeded).asUnmodifiableView();
 
     /// Seems freeing this pointer is not needed because "samples" gets
@@ -2028,8 +2288,11 @@ class FlutterSoLoudFfi extends FlutterSoLoud {
               ffi.Float,
               ffi.UnsignedLong,
               ffi.Bool,
-              ffi.Pointer<ffi.Float>)>>('readSamplesFromMem');
+              ffi.Pointer<ffi.Float>,
+              ffi.UnsignedInt,
+              ffi.Pointer<Utf8>,
+              ffi.Bool)>>('readSamplesFromMem');
   late final _readSamplesFromMem = _readSamplesFromMemPtr.asFunction<
       int Function(ffi.Pointer<ffi.Uint8>, int, double, double, int, bool,
-          ffi.Pointer<ffi.Float>)>();
+          ffi.Pointer<ffi.Float>, int, ffi.Pointer<Utf8>, bool)>();
 }
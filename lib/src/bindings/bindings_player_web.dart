@@ -11,6 +11,7 @@ import 'package:flutter_soloud/src/bindings/js_extension.dart';
 import 'package:flutter_soloud/src/enums.dart';
 import 'package:flutter_soloud/src/exceptions/exceptions.dart';
 import 'package:flutter_soloud/src/filters/filters.dart';
+import 'package:flutter_soloud/src/helpers/perf_snapshot.dart';
 import 'package:flutter_soloud/src/helpers/playback_device.dart';
 import 'package:flutter_soloud/src/sound_handle.dart';
 import 'package:flutter_soloud/src/sound_hash.dart';
@@ -113,6 +114,26 @@ class FlutterSoLoudWeb extends FlutterSoLoud {
     return PlayerErrors.values[ret];
   }
 
+  @override
+  PlayerErrors initEngineOffline(
+    int sampleRate,
+    int bufferSize,
+    Channels channels,
+  ) {
+    // The null driver is not built for the web.
+    return PlayerErrors.notImplemented;
+  }
+
+  @override
+  PlayerErrors renderOffline(Float32List buffer, int frames) {
+    return PlayerErrors.notImplemented;
+  }
+
+  @override
+  PlayerErrors renderOfflineToWav(String path, int frames) {
+    return PlayerErrors.notImplemented;
+  }
+
   @override
   PlayerErrors changeDevice(int deviceId) {
     final ret = wasmChangeDevice(deviceId);
@@ -194,7 +215,7 @@ class FlutterSoLoudWeb extends FlutterSoLoud {
       pathPtr,
       bytesPtr,
       buffer.length,
-      mode == LoadMode.memory ? 1 : 0,
+      mode.value,
       hashPtr,
     );
 
@@ -437,6 +458,7 @@ class FlutterSoLoudWeb extends FlutterSoLoud {
     bool paused = false,
     bool looping = false,
     Duration loopingStartAt = Duration.zero,
+    SoundHandle? bus,
   }) {
     final handlePtr = wasmMalloc(4); // 4 bytes for an int32
     final result = wasmPlay(
@@ -446,6 +468,7 @@ class FlutterSoLoudWeb extends FlutterSoLoud {
       paused,
       looping,
       loopingStartAt.toDouble(),
+      bus?.id ?? 0,
       handlePtr,
     );
 
@@ -530,6 +553,16 @@ class FlutterSoLoudWeb extends FlutterSoLoud {
     wasmSetFftSmoothing(smooth);
   }
 
+  @override
+  PlayerErrors setFftSize(int fftSize) {
+    return PlayerErrors.values[wasmSetFftSize(fftSize)];
+  }
+
+  @override
+  PlayerErrors setFftWindow(FftWindow window) {
+    return PlayerErrors.values[wasmSetFftWindow(window.index)];
+  }
+
   @override
   bool getAudioTexture(AudioData samples) {
     final isTheSameAsBeforePtr = wasmMalloc(4);
@@ -548,6 +581,19 @@ class FlutterSoLoudWeb extends FlutterSoLoud {
     return ret == 1;
   }
 
+  @override
+  bool getAudioTexture2DRing(AudioData samples) {
+    final isTheSameAsBeforePtr = wasmMalloc(4);
+    wasmGetAudioTexture2DRing(
+      samples.ctrl.samplesPtr,
+      samples.ctrl.ringHeadPtr,
+      isTheSameAsBeforePtr,
+    );
+    final ret = wasmGetI32Value(isTheSameAsBeforePtr, 'i32');
+    wasmFree(isTheSameAsBeforePtr);
+    return ret == 1;
+  }
+
   @override
   double getTextureValue(int row, int column) {
     final e = wasmGetTextureValue(row, column);
@@ -649,6 +695,71 @@ class FlutterSoLoudWeb extends FlutterSoLoud {
     return wasmSetMaxActiveVoiceCount(maxVoiceCount);
   }
 
+  @override
+  PlayerErrors setMixThreadCount(int threadCount) {
+    /// The WASM module is built without threads support.
+    return PlayerErrors.notImplemented;
+  }
+
+  @override
+  PlayerErrors setPrefetch(SoundHash soundHash, int milliseconds) {
+    /// The WASM module is built without threads support.
+    return PlayerErrors.notImplemented;
+  }
+
+  @override
+  int getPrefetchUnderrunCount() {
+    return 0;
+  }
+
+  @override
+  void setContentDeduplicationEnabled(bool enabled) {
+    wasmSetContentDedup(enabled ? 1 : 0);
+  }
+
+  @override
+  bool getContentDeduplicationEnabled() {
+    return wasmGetContentDedup() == 1;
+  }
+
+  @override
+  void setPerfCountersEnabled(bool enabled) {
+    wasmSetPerfCountersEnabled(enabled ? 1 : 0);
+  }
+
+  @override
+  PerfSnapshot? getPerfSnapshot() {
+    // Reading the struct from the WASM heap is not implemented.
+    return null;
+  }
+
+  @override
+  void resetPerfCounters() {
+    wasmResetPerfCounters();
+  }
+
+  /////////////////////////////////////////
+  /// buses
+  /////////////////////////////////////////
+
+  @override
+  ({PlayerErrors error, SoundHash soundHash, SoundHandle handle}) createBus() {
+    final hashPtr = wasmMalloc(4); // 4 bytes for an int32
+    final handlePtr = wasmMalloc(4);
+    final result = wasmCreateBus(hashPtr, handlePtr);
+
+    /// "*" means unsigned int 32
+    final ret = (
+      error: PlayerErrors.values[result],
+      soundHash: SoundHash(wasmGetI32Value(hashPtr, 'i32')),
+      handle: SoundHandle(wasmGetI32Value(handlePtr, 'i32')),
+    );
+    wasmFree(hashPtr);
+    wasmFree(handlePtr);
+
+    return ret;
+  }
+
   /////////////////////////////////////////
   /// voice groups
   /////////////////////////////////////////
@@ -926,6 +1037,7 @@ class FlutterSoLoudWeb extends FlutterSoLoud {
     bool paused = false,
     bool looping = false,
     Duration loopingStartAt = Duration.zero,
+    SoundHandle? bus,
   }) {
     final handlePtr = wasmMalloc(4); // 4 bytes for an int32
     final result = wasmPlay3d(
@@ -940,6 +1052,7 @@ class FlutterSoLoudWeb extends FlutterSoLoud {
       paused ? 1 : 0,
       looping ? 1 : 0,
       loopingStartAt.toDouble(),
+      bus?.id ?? 0,
       handlePtr,
     );
 
@@ -1095,6 +1208,9 @@ class FlutterSoLoudWeb extends FlutterSoLoud {
     double startTime = 0,
     double endTime = -1,
     bool average = false,
+    int threads = 1,
+    String? cacheDir,
+    bool buildCache = false,
   }) {
     throw UnimplementedError('[readSamplesFromFile] in not supported on the '
         'web platfom! Please use [readSamplesFromMem].');
@@ -1107,6 +1223,9 @@ class FlutterSoLoudWeb extends FlutterSoLoud {
     double startTime = 0,
     double endTime = -1,
     bool average = false,
+    int threads = 1,
+    String? cacheDir,
+    bool buildCache = false,
   }) {
     final bufferPtr = wasmMalloc(buffer.length);
     // Is there a way to speed up this array copy?
@@ -1123,6 +1242,10 @@ class FlutterSoLoudWeb extends FlutterSoLoud {
       numSamplesNeeded,
       average,
       samplesPtr,
+      threads,
+      // The peak cache is not supported on the web.
+      0,
+      false,
     );
 
     // Create a view of the WASM memory using JSFloat32Array first
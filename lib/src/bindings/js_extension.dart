@@ -124,7 +124,7 @@ external int wasmIsInited();
 @JS('Module_soloud._loadFile')
 external int wasmLoadFile(
   int completeFileNamePtr,
-  int loadIntoMem,
+  int loadMode,
   int hashPtr,
 );
 
@@ -133,7 +133,7 @@ external int wasmLoadMem(
   int uniqueNamePtr,
   int memPtr,
   int length,
-  int loadIntoMem,
+  int loadMode,
   int hashPtr,
 );
 
@@ -189,6 +189,7 @@ external int wasmPlay(
   bool paused,
   bool looping,
   double loopingStartAt,
+  int bus,
   int handlePtr,
 );
 
@@ -219,6 +220,18 @@ external void wasmSetVisualizationEnabled(int enabled);
 @JS('Module_soloud._getVisualizationEnabled')
 external int wasmGetVisualizationEnabled();
 
+@JS('Module_soloud._setContentDedup')
+external void wasmSetContentDedup(int enabled);
+
+@JS('Module_soloud._getContentDedup')
+external int wasmGetContentDedup();
+
+@JS('Module_soloud._setPerfCountersEnabled')
+external void wasmSetPerfCountersEnabled(int enabled);
+
+@JS('Module_soloud._resetPerfCounters')
+external void wasmResetPerfCounters();
+
 @JS('Module_soloud._getWave')
 external void wasmGetWave(int samplesPtr, int isTheSameAsBeforePtr);
 
@@ -228,12 +241,25 @@ external void wasmGetFft(int samplesPtr, int isTheSameAsBeforePtr);
 @JS('Module_soloud._setFftSmoothing')
 external void wasmSetFftSmoothing(double smooth);
 
+@JS('Module_soloud._setFftSize')
+external int wasmSetFftSize(int fftSize);
+
+@JS('Module_soloud._setFftWindow')
+external int wasmSetFftWindow(int window);
+
 @JS('Module_soloud._getAudioTexture')
 external void wasmGetAudioTexture(int samplesPtr, int isTheSameAsBeforePtr);
 
 @JS('Module_soloud._getAudioTexture2D')
 external void wasmGetAudioTexture2D(int samplesPtr, int isTheSameAsBeforePtr);
 
+@JS('Module_soloud._getAudioTexture2DRing')
+external void wasmGetAudioTexture2DRing(
+  int samplesPtr,
+  int headPtr,
+  int isTheSameAsBeforePtr,
+);
+
 @JS('Module_soloud._getTextureValue')
 external double wasmGetTextureValue(int row, int column);
 
@@ -298,6 +324,9 @@ external void wasmSetMaxActiveVoiceCount(int maxVoiceCount);
 /// voice groups
 /////////////////////////////////////////
 
+@JS('Module_soloud._createBus')
+external int wasmCreateBus(int hashPtr, int handlePtr);
+
 @JS('Module_soloud._createVoiceGroup')
 external int wasmCreateVoiceGroup();
 
@@ -425,6 +454,7 @@ external int wasmPlay3d(
   int paused,
   int looping,
   double loopingStartAt,
+  int bus,
   int handlePtr,
 );
 
@@ -520,4 +550,8 @@ external int wasmReadSamplesFromMem(
   // ignore: avoid_positional_boolean_parameters
   bool average,
   int pSamplesPtr,
+  int threadCount,
+  int cacheDirPtr,
+  // ignore: avoid_positional_boolean_parameters
+  bool buildCache,
 );
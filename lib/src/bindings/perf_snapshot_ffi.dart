@@ -0,0 +1,54 @@
+// ignore_for_file: public_member_api_docs
+
+import 'dart:ffi' as ffi;
+
+/// Reflection of `PerfSnapshot` in soloud_perf.h
+const int perfFilterSlots = 8;
+const int perfHistogramBuckets = 144;
+
+final class NativePerfSnapshot extends ffi.Struct {
+  @ffi.Uint64()
+  external int mixCount;
+
+  @ffi.Uint64()
+  external int mixTotalNs;
+
+  @ffi.Uint64()
+  external int mixMaxNs;
+
+  @ffi.Uint64()
+  external int bufferTotalNs;
+
+  @ffi.Uint64()
+  external int mixOverruns;
+
+  @ffi.Uint64()
+  external int lateMixes;
+
+  @ffi.Uint64()
+  external int resampleTotalNs;
+
+  @ffi.Uint64()
+  external int voiceFilterTotalNs;
+
+  @ffi.Array(perfFilterSlots)
+  external ffi.Array<ffi.Uint64> globalFilterTotalNs;
+
+  @ffi.Uint64()
+  external int streamUnderruns;
+
+  @ffi.Float()
+  external double lastLoad;
+
+  @ffi.Float()
+  external double maxLoad;
+
+  @ffi.Uint32()
+  external int activeVoices;
+
+  @ffi.Uint32()
+  external int virtualVoices;
+
+  @ffi.Array(perfHistogramBuckets)
+  external ffi.Array<ffi.Uint32> mixHistogram;
+}
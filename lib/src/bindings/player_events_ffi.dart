@@ -0,0 +1,43 @@
+// ignore_for_file: public_member_api_docs, constant_identifier_names
+
+import 'dart:ffi' as ffi;
+
+/// Reflection of event_queue.h
+
+enum NativePlayerEventType {
+  EVENT_VOICE_ENDED(0),
+  EVENT_FILE_LOADED(1),
+  EVENT_STATE_CHANGED(2),
+  EVENT_VOICES_RESYNC(3);
+
+  const NativePlayerEventType(this.value);
+  final int value;
+
+  static NativePlayerEventType fromValue(int value) => switch (value) {
+        0 => EVENT_VOICE_ENDED,
+        1 => EVENT_FILE_LOADED,
+        2 => EVENT_STATE_CHANGED,
+        3 => EVENT_VOICES_RESYNC,
+        _ => throw ArgumentError('Unknown value for PlayerEventType: $value'),
+      };
+}
+
+/// An event read in batches with `drainEvents`.
+final class NativePlayerEvent extends ffi.Struct {
+  @ffi.Int32()
+  external int type;
+
+  /// The voice handle, the sound hash or the new state, see
+  /// [NativePlayerEventType].
+  @ffi.Uint32()
+  external int value;
+
+  @ffi.Int32()
+  external int error;
+
+  @ffi.Uint64()
+  external int timeStamp;
+
+  /// Set only for the file loaded events, must be freed with `nativeFree`.
+  external ffi.Pointer<ffi.Char> completeFileName;
+}
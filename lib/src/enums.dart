@@ -102,7 +102,10 @@ enum PlayerErrors {
   audioFormatNotSupported(29),
 
   /// Opus ogg vorbis libraries not found.
-  opusOggVorbisLibsNotFound(30);
+  opusOggVorbisLibsNotFound(30),
+
+  /// Given handle doesn't belong to a bus.
+  handleIsNotABus(31);
 
   const PlayerErrors(this.value);
 
@@ -197,6 +200,8 @@ enum PlayerErrors {
             'installation and ensure the required libraries are available. '
             'Ref:'
             'https://github.com/alnitak/flutter_soloud/blob/main/NO_OPUS_OGG_LIBS.md';
+      case PlayerErrors.handleIsNotABus:
+        return "Given handle doesn't belong to a bus.";
     }
   }
 
@@ -289,15 +294,53 @@ enum WaveForm {
   fSaw,
 }
 
+/// The windowing algorithms applied to the wave data before computing
+/// the FFT data returned by the audio textures.
+///
+/// WARNING: Keep these in sync with `src/enums.h`.
+enum FftWindow {
+  /// Blackman window, the default.
+  blackman,
+
+  /// Hann window.
+  hann,
+
+  /// Hamming window.
+  hamming,
+
+  /// Gaussian window.
+  gauss,
+}
+
 /// The way an audio file is loaded.
+///
+/// WARNING: Keep these in sync with `src/enums.h`.
 enum LoadMode {
   /// Load and decompress the audio file into RAM.
   /// Less CPU, more memory allocated, low latency.
-  memory,
+  memory(1),
 
   /// Keep the file on disk and only load chunks as needed.
-  /// More CPU, less memory allocated, seeking lags with MP3s.
-  disk,
+  /// More CPU, less memory allocated. MP3s are indexed when loaded to
+  /// seek quickly.
+  disk(0),
+
+  /// Like [memory], but the decompressed samples are stored as 16 bit
+  /// integers instead of 32 bit floats: half the memory allocated, at the
+  /// cost of 16 bit precision and a conversion when the sound is played.
+  memoryCompact(2),
+
+  /// Keep the compressed audio file in RAM and decode it when needed, like
+  /// [disk] without reading the disk. Much less memory than [memory] for
+  /// long music tracks, with fast seeking (MP3 files are indexed when
+  /// loaded).
+  /// On Web it behaves like [memory].
+  memoryCompressed(3);
+
+  const LoadMode(this.value);
+
+  /// The integer value of the mode passed to the C++ API.
+  final int value;
 }
 
 /// Audio state changes. Not doing much now. Notifications should work
@@ -375,3 +375,14 @@ class SoLoudOpusOggVorbisLibsNotFoundCppException extends SoLoudCppException {
       'https://docs.page/alnitak/flutter_soloud_docs/get_started/no_opus_ogg_libs  '
       '(on the C++ side).';
 }
+
+/// An error occurred when asking to play a sound on a handle that is not
+/// the handle of a bus created with `SoLoud.createBus()`.
+class SoLoudHandleIsNotABusCppException extends SoLoudCppException {
+  /// Creates a new [SoLoudHandleIsNotABusCppException].
+  const SoLoudHandleIsNotABusCppException([super.message]);
+
+  @override
+  String get description => 'The given handle is not the handle of a bus. '
+      '(on the C++ side).';
+}
@@ -472,8 +472,8 @@ enum FilterType {
         FilterType.waveShaperFilter => 2,
         FilterType.robotizeFilter => 3,
         FilterType.freeverbFilter => 5,
-        FilterType.pitchShiftFilter => 3,
-        FilterType.limiterFilter => 5,
+        FilterType.pitchShiftFilter => 4,
+        FilterType.limiterFilter => 7,
         FilterType.compressorFilter => 8,
       };
 
@@ -10,11 +10,17 @@ enum Limiter {
   outputCeiling,
   kneeWidth,
   releaseTime,
-  attackTime;
+  attackTime,
 
-  final List<double> _mins = const [0, -60, -60, 0, 1, 0.1];
-  final List<double> _maxs = const [1, 0, 0, 30, 1000, 200];
-  final List<double> _defs = const [1, -6, -1, 2, 100, 1];
+  /// The lookahead in ms, 0 to disable it. Else the output is delayed by this
+  /// much and the gain goes down before the peaks, including the true peaks
+  /// between the samples, to keep them under the output ceiling.
+  /// The channels then share the same gain, and the attack time is not used.
+  lookahead;
+
+  final List<double> _mins = const [0, -60, -60, 0, 1, 0.1, 0];
+  final List<double> _maxs = const [1, 0, 0, 30, 1000, 200, 10];
+  final List<double> _defs = const [1, -6, -1, 2, 100, 1, 0];
 
   double get min => _mins[index];
   double get max => _maxs[index];
@@ -28,6 +34,7 @@ enum Limiter {
         Limiter.kneeWidth => 'Knee Width',
         Limiter.releaseTime => 'Release Time',
         Limiter.attackTime => 'Attack Time',
+        Limiter.lookahead => 'Lookahead',
       };
 }
 
@@ -41,6 +48,7 @@ abstract class _LimiterInternal extends FilterBase {
   Limiter get queryKneeWidth => Limiter.kneeWidth;
   Limiter get queryReleaseTime => Limiter.releaseTime;
   Limiter get queryAttackTime => Limiter.attackTime;
+  Limiter get queryLookahead => Limiter.lookahead;
 }
 
 class LimiterSingle extends _LimiterInternal {
@@ -93,6 +101,14 @@ class LimiterSingle extends _LimiterInternal {
         Limiter.attackTime.min,
         Limiter.attackTime.max,
       );
+
+  FilterParam lookahead({SoundHandle? soundHandle}) => FilterParam(
+        soundHandle,
+        filterType,
+        Limiter.lookahead.index,
+        Limiter.lookahead.min,
+        Limiter.lookahead.max,
+      );
 }
 
 class LimiterGlobal extends _LimiterInternal {
@@ -145,4 +161,12 @@ class LimiterGlobal extends _LimiterInternal {
         Limiter.attackTime.min,
         Limiter.attackTime.max,
       );
+
+  FilterParam get lookahead => FilterParam(
+        null,
+        filterType,
+        Limiter.lookahead.index,
+        Limiter.lookahead.min,
+        Limiter.lookahead.max,
+      );
 }
@@ -8,11 +8,12 @@ import 'package:flutter_soloud/src/sound_hash.dart';
 enum PitchShiftEnum {
   wet,
   shift,
-  semitones;
+  semitones,
+  perChannel;
 
-  final List<double> _mins = const [0, 0, -36];
-  final List<double> _maxs = const [1, 3, 36];
-  final List<double> _defs = const [1, 1, 0];
+  final List<double> _mins = const [0, 0, -36, 0];
+  final List<double> _maxs = const [1, 3, 36, 1];
+  final List<double> _defs = const [1, 1, 0, 0];
 
   double get min => _mins[index];
   double get max => _maxs[index];
@@ -23,6 +24,7 @@ enum PitchShiftEnum {
         PitchShiftEnum.wet => 'Wet',
         PitchShiftEnum.shift => 'Shift',
         PitchShiftEnum.semitones => 'Semitones',
+        PitchShiftEnum.perChannel => 'Per Channel',
       };
 }
 
@@ -33,6 +35,7 @@ abstract class _PitchShiftInternal extends FilterBase {
   PitchShiftEnum get queryWet => PitchShiftEnum.wet;
   PitchShiftEnum get queryShift => PitchShiftEnum.shift;
   PitchShiftEnum get querySemitones => PitchShiftEnum.semitones;
+  PitchShiftEnum get queryPerChannel => PitchShiftEnum.perChannel;
 }
 
 class PitchShiftSingle extends _PitchShiftInternal {
@@ -78,6 +81,17 @@ class PitchShiftSingle extends _PitchShiftInternal {
         PitchShiftEnum.semitones.max,
       );
 
+  /// 0 (the default) shifts the channels mixed down to mono and writes the
+  /// result to all of them. 1 shifts each channel on its own to keep the
+  /// stereo image, at the cost of one shift per channel.
+  FilterParam perChannel({SoundHandle? soundHandle}) => FilterParam(
+        soundHandle,
+        filterType,
+        PitchShiftEnum.perChannel.index,
+        PitchShiftEnum.perChannel.min,
+        PitchShiftEnum.perChannel.max,
+      );
+
   /// Adjust the play speed of a sound without changing the pitch of the audio.
   ///
   /// This is done by counteracting the change in pitch caused by changing the
@@ -131,4 +145,15 @@ class PitchShiftGlobal extends _PitchShiftInternal {
         PitchShiftEnum.semitones.min,
         PitchShiftEnum.semitones.max,
       );
+
+  /// 0 (the default) shifts the channels mixed down to mono and writes the
+  /// result to all of them. 1 shifts each channel on its own to keep the
+  /// stereo image, at the cost of one shift per channel.
+  FilterParam get perChannel => FilterParam(
+        null,
+        filterType,
+        PitchShiftEnum.perChannel.index,
+        PitchShiftEnum.perChannel.min,
+        PitchShiftEnum.perChannel.max,
+      );
 }
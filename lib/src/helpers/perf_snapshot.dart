@@ -0,0 +1,123 @@
+import 'package:flutter_soloud/src/soloud.dart';
+import 'package:meta/meta.dart';
+
+/// The performance counters of the audio engine, read with
+/// [SoLoud.getPerfSnapshot].
+///
+/// The times are summed since the counters were enabled or reset with
+/// [SoLoud.resetPerfCounters]. A "mix" is one call of the audio callback,
+/// which renders one buffer of audio.
+final class PerfSnapshot {
+  /// Constructs a new [PerfSnapshot].
+  @internal
+  const PerfSnapshot({
+    required this.mixCount,
+    required this.mixTotal,
+    required this.mixMax,
+    required this.bufferTotal,
+    required this.mixOverruns,
+    required this.lateMixes,
+    required this.resampleTotal,
+    required this.voiceFilterTotal,
+    required this.globalFilterTotal,
+    required this.streamUnderruns,
+    required this.lastLoad,
+    required this.maxLoad,
+    required this.activeVoices,
+    required this.virtualVoices,
+    required this.mixHistogram,
+  });
+
+  /// The number of mixes.
+  final int mixCount;
+
+  /// The time spent mixing.
+  final Duration mixTotal;
+
+  /// The longest mix.
+  final Duration mixMax;
+
+  /// The duration of the audio mixed.
+  final Duration bufferTotal;
+
+  /// The mixes which took longer than the audio they rendered.
+  final int mixOverruns;
+
+  /// The mixes which started more than 1.5 buffers after the previous one.
+  /// The device has most likely played silence in between: this is the
+  /// closest to an output underrun count the backends can report.
+  final int lateMixes;
+
+  /// The time spent resampling the voices.
+  final Duration resampleTotal;
+
+  /// The time spent in the filters of the sounds.
+  final Duration voiceFilterTotal;
+
+  /// The time spent in each global filter slot.
+  final List<Duration> globalFilterTotal;
+
+  /// The reads of buffer streams which had not enough data and were not
+  /// ended.
+  final int streamUnderruns;
+
+  /// The time of the last mix, in percent of the audio it rendered.
+  final double lastLoad;
+
+  /// The highest [lastLoad].
+  final double maxLoad;
+
+  /// The voices mixed in the last mix.
+  final int activeVoices;
+
+  /// The playing voices left out of the last mix because they were
+  /// inaudible or over the maximum active voice count.
+  final int virtualVoices;
+
+  /// The number of mixes by time. The bucket `i` counts the mixes which took
+  /// from [bucketStart] `(i)` to [bucketStart] `(i + 1)` microseconds.
+  final List<int> mixHistogram;
+
+  /// The average time of the mixes, in percent of the audio they rendered.
+  double get averageLoad => bufferTotal.inMicroseconds == 0
+      ? 0
+      : 100 * mixTotal.inMicroseconds / bufferTotal.inMicroseconds;
+
+  /// The lowest time counted by the [mixHistogram] bucket [bucket].
+  ///
+  /// The first 8 buckets are 1 microsecond wide, then each power of two is
+  /// split in 8 buckets.
+  static Duration bucketStart(int bucket) {
+    if (bucket < 8) return Duration(microseconds: bucket);
+    final msb = (bucket >> 3) + 2;
+    final sub = bucket & 7;
+    return Duration(microseconds: (8 + sub) << (msb - 3));
+  }
+
+  /// The mix time which [percentile] percent of the mixes did not exceed,
+  /// rounded up to the end of its [mixHistogram] bucket.
+  ///
+  /// [percentile] must be in the 0 ~ 100 range.
+  Duration mixPercentile(double percentile) {
+    final total = mixHistogram.fold(0, (a, b) => a + b);
+    if (total == 0) return Duration.zero;
+    final target = total * percentile / 100;
+    var count = 0;
+    for (var i = 0; i < mixHistogram.length; i++) {
+      count += mixHistogram[i];
+      if (count >= target && mixHistogram[i] > 0) {
+        // The last bucket counts all the longer mixes.
+        return i + 1 < mixHistogram.length ? bucketStart(i + 1) : mixMax;
+      }
+    }
+    return mixMax;
+  }
+
+  @override
+  String toString() => 'PerfSnapshot(mixCount: $mixCount, '
+      'averageLoad: ${averageLoad.toStringAsFixed(1)}%, '
+      'maxLoad: ${maxLoad.toStringAsFixed(1)}%, mixMax: $mixMax, '
+      'mixOverruns: $mixOverruns, lateMixes: $lateMixes, '
+      'streamUnderruns: $streamUnderruns, activeVoices: $activeVoices, '
+      'virtualVoices: $virtualVoices)';
+}
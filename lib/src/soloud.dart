@@ -12,6 +12,7 @@ import 'package:flutter_soloud/src/bindings/soloud_controller.dart';
 import 'package:flutter_soloud/src/enums.dart';
 import 'package:flutter_soloud/src/exceptions/exceptions.dart';
 import 'package:flutter_soloud/src/filters/filters.dart';
+import 'package:flutter_soloud/src/helpers/perf_snapshot.dart';
 import 'package:flutter_soloud/src/helpers/playback_device.dart';
 import 'package:flutter_soloud/src/metadata.dart';
 import 'package:flutter_soloud/src/sound_handle.dart';
@@ -21,15 +22,6 @@ import 'package:http/http.dart' as http;
 import 'package:logging/logging.dart';
 import 'package:meta/meta.dart';
 
-@pragma('vm:entry-point')
-void _loadFile(Map<String, dynamic> args) {
-  SoLoudController().soLoudFFI.loadFile(
-        args['path'] as String,
-        LoadMode.values[args['mode'] as int],
-        args['timeStamp'] as int,
-      );
-}
-
 @pragma('vm:entry-point')
 ({PlayerErrors error, SoundHash soundHash}) _loadMem(
     Map<String, dynamic> args) {
@@ -48,6 +40,9 @@ Float32List _readSamplesFromFile(Map<String, dynamic> args) {
         startTime: args['startTime'] as double,
         endTime: args['endTime'] as double,
         average: args['average'] as bool,
+        threads: args['threads'] as int,
+        cacheDir: args['cacheDir'] as String?,
+        buildCache: args['buildCache'] as bool,
       );
 }
 
@@ -59,6 +54,9 @@ Float32List _readSamplesFromMem(Map<String, dynamic> args) {
         startTime: args['startTime'] as double,
         endTime: args['endTime'] as double,
         average: args['average'] as bool,
+        threads: args['threads'] as int,
+        cacheDir: args['cacheDir'] as String?,
+        buildCache: args['buildCache'] as bool,
       );
 }
 
@@ -174,6 +172,9 @@ interface class SoLoud {
   /// Whether or not is it possible to ask for wave and FFT data.
   bool _isVisualizationEnabled = false;
 
+  /// The channels of the engine initialized with `offline: true`, or null.
+  Channels? _offlineChannels;
+
   /// The current status of the engine. This is `true` when the engine
   /// has been initialized and is immediately ready.
   ///
@@ -248,12 +249,19 @@ interface class SoLoud {
   /// The default value is 2048.
   ///
   /// [channels] mono, stereo, quad, 5.1, 7.1.
+  ///
+  /// If [offline] is `true`, no audio device is opened and [device] is
+  /// ignored: nothing is played, the audio is mixed only when calling
+  /// [renderOffline] or [renderOfflineToWav], as fast as the CPU allows.
+  /// Useful to export a mix, or to measure the engine on machines without
+  /// audio hardware. Not supported on the web.
   Future<void> init({
     PlaybackDevice? device,
     bool automaticCleanup = false,
     int sampleRate = 44100,
     int bufferSize = 2048,
     Channels channels = Channels.stereo,
+    bool offline = false,
   }) async {
     _log.finest('init() called');
 
@@ -275,14 +283,19 @@ interface class SoLoud {
     // Initialize native callbacks
     await _initializeNativeCallbacks();
 
-    final error = _controller.soLoudFFI.initEngine(
-      device?.id ?? -1,
-      sampleRate,
-      bufferSize,
-      channels,
-    );
+    final error = offline
+        ? _controller.soLoudFFI
+            .initEngineOffline(sampleRate, bufferSize, channels)
+        : _controller.soLoudFFI.initEngine(
+            device?.id ?? -1,
+            sampleRate,
+            bufferSize,
+            channels,
+          );
     _logPlayerError(error, from: 'initialize() result');
     if (error == PlayerErrors.noError) {
+      _offlineChannels = offline ? channels : null;
+
       /// get the visualization flag from the player on C side.
       /// Eventually we can set this as a parameter during the
       /// initialization with some other parameters like `sampleRate`
@@ -338,6 +351,54 @@ interface class SoLoud {
     _controller.soLoudFFI.disposeAllSound();
     _controller.soLoudFFI.deinit();
     _activeSounds.clear();
+    _offlineChannels = null;
+  }
+
+  /// Whether the engine has been initialized with `offline: true`.
+  bool get isOffline => isInitialized && _offlineChannels != null;
+
+  /// Mix the next [frames] frames of audio of an engine initialized with
+  /// `offline: true`, see [init].
+  ///
+  /// Returns the `frames * channels` interleaved samples. The playing voices
+  /// advance by [frames], as if a device had played them.
+  ///
+  /// Throws [SoLoudNotInitializedException] if the engine is not initialized.
+  /// Throws [SoLoudCppException] if the engine is not offline.
+  Float32List renderOffline(int frames) {
+    if (!isInitialized) {
+      throw const SoLoudNotInitializedException();
+    }
+    final channels = _offlineChannels;
+    if (channels == null) {
+      throw SoLoudCppException.fromPlayerError(PlayerErrors.invalidParameter);
+    }
+    final buffer = Float32List(frames * channels.count);
+    final error = _controller.soLoudFFI.renderOffline(buffer, frames);
+    if (error != PlayerErrors.noError) {
+      _log.severe(() => 'renderOffline(): $error');
+      throw SoLoudCppException.fromPlayerError(error);
+    }
+    return buffer;
+  }
+
+  /// Mix the next [frames] frames of audio of an engine initialized with
+  /// `offline: true` into a 32 bit float WAV file, see [init].
+  ///
+  /// [path] the file to create or overwrite.
+  ///
+  /// Throws [SoLoudNotInitializedException] if the engine is not initialized.
+  /// Throws [SoLoudCppException] if the engine is not offline or if the file
+  /// can't be written.
+  void renderOfflineToWav(String path, int frames) {
+    if (!isInitialized) {
+      throw const SoLoudNotInitializedException();
+    }
+    final error = _controller.soLoudFFI.renderOfflineToWav(path, frames);
+    if (error != PlayerErrors.noError) {
+      _log.severe(() => 'renderOfflineToWav(): $error');
+      throw SoLoudCppException.fromPlayerError(error);
+    }
   }
 
   /// Get the [AudioSource] which own the [handle]
@@ -356,9 +417,10 @@ interface class SoLoud {
   ///   - [SoLoudController().soLoudFFI.voiceEndedEvents]
   ///   - [SoLoudController().soLoudFFI.fileLoadedEvents]
   ///
-  /// These events are coming from `FlutterSoLoudFfi`. The callbacks
-  /// `_voiceEndedCallback` and `_fileLoadedCallback` are called from CPP.
-  /// From within these callbacks a new stream event is added and listened here.
+  /// These events are coming from `FlutterSoLoudFfi`. The callback
+  /// `_eventsReadyCallback` is called from CPP when events are queued.
+  /// It reads them in batches and adds a new stream event for each of them,
+  /// which are listened here.
   Future<void> _initializeNativeCallbacks() async {
     // Initialize callbacks.
     await _controller.soLoudFFI.setDartEventCallbacks();
@@ -392,6 +454,21 @@ interface class SoLoud {
       });
     }
 
+    // The voice ended events dropped when the queue was full are lost:
+    // end the handles that are no longer valid the same way.
+    if (!_controller.soLoudFFI.voicesResyncEventController.hasListener) {
+      _controller.soLoudFFI.voicesResyncEvents.listen((_) {
+        if (!isInitialized) return;
+        for (final sound in _activeSounds.toList()) {
+          for (final handle in sound.handles.toList()) {
+            if (!getIsValidVoiceHandle(handle)) {
+              _controller.soLoudFFI.voiceEndedEventController.add(handle.id);
+            }
+          }
+        }
+      });
+    }
+
     // Listen when a file has been loaded.
     if (!_controller.soLoudFFI.fileLoadedEventsController.hasListener) {
       _controller.soLoudFFI.fileLoadedEvents.listen((result) {
@@ -497,10 +574,17 @@ interface class SoLoud {
   /// when seeking/starting a sound (less CPU, more memory allocated).
   /// If [LoadMode.disk] is used instead, the audio data is loaded
   /// from the given file when needed (more CPU, less memory allocated).
-  /// See the [seek] note problem when using [LoadMode.disk].
+  /// See the [seek] note about MP3 files when using [LoadMode.disk].
+  /// [LoadMode.memoryCompact] loads the audio into memory like
+  /// [LoadMode.memory], storing it as 16 bit samples to halve its size.
+  /// [LoadMode.memoryCompressed] keeps the compressed file in memory and
+  /// decodes it while playing, with fast seeks.
   ///
   /// The default is [LoadMode.memory].
   ///
+  /// Files are decoded by a pool of native threads, so loading many files
+  /// at once, for example with `Future.wait`, decodes them in parallel.
+  ///
   /// Returns the new sound as [AudioSource].
   ///
   /// Throws [SoLoudNotInitializedException] if the engine is not initialized.
@@ -534,8 +618,9 @@ interface class SoLoud {
       '$path-$now': completer,
     });
 
-    await compute(
-        _loadFile, {'path': path, 'mode': mode.index, 'timeStamp': now});
+    // The file is decoded by a pool of native threads: this call only queues
+    // it and the result comes back through `fileLoadedEvents`.
+    _controller.soLoudFFI.loadFile(path, mode, now);
 
     return completer.future.whenComplete(() {
       loadedFileCompleters
@@ -562,7 +647,7 @@ interface class SoLoud {
   ///
   /// If [LoadMode.disk] is used instead, the audio data is loaded
   /// from the given file when needed (more CPU, less memory allocated).
-  /// See the [seek] note problem when using [LoadMode.disk].
+  /// See the [seek] note about MP3 files when using [LoadMode.disk].
   /// The default is [LoadMode.memory].
   ///
   /// IMPORTANT: on Web [LoadMode.disk] is is overridden to [LoadMode.memory].
@@ -621,8 +706,10 @@ interface class SoLoud {
   ///
   /// [maxBufferSizeDuration] same as [maxBufferSizeBytes] but the size is
   /// calculated based on the [sampleRate] and [channels] parameters.
-  /// <br/>**Note:** these parameters don't allocate any memory, but it is just
-  /// a limitation on the amount of data that can be added.
+  /// <br/>**Note:** these parameters don't allocate all the memory at once,
+  /// but it is just a limitation on the amount of data that can be added. The
+  /// memory grows as data is added. With [BufferingType.released] the room of
+  /// the data already played is reused.
   ///
   /// [bufferingType] enum to choose how the buffering will work while playing
   /// the stream. Using [BufferingType.preserved] will preserve the data already
@@ -1207,6 +1294,9 @@ interface class SoLoud {
   /// There is no way to set the end of the looping region — it will
   /// always be the end of the [sound].
   ///
+  /// Set [bus] to a bus created with [createBus] to play the sound through
+  /// the filters of the bus.
+  ///
   /// Returns the [SoundHandle] of the new sound instance.
   ///
   /// **NOTE**: by default, the maximum number of sounds you can play is 16 and
@@ -1223,6 +1313,9 @@ interface class SoLoud {
   ///
   /// Throws [SoLoudSoundHashNotFoundDartException] if the given [sound]
   /// is not found.
+  ///
+  /// Throws [SoLoudHandleIsNotABusCppException] if [bus] is not a bus
+  /// created with [createBus], or if it has been stopped or disposed.
   Future<SoundHandle> play(
     AudioSource sound, {
     double volume = 1,
@@ -1230,6 +1323,7 @@ interface class SoLoud {
     bool paused = false,
     bool looping = false,
     Duration loopingStartAt = Duration.zero,
+    AudioSource? bus,
   }) async {
     if (!isInitialized) {
       throw const SoLoudNotInitializedException();
@@ -1241,6 +1335,7 @@ interface class SoLoud {
       paused: paused,
       looping: looping,
       loopingStartAt: loopingStartAt,
+      bus: _busHandle(bus),
     );
     _logPlayerError(ret.error, from: 'play()');
     if (!(ret.error == PlayerErrors.noError ||
@@ -1518,17 +1613,10 @@ interface class SoLoud {
   ///
   /// Throws [SoLoudNotInitializedException] if the engine is not initialized.
   ///
-  /// **Note**: when seeking an MP3 file loaded using [LoadMode.disk], the
-  /// seek operation is performed but there will be a delay. This occurs because
-  /// the MP3 codec must compute each frame length to gain a new position.
-  /// The problem is explained in `souloud_wavstream.cpp`,
-  /// in the `WavStreamInstance::seek` function.
-  ///
-  /// Therefore, [LoadMode.disk] is useful for things like the background music,
-  /// and not for things like a music player where the user
-  /// expects being able to seek anywhere inside a playing track immediately.
-  /// If you need to seek MP3s without lags, please, use
-  /// [LoadMode.memory] instead, or use other supported audio formats.
+  /// **Note**: MP3 files loaded using [LoadMode.disk] or
+  /// [LoadMode.memoryCompressed] are indexed when they are loaded. Loading
+  /// reads the whole file once, and then seeking only decodes a few frames
+  /// from the closest index point, wherever it is in the track.
   void seek(SoundHandle handle, Duration time) {
     if (!isInitialized) {
       throw const SoLoudNotInitializedException();
@@ -1749,12 +1837,21 @@ interface class SoLoud {
   ///  *  [setMaxActiveVoiceCount] sets the current maximum active voice count.
   ///  *  [getActiveVoiceCount] concurrent sounds that are playing.
   ///  *  [getVoiceCount] the number of voices currently playing.
-  /// specific audio source.
+  ///
+  /// Throws [SoLoudNotInitializedException] if the engine is not initialized.
+  /// Throws [SoLoudCppException] if the audio data of [audioSource] is
+  /// shared with other sounds, see [setContentDeduplicationEnabled].
   int countAudioSource(AudioSource audioSource) {
     if (!isInitialized) {
       throw const SoLoudNotInitializedException();
     }
-    return _controller.soLoudFFI.countAudioSource(audioSource.soundHash);
+    final count =
+        _controller.soLoudFFI.countAudioSource(audioSource.soundHash);
+    if (count < 0) {
+      _log.severe(() => 'countAudioSource(): the audio data is shared');
+      throw SoLoudCppException.fromPlayerError(PlayerErrors.invalidParameter);
+    }
+    return count;
   }
 
   /// Returns the number of voices the application has told SoLoud to play.
@@ -1903,6 +2000,147 @@ interface class SoLoud {
     _controller.soLoudFFI.setMaxActiveVoiceCount(maxVoiceCount);
   }
 
+  /// Set the number of worker threads that render the playing voices
+  /// along with the audio thread. The default is 0, which renders every
+  /// voice on the audio thread.
+  ///
+  /// With many concurrent voices, spreading their decoding, filtering and
+  /// resampling over more cores reduces the time spent in each audio
+  /// callback. Only the voices of sounds loaded with [loadFile],
+  /// [loadAsset], [loadMem] or [loadWaveform] are rendered by the workers,
+  /// while buffer streams and buses are always rendered on the audio thread.
+  /// Voices are still summed in the same order, so the output doesn't change
+  /// with the thread count.
+  ///
+  /// [threadCount] the number of workers, up to 64. A good value is
+  /// the number of cores minus one.
+  ///
+  /// Throws [SoLoudNotInitializedException] if the engine is not initialized.
+  /// Throws [SoLoudCppException] if [threadCount] is invalid or on the web,
+  /// where threads are not supported.
+  void setMixThreadCount(int threadCount) {
+    if (!isInitialized) {
+      throw const SoLoudNotInitializedException();
+    }
+    final error = _controller.soLoudFFI.setMixThreadCount(threadCount);
+    if (error != PlayerErrors.noError) {
+      _log.severe(() => 'setMixThreadCount(): $error');
+      throw SoLoudCppException.fromPlayerError(error);
+    }
+  }
+
+  /// Decode [sound] ahead of its voices on a background thread, instead of
+  /// reading the file in the audio callback. The default is
+  /// [Duration.zero], which decodes on the audio thread.
+  ///
+  /// A slow storage, for example while another app writes to it, then no
+  /// longer makes the voices crackle as long as it catches up within
+  /// [readAhead]. When it doesn't, the voice plays silence and
+  /// [getPrefetchUnderrunCount] is incremented.
+  ///
+  /// Only the voices started after this call are prefetched. Each of them
+  /// keeps [readAhead] of decoded audio in memory.
+  /// A seek is done by the background thread too: the voice plays silence
+  /// until the audio at the new position is decoded.
+  ///
+  /// [sound] a sound loaded with [LoadMode.disk].
+  ///
+  /// Throws [SoLoudNotInitializedException] if the engine is not initialized.
+  /// Throws [SoLoudCppException] if [sound] is not loaded with
+  /// [LoadMode.disk], if its audio data is shared with other sounds (see
+  /// [setContentDeduplicationEnabled]), or on the web, where threads are not
+  /// supported.
+  void setPrefetch(AudioSource sound, Duration readAhead) {
+    if (!isInitialized) {
+      throw const SoLoudNotInitializedException();
+    }
+    final error = _controller.soLoudFFI
+        .setPrefetch(sound.soundHash, readAhead.inMilliseconds);
+    if (error != PlayerErrors.noError) {
+      _log.severe(() => 'setPrefetch(): $error');
+      throw SoLoudCppException.fromPlayerError(error);
+    }
+  }
+
+  /// Get the number of times a voice prefetched with [setPrefetch] played
+  /// silence because its audio was not decoded in time. The count only
+  /// grows, compare two readings to check a period of time.
+  int getPrefetchUnderrunCount() {
+    if (!isInitialized) {
+      return 0;
+    }
+    return _controller.soLoudFFI.getPrefetchUnderrunCount();
+  }
+
+  /// Share the audio data of the sounds loaded from the same bytes under
+  /// different names. The default is `false`.
+  ///
+  /// When enabled, [loadFile], [loadAsset], [loadUrl] and [loadMem] hash the
+  /// loaded bytes. If a sound with the same content has already been loaded
+  /// with the same [LoadMode], the new sound is not decoded again: it gets its
+  /// own [AudioSource] and handles, but uses the same audio data, which is
+  /// freed when the last of them is disposed.
+  ///
+  /// Only the sounds loaded while it is enabled are deduplicated. The sounds
+  /// sharing their audio data can't have filters: adding one throws
+  /// [SoLoudCppException]. [setPrefetch] and [countAudioSource] throw it too.
+  /// A sound with filters or prefetched is never shared.
+  ///
+  /// Throws [SoLoudNotInitializedException] if the engine is not initialized.
+  void setContentDeduplicationEnabled(bool enabled) {
+    if (!isInitialized) {
+      throw const SoLoudNotInitializedException();
+    }
+    _controller.soLoudFFI.setContentDeduplicationEnabled(enabled);
+  }
+
+  /// Whether the sounds loaded from the same bytes share their audio data.
+  /// See [setContentDeduplicationEnabled].
+  bool getContentDeduplicationEnabled() {
+    if (!isInitialized) {
+      return false;
+    }
+    return _controller.soLoudFFI.getContentDeduplicationEnabled();
+  }
+
+  /// Enable or disable the performance counters of the engine. The default
+  /// is `false`.
+  ///
+  /// When enabled, the engine times each call of the audio callback, the
+  /// resampling of the voices and the filters, which costs a few clock reads
+  /// per voice and per buffer. Read the counters with [getPerfSnapshot].
+  ///
+  /// Throws [SoLoudNotInitializedException] if the engine is not initialized.
+  void setPerfCountersEnabled(bool enabled) {
+    if (!isInitialized) {
+      throw const SoLoudNotInitializedException();
+    }
+    _controller.soLoudFFI.setPerfCountersEnabled(enabled);
+  }
+
+  /// Read the performance counters of the engine, see
+  /// [setPerfCountersEnabled]. Cheap enough to be called every frame.
+  ///
+  /// Returns null on the web, where they are not available yet.
+  ///
+  /// Throws [SoLoudNotInitializedException] if the engine is not initialized.
+  PerfSnapshot? getPerfSnapshot() {
+    if (!isInitialized) {
+      throw const SoLoudNotInitializedException();
+    }
+    return _controller.soLoudFFI.getPerfSnapshot();
+  }
+
+  /// Zero the performance counters of the engine.
+  ///
+  /// Throws [SoLoudNotInitializedException] if the engine is not initialized.
+  void resetPerfCounters() {
+    if (!isInitialized) {
+      throw const SoLoudNotInitializedException();
+    }
+    _controller.soLoudFFI.resetPerfCounters();
+  }
+
   /// Smooth FFT data.
   /// When new data is read and the values are decreasing, the new value
   /// will be decreased with an amplitude between the old and the new value.
@@ -1922,6 +2160,100 @@ interface class SoLoud {
     _controller.soLoudFFI.setFftSmoothing(smooth);
   }
 
+  /// Set the number of points of the FFT used to compute the FFT data
+  /// of [AudioData]. This many of the latest output samples are analyzed and
+  /// the resulting bins are reduced to the 256 FFT values, keeping the
+  /// loudest bin of each group. Larger sizes give more defined peaks at the
+  /// cost of more CPU time and of a slower response to changes.
+  ///
+  /// [fftSize] must be a power of two between 256 and 8192. Default is 512.
+  ///
+  /// Throws [SoLoudNotInitializedException] if the engine is not initialized.
+  /// Throws [SoLoudCppException] if [fftSize] is not valid.
+  void setFftSize(int fftSize) {
+    if (!isInitialized) {
+      throw const SoLoudNotInitializedException();
+    }
+    final error = _controller.soLoudFFI.setFftSize(fftSize);
+    if (error != PlayerErrors.noError) {
+      _log.severe(() => 'setFftSize(): $error');
+      throw SoLoudCppException.fromPlayerError(error);
+    }
+  }
+
+  /// Set the windowing algorithm applied to the wave data before computing
+  /// the FFT data of [AudioData].
+  ///
+  /// [window] the windowing algorithm. Default is [FftWindow.blackman].
+  ///
+  /// Throws [SoLoudNotInitializedException] if the engine is not initialized.
+  void setFftWindow(FftWindow window) {
+    if (!isInitialized) {
+      throw const SoLoudNotInitializedException();
+    }
+    final error = _controller.soLoudFFI.setFftWindow(window);
+    if (error != PlayerErrors.noError) {
+      _log.severe(() => 'setFftWindow(): $error');
+      throw SoLoudCppException.fromPlayerError(error);
+    }
+  }
+
+  // ///////////////////////////////////////
+  //  buses
+  // ///////////////////////////////////////
+
+  /// Create a bus: a submix that the sounds can be played through with the
+  /// `bus` parameter of [play] and [play3d].
+  ///
+  /// The voices playing on a bus are mixed together before the filters of
+  /// the bus, so a filter runs once for all of them. A filter added to a
+  /// sound instead runs once for each of its voices: for example 40
+  /// footsteps playing at the same time with a [FilterType.freeverbFilter]
+  /// would run 40 reverbs, while on a bus with that filter they share one.
+  ///
+  /// The bus is returned as an [AudioSource] which is already playing, and
+  /// whose only handle is in [AudioSource.handles]. It can be used as the
+  /// other sounds:
+  /// ```dart
+  /// final bus = await SoLoud.instance.createBus();
+  /// bus.filters.freeverbFilter.activate();
+  /// bus.filters.freeverbFilter.roomSize(soundHandle: bus.handles.first)
+  ///     .value = 0.8;
+  /// SoLoud.instance.setVolume(bus.handles.first, 0.5);
+  /// await SoLoud.instance.play(footstep, bus: bus);
+  /// ```
+  /// The filter parameters of a bus are set with the handle of the bus.
+  /// [disposeSource] stops the bus and the voices playing on it. The bus
+  /// can't be played with [play], and [seek] doesn't apply to it.
+  ///
+  /// **NOTE**: like the filters of the other sounds, the filters of a bus
+  /// are not available on the Web.
+  ///
+  /// Throws [SoLoudNotInitializedException] if the engine is not initialized.
+  Future<AudioSource> createBus() async {
+    if (!isInitialized) {
+      throw const SoLoudNotInitializedException();
+    }
+    final ret = _controller.soLoudFFI.createBus();
+    _logPlayerError(ret.error, from: 'createBus()');
+    if (ret.error != PlayerErrors.noError) {
+      throw SoLoudCppException.fromPlayerError(ret.error);
+    }
+
+    final newBus = AudioSource(ret.soundHash);
+    newBus.handlesInternal.add(ret.handle);
+    _activeSounds.add(newBus);
+    return newBus;
+  }
+
+  /// The handle to play a sound on [bus], null to play it directly.
+  SoundHandle? _busHandle(AudioSource? bus) {
+    if (bus == null) return null;
+    // A stopped bus has no handle left.
+    if (bus.handles.isEmpty) throw const SoLoudHandleIsNotABusCppException();
+    return bus.handles.first;
+  }
+
   // ///////////////////////////////////////
   //  voice groups
   // ///////////////////////////////////////
@@ -2418,6 +2750,9 @@ interface class SoLoud {
   ///
   /// Throws [SoLoudBufferStreamCanBePlayedOnlyOnceCppException] if we try to
   /// play a BufferStream using `release` buffer type more than once.
+  ///
+  /// Throws [SoLoudHandleIsNotABusCppException] if [bus] is not a bus
+  /// created with [createBus], or if it has been stopped or disposed.
   Future<SoundHandle> play3d(
     AudioSource sound,
     double posX,
@@ -2430,6 +2765,7 @@ interface class SoLoud {
     bool paused = false,
     bool looping = false,
     Duration loopingStartAt = Duration.zero,
+    AudioSource? bus,
   }) async {
     if (!isInitialized) {
       throw const SoLoudNotInitializedException();
@@ -2447,6 +2783,7 @@ interface class SoLoud {
       paused: paused,
       looping: looping,
       loopingStartAt: loopingStartAt,
+      bus: _busHandle(bus),
     );
 
     _logPlayerError(ret.error, from: 'play3d()');
@@ -2598,7 +2935,7 @@ interface class SoLoud {
   /// The returned Float32List is not guaranteed to be [numSamplesNeeded] long.
   /// Each value in the returned Float32List is in the range -1.0 to 1.0 (but
   /// not guaranteed). Their values are the average of audio data from the
-  /// previous index sample if [average] is true.
+  /// previous index sample if [average] is true, or their peak otherwise.
   /// NOTE: this is not available on Web. Use [readSamplesFromMem] instead.
   ///
   /// [completeFileName] the complete path to the audio file.
@@ -2616,6 +2953,20 @@ interface class SoLoud {
   /// average of the samples from the previous index sample. Defaults to false.
   /// When true it does not affect performance much.
   ///
+  /// [threads] the number of threads used to read the samples. The range is
+  /// split in chunks each read by its own decoder, so the result is the same
+  /// for any value. 0 uses all the CPU cores. Defaults to 1. MP3 and the Web
+  /// always use a single thread.
+  ///
+  /// [cacheDir] a directory where peak caches of the audio are stored. When
+  /// the cache of this audio content exists, the samples are read from it
+  /// without decoding, which makes reading the waveform at many zoom levels
+  /// almost free. Ranges with less than 256 audio frames per sample are
+  /// always decoded. Not supported on Web.
+  ///
+  /// [buildCache] if true and [cacheDir] has no cache for this audio yet, the
+  /// whole audio is decoded once to build it.
+  ///
   /// Here a representation of the range [startTime] to [endTime] in the audio
   /// with [numSamplesNeeded]=10:
   ///
@@ -2625,7 +2976,8 @@ interface class SoLoud {
   ///                        average of the samples from 2 to 3 and it is
   ///                        stored in the returned Float32List at index 3.
   ///                      - with [average]=false the value returned at index
-  ///                        3 is the value got at 3.
+  ///                        3 is the peak of the samples from 2 to 3: the one
+  ///                        with the largest magnitude, with its sign.
   ///
   /// Throws [SoLoudReadSamplesNoBackendCppException] if an error occurred
   /// while initializing the backend to read samples.
@@ -2647,18 +2999,25 @@ interface class SoLoud {
     double startTime = 0,
     double endTime = -1,
     bool average = false,
+    int threads = 1,
+    String? cacheDir,
+    bool buildCache = false,
   }) async {
     assert(
       endTime == -1 || endTime > startTime,
       '[endTime] must be greater than [startTime].',
     );
     assert(startTime >= 0, '[startTime] must be greater than or equal to 0.');
+    assert(threads >= 0, '[threads] must be greater than or equal to 0.');
     final samples = await compute(_readSamplesFromFile, {
       'completeFileName': completeFileName,
       'numSamplesNeeded': numSamplesNeeded,
       'startTime': startTime,
       'endTime': endTime,
       'average': average,
+      'threads': threads,
+      'cacheDir': cacheDir,
+      'buildCache': buildCache,
     });
 
     return samples;
@@ -2669,7 +3028,7 @@ interface class SoLoud {
   /// The returned Float32List is not guaranteed to be [numSamplesNeeded] long.
   /// Each value in the returned Float32List is in the range -1.0 to 1.0 (but
   /// not guaranteed). Their values are the average of audio data from the
-  /// previous index sample if [average] is true.
+  /// previous index sample if [average] is true, or their peak otherwise.
   /// NOTE: on Web this is synchronous and could freeze the UI.
   ///
   /// [buffer] the audio file buffer.
@@ -2687,6 +3046,20 @@ interface class SoLoud {
   /// average of the samples from the previous index sample. Defaults to false.
   /// When true it does not affect performance much.
   ///
+  /// [threads] the number of threads used to read the samples. The range is
+  /// split in chunks each read by its own decoder, so the result is the same
+  /// for any value. 0 uses all the CPU cores. Defaults to 1. MP3 and the Web
+  /// always use a single thread.
+  ///
+  /// [cacheDir] a directory where peak caches of the audio are stored. When
+  /// the cache of this audio content exists, the samples are read from it
+  /// without decoding, which makes reading the waveform at many zoom levels
+  /// almost free. Ranges with less than 256 audio frames per sample are
+  /// always decoded. Not supported on Web.
+  ///
+  /// [buildCache] if true and [cacheDir] has no cache for this audio yet, the
+  /// whole audio is decoded once to build it.
+  ///
   /// Here a representation of the range [startTime] to [endTime] in the audio
   /// with [numSamplesNeeded]=10:
   ///
@@ -2696,7 +3069,8 @@ interface class SoLoud {
   ///                        average of the samples from 2 to 3 and it is
   ///                        stored in the returned Float32List at index 3.
   ///                      - with [average]=false the value returned at index
-  ///                        3 is the value got at 3.
+  ///                        3 is the peak of the samples from 2 to 3: the one
+  ///                        with the largest magnitude, with its sign.
   ///
   /// Throws [SoLoudReadSamplesNoBackendCppException] if an error occurred
   /// while initializing the backend to read samples.
@@ -2718,18 +3092,25 @@ interface class SoLoud {
     double startTime = 0,
     double endTime = -1,
     bool average = false,
+    int threads = 1,
+    String? cacheDir,
+    bool buildCache = false,
   }) async {
     assert(
       endTime == -1 || endTime > startTime,
       '[endTime] must be greater than [startTime].',
     );
     assert(startTime >= 0, '[startTime] must be greater than or equal to 0.');
+    assert(threads >= 0, '[threads] must be greater than or equal to 0.');
     final samples = await compute(_readSamplesFromMem, {
       'buffer': buffer,
       'numSamplesNeeded': numSamplesNeeded,
       'startTime': startTime,
       'endTime': endTime,
       'average': average,
+      'threads': threads,
+      'cacheDir': cacheDir,
+      'buildCache': buildCache,
     });
 
     return samples;
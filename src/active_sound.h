@@ -5,6 +5,7 @@
 #include "enums.h"
 #include "soloud.h"
 
+#include <cstdint>
 #include <iostream>
 #include <vector>
 #include <memory>
@@ -24,13 +25,17 @@ struct ActiveHandle
 /// but this can be adjusted at runtime
 struct ActiveSound
 {
-    std::unique_ptr<SoLoud::AudioSource> sound;
+    // shared by the sounds loaded from the same content, see `Player::setContentDedup`
+    std::shared_ptr<SoLoud::AudioSource> sound;
     SoundType soundType;
     std::vector<ActiveHandle> handle;
     std::unique_ptr<Filters> filters;
     // unique identifier of this sound based on the file name
     unsigned int soundHash;
     std::string completeFileName;
+    // hash of the loaded file bytes, 0 when the sound is not deduplicated
+    uint64_t contentHash = 0;
+    LoadMode loadMode = LOAD_MODE_MEMORY;
 };
 
 #endif // ACTIVE_SOUND_H
\ No newline at end of file
@@ -5,10 +5,80 @@
 #include <cstring>
 #include <iostream>
 
+#if defined(SOLOUD_SSE_INTRINSICS)
+#include <emmintrin.h>
+#elif defined(SOLOUD_NEON_INTRINSICS)
+#include <arm_neon.h>
+#endif
+
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
 #endif
 
+namespace
+{
+    /// Polynomial q(m) such that log2(m) ~= (m - 1) * q(m) for m in [1, 2).
+    /// Least squares fit, max error 2.5e-6.
+    const float kLog2C0 = 3.04239512f;
+    const float kLog2C1 = -3.07942978f;
+    const float kLog2C2 = 2.27620456f;
+    const float kLog2C3 = -1.02132333f;
+    const float kLog2C4 = 0.250487346f;
+    const float kLog2C5 = -0.0257989497f;
+
+    /// 2 * log10(x) = log2(x) * 2 * log10(2)
+    const float kTwoLog10Of2 = 0.602059991f;
+
+#if defined(SOLOUD_SSE_INTRINSICS)
+    /// log2 of 4 floats >= 1
+    inline __m128 log2Sse(__m128 x)
+    {
+        __m128i bits = _mm_castps_si128(x);
+        __m128 e = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127)));
+        __m128 m = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007fffff)),
+                                                 _mm_set1_epi32(0x3f800000)));
+        __m128 p = _mm_set1_ps(kLog2C5);
+        p = _mm_add_ps(_mm_mul_ps(p, m), _mm_set1_ps(kLog2C4));
+        p = _mm_add_ps(_mm_mul_ps(p, m), _mm_set1_ps(kLog2C3));
+        p = _mm_add_ps(_mm_mul_ps(p, m), _mm_set1_ps(kLog2C2));
+        p = _mm_add_ps(_mm_mul_ps(p, m), _mm_set1_ps(kLog2C1));
+        p = _mm_add_ps(_mm_mul_ps(p, m), _mm_set1_ps(kLog2C0));
+        return _mm_add_ps(e, _mm_mul_ps(p, _mm_sub_ps(m, _mm_set1_ps(1.0f))));
+    }
+#elif defined(SOLOUD_NEON_INTRINSICS)
+    /// log2 of 4 floats >= 1
+    inline float32x4_t log2Neon(float32x4_t x)
+    {
+        int32x4_t bits = vreinterpretq_s32_f32(x);
+        float32x4_t e = vcvtq_f32_s32(vsubq_s32(vshrq_n_s32(bits, 23), vdupq_n_s32(127)));
+        float32x4_t m = vreinterpretq_f32_s32(vorrq_s32(vandq_s32(bits, vdupq_n_s32(0x007fffff)),
+                                                        vdupq_n_s32(0x3f800000)));
+        float32x4_t p = vdupq_n_f32(kLog2C5);
+        p = vmlaq_f32(vdupq_n_f32(kLog2C4), p, m);
+        p = vmlaq_f32(vdupq_n_f32(kLog2C3), p, m);
+        p = vmlaq_f32(vdupq_n_f32(kLog2C2), p, m);
+        p = vmlaq_f32(vdupq_n_f32(kLog2C1), p, m);
+        p = vmlaq_f32(vdupq_n_f32(kLog2C0), p, m);
+        return vmlaq_f32(e, p, vsubq_f32(m, vdupq_n_f32(1.0f)));
+    }
+
+    /// sqrt of 4 floats >= 0
+    inline float32x4_t sqrtNeon(float32x4_t x)
+    {
+#if defined(__aarch64__) || defined(_M_ARM64)
+        return vsqrtq_f32(x);
+#else
+        // Reciprocal square root estimate refined twice. 0 stays 0.
+        float32x4_t r = vrsqrteq_f32(x);
+        r = vmulq_f32(r, vrsqrtsq_f32(vmulq_f32(x, r), r));
+        r = vmulq_f32(r, vrsqrtsq_f32(vmulq_f32(x, r), r));
+        float32x4_t s = vmulq_f32(x, r);
+        return vbslq_f32(vceqq_f32(x, vdupq_n_f32(0.0f)), x, s);
+#endif
+    }
+#endif
+}
+
 Analyzer::Analyzer(int windowSize, float sampleRate)
     : mWindowSize(windowSize),
       sampleRate(sampleRate),
@@ -18,61 +88,82 @@ Analyzer::Analyzer(int windowSize, float sampleRate)
       a2(0.5f * alpha),
       fftSmoothing(0.8)
 {
+    mFftSize = 512;
+    mWindowType = FFT_WINDOW_BLACKMAN;
     for (float &i : FFTData)
         i = 0.0f;
-    for (float &i : temp)
-        i = 0.0f;
+    temp.assign(mFftSize * 2, 0.0f);
+    for (int i = 0; i < 256; i++)
+    {
+        mMagnitude2[i] = 0.0f;
+        mLevel[i] = 0.0f;
+    }
+    updateWindow();
 }
 
 Analyzer::~Analyzer() = default;
 
+int Analyzer::windowLength() const
+{
+    return mWindowSize > mFftSize ? mWindowSize : mFftSize;
+}
+
 /// Blackman windowing
 /// used by ShaderToy
-void Analyzer::blackmanWindow(float *samples, const float *waveData) const {
-    memset(samples + 512, 0, 512 * sizeof(float));
-    for (int i = 0; i < 256; i++) {
-        float multiplier = a0 - a1 * cosf(2 * M_PI * i / mWindowSize) + a2 * cosf(4 * M_PI * i / mWindowSize);
-        samples[i*2] = waveData[i] * multiplier;
-        samples[i*2+1] = 0;
-    }
+float Analyzer::blackmanWindow(int i) const {
+    return a0 - a1 * cosf(2 * M_PI * i / windowLength()) + a2 * cosf(4 * M_PI * i / windowLength());
 }
 
 /// Hann windowing
-void Analyzer::hanningWindow(float *samples, const float *waveData) const
+float Analyzer::hanningWindow(int i) const
 {
-    memset(samples + 512, 0, 512 * sizeof(float));
-    for (int i = 0; i < 256; i++)
-    {
-        samples[i * 2] = waveData[i] * 0.5f * (1.0f - cosf(2.0f * M_PI * (float)(i) / (float)(mWindowSize - 1)));
-        samples[i * 2 + 1] = 0.0f;
-    }
+    return 0.5f * (1.0f - cosf(2.0f * M_PI * (float)(i) / (float)(windowLength() - 1)));
 }
 
 /// Hamming windowing
-void Analyzer::hammingWindow(float *samples, const float *waveData) const
+float Analyzer::hammingWindow(int i) const
 {
-    memset(samples + 512, 0, 512 * sizeof(float));
-    for (int i = 0; i < 256; i++)
-    {
-        samples[i * 2] = waveData[i] * (0.54f - 0.46f * cosf(2.0f * M_PI * i / (mWindowSize - 1)));
-        samples[i * 2 + 1] = 0.0f;
-    }
+    return 0.54f - 0.46f * cosf(2.0f * M_PI * i / (windowLength() - 1));
 }
 
 /// Gaussian windowing
-void Analyzer::gaussWindow(float *samples, const float *waveData) const
+float Analyzer::gaussWindow(int i) const
 {
     const float sigma = 0.4f;  // Standard deviation (adjustable, typical values between 0.3 and 0.5)
-    const float N = mWindowSize - 1;
-    
-    memset(samples + 512, 0, 512 * sizeof(float));
-    for (int i = 0; i < 256; i++)
+    const float N = windowLength() - 1;
+
+    float n = i - N/2;  // Center the Gaussian
+    return expf(-0.5f * powf((n / (sigma * N/2)), 2));
+}
+
+void Analyzer::updateWindow()
+{
+    // https://en.wikipedia.org/wiki/Window_function
+    mWindow.resize(mFftSize);
+    for (int i = 0; i < mFftSize; i++)
     {
-        float n = i - N/2;  // Center the Gaussian
-        float gaussian = expf(-0.5f * powf((n / (sigma * N/2)), 2));
-        samples[i * 2] = waveData[i] * gaussian;
-        samples[i * 2 + 1] = 0.0f;
+        switch (mWindowType)
+        {
+        case FFT_WINDOW_HANN:
+            mWindow[i] = hanningWindow(i);
+            break;
+        case FFT_WINDOW_HAMMING:
+            mWindow[i] = hammingWindow(i);
+            break;
+        case FFT_WINDOW_GAUSS:
+            mWindow[i] = gaussWindow(i);
+            break;
+        default:
+            mWindow[i] = blackmanWindow(i);
+            break;
+        }
     }
+
+    // Adjust scaling based on frequency bin and normalize it. The magnitudes
+    // grow with the number of samples analyzed: keep the levels of 256.
+    const float norm = 256.0f / mFftSize;
+    for (int i = 0; i < 256; i++)
+        mScaling[i] = sqrtf((float)(i + 1)) / 2.0f * norm;
 }
 
 int Analyzer::freqToBin(float frequency) const {
@@ -95,6 +186,62 @@ float Analyzer::getBinFrequency(int binIndex) const {
     return binIndex * (sampleRate * 0.5f / 256.0f);
 }
 
+void Analyzer::calcMagnitudes()
+{
+    const float *bins = temp.data();
+    if (mFftSize == 256)
+    {
+        // 128 bins, each one is shown twice
+        for (int i = 0; i < 128; i++)
+        {
+            float real = bins[i * 2];
+            float imag = bins[i * 2 + 1];
+            mMagnitude2[i * 2] = mMagnitude2[i * 2 + 1] = real * real + imag * imag;
+        }
+        return;
+    }
+
+    // Keep the loudest of the bins falling in each output bin
+    const int group = mFftSize / 512;
+    for (int i = 0; i < 256; i++)
+    {
+        float max = 0.0f;
+        for (int k = i * group; k < (i + 1) * group; k++)
+        {
+            float real = bins[k * 2];
+            float imag = bins[k * 2 + 1];
+            float mag2 = real * real + imag * imag;
+            if (mag2 > max)
+                max = mag2;
+        }
+        mMagnitude2[i] = max;
+    }
+}
+
+void Analyzer::calcLevels()
+{
+    // The "+ 1.0" is to make sure I don't get negative values,
+#if defined(SOLOUD_SSE_INTRINSICS)
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 k = _mm_set1_ps(kTwoLog10Of2);
+    for (int i = 0; i < 256; i += 4)
+    {
+        __m128 mag = _mm_mul_ps(_mm_sqrt_ps(_mm_load_ps(mMagnitude2 + i)), _mm_load_ps(mScaling + i));
+        _mm_store_ps(mLevel + i, _mm_mul_ps(log2Sse(_mm_add_ps(mag, one)), k));
+    }
+#elif defined(SOLOUD_NEON_INTRINSICS)
+    const float32x4_t one = vdupq_n_f32(1.0f);
+    for (int i = 0; i < 256; i += 4)
+    {
+        float32x4_t mag = vmulq_f32(sqrtNeon(vld1q_f32(mMagnitude2 + i)), vld1q_f32(mScaling + i));
+        vst1q_f32(mLevel + i, vmulq_n_f32(log2Neon(vaddq_f32(mag, one)), kTwoLog10Of2));
+    }
+#else
+    for (int i = 0; i < 256; i++)
+        mLevel[i] = 2.f * log10f(sqrtf(mMagnitude2[i]) * mScaling[i] + 1.0f);
+#endif
+}
+
 float* Analyzer::calcFFT(float* waveData, float minFrequency, float maxFrequency)
 {
     if (waveData == nullptr)
@@ -102,40 +249,29 @@ float* Analyzer::calcFFT(float* waveData, float minFrequency, float maxFrequency
         return nullptr;
     }
 
-    // https://en.wikipedia.org/wiki/Window_function
-    blackmanWindow(temp, waveData);
-    // hanningWindow(temp, waveData);
-    // hammingWindow(temp, waveData);
-    // gaussWindow(temp, waveData);
-
-    SoLoud::FFT::fft1024(temp);
-
-    float real = temp[255 * 2];
-    float imag = temp[255 * 2 + 1];
-    float mag = sqrtf(real*real+imag*imag);
-    // Apply frequency-dependent scaling
-    float freqScaling = sqrtf(255.f + 1.f);  // Adjust scaling based on frequency bin
-    mag *= freqScaling / 2.0f;  // Normalize the scaling
-    // The "+ 1.0" is to make sure I don't get negative values,
-    float t = 2.f * log10f(mag+1.0f);
-    FFTData[255] = t;
+    // Windowed wave data as the real part
+    float *samples = temp.data();
+    for (int i = 0; i < mFftSize; i++)
+    {
+        samples[i * 2] = waveData[i] * mWindow[i];
+        samples[i * 2 + 1] = 0.0f;
+    }
+
+    SoLoud::FFT::fft(samples, mFftSize * 2);
+
+    calcMagnitudes();
+    calcLevels();
+
+    FFTData[255] = mLevel[255];
 
     for (int i = 254; i >= 0; i--)
     {
-        float real = temp[i * 2];
-        float imag = temp[i * 2 + 1];
-        if (real == 0 && imag == 0) {
+        if (mMagnitude2[i] == 0) {
             FFTData[i] = 0.0f;
             continue;
         }
-        float mag = sqrtf(real*real+imag*imag);
-
-        // Apply frequency-dependent scaling
-        float freqScaling = sqrtf((float)(i + 1));  // Adjust scaling based on frequency bin
-        mag *= freqScaling / 2.0f;  // Normalize the scaling
 
-        // The "+ 1.0" is to make sure I don't get negative values,
-        float t = 2.f * log10f(mag+1.0f) - FFTData[255];
+        float t = mLevel[i] - FFTData[255];
 
         if (t > 1.0f) t = 1.0f;
         else if (t < 0.001f) t = 0.0f;
@@ -154,6 +290,7 @@ float* Analyzer::calcFFT(float* waveData, float minFrequency, float maxFrequency
 void Analyzer::setWindowsSize(int fftWindowSize)
 {
     mWindowSize = fftWindowSize;
+    updateWindow();
 }
 
 void Analyzer::setSmoothing(float smooth)
@@ -161,4 +298,23 @@ void Analyzer::setSmoothing(float smooth)
     if (smooth < 0.0f || smooth > 1.0f)
         return;
     fftSmoothing = smooth;
-}
\ No newline at end of file
+}
+
+bool Analyzer::setFftSize(int fftSize)
+{
+    if (fftSize < 256 || fftSize > 8192 || (fftSize & (fftSize - 1)) != 0)
+        return false;
+    mFftSize = fftSize;
+    temp.assign(mFftSize * 2, 0.0f);
+    updateWindow();
+    return true;
+}
+
+bool Analyzer::setFftWindow(FftWindow window)
+{
+    if (window < FFT_WINDOW_BLACKMAN || window > FFT_WINDOW_GAUSS)
+        return false;
+    mWindowType = window;
+    updateWindow();
+    return true;
+}
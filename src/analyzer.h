@@ -2,6 +2,9 @@
 #define ANALYZER_H
 
 #include "common.h"
+#include "enums.h"
+
+#include <vector>
 
 class Analyzer {
 public:
@@ -10,24 +13,66 @@ public:
     ~Analyzer();
 
     // float *calcFFT(float *waveData);
+    /// @param waveData the latest [getFftSize] wave samples, oldest first.
     float *calcFFT(float *waveData, float minFrequency = 20.0f, float maxFrequency = 16000.0f);
     void setWindowsSize(int fftWindowSize);
     void setSmoothing(float smooth);
 
+    /// @brief set the number of points of the FFT.
+    /// @param fftSize a power of two between 256 and 8192. This many wave
+    /// samples are analyzed and the resulting bins are reduced (or expanded)
+    /// to the 256 FFT values returned by [calcFFT].
+    /// @return false if [fftSize] is not valid.
+    bool setFftSize(int fftSize);
+
+    /// @brief the number of wave samples [calcFFT] needs.
+    int getFftSize() const { return mFftSize; }
+
+    /// @brief set the windowing algorithm applied to the wave data.
+    /// @return false if [window] is not valid.
+    bool setFftWindow(FftWindow window);
+
 private:
+    /// @brief compute the coefficients of the current window type and size
+    /// for the [mFftSize] wave samples, and the scaling of the output bins.
+    void updateWindow();
+
+    /// @brief the window size, widened to the [mFftSize] samples analyzed.
+    int windowLength() const;
+
     /// @brief elaborate FFT data with the Blackman windowing algorithm
-    void blackmanWindow(float *samples, const float *waveData) const;
+    float blackmanWindow(int i) const;
 
     /// @brief elaborate FFT data with the hanning windowing algorithm
-    void hanningWindow(float* samples, const float *waveData) const;
+    float hanningWindow(int i) const;
 
     /// @brief elaborate FFT data with the hamm windowing algorithm
-    void hammingWindow(float* samples, const float *waveData) const;
+    float hammingWindow(int i) const;
 
-    void gaussWindow(float *samples, const float *waveData) const;
+    float gaussWindow(int i) const;
 
-    /// array used by filling it with audio samples and calculate FFT
-    float temp[1024];  // Needs to be 1024 for fft1024
+    /// @brief compute the squared magnitudes of the 256 output bins
+    /// from the FFT of [temp].
+    void calcMagnitudes();
+
+    /// @brief compute 2*log10(sqrt(mag2) * scale + 1) of the 256 output bins.
+    void calcLevels();
+
+    /// array used by filling it with audio samples and calculate FFT.
+    /// Holds [mFftSize] complex values.
+    std::vector<float> temp;
+
+    /// number of points of the FFT.
+    int mFftSize;
+
+    /// windowing algorithm and its precomputed [mFftSize] coefficients.
+    FftWindow mWindowType;
+    std::vector<float> mWindow;
+
+    /// squared magnitude, frequency scaling and level of each output bin.
+    alignas(16) float mMagnitude2[256];
+    alignas(16) float mScaling[256];
+    alignas(16) float mLevel[256];
 
     /// contains latest calulated FFT
     float FFTData[256];
@@ -49,7 +94,7 @@ private:
     float maxFreq;    // Maximum frequency to analyze
     int minBin;       // Minimum FFT bin corresponding to minFreq
     int maxBin;       // Maximum FFT bin corresponding to maxFreq
-    
+
     int freqToBin(float frequency) const;
     int mapFrequencyToFFTDataIndex(float freq) const;
     float mapFFTDataIndexToFrequency(int index) const;
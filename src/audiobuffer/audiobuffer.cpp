@@ -22,7 +22,6 @@
 
 namespace SoLoud
 {
-	std::mutex buffer_lock_mutex;
 	std::mutex check_buffer_mutex;
 
 	BufferStreamInstance::BufferStreamInstance(BufferStream *aParent)
@@ -38,7 +37,8 @@ namespace SoLoud
 
 	unsigned int BufferStreamInstance::getAudio(float *aBuffer, unsigned int aSamplesToRead, unsigned int aBufferSize)
 	{
-		std::lock_guard<std::mutex> lock(buffer_lock_mutex);
+		// No locks here: [mBuffer] is a single-producer/single-consumer ring buffer and this is its
+		// only consumer. The producer swaps its storage or clears it only while holding the audio mutex.
 
 		// When using BufferType::AUTO, samplerate and channels are got from the stream. Hence we need to update them
 		// regardless of how are set by setBufferStream. But these parameters need to be set after the play
@@ -53,6 +53,8 @@ namespace SoLoud
 		// This happens when using RELEASED buffer type
 		if (mParent->mBuffer.getFloatsBufferSize() == 0)
 		{
+			if (!mParent->dataIsEnded)
+				mParent->mThePlayer->soloud.mPerf.countStreamUnderrun();
 			memset(aBuffer, 0, sizeof(float) * aSamplesToRead);
 			// Calculate mStreamPosition based on mOffset
 			mStreamPosition = mOffset / (float)(mBaseSamplerate * mChannels);
@@ -70,8 +72,11 @@ namespace SoLoud
 		}
 
 		unsigned int bufferSize = mParent->mBuffer.getFloatsBufferSize();
-		float *buffer = reinterpret_cast<float *>(mParent->mBuffer.buffer.data());
-		int samplesToRead = mOffset + aSamplesToRead > bufferSize ? bufferSize - mOffset : aSamplesToRead;
+		int framesAvailable = mOffset < bufferSize ? (bufferSize - mOffset) / mChannels : 0;
+		int samplesToRead = framesAvailable < (int)aSamplesToRead ? framesAvailable : aSamplesToRead;
+		// The data being received is late.
+		if (samplesToRead < (int)aSamplesToRead && !mParent->dataIsEnded)
+			mParent->mThePlayer->soloud.mPerf.countStreamUnderrun();
 		if (samplesToRead <= 0)
 		{
 			memset(aBuffer, 0, sizeof(float) * aSamplesToRead);
@@ -90,30 +95,11 @@ namespace SoLoud
 			return 0;
 		}
 
-		if (samplesToRead != aSamplesToRead)
-		{
-			memset(aBuffer, 0, sizeof(float) * aSamplesToRead);
-		}
-
-		if (mChannels == 1)
-		{
-			// Optimization: if we have a mono audio source, we can just copy all the data in one go.
-			memcpy(aBuffer, buffer + mOffset, sizeof(float) * samplesToRead);
-		}
-		else
-		{
-			// From SoLoud documentation:
-			// So, if 1024 samples are requested from a stereo audio source, the first 1024 floats
-			// should be for the first channel, and the next 1024 samples should be for the second channel.
-			unsigned int i, j;
-			for (j = 0; j < mChannels; j++)
-			{
-				for (i = 0; i < samplesToRead; i++)
-				{
-					aBuffer[j * samplesToRead + i] = buffer[mOffset + i * mChannels + j];
-				}
-			}
-		}
+		// From SoLoud documentation:
+		// So, if 1024 samples are requested from a stereo audio source, the first 1024 floats
+		// should be for the first channel, and the next 1024 samples should be for the second channel.
+		// The channels are [aBufferSize] apart and SoLoud zeroes what is not read.
+		mParent->mBuffer.readFrames(aBuffer, mOffset, samplesToRead, mChannels, aBufferSize);
 
 		unsigned int totalBytesRead = samplesToRead * mChannels * sizeof(float);
 		size_t samplesRemoved = mParent->mBuffer.removeData(totalBytesRead);
@@ -280,12 +266,14 @@ namespace SoLoud
 
 	void BufferStream::resetBuffer()
 	{
-		std::lock_guard<std::mutex> lock(buffer_lock_mutex);
+		// The audio thread must not read [mBuffer] while it is cleared.
+		mThePlayer->soloud.lockAudioMutex_internal();
 		buffer.clear();
 		mBuffer.clear();
 		mSampleCount = 0;
 		mBytesReceived = 0;
 		mUncompressedBytesReceived = 0;
+		mThePlayer->soloud.unlockAudioMutex_internal();
 
 		for (int i = 0; i < mParent->handle.size(); i++)
 		{
@@ -365,13 +353,17 @@ namespace SoLoud
 			// Ogg Opus will decode to the sampleRate and channels of the current engine settings and
 			// the AudioSource will be set to use them.
 			// For the mp3 this AudioSource will impose the mp3 settings (the engine will convert to its settings).
-			auto [decoded, error] = streamDecoder->decode(buffer, &sampleRate, &channels,
+			// [mDecoded] keeps its capacity, so decoding doesn't allocate once warmed up.
+			std::vector<float> &decoded = mDecoded;
+			decoded.clear();
+			DecoderError error = streamDecoder->decode(buffer, &sampleRate, &channels,
 					[&](AudioMetadata meta)
 					{
 					//   meta.debug();
 						if (this->mOnMetadataCallback != nullptr)
 							this->callOnMetadataCallback(meta);
-					});
+					},
+					decoded);
 
 			// Handle decoder errors
 			switch (error)
@@ -406,6 +398,7 @@ namespace SoLoud
 					}
 				}
 
+				growBuffer(decoded.size());
 				bytesWritten = mBuffer.addData(
 								   BufferType::PCM_F32LE,
 								   decoded.data(),
@@ -422,6 +415,7 @@ namespace SoLoud
 		else
 		{
 			// PCM data
+			growBuffer(bufferDataToAdd / mPCMformat.bytesPerSample);
 			bytesWritten = mBuffer.addData(
 							   mPCMformat.dataType,
 							   buffer.data(),
@@ -452,6 +446,20 @@ namespace SoLoud
 		return PlayerErrors::noError;
 	}
 
+	void BufferStream::growBuffer(size_t numSamples)
+	{
+		if (!mBuffer.needsToGrow(numSamples))
+			return;
+		// Allocate and copy without the audio mutex, then hold it only to swap the
+		// storage so the audio thread can't read meanwhile. The old one is freed after.
+		Buffer::Storage storage = mBuffer.makeGrownStorage(numSamples);
+		if (!storage.data)
+			return;
+		mThePlayer->soloud.lockAudioMutex_internal();
+		mBuffer.swapStorage(storage);
+		mThePlayer->soloud.unlockAudioMutex_internal();
+	}
+
 	/// Check if some handles was paused for buffering and unpause them or restart them
 	/// if needed after adding [afterAddingBytesCount] bytes.
 	void BufferStream::checkBuffering(unsigned int afterAddingBytesCount)
@@ -80,6 +80,8 @@ namespace SoLoud
     void setDataIsEnded();
     void setBufferIcyMetaInt(int icyMetaInt);
     PlayerErrors addData(const void *aData, unsigned int numSamples, bool forceAdd = false);
+    // Make room in [mBuffer] to add [numSamples] float samples.
+    void growBuffer(size_t numSamples);
     void checkBuffering(unsigned int afterAddingBytesCount);
     void callOnMetadataCallback(AudioMetadata &metadata);
     void callOnBufferingCallback(bool isBuffering, unsigned int handle, double time);
@@ -90,6 +92,8 @@ namespace SoLoud
     AudioMetadataFFI convertMetadataToFFI(const AudioMetadata& metadata);
 
     std::vector<unsigned char> buffer;
+    // Decoded frames of the last [addData] call, reused to not allocate at every call.
+    std::vector<float> mDecoded;
   };
 };
 
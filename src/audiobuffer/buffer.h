@@ -6,7 +6,16 @@
 #include <algorithm>
 #include <iostream>
 #include <cstring>
-#include <mutex>
+#include <atomic>
+#include <memory>
+#include "soloud.h"
+
+#if defined(SOLOUD_SSE_INTRINSICS)
+#include <emmintrin.h>
+#elif !defined(DISABLE_SIMD) && (defined(__ARM_NEON) || defined(__aarch64__) || defined(_M_ARM64))
+#include <arm_neon.h>
+#define BUFFER_NEON_INTRINSICS
+#endif
 
 enum BufferingType
 {
@@ -14,19 +23,44 @@ enum BufferingType
     RELEASED
 };
 
+/// Single-producer/single-consumer ring buffer of float samples.
+///
+/// The producer is `BufferStream::addData` (Dart thread), the consumer is
+/// `BufferStreamInstance::getAudio` (audio thread). Reading and releasing data
+/// don't lock and don't move memory: the producer only advances [mWriteCount]
+/// and the consumer only advances [mReadCount].
+///
+/// The storage capacity is at most [maxBytes]. It is not allocated all at once,
+/// but it grows geometrically when the producer needs more room. The producer
+/// copies the data to the new storage with [makeGrownStorage] while the
+/// consumer keeps reading the old one, then [swapStorage] switches them when
+/// the consumer is not reading, that is while holding the SoLoud audio mutex
+/// (see `BufferStream::growBuffer`).
+///
+/// With `PRESERVED` buffering the data is never released and the buffer is
+/// filled linearly up to [maxBytes]. With `RELEASED` buffering the data read
+/// is released and its room is reused by the next writes.
 class Buffer
 {
 public:
-    std::vector<int8_t> buffer; // Buffer that stores int8_t data
     BufferingType bufferingType;
 
 private:
     size_t maxBytes; // Maximum capacity in bytes
-    std::mutex bufferMutex; // Add mutex for thread safety
+    std::unique_ptr<float[]> mData; // Ring storage
+    size_t mCapacity; // Current storage capacity in floats
+    std::atomic<uint64_t> mWriteCount; // Total floats written
+    std::atomic<uint64_t> mReadCount; // Total floats released
+
+    // The initial capacity in floats allocated when the first data is added.
+    static constexpr size_t kMinCapacity = 64 * 1024;
 
 public:
-    // Constructor that accepts the maxBytes parameter
-    Buffer() : bufferingType(BufferingType::PRESERVED), maxBytes(0) {}
+    Buffer() : bufferingType(BufferingType::PRESERVED),
+               maxBytes(0),
+               mCapacity(0),
+               mWriteCount(0),
+               mReadCount(0) {}
 
     ~Buffer()
     {
@@ -42,8 +76,87 @@ public:
         bufferingType = type;
     }
 
+    // Return the number of floats that will be written by adding
+    // [numSamples] samples, without exceeding [maxBytes].
+    size_t getFloatsToWrite(size_t numSamples)
+    {
+        size_t used = getFloatsBufferSize();
+        size_t maxFloats = maxBytes / sizeof(float);
+        if (used >= maxFloats)
+            return 0;
+        return std::min(numSamples, maxFloats - used);
+    }
+
+    // Return true if the storage must [grow] before adding [numSamples] samples.
+    bool needsToGrow(size_t numSamples)
+    {
+        size_t toWrite = getFloatsToWrite(numSamples);
+        return getFloatsBufferSize() + toWrite > mCapacity;
+    }
+
+    // A storage and its capacity in floats, see [makeGrownStorage].
+    struct Storage
+    {
+        std::unique_ptr<float[]> data;
+        size_t capacity = 0;
+    };
+
+    // Return a larger storage with room for [numSamples] more samples,
+    // holding a copy of the data not yet released, or an empty one if the
+    // current storage is large enough. Called by the producer: the consumer
+    // can keep reading and releasing meanwhile, it doesn't change the data.
+    Storage makeGrownStorage(size_t numSamples)
+    {
+        Storage storage;
+        // The data before [read] may be released meanwhile, the data after
+        // [read + used] is not written until the producer adds it.
+        uint64_t read = mReadCount.load(std::memory_order_acquire);
+        size_t used = (size_t)(mWriteCount.load(std::memory_order_relaxed) - read);
+        size_t needed = used + getFloatsToWrite(numSamples);
+        if (needed <= mCapacity)
+            return storage;
+        size_t newCapacity = std::max(kMinCapacity, mCapacity * 2);
+        newCapacity = std::max(newCapacity, needed);
+        newCapacity = std::min(newCapacity, maxBytes / sizeof(float));
+
+        // Uninitialized storage: the OS commits the pages only when written.
+        storage.data.reset(new float[newCapacity]);
+        storage.capacity = newCapacity;
+        // Keep the invariant: the float number `n` is stored at `n % capacity`.
+        for (uint64_t n = read; n < read + used;)
+        {
+            size_t src = n % mCapacity;
+            size_t dst = n % newCapacity;
+            size_t count = std::min<uint64_t>(read + used - n,
+                                              std::min(mCapacity - src, newCapacity - dst));
+            memcpy(storage.data.get() + dst, mData.get() + src, count * sizeof(float));
+            n += count;
+        }
+        return storage;
+    }
+
+    // Replace the storage with [storage], got from [makeGrownStorage] with
+    // no data added since, and give back the old one in [storage] to be
+    // freed. Only swaps pointers. The consumer must not read while this is
+    // running.
+    void swapStorage(Storage &storage)
+    {
+        std::swap(mData, storage.data);
+        std::swap(mCapacity, storage.capacity);
+    }
+
+    // Reallocate the storage to have room for [numSamples] more samples.
+    // The consumer must not read while this is running.
+    void grow(size_t numSamples)
+    {
+        Storage storage = makeGrownStorage(numSamples);
+        if (storage.data)
+            swapStorage(storage);
+    }
+
     // Return the number of data written. Should be the same as numSamples else
     // the buffer reached the [maxBytes] meaning the buffer is full.
+    // The samples are converted to float straight into the storage.
     size_t addData(const BufferType format, const void* data, size_t numSamples, bool *allDataAdded) {
         *allDataAdded = false;
         switch (format)
@@ -58,37 +171,25 @@ public:
             case BufferType::PCM_S8:
             {
                 const int8_t* data8 = reinterpret_cast<const int8_t*>(data);
-                float* d = new float[numSamples];
-                for (size_t i = 0; i < numSamples; ++i) {
-                    d[i] = data8[i] / 128.0f;
-                }
-                size_t ret = addData(d, numSamples, allDataAdded);
-                delete[] d;
-                return ret;
+                return write(numSamples, allDataAdded, [data8](float *dst, size_t from, size_t count) {
+                    convertS8(data8 + from, dst, count);
+                });
             }
             break;
             case BufferType::PCM_S16LE:
             {
                 const int16_t* data16 = reinterpret_cast<const int16_t*>(data);
-                float* d = new float[numSamples];
-                for (size_t i = 0; i < numSamples; ++i) {
-                    d[i] = data16[i] / 32768.0f;
-                }
-                size_t ret = addData(d, numSamples, allDataAdded);
-                delete[] d;
-                return ret;
+                return write(numSamples, allDataAdded, [data16](float *dst, size_t from, size_t count) {
+                    convertS16(data16 + from, dst, count);
+                });
             }
             break;
             case BufferType::PCM_S32LE:
             {
                 const int32_t* data32 = reinterpret_cast<const int32_t*>(data);
-                float* d = new float[numSamples];
-                for (size_t i = 0; i < numSamples; ++i) {
-                    d[i] = data32[i] / 2147483648.0f;
-                }
-                size_t ret = addData(d, numSamples, allDataAdded);
-                delete[] d;
-                return ret;
+                return write(numSamples, allDataAdded, [data32](float *dst, size_t from, size_t count) {
+                    convertS32(data32 + from, dst, count);
+                });
             }
             break;
         }
@@ -97,50 +198,182 @@ public:
 
     // Overload for float data, directly adding its bytes to the buffer.
     // Return the number of floats written.
+    // If the storage is not large enough, only the floats that fit are written:
+    // call [grow] before when [needsToGrow] is true.
     size_t addData(const float* data, size_t numSamples, bool *allDataAdded) {
-        std::lock_guard<std::mutex> lock(bufferMutex); // Lock during modification
-        uint64_t bytesNeeded = numSamples * sizeof(float);
-        int64_t newNumSamples = numSamples;
-        if (buffer.size() + bytesNeeded > maxBytes)
+        return write(numSamples, allDataAdded, [data](float *dst, size_t from, size_t count) {
+            memcpy(dst, data + from, count * sizeof(float));
+        });
+    }
+
+    // Copy [frames] frames of [channels] interleaved channels starting from
+    // the float [offset] of the data not yet released. The channels are
+    // stored de-interleaved into [dst], each one [dstStride] floats apart.
+    // This is called by the consumer.
+    void readFrames(float *dst, size_t offset, size_t frames, unsigned int channels, size_t dstStride)
+    {
+        if (frames == 0)
+            return;
+        const float *data = mData.get();
+        uint64_t read = mReadCount.load(std::memory_order_relaxed);
+        size_t pos = (read + offset) % mCapacity;
+        size_t count = frames * channels;
+        if (channels == 1)
         {
-            uint64_t bytesLeft = maxBytes - buffer.size();
-            newNumSamples = bytesLeft / sizeof(float);
-            if (bytesLeft <= 0)
-                return 0;
+            size_t firstPart = std::min(count, mCapacity - pos);
+            memcpy(dst, data + pos, firstPart * sizeof(float));
+            memcpy(dst + firstPart, data, (count - firstPart) * sizeof(float));
+            return;
         }
-        const int8_t* data8 = reinterpret_cast<const int8_t*>(data);  // Convert float array to int8_t array
-        buffer.insert(buffer.end(), data8, data8 + newNumSamples*sizeof(float)); // Append directly
-        *allDataAdded = newNumSamples == numSamples;
-        return newNumSamples;
+        if (pos + count <= mCapacity)
+        {
+            const float *src = data + pos;
+            for (unsigned int j = 0; j < channels; j++)
+                for (size_t i = 0; i < frames; i++)
+                    dst[j * dstStride + i] = src[i * channels + j];
+            return;
+        }
+        // The frames are split by the end of the ring.
+        for (unsigned int j = 0; j < channels; j++)
+            for (size_t i = 0; i < frames; i++)
+                dst[j * dstStride + i] = data[(pos + i * channels + j) % mCapacity];
     }
 
-    // Remove data from the start of the buffer
+    // Remove data from the start of the buffer.
+    // This is called by the consumer.
     size_t removeData(size_t bytesToRemove) {
-        std::lock_guard<std::mutex> lock(bufferMutex); // Lock during modification
         size_t samplesRemoved = 0;
         if (bufferingType == BufferingType::RELEASED && bytesToRemove > 0) {
-            samplesRemoved = bytesToRemove / sizeof(float);
-            if (bytesToRemove >= buffer.size()) {
-                buffer.clear();
-            } else {
-                buffer.erase(buffer.begin(), buffer.begin() + bytesToRemove);
-            }
+            samplesRemoved = std::min(bytesToRemove / sizeof(float), getFloatsBufferSize());
+            // Give back the room to the producer.
+            mReadCount.fetch_add(samplesRemoved, std::memory_order_release);
         }
         return samplesRemoved;
     }
 
-    // Function to get the current size of the buffer in bytes
+    // Function to get the current number of floats in the buffer
     size_t getFloatsBufferSize()
     {
-        std::lock_guard<std::mutex> lock(bufferMutex); // Lock during read
-        return buffer.size() / sizeof(float);
+        return (size_t)(mWriteCount.load(std::memory_order_acquire) -
+                        mReadCount.load(std::memory_order_acquire));
     }
 
-    // Clear the buffer
+    // Clear the buffer.
+    // The consumer must not read while this is running.
     void clear()
     {
-        std::lock_guard<std::mutex> lock(bufferMutex); // Lock during modification
-        buffer.clear();
+        mWriteCount.store(0);
+        mReadCount.store(0);
+        mData.reset();
+        mCapacity = 0;
+    }
+
+private:
+    // Write [numSamples] samples into the storage calling
+    // `convert(dst, from, count)` once for each contiguous part of the ring.
+    template <typename Convert>
+    size_t write(size_t numSamples, bool *allDataAdded, Convert convert)
+    {
+        *allDataAdded = false;
+        size_t newNumSamples = getFloatsToWrite(numSamples);
+        newNumSamples = std::min(newNumSamples, mCapacity - getFloatsBufferSize());
+        if (newNumSamples == 0)
+            return 0;
+
+        uint64_t written = mWriteCount.load(std::memory_order_relaxed);
+        size_t pos = written % mCapacity;
+        size_t firstPart = std::min(newNumSamples, mCapacity - pos);
+        convert(mData.get() + pos, 0, firstPart);
+        if (firstPart < newNumSamples)
+            convert(mData.get(), firstPart, newNumSamples - firstPart);
+        // Publish the new data to the consumer.
+        mWriteCount.store(written + newNumSamples, std::memory_order_release);
+
+        *allDataAdded = newNumSamples == numSamples;
+        return newNumSamples;
+    }
+
+    // PCM to float conversion. The scale factors are powers of two, so
+    // multiplying gives the same result of dividing by 128, 32768 and 2^31.
+    // SSE2 and NEON are part of the x86_64 and arm64 baselines. There is no
+    // AVX2 variant picked at runtime like the resamplers have: the loops are
+    // bound by loads and stores, and building the scalar loop with AVX2 was
+    // only about 5% faster (see benchmark/convert_benchmark.cpp). The web
+    // build and other targets use the scalar loop.
+    static void convertS8(const int8_t *src, float *dst, size_t count)
+    {
+        const float scale = 1.0f / 128.0f;
+        size_t i = 0;
+#if defined(SOLOUD_SSE_INTRINSICS)
+        const __m128 vscale = _mm_set1_ps(scale);
+        for (; i + 16 <= count; i += 16)
+        {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+            // Sign extend by placing the bytes in the high part and shifting.
+            __m128i lo16 = _mm_srai_epi16(_mm_unpacklo_epi8(v, v), 8);
+            __m128i hi16 = _mm_srai_epi16(_mm_unpackhi_epi8(v, v), 8);
+            _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(lo16, lo16), 16)), vscale));
+            _mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(lo16, lo16), 16)), vscale));
+            _mm_storeu_ps(dst + i + 8, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(hi16, hi16), 16)), vscale));
+            _mm_storeu_ps(dst + i + 12, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(hi16, hi16), 16)), vscale));
+        }
+#elif defined(BUFFER_NEON_INTRINSICS)
+        for (; i + 16 <= count; i += 16)
+        {
+            int8x16_t v = vld1q_s8(src + i);
+            int16x8_t lo16 = vmovl_s8(vget_low_s8(v));
+            int16x8_t hi16 = vmovl_s8(vget_high_s8(v));
+            vst1q_f32(dst + i, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(lo16))), scale));
+            vst1q_f32(dst + i + 4, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(lo16))), scale));
+            vst1q_f32(dst + i + 8, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(hi16))), scale));
+            vst1q_f32(dst + i + 12, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(hi16))), scale));
+        }
+#endif
+        for (; i < count; ++i)
+            dst[i] = src[i] * scale;
+    }
+
+    static void convertS16(const int16_t *src, float *dst, size_t count)
+    {
+        const float scale = 1.0f / 32768.0f;
+        size_t i = 0;
+#if defined(SOLOUD_SSE_INTRINSICS)
+        const __m128 vscale = _mm_set1_ps(scale);
+        for (; i + 8 <= count; i += 8)
+        {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+            _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16)), vscale));
+            _mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16)), vscale));
+        }
+#elif defined(BUFFER_NEON_INTRINSICS)
+        for (; i + 8 <= count; i += 8)
+        {
+            int16x8_t v = vld1q_s16(src + i);
+            vst1q_f32(dst + i, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(v))), scale));
+            vst1q_f32(dst + i + 4, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(v))), scale));
+        }
+#endif
+        for (; i < count; ++i)
+            dst[i] = src[i] * scale;
+    }
+
+    static void convertS32(const int32_t *src, float *dst, size_t count)
+    {
+        const float scale = 1.0f / 2147483648.0f;
+        size_t i = 0;
+#if defined(SOLOUD_SSE_INTRINSICS)
+        const __m128 vscale = _mm_set1_ps(scale);
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+            _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(v), vscale));
+        }
+#elif defined(BUFFER_NEON_INTRINSICS)
+        for (; i + 4 <= count; i += 4)
+            vst1q_f32(dst + i, vmulq_n_f32(vcvtq_f32_s32(vld1q_s32(src + i)), scale));
+#endif
+        for (; i < count; ++i)
+            dst[i] = (float)src[i] * scale;
     }
 };
 
@@ -9,6 +9,7 @@ FlacDecoderWrapper::FlacDecoderWrapper()
     : m_pFlacDecoder(nullptr),
       m_streamInfoProcessed(false),
       m_streamInitialized(false),
+      m_out(nullptr),
       m_channels(0),
       m_samplerate(0),
       m_bitsPerSample(0),
@@ -73,10 +74,12 @@ bool FlacDecoderWrapper::initializeDecoder(int engineSamplerate, int engineChann
     return true;
 }
 
-std::pair<std::vector<float>, DecoderError> FlacDecoderWrapper::decode(std::vector<unsigned char> &buffer, int *samplerate, int *channels)
+DecoderError FlacDecoderWrapper::decode(std::vector<unsigned char> &buffer, int *samplerate, int *channels, std::vector<float> &out)
 {
-    m_decodedPcm.clear();
+    m_out = &out;
     std::vector<unsigned char> clean_audio_data;
+    // Without ICY metadata the input is fed as is, without copying it.
+    const std::vector<unsigned char> *audio_data = &buffer;
 
     if (mIcyMetaInt > 0)
     {
@@ -116,18 +119,15 @@ std::pair<std::vector<float>, DecoderError> FlacDecoderWrapper::decode(std::vect
                 mAudioBytesCount++;
             }
         }
-    }
-    else
-    {
-        clean_audio_data = buffer;
+        audio_data = &clean_audio_data;
     }
 
-    // Now, use 'clean_audio_data' with the existing OGG/FLAC pipeline
-    if (!clean_audio_data.empty())
+    // Now, use 'audio_data' with the existing OGG/FLAC pipeline
+    if (!audio_data->empty())
     {
-        char *ogg_buffer = ogg_sync_buffer(&m_oy, clean_audio_data.size());
-        memcpy(ogg_buffer, clean_audio_data.data(), clean_audio_data.size());
-        ogg_sync_wrote(&m_oy, clean_audio_data.size());
+        char *ogg_buffer = ogg_sync_buffer(&m_oy, audio_data->size());
+        memcpy(ogg_buffer, audio_data->data(), audio_data->size());
+        ogg_sync_wrote(&m_oy, audio_data->size());
     }
     buffer.clear(); // Clear the original buffer as it has been processed
 
@@ -137,7 +137,8 @@ std::pair<std::vector<float>, DecoderError> FlacDecoderWrapper::decode(std::vect
         {
             if (ogg_stream_init(&m_os, ogg_page_serialno(&m_og)) != 0)
             {
-                return {m_decodedPcm, DecoderError::FailedToCreateDecoder};
+                m_out = nullptr;
+                return DecoderError::FailedToCreateDecoder;
             }
             m_streamInitialized = true;
         }
@@ -186,7 +187,8 @@ std::pair<std::vector<float>, DecoderError> FlacDecoderWrapper::decode(std::vect
     *samplerate = m_samplerate;
     *channels = m_channels;
 
-    return {m_decodedPcm, DecoderError::NoError};
+    m_out = nullptr;
+    return DecoderError::NoError;
 }
 
 FLAC__StreamDecoderReadStatus FlacDecoderWrapper::read_callback(const FLAC__StreamDecoder *decoder, FLAC__byte buffer[], size_t *bytes, void *client_data)
@@ -282,11 +284,22 @@ FLAC__StreamDecoderWriteStatus FlacDecoderWrapper::write_callback(const FLAC__St
         divisor = 128.0f;
     }
 
+    if (self->m_out == nullptr)
+    {
+        return FLAC__STREAM_DECODER_WRITE_STATUS_CONTINUE;
+    }
+
+    // Interleave straight at the end of the caller's output.
+    std::vector<float> &out = *self->m_out;
+    const size_t start = out.size();
+    out.resize(start + num_samples * self->m_channels);
+    float *dst = out.data() + start;
+    const float scale = 1.0f / divisor;
     for (size_t i = 0; i < num_samples; ++i)
     {
         for (unsigned channel = 0; channel < self->m_channels; ++channel)
         {
-            self->m_decodedPcm.push_back(static_cast<float>(buffer[channel][i]) / divisor);
+            *dst++ = static_cast<float>(buffer[channel][i]) * scale;
         }
     }
 
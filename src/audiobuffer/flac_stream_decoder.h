@@ -16,7 +16,7 @@ public:
     void setIcyMetaInt(int icyMetaInt);
 
     bool initializeDecoder(int engineSamplerate, int engineChannels) override;
-    std::pair<std::vector<float>, DecoderError> decode(std::vector<unsigned char>& buffer, int* sampleRate, int* channels) override;
+    DecoderError decode(std::vector<unsigned char>& buffer, int* sampleRate, int* channels, std::vector<float>& out) override;
 
 private:
     static FLAC__StreamDecoderReadStatus read_callback(const FLAC__StreamDecoder *decoder, FLAC__byte buffer[], size_t *bytes, void *client_data);
@@ -38,7 +38,8 @@ private:
     ogg_packet m_op;
     bool m_streamInitialized;
 
-    std::vector<float> m_decodedPcm;
+    // Where write_callback appends the decoded frames, set by decode().
+    std::vector<float> *m_out;
     int m_channels;
     int m_samplerate;
     int m_bitsPerSample;
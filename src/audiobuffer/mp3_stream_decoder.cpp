@@ -182,7 +182,7 @@ void MP3DecoderWrapper::processIcyStream(std::vector<unsigned char> &buffer)
 }
 
 
-std::pair<std::vector<float>, DecoderError> MP3DecoderWrapper::decode(std::vector<unsigned char> &buffer, int *samplerate, int *channels)
+DecoderError MP3DecoderWrapper::decode(std::vector<unsigned char> &buffer, int *samplerate, int *channels, std::vector<float> &out)
 {
     // For ICY streams, process the buffer to strip metadata first.
     if (detectedType == DetectedType::BUFFER_MP3_STREAM && mIcyMetaInt > 0) {
@@ -196,7 +196,7 @@ std::pair<std::vector<float>, DecoderError> MP3DecoderWrapper::decode(std::vecto
     }
 
     if (audioData.empty()) {
-        return {{}, DecoderError::NoError};
+        return DecoderError::NoError;
     }
 
     // --- Decoder Initialization ---
@@ -213,7 +213,7 @@ std::pair<std::vector<float>, DecoderError> MP3DecoderWrapper::decode(std::vecto
 
                 // If we don't have the full tag yet, return and wait for more data.
                 if (audioData.size() < totalTagLength) {
-                    return {{}, DecoderError::NoError};
+                    return DecoderError::NoError;
                 }
             }
         }
@@ -223,15 +223,14 @@ std::pair<std::vector<float>, DecoderError> MP3DecoderWrapper::decode(std::vecto
         if (!drmp3_init(&decoder, MP3DecoderWrapper::on_read, MP3DecoderWrapper::on_seek, nullptr, MP3DecoderWrapper::on_meta, this, nullptr)) {
             // If init fails, it might be because there's not enough data to find a valid frame yet.
             // This is not a fatal error in a streaming context.
-            return {{}, DecoderError::NoError};
+            return DecoderError::NoError;
         }
         isInitialized = true;
     }
 
     // --- Decoding Loop ---
-    std::vector<float> decodedData;
+    // The frames are decoded straight at the end of [out].
     const int MAX_FRAMES_PER_RUN = 4096;
-    float pcm_frames[MAX_FRAMES_PER_RUN];
     drmp3_uint64 frames_read;
 
     // Loop while the decoder can produce full chunks of frames.
@@ -245,10 +244,10 @@ std::pair<std::vector<float>, DecoderError> MP3DecoderWrapper::decode(std::vecto
         
         int framesToRequest = MAX_FRAMES_PER_RUN / decoder.channels;
         
-        frames_read = drmp3_read_pcm_frames_f32(&decoder, framesToRequest, pcm_frames);
-        if (frames_read > 0) {
-            decodedData.insert(decodedData.end(), pcm_frames, pcm_frames + frames_read * decoder.channels);
-        }
+        const size_t start = out.size();
+        out.resize(start + framesToRequest * decoder.channels);
+        frames_read = drmp3_read_pcm_frames_f32(&decoder, framesToRequest, out.data() + start);
+        out.resize(start + frames_read * decoder.channels);
 
         // If the read position has reached the end of internal buffer, we must stop.
         // The next on_read() call would return 0 and set the `atEnd` flag, which we must avoid.
@@ -273,7 +272,7 @@ std::pair<std::vector<float>, DecoderError> MP3DecoderWrapper::decode(std::vecto
         m_read_pos = 0;
     }
 
-    return {decodedData, DecoderError::NoError};
+    return DecoderError::NoError;
 }
 
 bool MP3DecoderWrapper::initializeDecoder(int engineSamplerate, int engineChannels)
@@ -24,7 +24,7 @@ public:
     // call this only once before decoding
     void setIcyMetaInt(int icyMetaInt);
 
-    std::pair<std::vector<float>, DecoderError> decode(std::vector<unsigned char>& buffer, int* samplerate, int* channels) override;
+    DecoderError decode(std::vector<unsigned char>& buffer, int* samplerate, int* channels, std::vector<float>& out) override;
 
     static bool checkForValidFrames(const std::vector<unsigned char>& buffer);
 
@@ -151,14 +151,14 @@ bool OpusDecoderWrapper::initializeDecoder(int engineSamplerateIn, int engineCha
     return true;
 }
 
-std::pair<std::vector<float>, DecoderError> OpusDecoderWrapper::decode(std::vector<unsigned char>& buffer, int* samplerate, int* channels)
+DecoderError OpusDecoderWrapper::decode(std::vector<unsigned char>& buffer, int* samplerate, int* channels, std::vector<float>& out)
 {
-    std::vector<float> decodedData;
+    const size_t start = out.size();
     bool eos_seen = false;
 
     if (buffer.empty())
     {
-        return {decodedData, DecoderError::NoError};
+        return DecoderError::NoError;
     }
 
     // Write data into ogg sync buffer
@@ -194,7 +194,7 @@ std::pair<std::vector<float>, DecoderError> OpusDecoderWrapper::decode(std::vect
         {
             if (ogg_stream_init(&os, ogg_page_serialno(&og)))
             {
-                return {decodedData, DecoderError::FailedToCreateDecoder};
+                return DecoderError::FailedToCreateDecoder;
             }
             streamInitialized = true;
         }
@@ -219,7 +219,7 @@ std::pair<std::vector<float>, DecoderError> OpusDecoderWrapper::decode(std::vect
         {
             if (ogg_stream_init(&os, ogg_page_serialno(&og)) != 0)
             {
-                return {decodedData, DecoderError::FailedToCreateDecoder};
+                return DecoderError::FailedToCreateDecoder;
             }
             streamInitialized = true;
         }
@@ -232,11 +232,7 @@ std::pair<std::vector<float>, DecoderError> OpusDecoderWrapper::decode(std::vect
         // Extract packets from page
         while (ogg_stream_packetout(&os, &op) == 1)
         {
-            auto packetData = decodePacket(&op);
-            if (!packetData.empty())
-            {
-                decodedData.insert(decodedData.end(), packetData.begin(), packetData.end());
-            }
+            decodePacket(&op, out);
         }
     }
 
@@ -249,19 +245,19 @@ std::pair<std::vector<float>, DecoderError> OpusDecoderWrapper::decode(std::vect
         if (fade_samples > 0 && decodingChannels > 0)
         {
             const size_t fade_floats = fade_samples * decodingChannels;
-            if (decodedData.size() > fade_floats)
+            if (out.size() - start > fade_floats)
             {
-                size_t start_fade = decodedData.size() - fade_floats;
+                size_t start_fade = out.size() - fade_floats;
                 for (size_t i = 0; i < fade_floats; ++i)
                 {
                     float multiplier = 1.0f - (float)(i / decodingChannels) / (float)fade_samples;
-                    decodedData[start_fade + i] *= multiplier;
+                    out[start_fade + i] *= multiplier;
                 }
             }
         }
     }
 
-    return {decodedData, DecoderError::NoError};
+    return DecoderError::NoError;
 }
 
 OpusInfo OpusDecoderWrapper::parseOpusHead(ogg_packet* packet) {
@@ -311,9 +307,8 @@ OpusInfo OpusDecoderWrapper::parseOpusHead(ogg_packet* packet) {
     return head;
 }
 
-std::vector<float> OpusDecoderWrapper::decodePacket(ogg_packet* packet)
+void OpusDecoderWrapper::decodePacket(ogg_packet* packet, std::vector<float>& out)
 {
-    std::vector<float> packetPcm;
 
     // Skip header packets (first 2 packets in Ogg Opus stream)
     if (!headerParsed)
@@ -327,7 +322,7 @@ std::vector<float> OpusDecoderWrapper::decodePacket(ogg_packet* packet)
             }
             catch (const std::exception &)
             {
-                return packetPcm;
+                return;
             }
 
             int desiredSampleRate = opusInfo.input_sample_rate > 0
@@ -346,7 +341,7 @@ std::vector<float> OpusDecoderWrapper::decodePacket(ogg_packet* packet)
 
             if (!ensureDecoder(desiredSampleRate, desiredChannels))
             {
-                return packetPcm;
+                return;
             }
 
             skipSamplesPending = static_cast<int>(
@@ -363,24 +358,29 @@ std::vector<float> OpusDecoderWrapper::decodePacket(ogg_packet* packet)
                 (static_cast<int64_t>(opusInfo.pre_skip) * decodingSamplerate + 47999) / 48000);
         }
         packetCount++;
-        return packetPcm;
+        return;
     }
 
     if (decoder == nullptr)
     {
-        return packetPcm;
+        return;
     }
 
     // Opus can handle frame sizes from 2.5ms to 60ms
     // We'll use buffer size to accommodate any frame size
     const int maxFrameSize = decodingSamplerate * 60 / 1000; // 60ms frame size
-    std::vector<float> outputBuffer(maxFrameSize * decodingChannels);
+    // Decode straight at the end of [out]. Its capacity is kept across calls,
+    // so after the first packets this doesn't allocate.
+    const size_t packetStart = out.size();
+    out.resize(packetStart + maxFrameSize * decodingChannels);
+    float *outputBuffer = out.data() + packetStart;
+    size_t floatsDecoded = 0;
 
     // Try decoding the packet
     int samples = opus_decode_float(decoder,
                                     packet->packet,
                                     packet->bytes,
-                                    outputBuffer.data(),
+                                    outputBuffer,
                                     maxFrameSize,
                                     0);
 
@@ -398,9 +398,11 @@ std::vector<float> OpusDecoderWrapper::decodePacket(ogg_packet* packet)
         //             packet->packet[0], packet->packet[1], 
         //             packet->packet[2], packet->packet[3]);
         
-        return packetPcm; // Skip invalid packet instead of throwing
+        out.resize(packetStart);
+        return; // Skip invalid packet instead of throwing
     }
 
+    // Keep only the usable samples, trimming the pre-skip and the end of stream.
     if (samples > 0)
     {
         int usableSamples = samples;
@@ -416,7 +418,8 @@ std::vector<float> OpusDecoderWrapper::decodePacket(ogg_packet* packet)
 
         if (usableSamples <= 0)
         {
-            return packetPcm;
+            out.resize(packetStart);
+            return;
         }
 
         int64_t allowedSamples = usableSamples;
@@ -425,7 +428,8 @@ std::vector<float> OpusDecoderWrapper::decodePacket(ogg_packet* packet)
             const int64_t remaining = totalSamplesExpected - totalOutputSamples;
             if (remaining <= 0)
             {
-                return packetPcm;
+                out.resize(packetStart);
+                return;
             }
             if (allowedSamples > remaining)
             {
@@ -435,17 +439,20 @@ std::vector<float> OpusDecoderWrapper::decodePacket(ogg_packet* packet)
 
         if (allowedSamples <= 0)
         {
-            return packetPcm;
+            out.resize(packetStart);
+            return;
         }
 
         const size_t startIndex = static_cast<size_t>(skippedSamples) * decodingChannels;
-        const size_t floatsToCopy = static_cast<size_t>(allowedSamples) * decodingChannels;
+        floatsDecoded = static_cast<size_t>(allowedSamples) * decodingChannels;
 
-        packetPcm.insert(packetPcm.end(),
-                         outputBuffer.begin() + startIndex,
-                         outputBuffer.begin() + startIndex + floatsToCopy);
+        if (startIndex > 0)
+        {
+            memmove(outputBuffer, outputBuffer + startIndex, floatsDecoded * sizeof(float));
+        }
         totalOutputSamples += allowedSamples;
     }
-    return packetPcm;
+
+    out.resize(packetStart + floatsDecoded);
 }
 #endif // #if defined(NO_OPUS_OGG_LIBS)
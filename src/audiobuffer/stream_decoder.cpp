@@ -105,45 +105,46 @@ DetectedType StreamDecoder::detectAudioFormat(const std::vector<unsigned char>&
     return DetectedType::BUFFER_UNKNOWN;
 }
 
-std::pair<std::vector<float>, DecoderError> StreamDecoder::decode(
+DecoderError StreamDecoder::decode(
     std::vector<unsigned char>& buffer,
     int* samplerate,
     int* channels,
-    TrackChangeCallback metadataChangeCallback)
+    TrackChangeCallback metadataChangeCallback,
+    std::vector<float>& out)
 {
     if (!isFormatDetected) {
         DetectedType detectedType = detectAudioFormat(buffer);
         if (detectedType == DetectedType::BUFFER_NO_ENOUGH_DATA)
-            return {{}, DecoderError::NoError};
+            return DecoderError::NoError;
 
         if (detectedType == DetectedType::BUFFER_UNKNOWN) {
-            return {{}, DecoderError::FormatNotSupported};
+            return DecoderError::FormatNotSupported;
         }
         
         if (detectedType == DetectedType::BUFFER_OGG_OPUS
             || detectedType == DetectedType::BUFFER_OGG_VORBIS
             || detectedType == DetectedType::BUFFER_OGG_FLAC) {
             #if defined(NO_OPUS_OGG_LIBS)
-                return {{}, DecoderError::NoOpusOggLibs};
+                return DecoderError::NoOpusOggLibs;
             #else
                 if (detectedType == DetectedType::BUFFER_OGG_VORBIS) {
                     mWrapper = std::make_unique<VorbisDecoderWrapper>();
                     isFormatDetected = static_cast<VorbisDecoderWrapper*>(mWrapper.get())->initializeDecoder(*samplerate, *channels);
                     if (!isFormatDetected) {
-                        return {{}, DecoderError::FailedToCreateDecoder};
+                        return DecoderError::FailedToCreateDecoder;
                     }
                 } else if (detectedType == DetectedType::BUFFER_OGG_FLAC) {
                     mWrapper = std::make_unique<FlacDecoderWrapper>();
                     isFormatDetected = static_cast<FlacDecoderWrapper*>(mWrapper.get())->initializeDecoder(*samplerate, *channels);
                     if (!isFormatDetected) {
-                        return {{}, DecoderError::FailedToCreateDecoder};
+                        return DecoderError::FailedToCreateDecoder;
                     }
                     static_cast<FlacDecoderWrapper*>(mWrapper.get())->setIcyMetaInt(mIcyMetaInt);
                 } else {
                     mWrapper = std::make_unique<OpusDecoderWrapper>();
                     isFormatDetected = static_cast<OpusDecoderWrapper*>(mWrapper.get())->initializeDecoder(*samplerate, *channels);
                     if (!isFormatDetected) {
-                        return {{}, DecoderError::FailedToCreateDecoder};
+                        return DecoderError::FailedToCreateDecoder;
                     }
                 }
             #endif
@@ -151,7 +152,7 @@ std::pair<std::vector<float>, DecoderError> StreamDecoder::decode(
             mWrapper = std::make_unique<MP3DecoderWrapper>();
             isFormatDetected = static_cast<MP3DecoderWrapper*>(mWrapper.get())->initializeDecoder(*samplerate, *channels);
             if (!isFormatDetected) {
-                return {{}, DecoderError::FailedToCreateDecoder};
+                return DecoderError::FailedToCreateDecoder;
             }
             static_cast<MP3DecoderWrapper*>(mWrapper.get())->setIcyMetaInt(mIcyMetaInt);
         }
@@ -164,21 +165,21 @@ std::pair<std::vector<float>, DecoderError> StreamDecoder::decode(
     if (mWrapper) {
         #if !defined(NO_OPUS_OGG_LIBS)
             if (mWrapper->detectedType == DetectedType::BUFFER_OGG_OPUS) {
-                return static_cast<OpusDecoderWrapper*>(mWrapper.get())->decode(buffer, samplerate, channels);
+                return static_cast<OpusDecoderWrapper*>(mWrapper.get())->decode(buffer, samplerate, channels, out);
             }
             else if (mWrapper->detectedType == DetectedType::BUFFER_OGG_VORBIS) {
-                return static_cast<VorbisDecoderWrapper*>(mWrapper.get())->decode(buffer, samplerate, channels);
+                return static_cast<VorbisDecoderWrapper*>(mWrapper.get())->decode(buffer, samplerate, channels, out);
             }
             else if (mWrapper->detectedType == DetectedType::BUFFER_OGG_FLAC) {
-                return static_cast<FlacDecoderWrapper*>(mWrapper.get())->decode(buffer, samplerate, channels);
+                return static_cast<FlacDecoderWrapper*>(mWrapper.get())->decode(buffer, samplerate, channels, out);
             }
         #endif
         if (mWrapper->detectedType == DetectedType::BUFFER_MP3_WITH_ID3 ||
             mWrapper->detectedType == DetectedType::BUFFER_MP3_STREAM) {
-            return static_cast<MP3DecoderWrapper *>(mWrapper.get())->decode(buffer, samplerate, channels);
+            return static_cast<MP3DecoderWrapper *>(mWrapper.get())->decode(buffer, samplerate, channels, out);
         }
     }
-    return {};
+    return DecoderError::NoError;
 }
 
 DetectedType StreamDecoder::getWrapperType()
@@ -191,7 +191,10 @@ class IDecoderWrapper {
 public:
     virtual ~IDecoderWrapper() = default;
     virtual bool initializeDecoder(int engineSamplerate, int engineChannels) = 0;
-    virtual std::pair<std::vector<float>, DecoderError> decode(std::vector<unsigned char>& buffer, int* sampleRate, int* channels) = 0;
+    /// Decode the data in [buffer] appending the interleaved float frames to [out].
+    /// [out] is owned by the caller, which should reuse it across calls so its
+    /// storage is allocated only once.
+    virtual DecoderError decode(std::vector<unsigned char>& buffer, int* sampleRate, int* channels, std::vector<float>& out) = 0;
     
     void setTrackChangeCallback(TrackChangeCallback callback) {
         onTrackChange = callback;
@@ -216,11 +219,14 @@ public:
 
     void setBufferIcyMetaInt(int icyMetaInt);
 
-    std::pair<std::vector<float>, DecoderError> decode(
+    /// Decode [buffer] appending the decoded frames to [out].
+    /// See [IDecoderWrapper::decode].
+    DecoderError decode(
         std::vector<unsigned char> &buffer,
         int *sampleRate,
         int *channels,
-        TrackChangeCallback metadataChangeCallback);
+        TrackChangeCallback metadataChangeCallback,
+        std::vector<float> &out);
 
     DetectedType getWrapperType();
 
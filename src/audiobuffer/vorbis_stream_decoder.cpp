@@ -75,15 +75,16 @@ AudioMetadata VorbisDecoderWrapper::getMetadata() {
     return metadata;
 }
 
-std::pair<std::vector<float>, DecoderError> VorbisDecoderWrapper::decode(std::vector<unsigned char>& buffer,
-                                               int* samplerate,
-                                               int* channels) {
-    std::vector<float> decodedData;
+DecoderError VorbisDecoderWrapper::decode(std::vector<unsigned char>& buffer,
+                                          int* samplerate,
+                                          int* channels,
+                                          std::vector<float>& out) {
+    const size_t start = out.size();
     ogg_int64_t total_samples = -1;
     bool eos_seen = false;
 
     if (buffer.empty()) {
-        return {decodedData, DecoderError::NoError};
+        return DecoderError::NoError;
     }
 
     // Write new bytes into ogg buffer
@@ -101,7 +102,7 @@ std::pair<std::vector<float>, DecoderError> VorbisDecoderWrapper::decode(std::ve
         
         if (!streamInitialized) {
             if (ogg_stream_init(&os, ogg_page_serialno(&og))) {
-                return {decodedData, DecoderError::FailedToCreateDecoder};
+                return DecoderError::FailedToCreateDecoder;
             }
             streamInitialized = true;
         }
@@ -129,7 +130,7 @@ std::pair<std::vector<float>, DecoderError> VorbisDecoderWrapper::decode(std::ve
             vorbis_comment_init(&vc);
             
             if (ogg_stream_init(&os, ogg_page_serialno(&og))) {
-                return {decodedData, DecoderError::FailedToCreateDecoder};
+                return DecoderError::FailedToCreateDecoder;
             }
             
             streamInitialized = true;
@@ -151,15 +152,14 @@ std::pair<std::vector<float>, DecoderError> VorbisDecoderWrapper::decode(std::ve
 
         // Extract packets from page
         while (ogg_stream_packetout(&os, &op) == 1) {
-            auto packetData = decodePacket(&op);
-            decodedData.insert(decodedData.end(), packetData.begin(), packetData.end());
+            decodePacket(&op, out);
         }
     }
 
     if (total_samples != -1 && vi.channels > 0) {
         size_t total_floats = total_samples * vi.channels;
-        if (decodedData.size() > total_floats) {
-            decodedData.resize(total_floats);
+        if (out.size() - start > total_floats) {
+            out.resize(start + total_floats);
         }
     }
 
@@ -167,11 +167,11 @@ std::pair<std::vector<float>, DecoderError> VorbisDecoderWrapper::decode(std::ve
         const size_t fade_samples = (size_t)(vi.rate * 0.005); // 5ms fade
         if (fade_samples > 0 && vi.channels > 0) {
             const size_t fade_floats = fade_samples * vi.channels;
-            if (decodedData.size() > fade_floats) {
-                size_t start_fade = decodedData.size() - fade_floats;
+            if (out.size() - start > fade_floats) {
+                size_t start_fade = out.size() - fade_floats;
                 for (size_t i = 0; i < fade_floats; ++i) {
                     float multiplier = 1.0f - (float)(i / vi.channels) / (float)fade_samples;
-                    decodedData[start_fade + i] *= multiplier;
+                    out[start_fade + i] *= multiplier;
                 }
             }
         }
@@ -183,12 +183,11 @@ std::pair<std::vector<float>, DecoderError> VorbisDecoderWrapper::decode(std::ve
         *channels   = vi.channels;
     }
 
-    return {decodedData, DecoderError::NoError};
+    return DecoderError::NoError;
 }
 
 
-std::vector<float> VorbisDecoderWrapper::decodePacket(ogg_packet* packet) {
-    std::vector<float> packetPcm;
+void VorbisDecoderWrapper::decodePacket(ogg_packet* packet, std::vector<float>& out) {
 
     // Handle header packets
     if (!headerParsed) {
@@ -202,7 +201,7 @@ std::vector<float> VorbisDecoderWrapper::decodePacket(ogg_packet* packet) {
             // Check if this looks like a Vorbis header packet (should start with 0x01)
             if (packet->bytes > 0 && packet->packet[0] != 0x01) {
                 fprintf(stderr, "First packet is not a Vorbis identification header\n");
-                return packetPcm;
+                return;
             }
         }
 
@@ -212,7 +211,7 @@ std::vector<float> VorbisDecoderWrapper::decodePacket(ogg_packet* packet) {
             if (packet->packetno != packetCount) {
                 fprintf(stderr, "Unexpected packet number %lld for header %d\n", 
                     packet->packetno, packetCount);
-                return packetPcm;
+                return;
             }
 
             int ret = vorbis_synthesis_headerin(&vi, &vc, packet);
@@ -223,7 +222,7 @@ std::vector<float> VorbisDecoderWrapper::decodePacket(ogg_packet* packet) {
                 // Reset state on header failure
                 headerParsed = false;
                 packetCount = 0;
-                return packetPcm;
+                return;
             }
 
             packetCount++;
@@ -248,12 +247,12 @@ std::vector<float> VorbisDecoderWrapper::decodePacket(ogg_packet* packet) {
                     packetCount = 0;
                 }
             }
-            return packetPcm; // no PCM during header parsing
+            return; // no PCM during header parsing
         }
     }
 
     if (!vorbisInitialized) {
-        return packetPcm;
+        return;
     }
 
     // Decode an audio packet
@@ -264,14 +263,16 @@ std::vector<float> VorbisDecoderWrapper::decodePacket(ogg_packet* packet) {
     float** pcm;
     int samples;
     while ((samples = vorbis_synthesis_pcmout(&vd, &pcm)) > 0) {
+        // Interleave straight at the end of [out].
+        const size_t packetStart = out.size();
+        out.resize(packetStart + (size_t)samples * vi.channels);
+        float* dst = out.data() + packetStart;
         for (int i = 0; i < samples; i++) {
             for (int ch = 0; ch < vi.channels; ch++) {
-                packetPcm.push_back(pcm[ch][i]);
+                *dst++ = pcm[ch][i];
             }
         }
         vorbis_synthesis_read(&vd, samples);
     }
-
-    return packetPcm;
 }
 #endif // #if defined(NO_OPUS_OGG_LIBS)
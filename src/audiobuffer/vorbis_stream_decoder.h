@@ -19,11 +19,11 @@ public:
     
     bool initializeDecoder(int engineSamplerate, int engineChannels) override;
     
-    std::pair<std::vector<float>, DecoderError> decode(std::vector<unsigned char>& buffer, int* samplerate, int* channels) override;
+    DecoderError decode(std::vector<unsigned char>& buffer, int* samplerate, int* channels, std::vector<float>& out) override;
     
 private:
     AudioMetadata getMetadata();
-    std::vector<float> decodePacket(ogg_packet* packet);
+    void decodePacket(ogg_packet* packet, std::vector<float>& out);
     
     int engineSamplerate;
     int engineChannels;
@@ -4,6 +4,7 @@
 #include "analyzer.h"
 #include "synth/basic_wave.h"
 #include "waveform/waveform.h"
+#include "event_queue.h"
 
 #ifndef COMMON_H
 #include "common.h"
@@ -11,12 +12,15 @@
 
 #ifdef __EMSCRIPTEN__
 #include <emscripten/emscripten.h>
+#else
+#include "load_pool.h"
 #endif
 
 #include <stdio.h>
 #include <iostream>
 #include <memory.h>
 #include <memory>
+#include <deque>
 #include <filesystem>
 
 #ifdef __cplusplus
@@ -27,20 +31,40 @@ extern "C"
     /// mutex to lock the init and dispose methods.
     std::mutex init_deinit_mutex;
 
-    /// mutex to lock the loading audio methods and make safe operations on player.sounds list.
+    /// mutex to serialize the loading audio methods with the disposal of sounds.
+    /// The sounds list itself is guarded by `Player::sounds_mutex`.
     std::mutex loadMutex;
 
     std::unique_ptr<Player> player = std::make_unique<Player>();
     std::unique_ptr<Analyzer> analyzer = std::make_unique<Analyzer>(256);
 
-    typedef void (*dartVoiceEndedCallback_t)(unsigned int *);
-    typedef void (*dartFileLoadedCallback_t)(enum PlayerErrors *, char *completeFileName, unsigned int *, uint64_t *timeStamp);
-    typedef void (*dartStateChangedCallback_t)(enum PlayerStateEvents *);
+#ifndef __EMSCRIPTEN__
+    /// threads decoding the files requested with [loadFile].
+    LoadPool loadPool;
+
+    /// true while [dispose] cancels the loads, guarded by `init_deinit_mutex`.
+    /// [loadFile] doesn't queue new loads meanwhile.
+    bool disposing = false;
+#endif
+
+    typedef void (*dartEventsReadyCallback_t)();
 
-    // to be used by `NativeCallable`, these functions must return void.
-    void (*dartVoiceEndedCallback)(unsigned int *) = nullptr;
-    void (*dartFileLoadedCallback)(enum PlayerErrors *, char *completeFileName, unsigned int *, uint64_t *timeStamp) = nullptr;
-    void (*dartStateChangedCallback)(enum PlayerStateEvents *) = nullptr;
+    // to be used by `NativeCallable`, this function must return void.
+    void (*dartEventsReadyCallback)() = nullptr;
+
+    /// The voice ended and state changed events waiting to be read by Dart
+    /// with [drainEvents].
+    EventQueue events;
+
+    /// The file loaded events waiting to be read by Dart. They are pushed by
+    /// the loader threads, which can wait for the lock, and must never be
+    /// dropped: Dart waits for each of them.
+    std::deque<PlayerEvent> fileLoadedEvents;
+    std::mutex fileLoadedEventsMutex;
+
+    /// True when [dartEventsReadyCallback] has been called and Dart has not
+    /// drained the events yet. Many events pushed in a row call it once.
+    std::atomic<bool> eventsPending(false);
 
     //////////////////////////////////////////////////////////////
     /// WEB WORKER
@@ -102,6 +126,25 @@ extern "C"
         free(pointer);
     }
 
+    /// Wake Dart up if it is not already draining the events.
+    void notifyEventsReady()
+    {
+        // Read once: `dispose` can clear it meanwhile.
+        dartEventsReadyCallback_t callback = dartEventsReadyCallback;
+        if (callback != nullptr && !eventsPending.exchange(true))
+            callback();
+    }
+
+    /// Queue [event] for Dart and wake it up if it is not already draining.
+    /// Called by the audio thread too: it doesn't allocate nor lock. When
+    /// the queue is full the event is dropped, and Dart re-syncs its voice
+    /// handles with the [EVENT_VOICES_RESYNC] event sent by [drainEvents].
+    void pushEvent(const PlayerEvent &event)
+    {
+        events.push(event);
+        notifyEventsReady();
+    }
+
     /// The callback to monitor when a voice ends.
     ///
     /// It is called by void `Soloud::stopVoice_internal(unsigned int aVoice)` when a voice ends
@@ -133,54 +176,71 @@ extern "C"
         sendToWorker("voiceEndedCallback", *handle);
 #endif
 
-        // The `dartVoiceEndedCallback` is not set on Web.
-        if (dartVoiceEndedCallback == nullptr)
+        // The `dartEventsReadyCallback` is not set on Web.
+        if (dartEventsReadyCallback == nullptr)
             return;
         // So, if the handle was already found before (henche the handle is not found), the
-        // callback to Dart has been already called. If this is the fist time this handle 
-        // is found, the callback to Dart must be called.
+        // event has been already sent to Dart. If this is the fist time this handle
+        // is found, the event must be sent.
         if (!isHandleFound)
             return;
-        // [n] pointer must be deleted in Dart.
-        unsigned int *n = (unsigned int *)malloc(sizeof(unsigned int *));
-        *n = *handle;
-        dartVoiceEndedCallback(n);
+        pushEvent({EVENT_VOICE_ENDED, *handle, 0, 0, nullptr});
     }
 
     /// The callback to monitor when a file is loaded.
     void fileLoadedCallback(enum PlayerErrors error, char *completeFileName, unsigned int *hash, uint64_t timeStamp)
     {
-        if (dartFileLoadedCallback == nullptr)
+        if (dartEventsReadyCallback == nullptr)
             return;
-        // [e,name,n] pointers must be deleted on Dart.
-        PlayerErrors *e = (PlayerErrors *)malloc(sizeof(PlayerErrors *));
-        *e = error;
-        char *name = strdup(completeFileName);
-        unsigned int *n = (unsigned int *)malloc(sizeof(unsigned int *));
-        *n = *hash;
-        uint64_t *ts = (uint64_t *)malloc(sizeof(uint64_t *));
-        *ts = timeStamp;
-        dartFileLoadedCallback(e, name, n, ts);
+        // The name is freed by Dart once the event is read.
+        {
+            std::lock_guard<std::mutex> lock(fileLoadedEventsMutex);
+            fileLoadedEvents.push_back({EVENT_FILE_LOADED, *hash, error, timeStamp, strdup(completeFileName)});
+        }
+        notifyEventsReady();
     }
 
     void stateChangedCallback(unsigned int state)
     {
-        PlayerStateEvents *type = (PlayerStateEvents *)malloc(sizeof(unsigned int *));
-        *type = (PlayerStateEvents)state;
-        if (dartStateChangedCallback != nullptr)
-            dartStateChangedCallback(type);
+        if (dartEventsReadyCallback == nullptr)
+            return;
+        pushEvent({EVENT_STATE_CHANGED, state, 0, 0, nullptr});
+    }
+
+    /// Set the Dart function to call when new events can be read with
+    /// [drainEvents].
+    FFI_PLUGIN_EXPORT void setDartEventCallback(dartEventsReadyCallback_t events_ready_callback)
+    {
+        dartEventsReadyCallback = events_ready_callback;
+        eventsPending.store(false);
     }
 
-    /// Set a Dart functions to call when an event occurs.
+    /// Move the oldest events to [buffer], to be called after the callback
+    /// set with [setDartEventCallback] and until it returns less than
+    /// [maxCount].
     ///
-    FFI_PLUGIN_EXPORT void setDartEventCallback(
-        dartVoiceEndedCallback_t voice_ended_callback,
-        dartFileLoadedCallback_t file_loaded_callback,
-        dartStateChangedCallback_t state_changed_callback)
+    /// [buffer] an array of [maxCount] events. The `completeFileName` of the
+    /// file loaded events must be freed with [nativeFree].
+    /// Return the number of events written to [buffer].
+    FFI_PLUGIN_EXPORT unsigned int drainEvents(PlayerEvent *buffer, unsigned int maxCount)
     {
-        dartVoiceEndedCallback = voice_ended_callback;
-        dartFileLoadedCallback = file_loaded_callback;
-        dartStateChangedCallback = state_changed_callback;
+        // Cleared before reading: an event pushed meanwhile calls the
+        // callback again instead of waiting for the next one.
+        eventsPending.store(false);
+        if (maxCount == 0)
+            return 0;
+        unsigned int count = 0;
+        if (events.takeDroppedCount() > 0)
+            buffer[count++] = {EVENT_VOICES_RESYNC, 0, 0, 0, nullptr};
+        {
+            std::lock_guard<std::mutex> lock(fileLoadedEventsMutex);
+            while (count < maxCount && !fileLoadedEvents.empty())
+            {
+                buffer[count++] = fileLoadedEvents.front();
+                fileLoadedEvents.pop_front();
+            }
+        }
+        return count + events.pop(buffer + count, maxCount - count);
     }
 
     //////////////////////////////////////////////////////////////////////////////////
@@ -238,6 +298,66 @@ extern "C"
         return (PlayerErrors)noError;
     }
 
+    /// Initialize the player without an audio device, to render the audio
+    /// faster than realtime with [renderOffline] or [renderOfflineToWav].
+    ///
+    /// [sampleRate] the sample rate of the rendered audio.
+    /// [bufferSize] the number of frames mixed at once.
+    /// [channels] 1=mono, 2=stereo, 4=quad, 6=5.1, 8=7.1.
+    ///
+    /// Returns [PlayerErrors.noError] if success.
+    FFI_PLUGIN_EXPORT enum PlayerErrors initEngineOffline(
+        unsigned int sampleRate,
+        unsigned int bufferSize,
+        unsigned int channels)
+    {
+        std::lock_guard<std::mutex> guard(init_deinit_mutex);
+        std::lock_guard<std::mutex> guard_load(loadMutex);
+
+        if (player.get() == nullptr)
+            player = std::make_unique<Player>();
+
+        player.get()->setStateChangedCallback(stateChangedCallback);
+        PlayerErrors res = player.get()->initOffline(sampleRate, bufferSize, channels);
+        if (res != noError)
+            return res;
+
+        const int windowSize = (player.get()->soloud.getBackendBufferSize() /
+                                player.get()->soloud.getBackendChannels()) -
+                               1;
+        analyzer.get()->setWindowsSize(windowSize);
+
+        player.get()->setVoiceEndedCallback(voiceEndedCallback);
+
+        return noError;
+    }
+
+    /// Mix the next [frames] frames of audio of an engine initialized with
+    /// [initEngineOffline].
+    ///
+    /// [buffer] receives [frames] * channels interleaved float samples.
+    FFI_PLUGIN_EXPORT enum PlayerErrors renderOffline(float *buffer, unsigned int frames)
+    {
+        std::lock_guard<std::mutex> guard(init_deinit_mutex);
+        if (player.get() == nullptr || !player.get()->isInited())
+            return backendNotInited;
+        return player.get()->renderOffline(buffer, frames);
+    }
+
+    /// Mix the next [frames] frames of audio of an engine initialized with
+    /// [initEngineOffline] into a 32 bit float WAV file.
+    ///
+    /// [path] the file to create or overwrite.
+    FFI_PLUGIN_EXPORT enum PlayerErrors renderOfflineToWav(const char *path, unsigned int frames)
+    {
+        std::lock_guard<std::mutex> guard(init_deinit_mutex);
+        if (player.get() == nullptr || !player.get()->isInited())
+            return backendNotInited;
+        if (path == nullptr)
+            return nullPointer;
+        return player.get()->renderOfflineToWav(path, frames);
+    }
+
     /// Change the playback device.
     ///
     /// [deviceID] the device ID. -1 for default OS output device.
@@ -308,12 +428,34 @@ extern "C"
     {
         if (player.get() == nullptr)
             return;
+#ifndef __EMSCRIPTEN__
+        // Report the pending loads and let the running ones end before
+        // the player goes away. The running ones take `init_deinit_mutex`,
+        // so it can't be held while waiting for them: the loads requested
+        // from now on are rejected instead.
+        {
+            std::lock_guard<std::mutex> guard(init_deinit_mutex);
+            disposing = true;
+        }
+        loadPool.cancelAll();
+#endif
         player.get()->disposeAllSound();
         std::lock_guard<std::mutex> guard(init_deinit_mutex);
         std::lock_guard<std::mutex> guard_load(loadMutex);
-        dartVoiceEndedCallback = nullptr;
-        dartFileLoadedCallback = nullptr;
-        dartStateChangedCallback = nullptr;
+#ifndef __EMSCRIPTEN__
+        disposing = false;
+#endif
+        dartEventsReadyCallback = nullptr;
+        // Nobody will read the events left.
+        PlayerEvent event;
+        while (events.pop(&event, 1) == 1)
+            continue;
+        {
+            std::lock_guard<std::mutex> lock(fileLoadedEventsMutex);
+            for (const PlayerEvent &loaded : fileLoadedEvents)
+                free(loaded.completeFileName);
+            fileLoadedEvents.clear();
+        }
         player.reset();
         player = nullptr;
         player = std::make_unique<Player>();
@@ -326,49 +468,139 @@ extern "C"
         return player.get()->isInited() ? 1 : 0;
     }
 
+#ifndef __EMSCRIPTEN__
+    /// Decode [completeFileName] and add it to the player sounds, then report
+    /// the result with [fileLoadedCallback]. Run by the [loadPool] threads.
+    void loadFileJob(
+        const std::string &completeFileName,
+        LoadMode loadMode,
+        uint64_t timeStamp,
+        bool cancelled)
+    {
+        std::filesystem::path pa = std::filesystem::u8path(completeFileName);
+        unsigned int hash = 0;
+        PlayerErrors error = noError;
+        bool dedup = false;
+        if (cancelled)
+            error = backendNotInited;
+        else
+        {
+            // Don't decode again a file already loaded.
+            std::lock_guard<std::mutex> guard_load(loadMutex);
+            if (player.get() == nullptr || !player.get()->isInited())
+                error = backendNotInited;
+            else if (player.get()->findByHash(Player::getFileHash(pa.string())) != nullptr)
+            {
+                hash = Player::getFileHash(pa.string());
+                error = fileAlreadyLoaded;
+            }
+            else
+                dedup = player.get()->getContentDedup();
+        }
+
+        // Nor the same content loaded under another name.
+        uint64_t contentHash = 0;
+        bool shared = false;
+        if (error == noError && dedup)
+        {
+            contentHash = Player::getContentHash(pa.string());
+            std::lock_guard<std::mutex> guard_init(init_deinit_mutex);
+            std::lock_guard<std::mutex> guard_load(loadMutex);
+            if (player.get() == nullptr || !player.get()->isInited())
+                error = backendNotInited;
+            else if (player.get()->findByHash(Player::getFileHash(pa.string())) != nullptr)
+            {
+                hash = Player::getFileHash(pa.string());
+                error = fileAlreadyLoaded;
+            }
+            else if (player.get()->addSharedSound(pa.string(), Player::getFileHash(pa.string()), contentHash, loadMode))
+            {
+                hash = Player::getFileHash(pa.string());
+                shared = true;
+            }
+        }
+
+        if (error == noError && !shared)
+        {
+            // The decoding runs without holding any lock. Only adding the
+            // new sound to the player is serialized.
+            std::unique_ptr<ActiveSound> newSound;
+            error = Player::decodeFile(pa.string(), loadMode, newSound);
+            if (error == noError)
+            {
+                newSound.get()->contentHash = contentHash;
+                std::lock_guard<std::mutex> guard_init(init_deinit_mutex);
+                std::lock_guard<std::mutex> guard_load(loadMutex);
+                if (player.get() == nullptr)
+                    error = backendNotInited;
+                else
+                    error = player.get()->addDecodedSound(std::move(newSound), &hash);
+            }
+        }
+
+        fileLoadedCallback(error, (char *)completeFileName.c_str(), &hash, timeStamp);
+    }
+#endif
+
     /// Load a new sound to be played once or multiple times later.
     ///
-    /// After loading the file, the [fileLoadedCallback] will call the
-    /// Dart function defined with [setDartEventCallback] which gives back
-    /// the error and the new hash.
+    /// The file is decoded by a pool of threads, so this returns immediately
+    /// and several files can be decoded at once. After loading the file, the
+    /// [fileLoadedCallback] will call the Dart function defined with
+    /// [setDartEventCallback] which gives back the error, the new hash and
+    /// the [timeStamp] identifying this request.
     ///
     /// [completeFileName] the complete file path.
-    /// [loadIntoMem] if true Soloud::wav will be used which loads
+    /// [loadMode] if LOAD_MODE_MEMORY Soloud::wav will be used which loads
     /// all audio data into memory. This will be useful when
     /// the audio is short, ie for game sounds, mainly used to prevent
     /// gaps or lags when starting a sound (less CPU, more memory allocated).
-    /// If false, Soloud::wavStream will be used and the audio data is loaded
+    /// LOAD_MODE_MEMORY_COMPACT does the same storing 16 bit samples, which
+    /// halves the memory allocated.
+    /// LOAD_MODE_MEMORY_COMPRESSED keeps the compressed data in memory and
+    /// decodes it when needed, with fast seeks.
+    /// If LOAD_MODE_DISK, Soloud::wavStream will be used and the audio data is loaded
     /// from the given file when needed (more CPU, less memory allocated).
-    /// See the [seek] note problem when using [loadIntoMem] = false
-    /// [hash] return the hash of the sound
-    /// Returns [PlayerErrors.noError] if success
+    /// See the [seek] note about mp3 files when using [loadMode] = LOAD_MODE_DISK
     FFI_PLUGIN_EXPORT void loadFile(
         char *completeFileName,
-        bool loadIntoMem,
+        int loadMode,
         uint64_t timeStamp)
     {
-        std::lock_guard<std::mutex> guard_init(init_deinit_mutex);
-        std::lock_guard<std::mutex> guard_load(loadMutex);
-
-        Player *p = player.get();
-        if (p == nullptr || !p->isInited())
         {
-            printf("WARNING (from SoLoud C++ binding code): the player has "
-                   "not yet been initialized. This is likely a bug in flutter_soloud. "
-                   "Please report the bug.\n");
-            return;
+            std::lock_guard<std::mutex> guard_init(init_deinit_mutex);
+            Player *p = player.get();
+            if (p == nullptr || !p->isInited())
+            {
+                printf("WARNING (from SoLoud C++ binding code): the player has "
+                       "not yet been initialized. This is likely a bug in flutter_soloud. "
+                       "Please report the bug.\n");
+                return;
+            }
         }
 
+#ifdef __EMSCRIPTEN__
+        // No threads on the web.
+        std::lock_guard<std::mutex> guard_init(init_deinit_mutex);
+        std::lock_guard<std::mutex> guard_load(loadMutex);
         std::filesystem::path pa = std::filesystem::u8path(completeFileName);
         unsigned int hash = 0;
-        // std::thread loadThread([p, pa, completeFileName, loadIntoMem, hash]()
-        //                        {
-        PlayerErrors error = p->loadFile(pa.string(), loadIntoMem, (unsigned int *)&hash);
-        // printf("*** LOAD FILE FROM THREAD error: %d  hash: %u\n", error,  *hash);
-        fileLoadedCallback(error, completeFileName, (unsigned int *)&hash, timeStamp);
-        // });
-        // // TODO(marco): use .detach()? Use std::atomic somewhere
-        // loadThread.join();
+        PlayerErrors error = player.get()->loadFile(pa.string(), (LoadMode)loadMode, &hash);
+        fileLoadedCallback(error, completeFileName, &hash, timeStamp);
+#else
+        std::lock_guard<std::mutex> guard_init(init_deinit_mutex);
+        if (disposing)
+        {
+            // Reported like the loads cancelled by [dispose].
+            unsigned int hash = 0;
+            fileLoadedCallback(backendNotInited, completeFileName, &hash, timeStamp);
+            return;
+        }
+        std::string name(completeFileName);
+        LoadMode mode = (LoadMode)loadMode;
+        loadPool.enqueue([name, mode, timeStamp](bool cancelled)
+                         { loadFileJob(name, mode, timeStamp, cancelled); });
+#endif
     }
 
     /// Load a new sound stored into [buffer] to be played once or multiple times later.
@@ -377,19 +609,23 @@ extern "C"
     /// [uniqueName] the unique name of the sound. Used only to have the [hash].
     /// [buffer] the audio data. These contains the audio file bytes.
     /// [length] the length of [buffer].
-    /// [loadIntoMem] if true Soloud::wav will be used which loads
+    /// [loadMode] if LOAD_MODE_MEMORY Soloud::wav will be used which loads
     /// all audio data into memory. This will be useful when
     /// the audio is short, ie for game sounds, mainly used to prevent
     /// gaps or lags when starting a sound (less CPU, more memory allocated).
-    /// If false, Soloud::wavStream will be used and the audio data is loaded
+    /// LOAD_MODE_MEMORY_COMPACT does the same storing 16 bit samples, which
+    /// halves the memory allocated.
+    /// LOAD_MODE_MEMORY_COMPRESSED keeps the compressed data in memory and
+    /// decodes it when needed, with fast seeks.
+    /// If LOAD_MODE_DISK, Soloud::wavStream will be used and the audio data is loaded
     /// from the given file when needed (more CPU, less memory allocated).
-    /// See the [seek] note problem when using [loadIntoMem] = false
+    /// See the [seek] note about mp3 files when using [loadMode] = LOAD_MODE_DISK
     /// [hash] return the hash of the sound.
     FFI_PLUGIN_EXPORT enum PlayerErrors loadMem(
         char *uniqueName,
         unsigned char *buffer,
         int length,
-        int loadIntoMem,
+        int loadMode,
         unsigned int *hash)
     {
         std::lock_guard<std::mutex> guard_init(init_deinit_mutex);
@@ -397,7 +633,7 @@ extern "C"
         // this check is already been done in Dart
         if (player.get() == nullptr || !player.get()->isInited())
             return backendNotInited;
-        return (PlayerErrors)player.get()->loadMem(uniqueName, buffer, length, loadIntoMem, *hash);
+        return (PlayerErrors)player.get()->loadMem(uniqueName, buffer, length, (LoadMode)loadMode, *hash);
     }
 
     /// Set up an audio stream.
@@ -769,6 +1005,8 @@ extern "C"
     /// the start of the stream. The loop start point can be set with this parameter, and
     /// current loop point can be queried with [getLoopingPoint] and
     /// changed by [setLoopingPoint].
+    /// [bus] the handle of a bus created with [createBus], 0 to play the
+    /// sound directly.
     /// Return the error if any and a new [handle] of this sound
     FFI_PLUGIN_EXPORT enum PlayerErrors play(
         unsigned int soundHash,
@@ -777,11 +1015,12 @@ extern "C"
         bool paused,
         bool looping,
         double loopingStartAt,
+        unsigned int bus,
         unsigned int *handle)
     {
         if (player.get() == nullptr || !player.get()->isInited())
             return backendNotInited;
-        PlayerErrors result = player.get()->play(soundHash, *handle, volume, pan, paused, looping, loopingStartAt);
+        PlayerErrors result = player.get()->play(soundHash, *handle, volume, pan, paused, looping, loopingStartAt, bus);
         return result;
     }
 
@@ -936,6 +1175,44 @@ extern "C"
         analyzer.get()->setSmoothing(smooth);
     }
 
+    /// Set the number of points of the FFT used by `getAudioTexture` and
+    /// `getAudioTexture2D`. This many of the latest output samples are
+    /// analyzed and the resulting bins are reduced to 256 FFT values.
+    ///
+    /// [fftSize] must be a power of two between 256 and 8192. Default is 512.
+    FFI_PLUGIN_EXPORT enum PlayerErrors setFftSize(int fftSize)
+    {
+        if (player.get() == nullptr || !player.get()->isInited())
+            return backendNotInited;
+        if (!analyzer.get()->setFftSize(fftSize))
+            return invalidParameter;
+        return noError;
+    }
+
+    /// Set the windowing algorithm applied to the wave data before the FFT.
+    ///
+    /// [window] one of the `FftWindow` values. Default is Blackman.
+    FFI_PLUGIN_EXPORT enum PlayerErrors setFftWindow(int window)
+    {
+        if (player.get() == nullptr || !player.get()->isInited())
+            return backendNotInited;
+        if (!analyzer.get()->setFftWindow((FftWindow)window))
+            return invalidParameter;
+        return noError;
+    }
+
+    /// The latest output samples analyzed by the FFT of the audio textures.
+    std::vector<float> fftWave;
+
+    /// Compute the 256 FFT values of the latest `Analyzer::getFftSize`
+    /// output samples.
+    float *calcTextureFFT()
+    {
+        fftWave.resize(analyzer.get()->getFftSize());
+        player.get()->soloud.getWaveHistory(fftWave.data(), (unsigned int)fftWave.size());
+        return analyzer.get()->calcFFT(fftWave.data());
+    }
+
     /// Return in [samples] a 512 float array.
     /// The first 256 floats represent the FFT frequencies data [>=0.0].
     /// The other 256 floats represent the wave data (amplitude) [-1.0~1.0].
@@ -953,7 +1230,7 @@ extern "C"
             return;
         }
         float *wave = player.get()->getWave(isTheSameAsBefore);
-        float *fft = analyzer.get()->calcFFT(wave);
+        float *fft = calcTextureFFT();
         
         if (*isTheSameAsBefore)
         {
@@ -967,46 +1244,82 @@ extern "C"
         *isTheSameAsBefore = false;
     }
 
+    /// Rows of 256 FFT values plus 256 of wave data. The newest row is at
+    /// [textureRingHead], the older ones follow it wrapping around.
+    float textureRing[256][512];
+    int textureRingHead = 0;
+
+    /// Write a new row in the next [textureRing] slot. Returns false if
+    /// the wave data didn't change since the last row.
+    bool updateTextureRing(bool *isTheSameAsBefore)
+    {
+        if (player.get() == nullptr || !player.get()->isInited() ||
+            analyzer.get() == nullptr || !player.get()->isVisualizationEnabled())
+        {
+            memset(textureRing, 0, sizeof(textureRing));
+            *isTheSameAsBefore = true;
+            return false;
+        }
+
+        float *wave = player.get()->getWave(isTheSameAsBefore);
+        float *fft = calcTextureFFT();
+        if (*isTheSameAsBefore)
+            return false;
+
+        textureRingHead = (textureRingHead + 255) & 255;
+        memcpy(textureRing[textureRingHead], fft, sizeof(float) * 256);
+        memcpy(textureRing[textureRingHead] + 256, wave, sizeof(float) * 256);
+        return true;
+    }
+
     /// Return a floats matrix of 256x512
     /// Every row are composed of 256 FFT values plus 256 of wave data
     /// Every time is called, a new row is stored in the
     /// first row and all the previous rows are shifted
     /// up (the last one will be lost).
     ///
+    /// NOTE: the rows are unrolled from the ring of `getAudioTexture2DRing`,
+    /// which copies the whole matrix. Prefer that function for new code.
+    ///
     /// [samples]
     float texture2D[256][512];
     FFI_PLUGIN_EXPORT void getAudioTexture2D(float **samples, bool *isTheSameAsBefore)
     {
-        if (player.get() == nullptr || !player.get()->isInited() ||
-            analyzer.get() == nullptr || !player.get()->isVisualizationEnabled())
-        {
-            *samples = *texture2D;
-            memset(*samples, 0, sizeof(float) * 512 * 256);
-            *isTheSameAsBefore = true;
-            return;
-        }
-
-        float *wave = player.get()->getWave(isTheSameAsBefore);
-        float *fft = analyzer.get()->calcFFT(wave);
-        if (*isTheSameAsBefore)
+        *samples = *texture2D;
+        if (!updateTextureRing(isTheSameAsBefore))
         {
-            *samples = *texture2D;
+            if (player.get() == nullptr || !player.get()->isInited() ||
+                analyzer.get() == nullptr || !player.get()->isVisualizationEnabled())
+                memset(*samples, 0, sizeof(float) * 512 * 256);
             return;
         }
 
-        /// shift up 1 row
-        memmove(texture2D[1], texture2D[0], sizeof(float) * 512 * 255);
-        /// store the new 1st row
-        memcpy(texture2D[0], fft, sizeof(float) * 256);
-        memcpy(texture2D[0] + 256, wave, sizeof(float) * 256);
-
-        *samples = *texture2D;
+        /// unroll the ring starting from the newest row
+        const int newest = 256 - textureRingHead;
+        memcpy(texture2D[0], textureRing[textureRingHead], sizeof(float) * 512 * newest);
+        memcpy(texture2D[newest], textureRing[0], sizeof(float) * 512 * textureRingHead);
         *isTheSameAsBefore = false;
     }
 
+    /// Return a floats matrix of 256x512 used as a ring of rows.
+    /// Every row are composed of 256 FFT values plus 256 of wave data.
+    /// Every time is called, a new row is stored in the slot before the
+    /// previous one and [head] is set to its index. Row `(head + i) % 256`
+    /// is `i` rows old, so a shader can scroll by offsetting its coordinates
+    /// instead of having the whole matrix moved.
+    ///
+    /// [samples] the matrix.
+    /// [head] the index of the newest row.
+    FFI_PLUGIN_EXPORT void getAudioTexture2DRing(float **samples, int *head, bool *isTheSameAsBefore)
+    {
+        updateTextureRing(isTheSameAsBefore);
+        *samples = *textureRing;
+        *head = textureRingHead;
+    }
+
     FFI_PLUGIN_EXPORT float getTextureValue(int row, int column)
     {
-        return texture2D[row][column];
+        return textureRing[(textureRingHead + row) & 255][column];
     }
 
     /// Get the sound length in seconds
@@ -1026,16 +1339,10 @@ extern "C"
     /// [handle] the sound handle
     /// Returns [PlayerErrors.noError] if success
     ///
-    /// NOTE: when seeking an mp3 file loaded using `loadIntoMem`=false
-    /// the seek operation is not performed due to lags. This occurs because the
-    /// mp3 codec must compute each frame length to gain a new position.
-    /// The problem is explained in souloud_wavstream.cpp
-    /// in `WavStreamInstance::seek` function.
-    ///
-    /// This mode is useful ie for background music, not for a music player
-    /// where a seek slider for mp3s is a must.
-    /// If you need seeking mp3, please, use `loadIntoMem`=true instead
-    /// or other audio formats!
+    /// NOTE: mp3 files loaded using `loadMode`=LOAD_MODE_DISK are indexed
+    /// when loaded: loading reads the whole file once, and then the seek only
+    /// decodes a few frames from the closest index point.
+    /// See `WavStream::buildMp3SeekTable` in souloud_wavstream.cpp.
     ///
     FFI_PLUGIN_EXPORT enum PlayerErrors seek(unsigned int handle, float time)
     {
@@ -1157,7 +1464,8 @@ extern "C"
         return player.get()->getActiveVoiceCount_internal();
     }
 
-    /// Returns the number of concurrent sounds that are playing a specific audio source.
+    /// Returns the number of concurrent sounds that are playing a specific audio source,
+    /// or -1 if the audio source is shared with other sounds.
     FFI_PLUGIN_EXPORT int countAudioSource(unsigned int soundHash)
     {
         if (player.get() == nullptr || !player.get()->isInited())
@@ -1243,6 +1551,113 @@ extern "C"
         player.get()->setMaxActiveVoiceCount(maxVoiceCount);
     }
 
+    /// Set the number of worker threads that render the voices along with
+    /// the audio thread. 0 renders all the voices on the audio thread.
+    /// [threadCount] the number of workers, up to 64.
+    FFI_PLUGIN_EXPORT enum PlayerErrors setMixThreadCount(unsigned int threadCount)
+    {
+        if (player.get() == nullptr || !player.get()->isInited())
+            return backendNotInited;
+#ifdef __EMSCRIPTEN__
+        return notImplemented;
+#else
+        return player.get()->setMixThreadCount(threadCount);
+#endif
+    }
+
+    /// Decode a sound loaded with [LoadMode.disk] ahead of its voices on a
+    /// background thread, so that a slow storage doesn't stall the audio
+    /// thread. Only the voices started after this call are prefetched.
+    /// [soundHash] the hash of the sound.
+    /// [milliseconds] how much audio is kept decoded for each voice. 0 decodes
+    /// on the audio thread.
+    FFI_PLUGIN_EXPORT enum PlayerErrors setPrefetch(unsigned int soundHash, unsigned int milliseconds)
+    {
+        if (player.get() == nullptr || !player.get()->isInited())
+            return backendNotInited;
+#ifdef __EMSCRIPTEN__
+        return notImplemented;
+#else
+        return player.get()->setPrefetch(soundHash, milliseconds);
+#endif
+    }
+
+    /// Get the number of times a prefetched voice played silence because
+    /// its audio was not decoded in time.
+    FFI_PLUGIN_EXPORT unsigned int getPrefetchUnderrunCount()
+    {
+        if (player.get() == nullptr || !player.get()->isInited())
+            return 0;
+        return player.get()->getPrefetchUnderrunCount();
+    }
+
+    /// Enable or disable the timing of the audio callback, of the resampling
+    /// and of the filters. Disabled by default.
+    FFI_PLUGIN_EXPORT void setPerfCountersEnabled(bool enabled)
+    {
+        if (player.get() == nullptr || !player.get()->isInited())
+            return;
+        player.get()->setPerfCountersEnabled(enabled);
+    }
+
+    /// Copy the performance counters of the mixing to [snapshot].
+    ///
+    /// [snapshot] the struct to fill, see `soloud_perf.h`.
+    FFI_PLUGIN_EXPORT enum PlayerErrors getPerfSnapshot(SoLoud::PerfSnapshot *snapshot)
+    {
+        if (player.get() == nullptr || !player.get()->isInited())
+            return backendNotInited;
+        player.get()->getPerfSnapshot(snapshot);
+        return noError;
+    }
+
+    /// Zero the performance counters.
+    FFI_PLUGIN_EXPORT void resetPerfCounters()
+    {
+        if (player.get() == nullptr || !player.get()->isInited())
+            return;
+        player.get()->resetPerfCounters();
+    }
+
+    /// Share the audio source of the sounds loaded from the same bytes under
+    /// different names, instead of decoding them again.
+    ///
+    /// [enabled] false by default. Only the sounds loaded while it is enabled
+    /// are deduplicated.
+    FFI_PLUGIN_EXPORT void setContentDedup(bool enabled)
+    {
+        std::lock_guard<std::mutex> guard_load(loadMutex);
+        if (player.get() == nullptr || !player.get()->isInited())
+            return;
+        player.get()->setContentDedup(enabled);
+    }
+
+    /// Return true if the sounds are deduplicated by content.
+    FFI_PLUGIN_EXPORT int getContentDedup()
+    {
+        if (player.get() == nullptr || !player.get()->isInited())
+            return 0;
+        return player.get()->getContentDedup() ? 1 : 0;
+    }
+
+    /////////////////////////////////////////
+    /// buses
+    /////////////////////////////////////////
+
+    /// Create a bus and start it. The sounds played on it with [play] or
+    /// [play3d] are mixed together and go through the filters of the bus
+    /// once, instead of each voice running its own filters.
+    ///
+    /// [hash] return the hash of the bus, to add filters to it.
+    /// [handle] return the handle of the bus, to play sounds on it and to
+    /// set its volume and filter parameters.
+    FFI_PLUGIN_EXPORT enum PlayerErrors createBus(unsigned int *hash, unsigned int *handle)
+    {
+        if (player.get() == nullptr || !player.get()->isInited())
+            return backendNotInited;
+        return player.get()->createBus(*hash, *handle);
+    }
+
     /////////////////////////////////////////
     /// voice groups
     /////////////////////////////////////////
@@ -1646,6 +2061,8 @@ extern "C"
     /// the start of the stream. The loop start point can be set with this parameter, and
     /// current loop point can be queried with [getLoopingPoint] and
     /// changed by [setLoopingPoint].
+    /// [bus] the handle of a bus created with [createBus], 0 to play the
+    /// sound directly.
     /// [handle] pointer to the handle for this new sound
     /// Return the error if any
     FFI_PLUGIN_EXPORT PlayerErrors play3d(
@@ -1660,6 +2077,7 @@ extern "C"
         bool paused,
         bool looping,
         double loopingStartAt,
+        unsigned int bus,
         unsigned int *handle)
     {
         if (player.get() == nullptr || !player.get()->isInited() ||
@@ -1673,7 +2091,7 @@ extern "C"
             velX, velY, velZ,
             volume,
             paused,
-            0,
+            bus,
             looping,
             loopingStartAt);
         return result;
@@ -1878,9 +2296,12 @@ extern "C"
         float endTime,
         unsigned long numSamplesNeeded,
         bool average,
-        float *pSamples)
+        float *pSamples,
+        unsigned int threadCount,
+        const char *cacheDir,
+        bool buildCache)
     {
-        return Waveform::readSamples(filePath, nullptr, 0, startTime, endTime, numSamplesNeeded, average, pSamples);
+        return Waveform::readSamples(filePath, nullptr, 0, startTime, endTime, numSamplesNeeded, average, pSamples, threadCount, cacheDir, buildCache);
     }
 
     FFI_PLUGIN_EXPORT enum ReadSamplesErrors readSamplesFromMem(
@@ -1890,9 +2311,12 @@ extern "C"
         float endTime,
         unsigned long numSamplesNeeded,
         bool average,
-        float *pSamples)
+        float *pSamples,
+        unsigned int threadCount,
+        const char *cacheDir,
+        bool buildCache)
     {
-        return Waveform::readSamples(nullptr, buffer, dataSize, startTime, endTime, numSamplesNeeded, average, pSamples);
+        return Waveform::readSamples(nullptr, buffer, dataSize, startTime, endTime, numSamplesNeeded, average, pSamples, threadCount, cacheDir, buildCache);
     }
 
 #ifdef __cplusplus
@@ -7,6 +7,13 @@
 #include <algorithm>
 #endif
 
+#include <sys/stat.h>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
 void platform_log(const char *fmt, ...) {
     va_list args;
     va_start(args, fmt);
@@ -25,4 +32,109 @@ void platform_log(const char *fmt, ...) {
     setvbuf(stdout, (char*)NULL, _IONBF, 0);
 #endif
 
-}
\ No newline at end of file
+}
+
+namespace
+{
+    const uint64_t PRIME1 = 0x9E3779B185EBCA87ULL;
+    const uint64_t PRIME2 = 0xC2B2AE3D27D4EB4FULL;
+    const uint64_t PRIME3 = 0x165667B19E3779F9ULL;
+
+    inline uint64_t rotl(uint64_t x, int r)
+    {
+        return (x << r) | (x >> (64 - r));
+    }
+
+    inline uint64_t read64(const unsigned char *p)
+    {
+        uint64_t v;
+        memcpy(&v, p, 8);
+        return v;
+    }
+
+    /// Hash computed on 4 independent 64 bit lanes, which keeps several
+    /// multiplications in flight. Data is consumed by stripes of 32 bytes.
+    struct ContentHasher
+    {
+        uint64_t lanes[4] = {PRIME1 + PRIME2, PRIME2, 0, 0 - PRIME1};
+        uint64_t totalSize = 0;
+
+        void addStripes(const unsigned char *data, size_t stripes)
+        {
+            for (size_t i = 0; i < stripes; i++, data += 32)
+                for (int l = 0; l < 4; l++)
+                    lanes[l] = rotl(lanes[l] + read64(data + l * 8) * PRIME2, 31) * PRIME1;
+            totalSize += stripes * 32;
+        }
+
+        uint64_t finish(const unsigned char *tail, size_t tailSize)
+        {
+            uint64_t h = rotl(lanes[0], 1) + rotl(lanes[1], 7) + rotl(lanes[2], 12) + rotl(lanes[3], 18);
+            h += totalSize + tailSize;
+            for (size_t i = 0; i < tailSize; i++)
+                h = rotl(h ^ (tail[i] * PRIME3), 11) * PRIME1;
+            h ^= h >> 33;
+            h *= PRIME2;
+            h ^= h >> 29;
+            h *= PRIME3;
+            h ^= h >> 32;
+            return h;
+        }
+    };
+
+    struct FileHash
+    {
+        long long size;
+        long long modified;
+        uint64_t hash;
+    };
+    std::mutex fileHashesMutex;
+    std::unordered_map<std::string, FileHash> fileHashes;
+} // namespace
+
+uint64_t hashContent(const unsigned char *data, size_t size)
+{
+    ContentHasher hasher;
+    hasher.addStripes(data, size / 32);
+    return hasher.finish(data + size / 32 * 32, size % 32);
+}
+
+bool hashFileContent(const char *filePath, uint64_t *hash)
+{
+    struct stat st;
+    if (stat(filePath, &st) != 0)
+        return false;
+
+    {
+        std::lock_guard<std::mutex> guard(fileHashesMutex);
+        auto it = fileHashes.find(filePath);
+        if (it != fileHashes.end() &&
+            it->second.size == (long long)st.st_size &&
+            it->second.modified == (long long)st.st_mtime)
+        {
+            *hash = it->second.hash;
+            return true;
+        }
+    }
+
+    FILE *file = fopen(filePath, "rb");
+    if (file == NULL)
+        return false;
+    // A multiple of the stripe size, so only the last read leaves a tail.
+    const size_t chunkSize = 1 << 20;
+    std::vector<unsigned char> chunk(chunkSize);
+    ContentHasher hasher;
+    size_t read;
+    while ((read = fread(chunk.data(), 1, chunkSize, file)) == chunkSize)
+        hasher.addStripes(chunk.data(), chunkSize / 32);
+    bool ok = ferror(file) == 0;
+    fclose(file);
+    if (!ok)
+        return false;
+    hasher.addStripes(chunk.data(), read / 32);
+    *hash = hasher.finish(chunk.data() + read / 32 * 32, read % 32);
+
+    std::lock_guard<std::mutex> guard(fileHashesMutex);
+    fileHashes[filePath] = {(long long)st.st_size, (long long)st.st_mtime, *hash};
+    return true;
+}
@@ -26,6 +26,8 @@
     #define _WASM_
 #endif
 
+#include <stddef.h>
+#include <stdint.h>
 
 #ifdef _IS_ANDROID_
 #include <android/log.h>
@@ -53,6 +55,14 @@
 void platform_log(const char *fmt, ...);
 #endif
 
+/// Hash of the audio data used to recognize the same content, e.g. to name
+/// and validate the peak cache files.
+uint64_t hashContent(const unsigned char *data, size_t size);
+
+/// Hash the content of [filePath]. The hash is remembered until the
+/// size or the modification time of the file change.
+bool hashFileContent(const char *filePath, uint64_t *hash);
+
 #define MIN(a, b) (((a) < (b)) ? (a) : (b))
 
 #endif // COMMON_H
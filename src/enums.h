@@ -73,6 +73,8 @@ typedef enum PlayerErrors
     audioFormatNotSupported = 29,
     /// Opus ogg vorbis libraries not found.
     opusOggVorbisLibsNotFound = 30,
+    /// Given handle doesn't belong to a bus.
+    handleIsNotABus = 31,
 } PlayerErrors_t;
 
 /// Possible read sample errors
@@ -110,6 +112,8 @@ typedef enum SoundType
     TYPE_SYNTH,
     // this sound is a streaming buffer
     TYPE_BUFFER_STREAM,
+    // this sound is a bus mixing the voices played on it, see `Player::createBus`
+    TYPE_BUS,
 } SoundType_t;
 
 typedef enum FilterType
@@ -128,6 +132,30 @@ typedef enum FilterType
     CompressorFilter
 } FilterType_t;
 
+/// Windowing algorithms applied to the wave data before the FFT.
+/// WARNING: Keep these in sync with `lib/src/enums.dart`.
+typedef enum FftWindow
+{
+    FFT_WINDOW_BLACKMAN = 0,
+    FFT_WINDOW_HANN = 1,
+    FFT_WINDOW_HAMMING = 2,
+    FFT_WINDOW_GAUSS = 3,
+} FftWindow_t;
+
+/// How the audio data of a loaded sound is stored.
+/// WARNING: Keep these in sync with `lib/src/enums.dart`.
+typedef enum LoadMode
+{
+    // using Soloud::wavStream, decoding the file when needed
+    LOAD_MODE_DISK = 0,
+    // using Soloud::wav with float samples
+    LOAD_MODE_MEMORY = 1,
+    // using Soloud::wav with 16 bit samples
+    LOAD_MODE_MEMORY_COMPACT = 2,
+    // using Soloud::wavStream, decoding the compressed data kept in memory
+    LOAD_MODE_MEMORY_COMPRESSED = 3,
+} LoadMode_t;
+
 /// WARNING: Keep these in sync with `lib/src/enums.dart`.
 typedef enum BufferType
 {
@@ -0,0 +1,79 @@
+#include "event_queue.h"
+
+EventQueue::EventQueue(unsigned int capacity)
+    : mPushPos(0), mPopPos(0), mDropped(0)
+{
+    size_t size = 2;
+    while (size < capacity)
+        size <<= 1;
+    mSlots.reset(new Slot[size]);
+    mMask = size - 1;
+    for (size_t i = 0; i < size; i++)
+        mSlots[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+bool EventQueue::push(const PlayerEvent &event)
+{
+    Slot *slot;
+    size_t pos = mPushPos.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        slot = &mSlots[pos & mMask];
+        size_t sequence = slot->sequence.load(std::memory_order_acquire);
+        intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+        if (diff == 0)
+        {
+            // The slot is free: claim it.
+            if (mPushPos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                break;
+        }
+        else if (diff < 0)
+        {
+            // The slot still holds the event pushed a lap ago.
+            mDropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        else
+            pos = mPushPos.load(std::memory_order_relaxed);
+    }
+
+    slot->event = event;
+    slot->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+unsigned int EventQueue::pop(PlayerEvent *events, unsigned int maxCount)
+{
+    unsigned int count = 0;
+    while (count < maxCount)
+    {
+        Slot *slot;
+        size_t pos = mPopPos.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            slot = &mSlots[pos & mMask];
+            size_t sequence = slot->sequence.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)sequence - (intptr_t)(pos + 1);
+            if (diff == 0)
+            {
+                if (mPopPos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0)
+                // Empty, or the next event is still being written.
+                return count;
+            else
+                pos = mPopPos.load(std::memory_order_relaxed);
+        }
+
+        events[count++] = slot->event;
+        // Free the slot for the push one lap ahead.
+        slot->sequence.store(pos + mMask + 1, std::memory_order_release);
+    }
+    return count;
+}
+
+unsigned int EventQueue::takeDroppedCount()
+{
+    return mDropped.exchange(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,79 @@
+#ifndef EVENT_QUEUE_H
+#define EVENT_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+/// The kind of a [PlayerEvent].
+/// WARNING: Keep these in sync with `lib/src/bindings/player_events_ffi.dart`.
+typedef enum PlayerEventType
+{
+    /// [value] is the handle of the voice ended or stopped.
+    EVENT_VOICE_ENDED = 0,
+    /// [value] is the hash of the sound, [error] the result of the load,
+    /// [timeStamp] and [completeFileName] identify the request.
+    EVENT_FILE_LOADED = 1,
+    /// [value] is the new `PlayerStateEvents`.
+    EVENT_STATE_CHANGED = 2,
+    /// Events have been dropped because the queue was full: the voice ended
+    /// ones among them are lost, and the voice handles must be checked.
+    EVENT_VOICES_RESYNC = 3,
+} PlayerEventType_t;
+
+/// An event sent to Dart. The struct is read as is by Dart, which is the
+/// owner of [completeFileName] and must free it with `nativeFree`.
+/// WARNING: Keep this in sync with `lib/src/bindings/player_events_ffi.dart`.
+typedef struct PlayerEvent
+{
+    int32_t type;
+    uint32_t value;
+    int32_t error;
+    uint64_t timeStamp;
+    char *completeFileName;
+} PlayerEvent;
+
+/// Bounded lock-free queue of [PlayerEvent]s.
+///
+/// Any thread can push and pop at the same time, the audio thread included:
+/// [push] never allocates nor blocks. When the queue is full the event is
+/// dropped and counted.
+class EventQueue
+{
+public:
+    /// @param capacity the maximum number of events queued, rounded up to a
+    /// power of two.
+    explicit EventQueue(unsigned int capacity = 4096);
+
+    /// @brief Queue [event].
+    /// @return false if the queue is full.
+    bool push(const PlayerEvent &event);
+
+    /// @brief Move up to [maxCount] of the oldest events to [events].
+    /// @return the number of events moved.
+    unsigned int pop(PlayerEvent *events, unsigned int maxCount);
+
+    /// @brief Return the number of events dropped because the queue was full,
+    /// and reset it.
+    unsigned int takeDroppedCount();
+
+private:
+    struct Slot
+    {
+        /// The push position this slot is waiting for, or the position + 1
+        /// once [event] has been written.
+        std::atomic<size_t> sequence;
+        PlayerEvent event;
+    };
+
+    std::unique_ptr<Slot[]> mSlots;
+    size_t mMask;
+    /// Written by the producers and by the consumers: keep them on their
+    /// own cache lines.
+    alignas(64) std::atomic<size_t> mPushPos;
+    alignas(64) std::atomic<size_t> mPopPos;
+    std::atomic<unsigned int> mDropped;
+};
+
+#endif // EVENT_QUEUE_H
@@ -1,10 +1,73 @@
 #include "compressor.h"
+#include "fast_math.h"
 
 #include <algorithm>
 #include <cmath>
 #include <stdio.h>
 #include <iostream>
 
+namespace {
+
+/// The gain of the compressor with its makeup, from the envelope in dB.
+struct CompressorCurve
+{
+    float threshold;
+    float kneeWidth;
+    float invKneeWidth2;
+    float slope;
+    float makeupGain;
+
+    CompressorCurve(float aThreshold, float aKneeWidth, float aRatio, float aMakeupGain)
+    {
+        threshold = aThreshold;
+        kneeWidth = aKneeWidth;
+        invKneeWidth2 = aKneeWidth > 0.f ? 1.0f / (aKneeWidth * aKneeWidth) : 0.f;
+        slope = 1.0f - (1.0f / aRatio);
+        makeupGain = aMakeupGain;
+    }
+
+    float gain(float aEnvelope) const
+    {
+        // Determine gain reduction in dB
+        float gainReductionDb = 0.0f;
+        const float delta = aEnvelope - threshold;
+        if (delta > 0.f) {
+            if (delta < kneeWidth) {
+                // Soft knee region
+                gainReductionDb = -slope * delta * delta * delta * invKneeWidth2;
+            } else {
+                // Hard knee
+                gainReductionDb = -slope * delta;
+            }
+        }
+        return FastMath::dbToGain(gainReductionDb + makeupGain);
+    }
+
+#if defined(SOLOUD_SSE_INTRINSICS)
+    __m128 gain_ps(__m128 aEnvelope) const
+    {
+        const __m128 delta = _mm_sub_ps(aEnvelope, _mm_set1_ps(threshold));
+        const __m128 hard = _mm_mul_ps(_mm_set1_ps(-slope), delta);
+        const __m128 soft = _mm_mul_ps(hard, _mm_mul_ps(_mm_mul_ps(delta, delta), _mm_set1_ps(invKneeWidth2)));
+        __m128 gainReductionDb = FastMath::select_ps(_mm_cmplt_ps(delta, _mm_set1_ps(kneeWidth)), soft, hard);
+        gainReductionDb = _mm_and_ps(_mm_cmpgt_ps(delta, _mm_setzero_ps()), gainReductionDb);
+        return FastMath::dbToGain_ps(_mm_add_ps(gainReductionDb, _mm_set1_ps(makeupGain)));
+    }
+#elif defined(SOLOUD_NEON_INTRINSICS)
+    float32x4_t gain_ps(float32x4_t aEnvelope) const
+    {
+        const float32x4_t delta = vsubq_f32(aEnvelope, vdupq_n_f32(threshold));
+        const float32x4_t hard = vmulq_n_f32(delta, -slope);
+        const float32x4_t soft = vmulq_f32(hard, vmulq_n_f32(vmulq_f32(delta, delta), invKneeWidth2));
+        float32x4_t gainReductionDb = FastMath::select_ps(vcltq_f32(delta, vdupq_n_f32(kneeWidth)), soft, hard);
+        gainReductionDb = FastMath::select_ps(vcgtq_f32(delta, vdupq_n_f32(0.f)), gainReductionDb, vdupq_n_f32(0.f));
+        return FastMath::dbToGain_ps(vaddq_f32(gainReductionDb, vdupq_n_f32(makeupGain)));
+    }
+#endif
+};
+
+} // namespace
+
 CompressorInstance::CompressorInstance(Compressor *aParent)
 {
     mParent = aParent;
@@ -19,6 +82,8 @@ CompressorInstance::CompressorInstance(Compressor *aParent)
 
     attackCoef = expf(-1.0f / (mParam[Compressor::ATTACK_TIME] * 0.001f * mParent->mSamplerate));
     releaseCoef = expf(-1.0f / (mParam[Compressor::RELEASE_TIME] * 0.001f * mParent->mSamplerate));
+    // The level of silence, 20 * log10(1e-8).
+    mEnvelope = -160.0f;
 }
 
 void CompressorInstance::filter(
@@ -31,52 +96,80 @@ void CompressorInstance::filter(
 {
     updateParams(aTime);
 
-    // Convert makeup gain to a linear scale
-    float makeupGainLin = powf(10.0f, mParam[Compressor::MAKEUP_GAIN] / 20.0f);
+    const CompressorCurve curve(
+        mParam[Compressor::THRESHOLD],
+        mParam[Compressor::KNEE_WIDTH],
+        mParam[Compressor::RATIO],
+        mParam[Compressor::MAKEUP_GAIN]);
 
-    float envelope = 0.0f;
+    // The levels, envelope and gains are computed 4 samples at a time where
+    // they don't depend on the previous sample, in blocks to not allocate.
+    for (unsigned int offset = 0; offset < aSamples; offset += SAMPLE_GRANULARITY) {
+        const unsigned int count = std::min(aSamples - offset, (unsigned int)SAMPLE_GRANULARITY);
 
-    for (unsigned int i = 0; i < aBufferSize; ++i) {
+        // The channels are linked: the loudest one drives the envelope.
+        std::fill(mLevel, mLevel + count, 1e-8f);
         for (unsigned int ch = 0; ch < aChannels; ++ch) {
-            float *sample = &aBuffer[i * aChannels + ch];
-            float inputLevel = fabsf(*sample);
-
-            // Convert the input level to dB for comparison
-            float inputLevelDb = 20.0f * log10f(fmaxf(inputLevel, 1e-8f));
+            const float *channel = aBuffer + ch * aBufferSize + offset;
+            for (unsigned int i = 0; i < count; ++i)
+                mLevel[i] = std::max(mLevel[i], std::fabs(channel[i]));
+        }
 
-            // Smooth the envelope
-            if (inputLevelDb > envelope) {
-                envelope = attackCoef * (envelope - inputLevelDb) + inputLevelDb;
-            } else {
-                envelope = releaseCoef * (envelope - inputLevelDb) + inputLevelDb;
-            }
+        // Convert the input level to dB for comparison
+        unsigned int i = 0;
+#if defined(SOLOUD_SSE_INTRINSICS)
+        for (; i + 4 <= count; i += 4)
+            _mm_storeu_ps(mLevel + i, FastMath::gainToDb_ps(_mm_loadu_ps(mLevel + i)));
+#elif defined(SOLOUD_NEON_INTRINSICS)
+        for (; i + 4 <= count; i += 4)
+            vst1q_f32(mLevel + i, FastMath::gainToDb_ps(vld1q_f32(mLevel + i)));
+#endif
+        for (; i < count; ++i)
+            mLevel[i] = FastMath::gainToDb(mLevel[i]);
 
-            // Determine gain reduction in dB
-            float gainReductionDb = 0.0f;
-            if (envelope > mParam[Compressor::THRESHOLD]) {
-                if (envelope < (mParam[Compressor::THRESHOLD] + mParam[Compressor::KNEE_WIDTH])) {
-                    // Soft knee region
-                    float delta = envelope - mParam[Compressor::THRESHOLD];
-                    gainReductionDb = (1.0f - (1.0f / mParam[Compressor::RATIO])) * powf(delta / mParam[Compressor::KNEE_WIDTH], 2.0f) * delta;
-                } else {
-                    // Hard knee
-                    gainReductionDb = (mParam[Compressor::THRESHOLD] - envelope) * (1.0f - (1.0f / mParam[Compressor::RATIO]));
-                }
-            }
+        // Smooth the envelope
+        for (i = 0; i < count; ++i) {
+            const float coef = mLevel[i] > mEnvelope ? attackCoef : releaseCoef;
+            mEnvelope = coef * (mEnvelope - mLevel[i]) + mLevel[i];
+            mGain[i] = mEnvelope;
+        }
 
-            // Convert gain reduction back to linear
-            float gainReductionLin = powf(10.0f, gainReductionDb / 20.0f);
+        // Convert the gain reduction and makeup gain to linear, with the wet/dry
+        // mix ramping from its previous value
+        getParamRamp(Compressor::WET, mWet, offset, count, aSamples);
+        i = 0;
+#if defined(SOLOUD_SSE_INTRINSICS)
+        const __m128 one = _mm_set1_ps(1.0f);
+        for (; i + 4 <= count; i += 4) {
+            const __m128 gain = curve.gain_ps(_mm_loadu_ps(mGain + i));
+            const __m128 wet = _mm_loadu_ps(mWet + i);
+            _mm_storeu_ps(mGain + i, _mm_add_ps(_mm_mul_ps(gain, wet), _mm_sub_ps(one, wet)));
+        }
+#elif defined(SOLOUD_NEON_INTRINSICS)
+        const float32x4_t one = vdupq_n_f32(1.0f);
+        for (; i + 4 <= count; i += 4) {
+            const float32x4_t gain = curve.gain_ps(vld1q_f32(mGain + i));
+            const float32x4_t wet = vld1q_f32(mWet + i);
+            vst1q_f32(mGain + i, vmlaq_f32(vsubq_f32(one, wet), gain, wet));
+        }
+#endif
+        for (; i < count; ++i)
+            mGain[i] = curve.gain(mGain[i]) * mWet[i] + (1.0f - mWet[i]);
 
-            // Apply gain reduction, makeup gain, and wet/dry mix
-            *sample = mParam[Compressor::WET] * 
-                    (*sample * gainReductionLin * makeupGainLin) + 
-                    (1.0f - mParam[Compressor::WET]) * 
-                    (*sample);
+        for (unsigned int ch = 0; ch < aChannels; ++ch) {
+            float *channel = aBuffer + ch * aBufferSize + offset;
+            i = 0;
+#if defined(SOLOUD_SSE_INTRINSICS)
+            for (; i + 4 <= count; i += 4)
+                _mm_storeu_ps(channel + i, _mm_mul_ps(_mm_loadu_ps(channel + i), _mm_loadu_ps(mGain + i)));
+#elif defined(SOLOUD_NEON_INTRINSICS)
+            for (; i + 4 <= count; i += 4)
+                vst1q_f32(channel + i, vmulq_f32(vld1q_f32(channel + i), vld1q_f32(mGain + i)));
+#endif
+            for (; i < count; ++i)
+                channel[i] *= mGain[i];
         }
     }
-
-    // printf("CompressorInstance::filter(%f, %f)\n",
-    //        mParam[Compressor::THRESHOLD], threshold);
 }
 
 void CompressorInstance::setFilterParameter(unsigned int aAttributeId, float aValue)
@@ -11,6 +11,12 @@ class CompressorInstance : public SoLoud::FilterInstance
     Compressor *mParent;
     float attackCoef;
     float releaseCoef;
+    // The level followed in dB, kept between the calls.
+    float mEnvelope;
+    // Levels, gains and wet levels of the block being processed.
+    float mLevel[SAMPLE_GRANULARITY];
+    float mGain[SAMPLE_GRANULARITY];
+    float mWet[SAMPLE_GRANULARITY];
 
 public:
     virtual void filter(
@@ -0,0 +1,233 @@
+#ifndef FAST_MATH_H
+#define FAST_MATH_H
+
+#include "soloud.h"
+
+#include <string.h>
+#include <math.h>
+
+#if defined(SOLOUD_SSE_INTRINSICS)
+#include <emmintrin.h>
+#elif defined(SOLOUD_NEON_INTRINSICS)
+#include <arm_neon.h>
+#endif
+
+/*
+    log2 and exp2 approximations for the dynamics filters, which convert every
+    sample to dB and back.
+
+    fastLog2 reduces x to m * 2^e with m in [sqrt(1/2), sqrt(2)) and sums the
+    atanh series of log2(m) up to the 7th power: the error is below 2e-7 for m,
+    plus the rounding of the sum with e. It stays below 1.1e-6 for x in
+    [1e-8, 1e4], so the dB values are within 2e-5 dB. x is clamped to the
+    smallest normal float, which also maps 0 and NaN to -126.
+    fastExp2 splits x in its nearest integer and a fraction in [-0.5, 0.5], and
+    evaluates 2^fraction with its Taylor series up to the 6th power: the relative
+    error is below 3e-7 for x in [-126, 126], and x is clamped to that range.
+    With the rounding of the scaling, dbToGain stays within 1.5e-6 relative
+    error for [-160, 80] dB.
+
+    The _ps variants compute the same values 4 at a time with SSE or NEON. 32 bit
+    ARM has no vector division: log2_ps refines the reciprocal estimate twice,
+    which keeps it within the same bound.
+*/
+namespace FastMath
+{
+    // 20 * log10(2) and its inverse.
+    const float kDbPerOctave = 6.02059991f;
+    const float kOctavesPerDb = 0.166096405f;
+
+    const float kLog2C1 = 2.88539008f; // 2 / ln(2)
+    const float kLog2C3 = 0.961796694f;
+    const float kLog2C5 = 0.577078016f;
+    const float kLog2C7 = 0.412198583f;
+
+    const float kExp2C1 = 0.693147181f; // ln(2)^k / k!
+    const float kExp2C2 = 0.240226507f;
+    const float kExp2C3 = 0.0555041087f;
+    const float kExp2C4 = 0.00961812911f;
+    const float kExp2C5 = 0.00133335581f;
+    const float kExp2C6 = 0.000154035304f;
+
+    const float kSqrt2 = 1.41421356f;
+    const float kMinNormal = 1.17549435e-38f;
+    const float kRoundMagic = 12582912.f;
+    const unsigned int kRoundMagicBits = 0x4b400000;
+
+    inline float fastLog2(float x)
+    {
+        if (!(x > kMinNormal))
+            x = kMinNormal;
+        unsigned int bits;
+        memcpy(&bits, &x, sizeof(bits));
+        int e = (int)(bits >> 23) - 127;
+        bits = (bits & 0x007fffff) | 0x3f800000;
+        float m;
+        memcpy(&m, &bits, sizeof(m));
+        if (m > kSqrt2)
+        {
+            m *= 0.5f;
+            e++;
+        }
+        const float t = (m - 1.f) / (m + 1.f);
+        const float t2 = t * t;
+        return (float)e + t * (kLog2C1 + t2 * (kLog2C3 + t2 * (kLog2C5 + t2 * kLog2C7)));
+    }
+
+    inline float fastExp2(float x)
+    {
+        x = x < -126.f ? -126.f : (x > 126.f ? 126.f : x);
+        // Adding 1.5 * 2^23 rounds x to an integer, left in the low mantissa bits.
+        const float rounded = x + kRoundMagic;
+        unsigned int bits;
+        memcpy(&bits, &rounded, sizeof(bits));
+        const float f = x - (rounded - kRoundMagic);
+        const float p = 1.f + f * (kExp2C1 + f * (kExp2C2 + f * (kExp2C3 + f * (kExp2C4 + f * (kExp2C5 + f * kExp2C6)))));
+        bits = (bits - kRoundMagicBits + 127) << 23;
+        float scale;
+        memcpy(&scale, &bits, sizeof(scale));
+        return p * scale;
+    }
+
+    /// 20 * log10([x]).
+    inline float gainToDb(float x)
+    {
+        return kDbPerOctave * fastLog2(x);
+    }
+
+    /// 10 ^ ([db] / 20).
+    inline float dbToGain(float db)
+    {
+        return fastExp2(kOctavesPerDb * db);
+    }
+
+#if defined(SOLOUD_SSE_INTRINSICS)
+    inline __m128 select_ps(__m128 mask, __m128 a, __m128 b)
+    {
+        return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+    }
+
+    inline __m128 log2_ps(__m128 x)
+    {
+        x = _mm_max_ps(x, _mm_set1_ps(kMinNormal));
+        const __m128i bits = _mm_castps_si128(x);
+        __m128 e = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127)));
+        __m128 m = _mm_castsi128_ps(_mm_or_si128(
+            _mm_and_si128(bits, _mm_set1_epi32(0x007fffff)), _mm_set1_epi32(0x3f800000)));
+        const __m128 big = _mm_cmpgt_ps(m, _mm_set1_ps(kSqrt2));
+        m = select_ps(big, _mm_mul_ps(m, _mm_set1_ps(0.5f)), m);
+        e = _mm_add_ps(e, _mm_and_ps(big, _mm_set1_ps(1.f)));
+        const __m128 one = _mm_set1_ps(1.f);
+        const __m128 t = _mm_div_ps(_mm_sub_ps(m, one), _mm_add_ps(m, one));
+        const __m128 t2 = _mm_mul_ps(t, t);
+        __m128 p = _mm_add_ps(_mm_mul_ps(t2, _mm_set1_ps(kLog2C7)), _mm_set1_ps(kLog2C5));
+        p = _mm_add_ps(_mm_mul_ps(t2, p), _mm_set1_ps(kLog2C3));
+        p = _mm_add_ps(_mm_mul_ps(t2, p), _mm_set1_ps(kLog2C1));
+        return _mm_add_ps(e, _mm_mul_ps(t, p));
+    }
+
+    inline __m128 exp2_ps(__m128 x)
+    {
+        x = _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(-126.f)), _mm_set1_ps(126.f));
+        // Rounds to nearest with the default MXCSR.
+        const __m128i i = _mm_cvtps_epi32(x);
+        const __m128 f = _mm_sub_ps(x, _mm_cvtepi32_ps(i));
+        __m128 p = _mm_add_ps(_mm_mul_ps(f, _mm_set1_ps(kExp2C6)), _mm_set1_ps(kExp2C5));
+        p = _mm_add_ps(_mm_mul_ps(f, p), _mm_set1_ps(kExp2C4));
+        p = _mm_add_ps(_mm_mul_ps(f, p), _mm_set1_ps(kExp2C3));
+        p = _mm_add_ps(_mm_mul_ps(f, p), _mm_set1_ps(kExp2C2));
+        p = _mm_add_ps(_mm_mul_ps(f, p), _mm_set1_ps(kExp2C1));
+        p = _mm_add_ps(_mm_mul_ps(f, p), _mm_set1_ps(1.f));
+        const __m128 scale = _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(i, _mm_set1_epi32(127)), 23));
+        return _mm_mul_ps(p, scale);
+    }
+
+    inline __m128 gainToDb_ps(__m128 x)
+    {
+        return _mm_mul_ps(_mm_set1_ps(kDbPerOctave), log2_ps(x));
+    }
+
+    inline __m128 dbToGain_ps(__m128 db)
+    {
+        return exp2_ps(_mm_mul_ps(_mm_set1_ps(kOctavesPerDb), db));
+    }
+
+    inline __m128 abs_ps(__m128 x)
+    {
+        return _mm_andnot_ps(_mm_set1_ps(-0.f), x);
+    }
+#elif defined(SOLOUD_NEON_INTRINSICS)
+    inline float32x4_t select_ps(uint32x4_t mask, float32x4_t a, float32x4_t b)
+    {
+        return vbslq_f32(mask, a, b);
+    }
+
+    inline float32x4_t div_ps(float32x4_t a, float32x4_t b)
+    {
+#if defined(__aarch64__) || defined(_M_ARM64)
+        return vdivq_f32(a, b);
+#else
+        float32x4_t r = vrecpeq_f32(b);
+        r = vmulq_f32(r, vrecpsq_f32(b, r));
+        r = vmulq_f32(r, vrecpsq_f32(b, r));
+        return vmulq_f32(a, r);
+#endif
+    }
+
+    inline float32x4_t log2_ps(float32x4_t x)
+    {
+        // Also maps NaN to the smallest normal float, as the scalar version.
+        const float32x4_t minNormal = vdupq_n_f32(kMinNormal);
+        x = vbslq_f32(vcgtq_f32(x, minNormal), x, minNormal);
+        const int32x4_t bits = vreinterpretq_s32_f32(x);
+        float32x4_t e = vcvtq_f32_s32(vsubq_s32(vshrq_n_s32(bits, 23), vdupq_n_s32(127)));
+        float32x4_t m = vreinterpretq_f32_s32(vorrq_s32(
+            vandq_s32(bits, vdupq_n_s32(0x007fffff)), vdupq_n_s32(0x3f800000)));
+        const uint32x4_t big = vcgtq_f32(m, vdupq_n_f32(kSqrt2));
+        m = vbslq_f32(big, vmulq_n_f32(m, 0.5f), m);
+        const float32x4_t one = vdupq_n_f32(1.f);
+        e = vaddq_f32(e, vbslq_f32(big, one, vdupq_n_f32(0.f)));
+        const float32x4_t t = div_ps(vsubq_f32(m, one), vaddq_f32(m, one));
+        const float32x4_t t2 = vmulq_f32(t, t);
+        float32x4_t p = vmlaq_f32(vdupq_n_f32(kLog2C5), t2, vdupq_n_f32(kLog2C7));
+        p = vmlaq_f32(vdupq_n_f32(kLog2C3), t2, p);
+        p = vmlaq_f32(vdupq_n_f32(kLog2C1), t2, p);
+        return vmlaq_f32(e, t, p);
+    }
+
+    inline float32x4_t exp2_ps(float32x4_t x)
+    {
+        x = vminq_f32(vmaxq_f32(x, vdupq_n_f32(-126.f)), vdupq_n_f32(126.f));
+        // Rounds to nearest as fastExp2: the conversion instructions truncate on 32 bit ARM.
+        const float32x4_t magic = vdupq_n_f32(kRoundMagic);
+        const float32x4_t rounded = vaddq_f32(x, magic);
+        const float32x4_t f = vsubq_f32(x, vsubq_f32(rounded, magic));
+        float32x4_t p = vmlaq_f32(vdupq_n_f32(kExp2C5), f, vdupq_n_f32(kExp2C6));
+        p = vmlaq_f32(vdupq_n_f32(kExp2C4), f, p);
+        p = vmlaq_f32(vdupq_n_f32(kExp2C3), f, p);
+        p = vmlaq_f32(vdupq_n_f32(kExp2C2), f, p);
+        p = vmlaq_f32(vdupq_n_f32(kExp2C1), f, p);
+        p = vmlaq_f32(vdupq_n_f32(1.f), f, p);
+        const int32x4_t i = vsubq_s32(vreinterpretq_s32_f32(rounded), vdupq_n_s32((int)kRoundMagicBits));
+        const float32x4_t scale = vreinterpretq_f32_s32(vshlq_n_s32(vaddq_s32(i, vdupq_n_s32(127)), 23));
+        return vmulq_f32(p, scale);
+    }
+
+    inline float32x4_t gainToDb_ps(float32x4_t x)
+    {
+        return vmulq_n_f32(log2_ps(x), kDbPerOctave);
+    }
+
+    inline float32x4_t dbToGain_ps(float32x4_t db)
+    {
+        return exp2_ps(vmulq_n_f32(db, kOctavesPerDb));
+    }
+
+    inline float32x4_t abs_ps(float32x4_t x)
+    {
+        return vabsq_f32(x);
+    }
+#endif
+} // namespace FastMath
+
+#endif // FAST_MATH_H
@@ -176,6 +176,11 @@ PlayerErrors Filters::addFilter(FilterType filterType)
     if (isFilterActive(filterType) >= 0)
         return filterAlreadyAdded;
 
+    // The audio source of a sound deduplicated by content is shared with
+    // other sounds, which would get the filter too.
+    if (mSound != nullptr && mSound->sound.use_count() > 1)
+        return invalidParameter;
+
     SoLoud::Filter* newFilter = nullptr;
     switch (filterType)
     {
@@ -207,7 +212,7 @@ PlayerErrors Filters::addFilter(FilterType filterType)
         newFilter = new SoLoud::FreeverbFilter();
         break;
     case PitchShiftFilter:
-        newFilter = new PitchShift();
+        newFilter = new PitchShift(mSound == nullptr ? mSoloud->mChannels : mSound->sound.get()->mChannels);
         break;
     case LimiterFilter:
         newFilter = new Limiter();
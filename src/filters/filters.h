@@ -37,6 +37,8 @@ public:
     ~Filters() {}
 
     int isFilterActive(FilterType filter);
+
+    bool hasFilters() const { return !filters.empty(); }
     
     PlayerErrors addFilter(FilterType filterType);
     
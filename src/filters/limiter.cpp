@@ -1,20 +1,226 @@
 #include "limiter.h"
+#include "fast_math.h"
 
 #include <algorithm>
 #include <cmath>
 #include <vector>
 #include <stdio.h>
 
+namespace {
+
+/// The gain curve of the limiter, from the input level in dB.
+struct LimiterCurve
+{
+    float kneeStart;
+    float kneeEnd;
+    float invKneeWidth;
+    float outputCeiling;
+
+    LimiterCurve(float aThreshold, float aOutputCeiling, float aKneeWidth)
+    {
+        kneeStart = aThreshold - (aKneeWidth / 2.0f);
+        kneeEnd = aThreshold + (aKneeWidth / 2.0f);
+        invKneeWidth = aKneeWidth > 0.f ? 1.0f / aKneeWidth : 0.f;
+        outputCeiling = aOutputCeiling;
+    }
+
+    float gain(float aLevel) const
+    {
+        const float inputDB = FastMath::gainToDb(std::fabs(aLevel) + 1e-6f);
+        if (inputDB <= kneeStart)
+            return 1.0f;
+        float excess;
+        if (inputDB > kneeEnd)
+            // Full limiting above knee
+            excess = inputDB - outputCeiling;
+        else
+            // Soft knee zone
+            excess = (inputDB - outputCeiling) * (inputDB - kneeStart) * invKneeWidth;
+        return FastMath::dbToGain(-excess);
+    }
+
+#if defined(SOLOUD_SSE_INTRINSICS)
+    __m128 gain_ps(__m128 aLevel) const
+    {
+        const __m128 inputDB = FastMath::gainToDb_ps(_mm_add_ps(FastMath::abs_ps(aLevel), _mm_set1_ps(1e-6f)));
+        const __m128 excess = _mm_sub_ps(inputDB, _mm_set1_ps(outputCeiling));
+        const __m128 kneePosition = _mm_mul_ps(_mm_sub_ps(inputDB, _mm_set1_ps(kneeStart)), _mm_set1_ps(invKneeWidth));
+        __m128 gainDB = FastMath::select_ps(
+            _mm_cmpgt_ps(inputDB, _mm_set1_ps(kneeStart)), _mm_mul_ps(excess, kneePosition), _mm_setzero_ps());
+        gainDB = FastMath::select_ps(_mm_cmpgt_ps(inputDB, _mm_set1_ps(kneeEnd)), excess, gainDB);
+        return FastMath::dbToGain_ps(_mm_sub_ps(_mm_setzero_ps(), gainDB));
+    }
+#elif defined(SOLOUD_NEON_INTRINSICS)
+    float32x4_t gain_ps(float32x4_t aLevel) const
+    {
+        const float32x4_t inputDB = FastMath::gainToDb_ps(vaddq_f32(FastMath::abs_ps(aLevel), vdupq_n_f32(1e-6f)));
+        const float32x4_t excess = vsubq_f32(inputDB, vdupq_n_f32(outputCeiling));
+        const float32x4_t kneePosition = vmulq_n_f32(vsubq_f32(inputDB, vdupq_n_f32(kneeStart)), invKneeWidth);
+        float32x4_t gainDB = FastMath::select_ps(
+            vcgtq_f32(inputDB, vdupq_n_f32(kneeStart)), vmulq_f32(excess, kneePosition), vdupq_n_f32(0.f));
+        gainDB = FastMath::select_ps(vcgtq_f32(inputDB, vdupq_n_f32(kneeEnd)), excess, gainDB);
+        return FastMath::dbToGain_ps(vnegq_f32(gainDB));
+    }
+#endif
+
+    /// Write to [aTarget] the gains of [aCount] levels, which can be the same buffer.
+    void gains(const float *aLevels, float *aTarget, unsigned int aCount) const
+    {
+        unsigned int i = 0;
+#if defined(SOLOUD_SSE_INTRINSICS)
+        for (; i + 4 <= aCount; i += 4)
+            _mm_storeu_ps(aTarget + i, gain_ps(_mm_loadu_ps(aLevels + i)));
+#elif defined(SOLOUD_NEON_INTRINSICS)
+        for (; i + 4 <= aCount; i += 4)
+            vst1q_f32(aTarget + i, gain_ps(vld1q_f32(aLevels + i)));
+#endif
+        for (; i < aCount; i++)
+            aTarget[i] = gain(aLevels[i]);
+    }
+};
+
+/// Mix [aCount] gains with their [aWet] level, in place.
+void mixWet(float *aGains, const float *aWet, unsigned int aCount)
+{
+    unsigned int i = 0;
+#if defined(SOLOUD_SSE_INTRINSICS)
+    const __m128 one = _mm_set1_ps(1.0f);
+    for (; i + 4 <= aCount; i += 4)
+    {
+        const __m128 wet = _mm_loadu_ps(aWet + i);
+        _mm_storeu_ps(aGains + i, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(aGains + i), wet), _mm_sub_ps(one, wet)));
+    }
+#elif defined(SOLOUD_NEON_INTRINSICS)
+    const float32x4_t one = vdupq_n_f32(1.0f);
+    for (; i + 4 <= aCount; i += 4)
+    {
+        const float32x4_t wet = vld1q_f32(aWet + i);
+        vst1q_f32(aGains + i, vmlaq_f32(vsubq_f32(one, wet), vld1q_f32(aGains + i), wet));
+    }
+#endif
+    for (; i < aCount; i++)
+        aGains[i] = aGains[i] * aWet[i] + (1.0f - aWet[i]);
+}
+
+/// Multiply [aCount] samples by their gain.
+void applyGains(float *aSamples, const float *aGains, unsigned int aCount)
+{
+    unsigned int i = 0;
+#if defined(SOLOUD_SSE_INTRINSICS)
+    for (; i + 4 <= aCount; i += 4)
+        _mm_storeu_ps(aSamples + i, _mm_mul_ps(_mm_loadu_ps(aSamples + i), _mm_loadu_ps(aGains + i)));
+#elif defined(SOLOUD_NEON_INTRINSICS)
+    for (; i + 4 <= aCount; i += 4)
+        vst1q_f32(aSamples + i, vmulq_f32(vld1q_f32(aSamples + i), vld1q_f32(aGains + i)));
+#endif
+    for (; i < aCount; i++)
+        aSamples[i] *= aGains[i];
+}
+
+/// 4x oversampling windowed sinc, the size of the ITU BS.1770 true peak
+/// meter filter: the samples at 1/4, 1/2 and 3/4 between [i - 6] and [i - 5]
+/// from the samples [i - 11] to [i].
+struct TruePeakKernel
+{
+    float coefs[3][TRUE_PEAK_TAPS];
+
+    TruePeakKernel()
+    {
+        const double pi = 3.14159265358979323846;
+        for (int phase = 0; phase < 3; phase++)
+        {
+            const double fraction = (phase + 1) / 4.0;
+            double sum = 0;
+            for (int j = 0; j < TRUE_PEAK_TAPS; j++)
+            {
+                const double t = j - (TRUE_PEAK_TAPS / 2 - 1) - fraction;
+                const double window = 0.5 + 0.5 * std::cos(pi * t / (TRUE_PEAK_TAPS / 2));
+                coefs[phase][j] = (float)(std::sin(pi * t) / (pi * t) * window);
+                sum += coefs[phase][j];
+            }
+            // No gain at DC.
+            for (int j = 0; j < TRUE_PEAK_TAPS; j++)
+                coefs[phase][j] = (float)(coefs[phase][j] / sum);
+        }
+    }
+
+    /// Raise [aPeaks] to the true peaks of [aCount] samples, which follow
+    /// TRUE_PEAK_TAPS - 1 samples of history in [aInput].
+    void peaks(const float *aInput, float *aPeaks, unsigned int aCount) const
+    {
+        unsigned int i = 0;
+#if defined(SOLOUD_SSE_INTRINSICS)
+        for (; i + 4 <= aCount; i += 4)
+        {
+            __m128 peak = _mm_max_ps(_mm_loadu_ps(aPeaks + i),
+                                     FastMath::abs_ps(_mm_loadu_ps(aInput + i + TRUE_PEAK_TAPS - 1)));
+            for (int phase = 0; phase < 3; phase++)
+            {
+                __m128 sum = _mm_setzero_ps();
+                for (int j = 0; j < TRUE_PEAK_TAPS; j++)
+                    sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(coefs[phase][j]), _mm_loadu_ps(aInput + i + j)));
+                peak = _mm_max_ps(peak, FastMath::abs_ps(sum));
+            }
+            _mm_storeu_ps(aPeaks + i, peak);
+        }
+#elif defined(SOLOUD_NEON_INTRINSICS)
+        for (; i + 4 <= aCount; i += 4)
+        {
+            float32x4_t peak = vmaxq_f32(vld1q_f32(aPeaks + i),
+                                         vabsq_f32(vld1q_f32(aInput + i + TRUE_PEAK_TAPS - 1)));
+            for (int phase = 0; phase < 3; phase++)
+            {
+                float32x4_t sum = vdupq_n_f32(0.f);
+                for (int j = 0; j < TRUE_PEAK_TAPS; j++)
+                    sum = vmlaq_n_f32(sum, vld1q_f32(aInput + i + j), coefs[phase][j]);
+                peak = vmaxq_f32(peak, vabsq_f32(sum));
+            }
+            vst1q_f32(aPeaks + i, peak);
+        }
+#endif
+        for (; i < aCount; i++)
+        {
+            float peak = std::max(aPeaks[i], std::fabs(aInput[i + TRUE_PEAK_TAPS - 1]));
+            for (int phase = 0; phase < 3; phase++)
+            {
+                float sum = 0.f;
+                for (int j = 0; j < TRUE_PEAK_TAPS; j++)
+                    sum += coefs[phase][j] * aInput[i + j];
+                peak = std::max(peak, std::fabs(sum));
+            }
+            aPeaks[i] = peak;
+        }
+    }
+};
+
+} // namespace
+
 LimiterInstance::LimiterInstance(Limiter *aParent)
+    : mDelaySize(0), mDelayPos(0), mLookahead(0), mLookaheadSamplerate(0), mLookaheadChannels(0),
+      mMinHead(0), mMinCount(0), mFrame(0), mHeldGain(1.0f), mAveragePos(0), mAverageSum(0)
 {
     mParent = aParent;
-    initParams(6);
+    mCurrentGain.assign(MAX_CHANNELS, 1.0f);
+
+    // The true peaks are found TRUE_PEAK_TAPS / 2 samples late: all the
+    // buffers hold the largest window.
+    const unsigned int maxLookahead =
+        (unsigned int)std::ceil(aParent->getParamMax(Limiter::LOOKAHEAD) * 0.001f * LOOKAHEAD_MAX_SAMPLERATE);
+    mDelaySize = maxLookahead + TRUE_PEAK_TAPS / 2 + 1;
+    mDelay.assign(mDelaySize * MAX_CHANNELS, 0.f);
+    mHistory.assign((TRUE_PEAK_TAPS - 1) * MAX_CHANNELS, 0.f);
+    mMinGain.resize(mDelaySize);
+    mMinFrame.resize(mDelaySize);
+    mAverage.resize(mDelaySize);
+
+    initParams(7);
     mParam[Limiter::WET] = aParent->mWet;
     mParam[Limiter::THRESHOLD] = aParent->mThreshold;
     mParam[Limiter::OUTPUT_CEILING] = aParent->mOutputCeiling;
     mParam[Limiter::KNEE_WIDTH] = aParent->mKneeWidth;
     mParam[Limiter::RELEASE_TIME] = aParent->mReleaseTime;
     mParam[Limiter::ATTACK_TIME] = aParent->mAttackTime;
+    mParam[Limiter::LOOKAHEAD] = aParent->mLookahead;
 }
 
 void LimiterInstance::filter(
@@ -27,72 +233,155 @@ void LimiterInstance::filter(
 {
     updateParams(aTime);
 
-    const float threshold = std::pow(10.0f, mParam[Limiter::THRESHOLD] / 20.0f); // Convert threshold dB to linear
-    const float outputCeiling = std::pow(10.0f, mParam[Limiter::OUTPUT_CEILING] / 20.0f); // Convert output ceiling dB to linear
-    const float kneeWidth = mParam[Limiter::KNEE_WIDTH]; // In dB, defines the width of the knee
-    const float kneeStart = mParam[Limiter::THRESHOLD] - (kneeWidth / 2.0f);
-    const float kneeEnd = mParam[Limiter::THRESHOLD] + (kneeWidth / 2.0f);
-    
+    unsigned int lookahead = (unsigned int)(mParam[Limiter::LOOKAHEAD] * 0.001f * aSamplerate + 0.5f);
+    lookahead = std::min(lookahead, mDelaySize - TRUE_PEAK_TAPS / 2 - 1);
+    if (lookahead == 0)
+    {
+        mLookahead = 0;
+        filterChannels(aBuffer, aSamples, aBufferSize, aChannels, aSamplerate);
+        return;
+    }
+
+    if (lookahead != mLookahead || aSamplerate != mLookaheadSamplerate || aChannels != mLookaheadChannels)
+        resetLookahead(lookahead, aChannels, aSamplerate);
+    filterLookahead(aBuffer, aSamples, aBufferSize, aChannels, aSamplerate);
+}
+
+void LimiterInstance::filterChannels(float *aBuffer, unsigned int aSamples, unsigned int aBufferSize, unsigned int aChannels, float aSamplerate)
+{
+    const LimiterCurve curve(mParam[Limiter::THRESHOLD], mParam[Limiter::OUTPUT_CEILING], mParam[Limiter::KNEE_WIDTH]);
+
     // Time constants
     const float releaseTime = mParam[Limiter::RELEASE_TIME] / 1000.0f; // Convert release time to seconds
     const float attackTime = mParam[Limiter::ATTACK_TIME] / 1000.0f; // Convert attack time to seconds
     const float releaseCoef = std::exp(-1.0f / (aSamplerate * releaseTime));
     const float attackCoef = std::exp(-1.0f / (aSamplerate * attackTime));
 
-    // Initialize per-channel gain tracking if needed
-    if (mCurrentGain.size() != aChannels) {
-        mCurrentGain.resize(aChannels, 1.0f);
-    }
-
-    // Process each channel
+    // Process each channel, in blocks: the gains are computed 4 samples at a
+    // time, only their smoothing depends on the previous sample.
     for (unsigned int ch = 0; ch < aChannels; ++ch) {
         float &currentGain = mCurrentGain[ch];
-        
-        for (unsigned int sample = 0; sample < aSamples; ++sample) {
-            unsigned int index = sample * aChannels + ch; // Index for the sample in the interleaved buffer
-            
-            // Get the sample value for this channel
-            float input = aBuffer[index];
-            float inputAbs = std::fabs(input);
-
-            // Calculate input level in dB
-            float inputDB = 20.0f * std::log10(inputAbs + 1e-6f);
-            
-            // Calculate gain reduction
-            float targetGain = 1.0f;
-            if (inputDB > kneeEnd) {
-                // Full limiting above knee
-                float excess = inputDB - mParam[Limiter::OUTPUT_CEILING];
-                targetGain = std::pow(10.0f, -excess / 20.0f);
-            }
-            else if (inputDB > kneeStart) {
-                // Soft knee zone
-                float kneePosition = (inputDB - kneeStart) / kneeWidth;
-                float excess = (inputDB - mParam[Limiter::OUTPUT_CEILING]) * kneePosition;
-                targetGain = std::pow(10.0f, -excess / 20.0f);
-            }
+        float *channel = aBuffer + ch * aBufferSize;
+
+        for (unsigned int offset = 0; offset < aSamples; offset += SAMPLE_GRANULARITY) {
+            const unsigned int count = std::min(aSamples - offset, (unsigned int)SAMPLE_GRANULARITY);
+            curve.gains(channel + offset, mTarget, count);
 
             // Smooth gain changes
-            if (targetGain < currentGain) {
-                // Attack phase
-                currentGain = attackCoef * currentGain + (1.0f - attackCoef) * targetGain;
-            } else {
-                // Release phase
-                currentGain = releaseCoef * currentGain + (1.0f - releaseCoef) * targetGain;
+            for (unsigned int i = 0; i < count; ++i) {
+                const float coef = mTarget[i] < currentGain ? attackCoef : releaseCoef;
+                currentGain = coef * currentGain + (1.0f - coef) * mTarget[i];
+                mGain[i] = currentGain;
             }
 
-            // Apply the gain and wet/dry mix
-            float outputSample = input * currentGain;
-            aBuffer[index] = (mParam[Limiter::WET] * outputSample) + 
-                            ((1.0f - mParam[Limiter::WET]) * input);
+            getParamRamp(Limiter::WET, mWet, offset, count, aSamples);
+            mixWet(mGain, mWet, count);
+            applyGains(channel + offset, mGain, count);
         }
     }
+}
 
-    // printf("LimiterInstance::filter(%f, %f, %f, %f,   gain=%f)\n",
-    //        mParam[Limiter::THRESHOLD],
-    //        mParam[Limiter::OUTPUT_CEILING],
-    //        mParam[Limiter::KNEE_WIDTH],
-    //        mParam[Limiter::RELEASE_TIME], gain);
+void LimiterInstance::resetLookahead(unsigned int aLookahead, unsigned int aChannels, float aSamplerate)
+{
+    // The buffers are allocated by the constructor: only their content is reset.
+    if (mLookahead == 0 || aChannels != mLookaheadChannels)
+    {
+        // Start from silence rather than from what was delayed long ago.
+        std::fill(mDelay.begin(), mDelay.begin() + mDelaySize * aChannels, 0.f);
+        std::fill(mHistory.begin(), mHistory.begin() + (TRUE_PEAK_TAPS - 1) * aChannels, 0.f);
+        mDelayPos = 0;
+        mHeldGain = 1.0f;
+    }
+
+    // Only the gain is carried over when the lookahead changes.
+    mMinHead = 0;
+    mMinCount = 0;
+    std::fill(mAverage.begin(), mAverage.begin() + aLookahead, mHeldGain);
+    mAveragePos = 0;
+    mAverageSum = (double)mHeldGain * aLookahead;
+    mLookahead = aLookahead;
+    mLookaheadSamplerate = aSamplerate;
+    mLookaheadChannels = aChannels;
+}
+
+void LimiterInstance::filterLookahead(float *aBuffer, unsigned int aSamples, unsigned int aBufferSize, unsigned int aChannels, float aSamplerate)
+{
+    const LimiterCurve curve(mParam[Limiter::THRESHOLD], mParam[Limiter::OUTPUT_CEILING], mParam[Limiter::KNEE_WIDTH]);
+    const float releaseTime = mParam[Limiter::RELEASE_TIME] / 1000.0f;
+    const float releaseCoef = std::exp(-1.0f / (aSamplerate * releaseTime));
+
+    // A true peak is known TRUE_PEAK_TAPS / 2 samples after the samples
+    // around it. It must be held for the lookahead after that, and the audio
+    // is delayed by as much so that the gain is down when they play.
+    static const TruePeakKernel kernel;
+    const unsigned int delay = mLookahead + TRUE_PEAK_TAPS / 2;
+    const unsigned int hold = delay + 1;
+
+    for (unsigned int offset = 0; offset < aSamples; offset += SAMPLE_GRANULARITY)
+    {
+        const unsigned int count = std::min(aSamples - offset, (unsigned int)SAMPLE_GRANULARITY);
+
+        // The channels are linked: the loudest one sets the gain of all.
+        std::fill(mTarget, mTarget + count, 0.f);
+        for (unsigned int ch = 0; ch < aChannels; ++ch)
+        {
+            float *history = &mHistory[ch * (TRUE_PEAK_TAPS - 1)];
+            std::copy(history, history + TRUE_PEAK_TAPS - 1, mPeakInput);
+            std::copy(aBuffer + ch * aBufferSize + offset, aBuffer + ch * aBufferSize + offset + count, mPeakInput + TRUE_PEAK_TAPS - 1);
+            kernel.peaks(mPeakInput, mTarget, count);
+            std::copy(mPeakInput + count, mPeakInput + count + TRUE_PEAK_TAPS - 1, history);
+        }
+        curve.gains(mTarget, mTarget, count);
+
+        const unsigned int capacity = mDelaySize;
+        for (unsigned int i = 0; i < count; ++i)
+        {
+            // Minimum of the targets over the hold window.
+            while (mMinCount > 0 && mFrame - mMinFrame[mMinHead] >= hold)
+            {
+                mMinHead = (mMinHead + 1) % capacity;
+                mMinCount--;
+            }
+            while (mMinCount > 0 && mMinGain[(mMinHead + mMinCount - 1) % capacity] >= mTarget[i])
+                mMinCount--;
+            const unsigned int last = (mMinHead + mMinCount) % capacity;
+            mMinGain[last] = mTarget[i];
+            mMinFrame[last] = mFrame;
+            mMinCount++;
+            mFrame++;
+
+            // Instant attack: the moving average ramps it down over the
+            // lookahead, and it is there when the peak plays.
+            const float minGain = mMinGain[mMinHead];
+            if (minGain < mHeldGain)
+                mHeldGain = minGain;
+            else
+                mHeldGain = releaseCoef * mHeldGain + (1.0f - releaseCoef) * minGain;
+
+            mAverageSum += mHeldGain - mAverage[mAveragePos];
+            mAverage[mAveragePos] = mHeldGain;
+            mAveragePos = mAveragePos + 1 == mLookahead ? 0 : mAveragePos + 1;
+            mGain[i] = (float)(mAverageSum / mLookahead);
+        }
+        getParamRamp(Limiter::WET, mWet, offset, count, aSamples);
+        mixWet(mGain, mWet, count);
+
+        for (unsigned int ch = 0; ch < aChannels; ++ch)
+        {
+            float *channel = aBuffer + ch * aBufferSize + offset;
+            float *line = &mDelay[ch * capacity];
+            unsigned int write = mDelayPos;
+            unsigned int read = (mDelayPos + capacity - delay) % capacity;
+            for (unsigned int i = 0; i < count; ++i)
+            {
+                line[write] = channel[i];
+                channel[i] = line[read] * mGain[i];
+                write = write + 1 == capacity ? 0 : write + 1;
+                read = read + 1 == capacity ? 0 : read + 1;
+            }
+        }
+        mDelayPos = (mDelayPos + count) % capacity;
+    }
 }
 
 void LimiterInstance::setFilterParameter(unsigned int aAttributeId, float aValue)
@@ -139,6 +428,12 @@ void LimiterInstance::setFilterParameter(unsigned int aAttributeId, float aValue
             return;
         mParam[Limiter::ATTACK_TIME] = aValue;
         break;
+    case Limiter::LOOKAHEAD:
+        if (aValue < mParent->getParamMin(Limiter::LOOKAHEAD) ||
+            aValue > mParent->getParamMax(Limiter::LOOKAHEAD))
+            return;
+        mParam[Limiter::LOOKAHEAD] = aValue;
+        break;
     }
 
     mParamChanged |= 1 << aAttributeId;
@@ -178,13 +473,18 @@ SoLoud::result Limiter::setParam(unsigned int aParamIndex, float aValue)
             return SoLoud::INVALID_PARAMETER;
         mAttackTime = aValue;
         break;
+    case LOOKAHEAD:
+        if (aValue < getParamMin(LOOKAHEAD) || aValue > getParamMax(LOOKAHEAD))
+            return SoLoud::INVALID_PARAMETER;
+        mLookahead = aValue;
+        break;
     }
     return SoLoud::SO_NO_ERROR;
 }
 
 int Limiter::getParamCount()
 {
-    return 6;
+    return 7;
 }
 
 const char *Limiter::getParamName(unsigned int aParamIndex)
@@ -203,6 +503,8 @@ const char *Limiter::getParamName(unsigned int aParamIndex)
         return "Release Time";
     case ATTACK_TIME:
         return "Attack Time";
+    case LOOKAHEAD:
+        return "Lookahead";
     }
     return "Wet";
 }
@@ -228,6 +530,8 @@ float Limiter::getParamMax(unsigned int aParamIndex)
         return 1000.0f;
     case ATTACK_TIME:
         return 200.0f;
+    case LOOKAHEAD:
+        return 10.0f;
     }
     return 1;
 }
@@ -248,6 +552,8 @@ float Limiter::getParamMin(unsigned int aParamIndex)
         return 1.0f;
     case ATTACK_TIME:
         return 0.1f;
+    case LOOKAHEAD:
+        return 0.0f;
     }
     return 1;
 }
@@ -260,6 +566,7 @@ Limiter::Limiter()
     mKneeWidth = 6.0f;    // Wider knee for smoother transition
     mReleaseTime = 50.0f; // Faster release
     mAttackTime = 1.0f;   // Fast attack to catch peaks
+    mLookahead = 0.0f;    // No delay by default
 }
 
 SoLoud::FilterInstance *Limiter::createInstance()
@@ -4,12 +4,56 @@
 #include "soloud.h"
 #include <vector>
 
+// Taps of the filter estimating the true peaks in the lookahead mode.
+#define TRUE_PEAK_TAPS 12
+// Sample rate up to which the lookahead buffers hold the max lookahead.
+// Above it, the lookahead is shortened to fit.
+#define LOOKAHEAD_MAX_SAMPLERATE 192000
+
 class Limiter;
 
 class LimiterInstance : public SoLoud::FilterInstance
 {
     Limiter *mParent;
-    std::vector<float> mCurrentGain; // Store gain per channel
+    std::vector<float> mCurrentGain; // Store gain per channel, for MAX_CHANNELS
+
+    // Target and smoothed gains of the block being processed, and the wet
+    // level ramping from its previous value.
+    float mTarget[SAMPLE_GRANULARITY];
+    float mGain[SAMPLE_GRANULARITY];
+    float mWet[SAMPLE_GRANULARITY];
+
+    // Lookahead mode state, allocated by the constructor for the max
+    // lookahead at LOOKAHEAD_MAX_SAMPLERATE and MAX_CHANNELS, so that
+    // filter() doesn't allocate.
+    // The input delayed by the lookahead, per channel.
+    std::vector<float> mDelay;
+    unsigned int mDelaySize;
+    unsigned int mDelayPos;
+    // The last TRUE_PEAK_TAPS - 1 input samples per channel, and the block
+    // after them, to estimate the true peaks.
+    std::vector<float> mHistory;
+    float mPeakInput[TRUE_PEAK_TAPS - 1 + SAMPLE_GRANULARITY];
+    // Lookahead in samples, 0 when disabled.
+    unsigned int mLookahead;
+    float mLookaheadSamplerate;
+    unsigned int mLookaheadChannels;
+    // Minimum of the target gains over the lookahead, kept in a ring of
+    // increasing gains with the frame they were computed for.
+    std::vector<float> mMinGain;
+    std::vector<unsigned int> mMinFrame;
+    unsigned int mMinHead;
+    unsigned int mMinCount;
+    unsigned int mFrame;
+    // The gain after the release, and its moving average over the lookahead.
+    float mHeldGain;
+    std::vector<float> mAverage;
+    unsigned int mAveragePos;
+    double mAverageSum;
+
+    void filterChannels(float *aBuffer, unsigned int aSamples, unsigned int aBufferSize, unsigned int aChannels, float aSamplerate);
+    void filterLookahead(float *aBuffer, unsigned int aSamples, unsigned int aBufferSize, unsigned int aChannels, float aSamplerate);
+    void resetLookahead(unsigned int aLookahead, unsigned int aChannels, float aSamplerate);
 
 public:
     virtual void filter(
@@ -34,7 +78,11 @@ public:
         OUTPUT_CEILING = 2,
         KNEE_WIDTH = 3,
         RELEASE_TIME = 4,
-        ATTACK_TIME = 5
+        ATTACK_TIME = 5,
+        // 0 disables it. Else the output is delayed by this many ms, and the
+        // gain goes down before the peaks, true peaks between the samples
+        // included, so that they don't exceed the output ceiling.
+        LOOKAHEAD = 6
     };
     float mWet;           // Wet/dry mix ratio, 1.0 means fully wet, 0.0 means fully dry
     float mThreshold;     // The threshold in dB. Signals above this level are reduced in gain. A lower value means more aggressive limiting.
@@ -42,6 +90,7 @@ public:
     float mKneeWidth;     // The width of the knee in dB. A larger value results in a softer transition into limiting.
     float mReleaseTime;   // The release time in milliseconds. Determines how quickly the gain reduction recovers after a signal drops below the threshold.
     float mAttackTime;    // Attack time in milliseconds
+    float mLookahead;     // Lookahead time in milliseconds, 0 to disable it. The attack time is not used with a lookahead.
 
     virtual int getParamCount();
     virtual const char *getParamName(unsigned int aParamIndex);
@@ -1,16 +1,26 @@
 #include <string.h>
-#include <memory>
 #include <cmath>
 
 #include "pitch_shift_filter.h"
 
+#if defined(SOLOUD_SSE_INTRINSICS)
+// trying to get more quality when SIMD is enabled.
+#define PITCH_SHIFT_FRAME_SIZE 4096
+#define PITCH_SHIFT_OVERSAMPLING 16
+#else
+#define PITCH_SHIFT_FRAME_SIZE 2048
+#define PITCH_SHIFT_OVERSAMPLING 8
+#endif
+
 PitchShiftInstance::PitchShiftInstance(PitchShift *aParent)
+    : pitchShift(PITCH_SHIFT_FRAME_SIZE, PITCH_SHIFT_OVERSAMPLING, aParent->mChannels),
+      mPerChannel(false)
 {
     mParent = aParent;
-    pitchShift = CSmbPitchShift();
-    initParams(3);
+    initParams(4);
     mParam[PitchShift::SHIFT] = aParent->mShift;
     mParam[PitchShift::SEMITONES] = aParent->mSemitones;
+    mParam[PitchShift::PER_CHANNEL] = aParent->mPerChannel;
 }
 
 void PitchShiftInstance::filter(
@@ -22,28 +32,69 @@ void PitchShiftInstance::filter(
     SoLoud::time aTime)
 {
     updateParams(aTime);
-    float *in = (float *)calloc((aSamples), sizeof(float));
-    for (int j = 0; j < aSamples; j++)
+    const bool perChannel = mParam[PitchShift::PER_CHANNEL] >= 0.5f && aChannels > 1 &&
+                            aChannels <= (unsigned int)pitchShift.getChannels();
+    if (perChannel != mPerChannel)
     {
-        // shrink channels to one to feed smbPitchShift.
-        for (int n = 0; n < aChannels; n++)
-            in[j] += aBuffer[j + aSamples * n];
-        in[j] /= (float)aChannels;
+        // The first channel goes on with the state of the mix down, the
+        // others must not play what they kept from the last time.
+        for (int n = 1; n < pitchShift.getChannels(); n++)
+            pitchShift.reset(n);
+        mPerChannel = perChannel;
     }
-    
-#if defined(SOLOUD_SSE_INTRINSICS)
-    // trying to get more quality when SIMD is enabled.
-    pitchShift.smbPitchShift(mParam[PitchShift::SHIFT], aSamples, 4096, 16, aSamplerate, in, in);
-#else
-    pitchShift.smbPitchShift(mParam[PitchShift::SHIFT], aSamples, 2048, 8, aSamplerate, in, in);
-#endif
-    for (int j = 0; j < aSamples; j++)
+
+    if (perChannel)
+        filterPerChannel(aBuffer, aSamples, aBufferSize, aChannels);
+    else
+        filterMono(aBuffer, aSamples, aBufferSize, aChannels);
+}
+
+void PitchShiftInstance::filterMono(float *aBuffer, unsigned int aSamples, unsigned int aBufferSize, unsigned int aChannels)
+{
+    for (unsigned int offset = 0; offset < aSamples; offset += SAMPLE_GRANULARITY)
     {
-        aBuffer[j] = aBuffer[j] * (1.0f - mParam[PitchShift::WET]) + in[j] * mParam[PitchShift::WET]; // L chan
-        for (int n = 1; n < aChannels; n++)
-            aBuffer[j + aSamples] = aBuffer[j + aSamples] * (1.0f - mParam[PitchShift::WET]) + in[j] * mParam[PitchShift::WET]; // R chan
+        const unsigned int count = aSamples - offset < SAMPLE_GRANULARITY ? aSamples - offset : SAMPLE_GRANULARITY;
+        getParamRamp(PitchShift::WET, mWet, offset, count, aSamples);
+        for (unsigned int j = 0; j < count; j++)
+        {
+            // shrink channels to one to feed smbPitchShift.
+            float sum = 0.f;
+            for (unsigned int n = 0; n < aChannels; n++)
+                sum += aBuffer[offset + j + aBufferSize * n];
+            mMono[j] = sum / (float)aChannels;
+        }
+
+        pitchShift.smbPitchShift(mParam[PitchShift::SHIFT], count, mMono, mMono);
+
+        for (unsigned int n = 0; n < aChannels; n++)
+        {
+            float *channel = aBuffer + offset + aBufferSize * n;
+            for (unsigned int j = 0; j < count; j++)
+                channel[j] = channel[j] * (1.0f - mWet[j]) + mMono[j] * mWet[j];
+        }
+    }
+}
+
+// The channels are shifted one after the other, on the thread running the
+// filter. Within a channel, the analysis and synthesis loops run 4 bins at
+// a time with SSE, which is wider than the channels of most sounds. Across
+// voices, the filters of the sounds rendered on the mix pool (see
+// Soloud::setMixThreadCount) run on its workers, but a global filter and
+// the channels of one voice always take a single thread.
+void PitchShiftInstance::filterPerChannel(float *aBuffer, unsigned int aSamples, unsigned int aBufferSize, unsigned int aChannels)
+{
+    for (unsigned int n = 0; n < aChannels; n++)
+    {
+        float *channel = aBuffer + aBufferSize * n;
+        for (unsigned int offset = 0; offset < aSamples; offset += SAMPLE_GRANULARITY)
+        {
+            const unsigned int count = aSamples - offset < SAMPLE_GRANULARITY ? aSamples - offset : SAMPLE_GRANULARITY;
+            pitchShift.smbPitchShift(mParam[PitchShift::SHIFT], count, channel + offset, mMono, n);
+            getParamRamp(PitchShift::WET, mWet, offset, count, aSamples);
+            for (unsigned int j = 0; j < count; j++)
+                channel[offset + j] = channel[offset + j] * (1.0f - mWet[j]) + mMono[j] * mWet[j];
+        }
     }
-    free(in);
 }
 
 void PitchShiftInstance::setFilterParameter(unsigned int aAttributeId, float aValue)
@@ -74,6 +125,9 @@ void PitchShiftInstance::setFilterParameter(unsigned int aAttributeId, float aVa
         mParam[PitchShift::SEMITONES] = aValue;
         mParam[PitchShift::SHIFT] = pow(2., aValue / 12.);
         break;
+    case PitchShift::PER_CHANNEL:
+        mParam[PitchShift::PER_CHANNEL] = aValue >= 0.5f ? 1.f : 0.f;
+        break;
     }
 
     mParamChanged |= 1 << aAttributeId;
@@ -100,13 +154,16 @@ SoLoud::result PitchShift::setParam(unsigned int aParamIndex, float aValue)
         mSemitones = aValue;
         mShift = pow(2., mSemitones / 12.);
         break;
+    case PER_CHANNEL:
+        mPerChannel = aValue >= 0.5f ? 1.f : 0.f;
+        break;
     }
     return SoLoud::SO_NO_ERROR;
 }
 
 int PitchShift::getParamCount()
 {
-    return 3;
+    return 4;
 }
 
 const char *PitchShift::getParamName(unsigned int aParamIndex)
@@ -119,12 +176,16 @@ const char *PitchShift::getParamName(unsigned int aParamIndex)
         return "Shift";
     case SEMITONES:
         return "Semitones";
+    case PER_CHANNEL:
+        return "Per Channel";
     }
     return "Wet";
 }
 
 unsigned int PitchShift::getParamType(unsigned int aParamIndex)
 {
+    if (aParamIndex == PER_CHANNEL)
+        return BOOL_PARAM;
     return FLOAT_PARAM;
 }
 
@@ -138,6 +199,8 @@ float PitchShift::getParamMax(unsigned int aParamIndex)
         return 3.f;
     case SEMITONES:
         return 36.f;
+    case PER_CHANNEL:
+        return 1.f;
     }
     return 1;
 }
@@ -152,15 +215,19 @@ float PitchShift::getParamMin(unsigned int aParamIndex)
         return 0.1f;
     case SEMITONES:
         return -36.f;
+    case PER_CHANNEL:
+        return 0.f;
     }
     return 1;
 }
 
-PitchShift::PitchShift()
+PitchShift::PitchShift(unsigned int aChannels)
 {
     mWet = 1.0f;
     mShift = 1.0f;
     mSemitones = 0.0f;
+    mPerChannel = 0.0f;
+    mChannels = aChannels < 1 ? 1 : aChannels > MAX_CHANNELS ? MAX_CHANNELS : aChannels;
 }
 
 SoLoud::FilterInstance *PitchShift::createInstance()
@@ -8,8 +8,20 @@ class PitchShift;
 
 class PitchShiftInstance : public SoLoud::FilterInstance
 {
+    // Shifts the channels mixed down with its first channel, or each channel
+    // with PER_CHANNEL. The states of all the channels are allocated here, not
+    // on the audio thread.
     CSmbPitchShift pitchShift;
+    bool mPerChannel;
     PitchShift *mParent;
+    // The channels mixed down, or the shifted channel, processed in blocks
+    // to not allocate.
+    float mMono[SAMPLE_GRANULARITY];
+    // The wet level of the block, ramping from its previous value.
+    float mWet[SAMPLE_GRANULARITY];
+
+    void filterMono(float *aBuffer, unsigned int aSamples, unsigned int aBufferSize, unsigned int aChannels);
+    void filterPerChannel(float *aBuffer, unsigned int aSamples, unsigned int aBufferSize, unsigned int aChannels);
 
 public:
     virtual void filter(
@@ -30,11 +42,17 @@ public:
     {
         WET = 0,
         SHIFT = 1,
-        SEMITONES = 2
+        SEMITONES = 2,
+        // 0 shifts the channels mixed down, 1 shifts each channel on its own
+        // to keep the stereo image, at the cost of one shift per channel.
+        PER_CHANNEL = 3
     };
     float mWet;
     float mShift;
     float mSemitones;
+    float mPerChannel;
+    // The channels the instances can shift on their own with PER_CHANNEL.
+    unsigned int mChannels;
     virtual int getParamCount();
     virtual const char *getParamName(unsigned int aParamIndex);
     virtual unsigned int getParamType(unsigned int aParamIndex);
@@ -42,7 +60,9 @@ public:
     virtual float getParamMin(unsigned int aParamIndex);
     SoLoud::result setParam(unsigned int aParamIndex, float aValue);
     virtual SoLoud::FilterInstance *createInstance();
-    PitchShift();
+    /// @param aChannels the channels of the sound, or of the engine for a
+    /// global filter. Buffers with more channels are mixed down.
+    PitchShift(unsigned int aChannels = 1);
 };
 
 #endif
\ No newline at end of file
@@ -13,13 +13,12 @@
 * the pitch. numSampsToProcess tells the routine how many samples in indata[0...
 * numSampsToProcess-1] should be pitch shifted and moved to outdata[0 ...
 * numSampsToProcess-1]. The two buffers can be identical (ie. it can process the
-* data in-place). fftFrameSize defines the FFT frame size used for the
-* processing. Typical values are 1024, 2048 and 4096. It may be any value <=
-* MAX_FRAME_LENGTH but it MUST be a power of 2. osamp is the STFT
+* data in-place). fftFrameSize, given to the constructor, defines the FFT frame
+* size used for the processing. Typical values are 1024, 2048 and 4096. It may
+* be any value but it MUST be a power of 2. osamp is the STFT
 * oversampling factor which also determines the overlap between adjacent STFT
 * frames. It should at least be 4 for moderate scaling ratios. A value of 32 is
-* recommended for best quality. sampleRate takes the sample rate for the signal 
-* in unit Hz, ie. 44100 for 44.1 kHz audio. The data passed to the routine in 
+* recommended for best quality. The data passed to the routine in 
 * indata[] should be in the range [-1.0, 1.0), which is also the output range 
 * for the data, make sure you scale the data accordingly (for 16bit signed integers
 * you would have to divide (and multiply) by 32768). 
@@ -40,267 +39,311 @@
 #include "smbPitchShift.h"
 #include "soloud.h"
 
+#include <algorithm>
 #include <string.h>
 #include <math.h>
-#include <stdio.h>
-#include <memory>
 
-#ifndef M_PI_2
-#define M_PI_2 1.57079632679489661923
+#if defined(SOLOUD_SSE_INTRINSICS)
+#include <emmintrin.h>
 #endif
 
 namespace {
 
-#if defined(SOLOUD_SSE_INTRINSICS)
-#include <emmintrin.h>
-#include <pmmintrin.h>
-#include <xmmintrin.h>
-
-FFI_PLUGIN_EXPORT void smbFft(float *fftBuffer, long fftFrameSize, long sign)
-/* 
-    FFT routine, (C)1996 S.M.Bernsee. Sign = -1 is FFT, 1 is iFFT (inverse)
-    Fills fftBuffer[0...2*fftFrameSize-1] with the Fourier transform of the
-    time domain data in fftBuffer[0...2*fftFrameSize-1]. The FFT array takes
-    and returns the cosine and sine parts in an interleaved manner, ie.
-    fftBuffer[0] = cosPart[0], fftBuffer[1] = sinPart[0], asf. fftFrameSize
-    must be a power of 2. It expects a complex input signal (see footnote 2),
-    ie. when working with 'common' audio signals our input signal has to be
-    passed as {in[0],0.,in[1],0.,in[2],0.,...} asf. In that case, the transform
-    of the frequencies of interest is in fftBuffer[0...fftFrameSize].
+const float kPi = 3.14159265358979323846f;
+const float kHalfPi = 1.57079632679489661923f;
+const float kTwoPi = 6.28318530717958647692f;
+
+/*
+    The analysis and the synthesis keep the phases in turns (1 turn = 2 pi) and
+    the frequencies in bins: the sample rate cancels out, and the phases can be
+    wrapped to [-0.5, 0.5] without changing their sine and cosine.
+
+    atan2, sin and cos are replaced by branch free polynomial approximations so
+    that each of these loops runs 4 bins at a time with SSE:
+    |fastAtan2(y, x) - atan2(y, x)| < 1e-5 rad, |fastSin(x) - sin(x)| < 4e-6.
 */
+
+inline float fastAtan2(float y, float x)
 {
-    const auto number = 2 * fftFrameSize - 2;
-    for (long i = 2, j = 0; i < number; i += 2) {
-        for (long bitm = fftFrameSize; bitm != 1; bitm >>= 1)
-        {
-            if (j & bitm)
-                j &= ~bitm;
-            else
-            {
-                j |= bitm;
-                break;
-            }
-        }
-        if (i < j) {
-            auto p1 = fftBuffer+i; 
-            auto p2 = fftBuffer+j;
-            auto temp = *p1; *(p1++) = *p2;
-            *(p2++) = temp; temp = *p1;
-            *p1 = *p2; *p2 = temp;
-        }
-    }
-    for (long k = 0, le = 2; k < (long)(log(fftFrameSize)/log(2.)+.5); k++) {
-        le <<= 1;
-        const auto le2 = le>>1;
-        /* __declspec(align(8)) */ struct { float r, i; } u{ 1.0, 0.0 };
+    const float ax = fabsf(x);
+    const float ay = fabsf(y);
+    const float mx = ax > ay ? ax : ay;
+    const float mn = ax > ay ? ay : ax;
+    const float a = mn / (mx > 1e-30f ? mx : 1e-30f);
+    const float s = a * a;
+    float r = ((-0.0464964749f * s + 0.15931422f) * s - 0.327622764f) * s * a + a;
+    if (ay > ax)
+        r = kHalfPi - r;
+    if (x < 0.f)
+        r = kPi - r;
+    return y < 0.f ? -r : r;
+}
 
-        const float arg = M_PI / (le2>>1);
-        const float wr = cos(arg);
-        const float wi = sign*sin(arg);
-        for (long j = 0; j < le2; j += 2) {
-            auto p1r = fftBuffer+j; 
-            auto p2r = p1r+le2;
+/// sin(x) for x in [-pi/2, pi/2].
+inline float sinPoly(float x)
+{
+    const float x2 = x * x;
+    return x * (1.f + x2 * (-1.f / 6.f + x2 * (1.f / 120.f + x2 * (-1.f / 5040.f + x2 * (1.f / 362880.f)))));
+}
 
-            __m128 u_ = _mm_castpd_ps(_mm_movedup_pd(_mm_load_sd((const double*)&u)));
+/// Sine and cosine of [turns] in [-0.5, 0.5].
+inline void fastSinCos(float turns, float &s, float &c)
+{
+    const float x = turns * kTwoPi;
+    const float ax = fabsf(x);
+    const float folded = ax > kHalfPi ? kPi - ax : ax;
+    s = x < 0.f ? -sinPoly(folded) : sinPoly(folded);
+    c = sinPoly(kHalfPi - ax);
+}
 
-            __m128 ldup = _mm_moveldup_ps(u_);
-            __m128 hdup = _mm_movehdup_ps(u_);
+inline float wrapTurns(float t)
+{
+    return t - floorf(t + 0.5f);
+}
 
-            long i = j;
-            for (; i < 2*fftFrameSize - le; i += le * 2) 
-            {
-                __m128 p2 = _mm_loadh_pi(_mm_castpd_ps(_mm_load_sd((const double*)p2r)), (const __m64*)(p2r + le));
-                __m128 part1 = _mm_mul_ps(p2, ldup);
-                __m128 part2 = _mm_mul_ps(p2, hdup);
-                part2 = _mm_castsi128_ps(_mm_shuffle_epi32(_mm_castps_si128(part2), _MM_SHUFFLE(2, 3, 0, 1)));
-                __m128 t = _mm_addsub_ps(part1, part2);
+#if defined(SOLOUD_SSE_INTRINSICS)
+inline __m128 select_ps(__m128 mask, __m128 a, __m128 b)
+{
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
 
-                __m128 p1 = _mm_loadh_pi(_mm_castpd_ps(_mm_load_sd((const double*)p1r)), (const __m64*)(p1r + le));
-                __m128 buffer = _mm_sub_ps(p1, t);
+inline __m128 atan2_ps(__m128 y, __m128 x)
+{
+    const __m128 signMask = _mm_set1_ps(-0.f);
+    const __m128 ax = _mm_andnot_ps(signMask, x);
+    const __m128 ay = _mm_andnot_ps(signMask, y);
+    const __m128 mx = _mm_max_ps(ax, ay);
+    const __m128 mn = _mm_min_ps(ax, ay);
+    const __m128 a = _mm_div_ps(mn, _mm_max_ps(mx, _mm_set1_ps(1e-30f)));
+    const __m128 s = _mm_mul_ps(a, a);
+    __m128 r = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(-0.0464964749f), s), _mm_set1_ps(0.15931422f));
+    r = _mm_add_ps(_mm_mul_ps(r, s), _mm_set1_ps(-0.327622764f));
+    r = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(r, s), a), a);
+    r = select_ps(_mm_cmpgt_ps(ay, ax), _mm_sub_ps(_mm_set1_ps(kHalfPi), r), r);
+    r = select_ps(_mm_cmplt_ps(x, _mm_setzero_ps()), _mm_sub_ps(_mm_set1_ps(kPi), r), r);
+    return _mm_xor_ps(r, _mm_and_ps(y, signMask));
+}
+
+inline __m128 sinPoly_ps(__m128 x)
+{
+    const __m128 x2 = _mm_mul_ps(x, x);
+    __m128 p = _mm_add_ps(_mm_mul_ps(x2, _mm_set1_ps(1.f / 362880.f)), _mm_set1_ps(-1.f / 5040.f));
+    p = _mm_add_ps(_mm_mul_ps(x2, p), _mm_set1_ps(1.f / 120.f));
+    p = _mm_add_ps(_mm_mul_ps(x2, p), _mm_set1_ps(-1.f / 6.f));
+    p = _mm_add_ps(_mm_mul_ps(x2, p), _mm_set1_ps(1.f));
+    return _mm_mul_ps(x, p);
+}
 
-                _mm_storeh_pi((__m64*)(p2r + le), buffer);
-                _mm_storel_pi((__m64*)p2r, buffer);
+inline void sincos_ps(__m128 turns, __m128 &s, __m128 &c)
+{
+    const __m128 signMask = _mm_set1_ps(-0.f);
+    const __m128 x = _mm_mul_ps(turns, _mm_set1_ps(kTwoPi));
+    const __m128 ax = _mm_andnot_ps(signMask, x);
+    const __m128 halfPi = _mm_set1_ps(kHalfPi);
+    const __m128 folded = select_ps(_mm_cmpgt_ps(ax, halfPi), _mm_sub_ps(_mm_set1_ps(kPi), ax), ax);
+    s = _mm_xor_ps(sinPoly_ps(folded), _mm_and_ps(x, signMask));
+    c = sinPoly_ps(_mm_sub_ps(halfPi, ax));
+}
 
-                buffer = _mm_add_ps(p1, t);
-                _mm_storeh_pi((__m64*)(p1r + le), buffer);
-                _mm_storel_pi((__m64*)p1r, buffer);
+/// [t] minus its nearest integer. |t| must be < 2^31.
+inline __m128 wrapTurns_ps(__m128 t)
+{
+    return _mm_sub_ps(t, _mm_cvtepi32_ps(_mm_cvtps_epi32(t)));
+}
+#endif
 
-                p1r += le * 2; 
-                p2r += le * 2; 
-            }
+} // namespace
 
+// -----------------------------------------------------------------------------------------------------------------
 
-            if (i < 2 * fftFrameSize) {
-                const auto p1i = p1r + 1;
-                const auto p2i = p2r + 1;
-                const float tr = *p2r * u.r - *p2i * u.i;
-                const float ti = *p2r * u.i + *p2i * u.r;
-                *p2r = *p1r - tr; *p2i = *p1i - ti;
-                *p1r += tr; *p1i += ti;
-            }
+CSmbPitchShift::CSmbPitchShift(long fftFrameSize, long osamp, int channels)
+    : mFrameSize(fftFrameSize),
+      mHalfSize(fftFrameSize / 2),
+      mOsamp(osamp),
+      mStepSize(fftFrameSize / osamp),
+      mChannels(channels),
+      mWindow(fftFrameSize),
+      mTwiddles(fftFrameSize - 2),
+      mSplitRe(fftFrameSize / 2 + 1),
+      mSplitIm(fftFrameSize / 2 + 1),
+      mBitReverse(fftFrameSize / 2),
+      mExpectedTurns(fftFrameSize / 2 + 1),
+      gInFIFO(channels * fftFrameSize),
+      gOutFIFO(channels * (fftFrameSize / osamp)),
+      gOutputAccum(channels * (fftFrameSize + fftFrameSize / osamp)),
+      gLastPhase(channels * (fftFrameSize / 2 + 1)),
+      gSumPhase(channels * (fftFrameSize / 2 + 1)),
+      gErrors(channels * (fftFrameSize / 2 + 1)),
+      gFFTworksp(fftFrameSize),
+      gRe(fftFrameSize / 2 + 1),
+      gIm(fftFrameSize / 2 + 1),
+      gAnaFreq(fftFrameSize / 2 + 1),
+      gAnaMagn(fftFrameSize / 2 + 1),
+      gSynFreq(fftFrameSize / 2 + 1),
+      gSynMagn(fftFrameSize / 2 + 1),
+      gRover(channels, 0)
+{
+    const long n = mFrameSize;
+    const long m = mHalfSize;
 
+    for (long k = 0; k < n; k++)
+        mWindow[k] = (float)(-.5 * cos(2. * M_PI * (double)k / (double)n) + .5);
 
-            const float tr = u.r*wr - u.i*wi;
-            u.i = u.r*wi + u.i*wr;
-            u.r = tr;
+    // The twiddles of the stage with butterflies [h] apart start at [h]:
+    // exp(-2 pi i j / (2 h)), j < h.
+    for (long h = 1; h < m; h <<= 1)
+    {
+        for (long j = 0; j < h; j++)
+        {
+            const double arg = -M_PI * (double)j / (double)h;
+            mTwiddles[2 * (h + j) - 2] = (float)cos(arg);
+            mTwiddles[2 * (h + j) - 1] = (float)sin(arg);
         }
     }
-}
-#else
-/// Without SIMD
-FFI_PLUGIN_EXPORT void smbFft(float *fftBuffer, long fftFrameSize, long sign)
-/* 
-    FFT routine, (C)1996 S.M.Bernsee. Sign = -1 is FFT, 1 is iFFT (inverse)
-    Fills fftBuffer[0...2*fftFrameSize-1] with the Fourier transform of the
-    time domain data in fftBuffer[0...2*fftFrameSize-1]. The FFT array takes
-    and returns the cosine and sine parts in an interleaved manner, ie.
-    fftBuffer[0] = cosPart[0], fftBuffer[1] = sinPart[0], asf. fftFrameSize
-    must be a power of 2. It expects a complex input signal (see footnote 2),
-    ie. when working with 'common' audio signals our input signal has to be
-    passed as {in[0],0.,in[1],0.,in[2],0.,...} asf. In that case, the transform
-    of the frequencies of interest is in fftBuffer[0...fftFrameSize].
-*/
-{
-    float wr, wi, arg, *p1, *p2, temp;
-    float tr, ti, ur, ui, *p1r, *p1i, *p2r, *p2i;
-    long i, bitm, j, le, le2, k;
-
-    for (i = 2; i < 2*fftFrameSize-2; i += 2) {
-        for (bitm = 2, j = 0; bitm < 2*fftFrameSize; bitm <<= 1) {
-            if (i & bitm) j++;
-            j <<= 1;
-        }
-        if (i < j) {
-            p1 = fftBuffer+i; p2 = fftBuffer+j;
-            temp = *p1; *(p1++) = *p2;
-            *(p2++) = temp; temp = *p1;
-            *p1 = *p2; *p2 = temp;
-        }
+
+    for (long k = 0; k <= m; k++)
+    {
+        const double arg = -2. * M_PI * (double)k / (double)n;
+        mSplitRe[k] = (float)cos(arg);
+        mSplitIm[k] = (float)sin(arg);
+        mExpectedTurns[k] = (float)((k * mStepSize) % n) / (float)n;
     }
-    for (k = 0, le = 2; k < (long)(log(fftFrameSize)/log(2.)+.5); k++) {
-        le <<= 1;
-        le2 = le>>1;
-        ur = 1.0;
-        ui = 0.0;
-        arg = M_PI / (le2>>1);
-        wr = cos(arg);
-        wi = sign*sin(arg);
-        for (j = 0; j < le2; j += 2) {
-            p1r = fftBuffer+j; p1i = p1r+1;
-            p2r = p1r+le2; p2i = p2r+1;
-            for (i = j; i < 2*fftFrameSize; i += le) {
-                tr = *p2r * ur - *p2i * ui;
-                ti = *p2r * ui + *p2i * ur;
-                *p2r = *p1r - tr; *p2i = *p1i - ti;
-                *p1r += tr; *p1i += ti;
-                p1r += le; p1i += le;
-                p2r += le; p2i += le;
-            }
-            tr = ur*wr - ui*wi;
-            ui = ur*wi + ui*wr;
-            ur = tr;
-        }
+
+    unsigned int bits = 0;
+    while ((1L << bits) < m)
+        bits++;
+    for (long i = 0; i < m; i++)
+    {
+        unsigned int r = 0;
+        for (unsigned int b = 0; b < bits; b++)
+            r |= ((i >> b) & 1) << (bits - 1 - b);
+        mBitReverse[i] = r;
     }
 }
-#endif
-
-// -----------------------------------------------------------------------------------------------------------------
 
-/*
-
-    12/12/02, smb
-    
-    PLEASE NOTE:
-    
-    There have been some reports on domain errors when the atan2() function was used
-    as in the above code. Usually, a domain error should not interrupt the program flow
-    (maybe except in Debug mode) but rather be handled "silently" and a global variable
-    should be set according to this error. However, on some occasions people ran into
-    this kind of scenario, so a replacement atan2() function is provided here.
-    
-    If you are experiencing domain errors and your program stops, simply replace all
-    instances of atan2() with calls to the smbAtan2() function below.
-    
-*/
-
-// Approximation was taken from:
-// http://www-labs.iro.umontreal.ca/~mignotte/IFT2425/Documents/EfficientApproximationArctgFunction.pdf
-//
-// |Error = fast_atan2(y, x) - atan2f(y, x)| < 0.00468 rad
-//
-// Octants:
-//         pi/2
-//       ` 3 | 2 /
-//        `  |  /
-//       4 ` | / 1
-//   pi -----+----- 0
-//       5 / | ` 8
-//        /  |  `
-//       / 6 | 7 `
-//         3pi/2
-
-template<typename T> T CopySign(T v, T x)
+void CSmbPitchShift::reset(int channel)
 {
-    return (x >= 0) ? v : -v;
+    const long bins = mHalfSize + 1;
+    const long accumSize = mFrameSize + mStepSize;
+    gRover[channel] = 0;
+    std::fill_n(gInFIFO.begin() + channel * mFrameSize, mFrameSize, 0.f);
+    std::fill_n(gOutFIFO.begin() + channel * mStepSize, mStepSize, 0.f);
+    std::fill_n(gOutputAccum.begin() + channel * accumSize, accumSize, 0.f);
+    std::fill_n(gLastPhase.begin() + channel * bins, bins, 0.f);
+    std::fill_n(gSumPhase.begin() + channel * bins, bins, 0.f);
+    std::fill_n(gErrors.begin() + channel * bins, bins, 0.f);
 }
 
-FFI_PLUGIN_EXPORT double smbAtan2(double y, double x)
+void CSmbPitchShift::complexFft(bool inverse)
 {
-    constexpr double scaling_constant = 0.28086;
+    float *a = gFFTworksp.data();
+    const long m = mHalfSize;
 
-    if (x == 0.) {
-        // Special case atan2(0.0, 0.0) = 0.0
-        if (y == 0.) {
-            return 0.;
+    for (long i = 0; i < m; i++)
+    {
+        const long j = mBitReverse[i];
+        if (i < j)
+        {
+            float t = a[2 * i];
+            a[2 * i] = a[2 * j];
+            a[2 * j] = t;
+            t = a[2 * i + 1];
+            a[2 * i + 1] = a[2 * j + 1];
+            a[2 * j + 1] = t;
         }
-
-        // x is zero so we are either at pi/2 for (y > 0) or -pi/2 for (y < 0)
-        return CopySign(M_PI_2, y);
     }
 
-    // Calculate quotient of y and x
-    const auto div = y / x;
-
-    // Determine in which octants we can be, if |y| is smaller than |x| (|div|<1)
-    // then we are either in 1,4,5 or 8 else we are in 2,3,6 or 7.
-    if (fabs(div) < 1.) {
-        // We are in 1,4,5 or 8
-
-        const auto atan = div / (1. + scaling_constant * div * div);
+    // The first stage only adds and subtracts.
+    for (long i = 0; i < 2 * m; i += 4)
+    {
+        const float ur = a[i], ui = a[i + 1];
+        const float vr = a[i + 2], vi = a[i + 3];
+        a[i] = ur + vr;
+        a[i + 1] = ui + vi;
+        a[i + 2] = ur - vr;
+        a[i + 3] = ui - vi;
+    }
 
-        // If we are in 4 or 5 we need to add pi or -pi respectively
-        if (x < 0.) {
-            return CopySign(M_PI, y) + atan;
+    const float sign = inverse ? -1.f : 1.f;
+    for (long h = 2; h < m; h <<= 1)
+    {
+        const float *w = &mTwiddles[2 * h - 2];
+        for (long i = 0; i < m; i += 2 * h)
+        {
+            float *p1 = a + 2 * i;
+            float *p2 = p1 + 2 * h;
+            long j = 0;
+#if defined(SOLOUD_SSE_INTRINSICS)
+            // Two butterflies at a time: (re, im, re, im).
+            const __m128 conj = inverse ? _mm_set_ps(-1.f, 1.f, -1.f, 1.f) : _mm_set_ps(1.f, -1.f, 1.f, -1.f);
+            for (; j < h; j += 2)
+            {
+                const __m128 tw = _mm_loadu_ps(w + 2 * j);
+                const __m128 wr = _mm_shuffle_ps(tw, tw, _MM_SHUFFLE(2, 2, 0, 0));
+                const __m128 wi = _mm_shuffle_ps(tw, tw, _MM_SHUFFLE(3, 3, 1, 1));
+                const __m128 v = _mm_loadu_ps(p2 + 2 * j);
+                const __m128 vSwap = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+                const __m128 t = _mm_add_ps(_mm_mul_ps(v, wr), _mm_mul_ps(_mm_mul_ps(vSwap, wi), conj));
+                const __m128 u = _mm_loadu_ps(p1 + 2 * j);
+                _mm_storeu_ps(p1 + 2 * j, _mm_add_ps(u, t));
+                _mm_storeu_ps(p2 + 2 * j, _mm_sub_ps(u, t));
+            }
+#endif
+            for (; j < h; j++)
+            {
+                const float wr = w[2 * j];
+                const float wi = sign * w[2 * j + 1];
+                const float tr = p2[2 * j] * wr - p2[2 * j + 1] * wi;
+                const float ti = p2[2 * j] * wi + p2[2 * j + 1] * wr;
+                p2[2 * j] = p1[2 * j] - tr;
+                p2[2 * j + 1] = p1[2 * j + 1] - ti;
+                p1[2 * j] += tr;
+                p1[2 * j + 1] += ti;
+            }
         }
-        return atan;
     }
-
-    // We are in 2,3,6 or 7
-    return CopySign(M_PI_2, y) - div / (div * div + scaling_constant);
 }
 
-//double smbAtan2(double x, double y)
-//{
-//  double signx;
-//  if (x > 0.) signx = 1.;  
-//  else signx = -1.;
-//  
-//  if (x == 0.) return 0.;
-//  if (y == 0.) return signx * M_PI / 2.;
-//  
-//  return atan2(x, y);
-//}
-
-
-} // namespace
-
-
-// -----------------------------------------------------------------------------------------------------------------
+void CSmbPitchShift::realFft()
+{
+    // The even and odd samples are the real and imaginary parts of a complex
+    // signal half as long: transform it, then split its spectrum.
+    complexFft(false);
+
+    const float *z = gFFTworksp.data();
+    const long m = mHalfSize;
+    for (long k = 0; k <= m; k++)
+    {
+        const long k1 = k == m ? 0 : k;
+        const long k2 = k == 0 ? 0 : m - k;
+        const float a = z[2 * k1], b = z[2 * k1 + 1];
+        const float c = z[2 * k2], d = z[2 * k2 + 1];
+        const float er = .5f * (a + c), ei = .5f * (b - d);
+        const float orr = .5f * (b + d), oi = -.5f * (a - c);
+        gRe[k] = er + mSplitRe[k] * orr - mSplitIm[k] * oi;
+        gIm[k] = ei + mSplitRe[k] * oi + mSplitIm[k] * orr;
+    }
+}
 
-CSmbPitchShift::CSmbPitchShift() {
+void CSmbPitchShift::inverseRealFft()
+{
+    float *z = gFFTworksp.data();
+    const long m = mHalfSize;
+    for (long k = 0; k < m; k++)
+    {
+        const float p = gRe[k], q = gIm[k];
+        const float r = gRe[m - k], s = gIm[m - k];
+        const float fer = p + r, fei = q - s;
+        const float dr = p - r, di = q + s;
+        const float forr = dr * mSplitRe[k] + di * mSplitIm[k];
+        const float foi = di * mSplitRe[k] - dr * mSplitIm[k];
+        z[2 * k] = fer - foi;
+        z[2 * k + 1] = fei + forr;
+    }
+    complexFft(true);
 }
 
-void CSmbPitchShift::smbPitchShift(float pitchShift, long numSampsToProcess, long fftFrameSize, long osamp, float sampleRate, float *indata, float *outdata)
+void CSmbPitchShift::smbPitchShift(float pitchShift, long numSampsToProcess, const float *indata, float *outdata, int channel)
 /*
     Routine smbPitchShift(). See top of file for explanation
     Purpose: doing pitch shifting while maintaining duration using the Short
@@ -309,157 +352,147 @@ void CSmbPitchShift::smbPitchShift(float pitchShift, long numSampsToProcess, lon
 */
 {
     /* set up some handy variables */
-    const long fftFrameSize2 = fftFrameSize/2;
-    const long stepSize = fftFrameSize/osamp;
-    const double freqPerBin = sampleRate/(double)fftFrameSize;
-    const double expct = 2.*M_PI*(double)stepSize/(double)fftFrameSize;
-    const long inFifoLatency = fftFrameSize-stepSize;
-    if (!gRover) 
-        gRover = inFifoLatency;
-
-    /* initialize our static arrays */
-    if (!gInit) {
-        memset(gInFIFO, 0, MAX_FRAME_LENGTH*sizeof(float));
-        memset(gOutFIFO, 0, MAX_FRAME_LENGTH*sizeof(float));
-        memset(gFFTworksp, 0, 2*MAX_FRAME_LENGTH*sizeof(float));
-        memset(gLastPhase, 0, (MAX_FRAME_LENGTH/2+1)*sizeof(float));
-        memset(gSumPhase, 0, (MAX_FRAME_LENGTH/2+1)*sizeof(float));
-        memset(gOutputAccum, 0, 2*MAX_FRAME_LENGTH*sizeof(float));
-        memset(gAnaFreq, 0, MAX_FRAME_LENGTH*sizeof(float));
-        memset(gAnaMagn, 0, MAX_FRAME_LENGTH*sizeof(float));
-
-        memset(gErrors, 0, MAX_FRAME_LENGTH * sizeof(float));
-
-        gInit = true;
-    }
-
-    auto window = std::make_unique<double[]>(fftFrameSize);
-    for (long k = 0; k < fftFrameSize; k++) {
-        window[k] = -.5*cos(2.*M_PI*(double)k / (double)fftFrameSize) + .5;
-    }
+    const long fftFrameSize = mFrameSize;
+    const long fftFrameSize2 = mHalfSize;
+    const long stepSize = mStepSize;
+    const float osamp = (float)mOsamp;
+    const long inFifoLatency = fftFrameSize - stepSize;
+    const float outputScale = 2.f / (fftFrameSize2 * osamp);
+
+    /* the state of [channel] */
+    float *const inFIFO = &gInFIFO[channel * fftFrameSize];
+    float *const outFIFO = &gOutFIFO[channel * stepSize];
+    float *const outputAccum = &gOutputAccum[channel * (fftFrameSize + stepSize)];
+    float *const lastPhase = &gLastPhase[channel * (fftFrameSize2 + 1)];
+    float *const sumPhase = &gSumPhase[channel * (fftFrameSize2 + 1)];
+    float *const errors = &gErrors[channel * (fftFrameSize2 + 1)];
+    long rover = gRover[channel];
+    if (!rover)
+        rover = inFifoLatency;
 
     /* main processing loop */
-    for (long i = 0; i < numSampsToProcess; i++){
-
+    for (long i = 0; i < numSampsToProcess; i++)
+    {
         /* As long as we have not yet collected enough data just read in */
-        gInFIFO[gRover] = indata[i];
-        outdata[i] = gOutFIFO[gRover-inFifoLatency];
-        gRover++;
+        inFIFO[rover] = indata[i];
+        outdata[i] = outFIFO[rover - inFifoLatency];
+        rover++;
 
         /* now we have enough data for processing */
-        if (gRover >= fftFrameSize) {
-            gRover = inFifoLatency;
-
-            /* do windowing and re,im interleave */
-            for (long k = 0; k < fftFrameSize;k++) {
-                gFFTworksp[2*k] = gInFIFO[k] * window[k];
-                gFFTworksp[2*k+1] = 0.;
-            }
-
-
-            /* ***************** ANALYSIS ******************* */
-            /* do transform */
-            smbFft(gFFTworksp, fftFrameSize, -1);
-
-            /* this is the analysis step */
-            for (long k = 0; k <= fftFrameSize2; k++) {
+        if (rover < fftFrameSize)
+            continue;
+        rover = inFifoLatency;
 
-                /* de-interlace FFT buffer */
-                const auto real = gFFTworksp[2*k];
-                const auto imag = gFFTworksp[2*k+1];
+        /* do windowing */
+        for (long k = 0; k < fftFrameSize; k++)
+            gFFTworksp[k] = inFIFO[k] * mWindow[k];
 
-                /* compute magnitude and phase */
-                const auto magn = 2.*hypotf(real, imag);
-                const auto phase = smbAtan2(imag,real);
+        /* ***************** ANALYSIS ******************* */
+        realFft();
 
-                /* compute phase difference */
-                double tmp = phase - gLastPhase[k];
-                gLastPhase[k] = phase;
-
-                /* subtract expected phase difference */
-                tmp -= (double)k*expct;
-
-                /* map delta phase into +/- Pi interval */
-                /* get deviation from bin frequency from the +/- Pi interval */
-                tmp /= (2.*M_PI);
-                tmp = osamp * (tmp - floor(tmp + 0.5)); // faster than round
+        /* compute the magnitude and the true frequency of each bin from the
+           phase difference with the previous frame */
+        long k = 0;
+#if defined(SOLOUD_SSE_INTRINSICS)
+        {
+            const __m128 toTurns = _mm_set1_ps(1.f / kTwoPi);
+            const __m128 vOsamp = _mm_set1_ps(osamp);
+            __m128 bin = _mm_set_ps(3.f, 2.f, 1.f, 0.f);
+            for (; k + 4 <= fftFrameSize2; k += 4)
+            {
+                const __m128 re = _mm_loadu_ps(&gRe[k]);
+                const __m128 im = _mm_loadu_ps(&gIm[k]);
+                const __m128 magn = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(re, re), _mm_mul_ps(im, im)));
+                const __m128 phase = _mm_mul_ps(atan2_ps(im, re), toTurns);
+                __m128 delta = _mm_sub_ps(phase, _mm_loadu_ps(&lastPhase[k]));
+                _mm_storeu_ps(&lastPhase[k], phase);
+                delta = wrapTurns_ps(_mm_sub_ps(delta, _mm_loadu_ps(&mExpectedTurns[k])));
+                _mm_storeu_ps(&gAnaMagn[k], magn);
+                _mm_storeu_ps(&gAnaFreq[k], _mm_add_ps(bin, _mm_mul_ps(delta, vOsamp)));
+                bin = _mm_add_ps(bin, _mm_set1_ps(4.f));
+            }
+        }
+#endif
+        for (; k <= fftFrameSize2; k++)
+        {
+            const float magn = sqrtf(gRe[k] * gRe[k] + gIm[k] * gIm[k]);
+            const float phase = fastAtan2(gIm[k], gRe[k]) * (1.f / kTwoPi);
+            const float delta = wrapTurns(phase - lastPhase[k] - mExpectedTurns[k]);
+            lastPhase[k] = phase;
+            gAnaMagn[k] = magn;
+            gAnaFreq[k] = (float)k + osamp * delta;
+        }
 
-                /* compute the k-th partials' true frequency */
-                tmp = (k + tmp) * freqPerBin;
+        /* ***************** PROCESSING ******************* */
+        /* this does the actual pitch shifting */
+        memset(gSynMagn.data(), 0, (fftFrameSize2 + 1) * sizeof(float));
+        memset(gSynFreq.data(), 0, (fftFrameSize2 + 1) * sizeof(float));
+        for (k = 0; k <= fftFrameSize2; k++)
+        {
+            const float originalIndex = k * pitchShift + errors[k];
+            const long index = (long)originalIndex;
+            errors[k] = originalIndex - index;
 
-                /* store magnitude and true frequency in analysis arrays */
-                gAnaMagn[k] = magn;
-                gAnaFreq[k] = tmp;
+            if (index <= fftFrameSize2)
+            {
+                const bool useSynFreq = gSynMagn[index] < gAnaMagn[k];
 
+                gSynMagn[index] += gAnaMagn[k];
+                if (useSynFreq)
+                    gSynFreq[index] = gAnaFreq[k] * pitchShift;
             }
+        }
 
-            /* ***************** PROCESSING ******************* */
-            /* this does the actual pitch shifting */
-            memset(gSynMagn, 0, fftFrameSize*sizeof(float));
-            memset(gSynFreq, 0, fftFrameSize*sizeof(float));
-            for (long k = 0; k <= fftFrameSize2; k++) {
-
-                //const long index = k*pitchShift;
-                const auto originalIndex = k*pitchShift + gErrors[k];
-                const long index = originalIndex;
-                gErrors[k] = originalIndex - index;
-
-                if (index <= fftFrameSize2) {
-                    const bool useSynFreq = gSynMagn[index] < gAnaMagn[k];
-
-                    gSynMagn[index] += gAnaMagn[k];
-                    if (useSynFreq) {
-                        gSynFreq[index] = gAnaFreq[k] * pitchShift;
-                    }
-                } 
+        /* ***************** SYNTHESIS ******************* */
+        /* accumulate the phase of each bin from its frequency */
+        k = 0;
+#if defined(SOLOUD_SSE_INTRINSICS)
+        {
+            const __m128 invOsamp = _mm_set1_ps(1.f / osamp);
+            __m128 bin = _mm_set_ps(3.f, 2.f, 1.f, 0.f);
+            for (; k + 4 <= fftFrameSize2; k += 4)
+            {
+                const __m128 deviation = _mm_sub_ps(_mm_loadu_ps(&gSynFreq[k]), bin);
+                __m128 phase = _mm_add_ps(_mm_loadu_ps(&sumPhase[k]), _mm_mul_ps(deviation, invOsamp));
+                phase = wrapTurns_ps(_mm_add_ps(phase, _mm_loadu_ps(&mExpectedTurns[k])));
+                _mm_storeu_ps(&sumPhase[k], phase);
+                __m128 s, c;
+                sincos_ps(phase, s, c);
+                const __m128 magn = _mm_loadu_ps(&gSynMagn[k]);
+                _mm_storeu_ps(&gRe[k], _mm_mul_ps(magn, c));
+                _mm_storeu_ps(&gIm[k], _mm_mul_ps(magn, s));
+                bin = _mm_add_ps(bin, _mm_set1_ps(4.f));
             }
-            
-            /* ***************** SYNTHESIS ******************* */
-            /* this is the synthesis step */
-            for (long k = 0; k <= fftFrameSize2; k++) {
-
-                /* get magnitude and true frequency from synthesis arrays */
-                const auto magn = gSynMagn[k];
-                double tmp = gSynFreq[k];
-
-                /* get bin deviation from freq deviation */
-                tmp /= freqPerBin;
-
-                /* subtract bin mid frequency */
-                tmp -= k;
-
-                /* take osamp into account */
-                tmp = 2.*M_PI*tmp/osamp;
-
-                /* add the overlap phase advance back in */
-                tmp += (double)k*expct;
-
-                /* accumulate delta phase to get bin phase */
-                gSumPhase[k] += tmp;
-                const auto phase = gSumPhase[k];
-
-                /* get real and imag part and re-interleave */
-                gFFTworksp[2*k] = magn*cosf(phase);
-                gFFTworksp[2*k+1] = magn*sinf(phase);
-            } 
-
-            /* zero negative frequencies */
-            for (long k = fftFrameSize+2; k < 2*fftFrameSize; k++) gFFTworksp[k] = 0.;
+        }
+#endif
+        for (; k <= fftFrameSize2; k++)
+        {
+            const float deviation = gSynFreq[k] - (float)k;
+            const float phase = wrapTurns(sumPhase[k] + deviation / osamp + mExpectedTurns[k]);
+            sumPhase[k] = phase;
+            float s, c;
+            fastSinCos(phase, s, c);
+            gRe[k] = gSynMagn[k] * c;
+            gIm[k] = gSynMagn[k] * s;
+        }
+        /* only the positive frequencies are set: the DC and Nyquist bins count
+           twice in the real inverse transform */
+        gRe[0] *= 2.f;
+        gIm[0] = 0.f;
+        gRe[fftFrameSize2] *= 2.f;
+        gIm[fftFrameSize2] = 0.f;
 
-            /* do inverse transform */
-            smbFft(gFFTworksp, fftFrameSize, 1);
+        inverseRealFft();
 
-            /* do windowing and add to output accumulator */ 
-            for(long k=0; k < fftFrameSize; k++) {
-                gOutputAccum[k] += 2. * window[k] * gFFTworksp[2*k]/(fftFrameSize2*osamp);
-            }
-            for (long k = 0; k < stepSize; k++) gOutFIFO[k] = gOutputAccum[k];
+        /* do windowing and add to output accumulator */
+        for (k = 0; k < fftFrameSize; k++)
+            outputAccum[k] += mWindow[k] * gFFTworksp[k] * outputScale;
+        memcpy(outFIFO, outputAccum, stepSize * sizeof(float));
 
-            /* shift accumulator */
-            memmove(gOutputAccum, gOutputAccum+stepSize, fftFrameSize*sizeof(float));
+        /* shift accumulator */
+        memmove(outputAccum, outputAccum + stepSize, fftFrameSize * sizeof(float));
 
-            /* move input FIFO */
-            for (long k = 0; k < inFifoLatency; k++) gInFIFO[k] = gInFIFO[k+stepSize];
-        }
+        /* move input FIFO */
+        memmove(inFIFO, inFIFO + stepSize, inFifoLatency * sizeof(float));
     }
 }
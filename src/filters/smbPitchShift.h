@@ -2,36 +2,73 @@
 #define SMB_PITCHSHIFT_H
 // http://blogs.zynaptiq.com/bernsee/pitch-shifting-using-the-ft/
 
+#include <vector>
+
 class CSmbPitchShift
 {
-    enum { MAX_FRAME_LENGTH = 8192 };
-
 public:
-    CSmbPitchShift();
-    
-    void reset()
-    {
-        gRover = 0;
-        gInit = false;
-    }
-    void smbPitchShift(float pitchShift, long numSampsToProcess, long fftFrameSize, long osamp, float sampleRate, float *indata, float *outdata);
+    /// @param fftFrameSize the STFT frame size, a power of 2 >= 8.
+    /// @param osamp the STFT oversampling factor, which also sets the overlap
+    /// between adjacent frames. At least 4, a power of 2 <= [fftFrameSize].
+    /// @param channels the number of independent signals to shift. They share
+    /// the tables and the scratch buffers, only their state is kept apart.
+    CSmbPitchShift(long fftFrameSize, long osamp, int channels = 1);
+
+    /// @brief Clear the audio kept from the previous calls of [channel].
+    void reset(int channel);
+
+    int getChannels() const { return mChannels; }
+
+    /// @brief Shift the pitch of [numSampsToProcess] samples of [indata] to
+    /// [outdata], which can be the same buffer. The output is delayed by
+    /// [fftFrameSize] - [fftFrameSize] / [osamp] samples.
+    /// Doesn't allocate: it can run on the audio thread.
+    /// @param channel the state to use, < the channels given to the constructor.
+    void smbPitchShift(float pitchShift, long numSampsToProcess, const float *indata, float *outdata, int channel = 0);
 
 private:
-    float gInFIFO[MAX_FRAME_LENGTH];
-    float gOutFIFO[MAX_FRAME_LENGTH];
-    float gFFTworksp[2 * MAX_FRAME_LENGTH];
-    float gLastPhase[MAX_FRAME_LENGTH / 2 + 1];
-    float gSumPhase[MAX_FRAME_LENGTH / 2 + 1];
-    float gOutputAccum[2 * MAX_FRAME_LENGTH];
-    float gAnaFreq[MAX_FRAME_LENGTH];
-    float gAnaMagn[MAX_FRAME_LENGTH];
-    float gSynFreq[MAX_FRAME_LENGTH];
-    float gSynMagn[MAX_FRAME_LENGTH];
-
-    float gErrors[MAX_FRAME_LENGTH];
-
-    long gRover = 0;
-    bool gInit = false;
+    /// @brief Forward FFT of [gFFTworksp] (real input) to [gRe] and [gIm], bins 0..N/2.
+    void realFft();
+    /// @brief Inverse FFT of [gRe] and [gIm], bins 0..N/2, to [gFFTworksp] (real output).
+    void inverseRealFft();
+    /// @brief In place complex FFT of N/2 interleaved points of [gFFTworksp].
+    void complexFft(bool inverse);
+
+    long mFrameSize;
+    long mHalfSize;
+    long mOsamp;
+    long mStepSize;
+    int mChannels;
+
+    /// Tables computed once by the constructor.
+    std::vector<float> mWindow;
+    /// exp(-2 pi i j / (N/2)), j < N/4, interleaved.
+    std::vector<float> mTwiddles;
+    /// exp(-2 pi i k / N), k <= N/2, to split the half size FFT.
+    std::vector<float> mSplitRe;
+    std::vector<float> mSplitIm;
+    std::vector<unsigned int> mBitReverse;
+    /// The phase advance of each bin between two frames, in turns.
+    std::vector<float> mExpectedTurns;
+
+    /// State kept between the calls, one after the other for each channel.
+    std::vector<float> gInFIFO;
+    std::vector<float> gOutFIFO;
+    std::vector<float> gOutputAccum;
+    std::vector<float> gLastPhase;
+    std::vector<float> gSumPhase;
+    std::vector<float> gErrors;
+
+    /// Scratch buffers of each frame.
+    std::vector<float> gFFTworksp;
+    std::vector<float> gRe;
+    std::vector<float> gIm;
+    std::vector<float> gAnaFreq;
+    std::vector<float> gAnaMagn;
+    std::vector<float> gSynFreq;
+    std::vector<float> gSynMagn;
+
+    std::vector<long> gRover;
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -99,9 +99,12 @@
 #include "common.cpp"
 #include "bindings.cpp"
 #include "player.cpp"
+#include "load_pool.cpp"
+#include "event_queue.cpp"
 #include "analyzer.cpp"
 #include "synth/basic_wave.cpp"
 #include "waveform/waveform.cpp"
+#include "waveform/peak_cache.cpp"
 #include "waveform/miniaudio_libvorbis.cpp"
 #include "audiobuffer/audiobuffer.cpp"
 #include "audiobuffer/stream_decoder.cpp"
@@ -0,0 +1,73 @@
+#include "load_pool.h"
+
+LoadPool::LoadPool(unsigned int maxThreads)
+    : mMaxThreads(maxThreads), mIdle(0), mRunning(0), mCancelling(false), mStopping(false)
+{
+    if (mMaxThreads == 0)
+    {
+        // Leave a core for the audio and the UI threads.
+        unsigned int cores = std::thread::hardware_concurrency();
+        mMaxThreads = cores > 1 ? cores - 1 : 1;
+    }
+}
+
+LoadPool::~LoadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        // Drop the queued jobs: at exit there is nobody to report to.
+        mJobs.clear();
+        mStopping = true;
+    }
+    mWakeUp.notify_all();
+    for (std::thread &thread : mThreads)
+        thread.join();
+}
+
+void LoadPool::enqueue(Job job)
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mJobs.push_back(std::move(job));
+        if (mJobs.size() > mIdle && mThreads.size() < mMaxThreads)
+            mThreads.emplace_back(&LoadPool::workerLoop, this);
+    }
+    mWakeUp.notify_one();
+}
+
+void LoadPool::cancelAll()
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    if (mThreads.empty())
+        return;
+    mCancelling = true;
+    mWakeUp.notify_all();
+    mAllDone.wait(lock, [this]
+                  { return mJobs.empty() && mRunning == 0; });
+    mCancelling = false;
+}
+
+void LoadPool::workerLoop()
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    for (;;)
+    {
+        mIdle++;
+        mWakeUp.wait(lock, [this]
+                     { return mStopping || !mJobs.empty(); });
+        mIdle--;
+        if (mJobs.empty())
+            return;
+
+        Job job = std::move(mJobs.front());
+        mJobs.pop_front();
+        bool cancelled = mCancelling;
+        mRunning++;
+        lock.unlock();
+        job(cancelled);
+        lock.lock();
+        mRunning--;
+        if (mJobs.empty() && mRunning == 0)
+            mAllDone.notify_all();
+    }
+}
@@ -0,0 +1,48 @@
+#ifndef LOAD_POOL_H
+#define LOAD_POOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// Bounded pool of threads running the jobs queued with [enqueue], used to
+/// decode several files at once without blocking the caller.
+/// Threads are started on demand, up to the maximum.
+class LoadPool
+{
+public:
+    /// A queued job. [cancelled] is true when the job has been dequeued by
+    /// [cancelAll]: it should only report that it has not been run.
+    typedef std::function<void(bool cancelled)> Job;
+
+    /// @param maxThreads the maximum number of concurrent jobs. 0 uses all
+    /// the CPU cores but one.
+    explicit LoadPool(unsigned int maxThreads = 0);
+    ~LoadPool();
+
+    /// @brief Queue [job] to be run by the first free thread.
+    void enqueue(Job job);
+
+    /// @brief Cancel the queued jobs and wait for the running ones.
+    void cancelAll();
+
+private:
+    void workerLoop();
+
+    unsigned int mMaxThreads;
+    std::vector<std::thread> mThreads;
+    std::deque<Job> mJobs;
+    /// Threads waiting for a job, and jobs being run.
+    unsigned int mIdle;
+    unsigned int mRunning;
+    bool mCancelling;
+    bool mStopping;
+    std::mutex mMutex;
+    std::condition_variable mWakeUp;
+    std::condition_variable mAllDone;
+};
+
+#endif // LOAD_POOL_H
@@ -2,6 +2,7 @@
 #include "player.h"
 #include "soloud.h"
 #include "soloud_wav.h"
+#include "soloud_bus.h"
 // #include "soloud_thread.h"
 #include "soloud_wavstream.h"
 #include "synth/basic_wave.h"
@@ -23,7 +24,7 @@
 #define __WEB__ 0
 #endif
 
-Player::Player() : mInited(false), mFilters(&soloud, nullptr) {}
+Player::Player() : mInited(false), mOffline(false), mContentDedup(false), mFilters(&soloud, nullptr) {}
 
 Player::~Player()
 {
@@ -77,10 +78,100 @@ PlayerErrors Player::init(unsigned int sampleRate, unsigned int bufferSize, unsi
     return (PlayerErrors)result;
 }
 
+PlayerErrors Player::initOffline(unsigned int sampleRate, unsigned int bufferSize, unsigned int channels)
+{
+    if (mInited)
+        return playerAlreadyInited;
+    if (bufferSize == 0)
+        return invalidParameter;
+
+    // The null driver neither opens a device nor starts an audio thread. It
+    // wants at least SAMPLE_GRANULARITY frames, but [renderOffline] can mix
+    // smaller blocks, like a device with a smaller buffer would ask.
+    SoLoud::result result = soloud.init(
+        SoLoud::Soloud::CLIP_ROUNDOFF,
+        SoLoud::Soloud::NULLDRIVER, sampleRate,
+        bufferSize < SAMPLE_GRANULARITY ? SAMPLE_GRANULARITY : bufferSize,
+        channels);
+    if (result == SoLoud::INVALID_PARAMETER)
+        return invalidParameter;
+    if (result == SoLoud::NOT_IMPLEMENTED)
+        return notImplemented;
+    if (result != SoLoud::SO_NO_ERROR)
+        return backendNotInited;
+
+    mInited = true;
+    mOffline = true;
+    mSampleRate = sampleRate;
+    mBufferSize = bufferSize;
+    mChannels = channels;
+    return noError;
+}
+
+bool Player::isOffline()
+{
+    return mOffline;
+}
+
+PlayerErrors Player::renderOffline(float *buffer, unsigned int frames)
+{
+    if (!mInited)
+        return backendNotInited;
+    // With a device, the audio thread is already mixing.
+    if (!mOffline)
+        return invalidParameter;
+    if (buffer == nullptr)
+        return nullPointer;
+
+    // Soloud::mix can't mix more than its scratch buffer at once.
+    while (frames > 0)
+    {
+        unsigned int n = frames < mBufferSize ? frames : mBufferSize;
+        soloud.mix(buffer, n);
+        buffer += n * mChannels;
+        frames -= n;
+    }
+    return noError;
+}
+
+PlayerErrors Player::renderOfflineToWav(const std::string &path, unsigned int frames)
+{
+    if (!mInited)
+        return backendNotInited;
+    if (!mOffline)
+        return invalidParameter;
+
+    ma_encoder_config config = ma_encoder_config_init(
+        ma_encoding_format_wav, ma_format_f32, mChannels, mSampleRate);
+    ma_encoder encoder;
+    if (ma_encoder_init_file(path.c_str(), &config, &encoder) != MA_SUCCESS)
+        return invalidParameter;
+
+    PlayerErrors ret = noError;
+    std::vector<float> buffer(mBufferSize * mChannels);
+    while (frames > 0)
+    {
+        unsigned int n = frames < mBufferSize ? frames : mBufferSize;
+        soloud.mix(buffer.data(), n);
+        ma_uint64 written = 0;
+        if (ma_encoder_write_pcm_frames(&encoder, buffer.data(), n, &written) != MA_SUCCESS ||
+            written != n)
+        {
+            ret = unknownError;
+            break;
+        }
+        frames -= n;
+    }
+    ma_encoder_uninit(&encoder);
+    return ret;
+}
+
 PlayerErrors Player::changeDevice(int deviceID)
 {
     if (!mInited)
         return backendNotInited;
+    if (mOffline)
+        return invalidParameter;
 
     void *playbackInfos_id = nullptr;
 
@@ -153,6 +244,13 @@ void Player::dispose()
     setStateChangedCallback(nullptr);
     soloud.deinit();
     mInited = false;
+    mOffline = false;
+    {
+        std::lock_guard<std::mutex> guard(remove_handle_mutex);
+        soundsByHandle.clear();
+    }
+    std::lock_guard<std::mutex> guard(sounds_mutex);
+    soundsByHash.clear();
     sounds.clear();
 }
 
@@ -163,6 +261,7 @@ bool Player::isInited()
 
 int Player::getSoundsCount()
 {
+    std::lock_guard<std::mutex> guard(sounds_mutex);
     return (int)sounds.size();
 }
 
@@ -232,13 +331,20 @@ const std::string Player::getErrorString(PlayerErrors errorCode) const
         return "error: audio format not supported!";
     case opusOggVorbisLibsNotFound:
         return "error: opus ogg vorbis libraries not found!";
+    case handleIsNotABus:
+        return "error: handle is not a bus!";
     }
     return "Other error";
 }
 
+unsigned int Player::getFileHash(const std::string &completeFileName)
+{
+    return (int32_t)std::hash<std::string>{}(completeFileName) & 0x7fffffff;
+}
+
 PlayerErrors Player::loadFile(
     const std::string &completeFileName,
-    bool loadIntoMem,
+    LoadMode loadMode,
     unsigned int *hash)
 {
     if (!mInited)
@@ -246,7 +352,7 @@ PlayerErrors Player::loadFile(
 
     *hash = 0;
 
-    unsigned int newHash = (int32_t)std::hash<std::string>{}(completeFileName) & 0x7fffffff;
+    unsigned int newHash = getFileHash(completeFileName);
     /// check if the sound has already been loaded
     auto const s = findByHash(newHash);
 
@@ -256,45 +362,134 @@ PlayerErrors Player::loadFile(
         return fileAlreadyLoaded;
     }
 
-    std::unique_ptr<ActiveSound> newSound = std::make_unique<ActiveSound>();
+    uint64_t contentHash = 0;
+    if (mContentDedup)
+    {
+        contentHash = getContentHash(completeFileName);
+        if (addSharedSound(completeFileName, newHash, contentHash, loadMode))
+        {
+            *hash = newHash;
+            return noError;
+        }
+    }
+
+    std::unique_ptr<ActiveSound> newSound;
+    PlayerErrors error = decodeFile(completeFileName, loadMode, newSound);
+    if (error != noError)
+        return error;
+
+    newSound.get()->contentHash = contentHash;
+    return addDecodedSound(std::move(newSound), hash);
+}
+
+PlayerErrors Player::decodeFile(
+    const std::string &completeFileName,
+    LoadMode loadMode,
+    std::unique_ptr<ActiveSound> &newSound)
+{
+    newSound = std::make_unique<ActiveSound>();
     newSound.get()->completeFileName = std::string(completeFileName);
-    *hash = newHash;
-    newSound.get()->soundHash = newHash;
+    newSound.get()->soundHash = getFileHash(completeFileName);
+    newSound.get()->loadMode = loadMode;
 
     SoLoud::result result;
     // This function is never called when running on the Web, but [__WEB__] is checked for consistency with [loadMem].
-    if (loadIntoMem || __WEB__)
+    if ((loadMode != LOAD_MODE_DISK && loadMode != LOAD_MODE_MEMORY_COMPRESSED) || __WEB__)
     {
         newSound.get()->sound = std::make_unique<SoLoud::Wav>();
         newSound.get()->soundType = TYPE_WAV;
-        result = static_cast<SoLoud::Wav *>(newSound.get()->sound.get())->load(completeFileName.c_str());
+        SoLoud::Wav *wav = static_cast<SoLoud::Wav *>(newSound.get()->sound.get());
+        wav->setCompactStorage(loadMode == LOAD_MODE_MEMORY_COMPACT);
+        result = wav->load(completeFileName.c_str());
     }
     else
     {
         newSound.get()->sound = std::make_unique<SoLoud::WavStream>();
         newSound.get()->soundType = TYPE_WAVSTREAM;
-        result = static_cast<SoLoud::WavStream *>(newSound.get()->sound.get())->load(completeFileName.c_str());
+        SoLoud::WavStream *stream = static_cast<SoLoud::WavStream *>(newSound.get()->sound.get());
+        if (loadMode == LOAD_MODE_MEMORY_COMPRESSED)
+            result = stream->loadToMem(completeFileName.c_str());
+        else
+            result = stream->load(completeFileName.c_str());
     }
 
     if (result != SoLoud::SO_NO_ERROR)
+        newSound.reset();
+
+    return (PlayerErrors)result;
+}
+
+PlayerErrors Player::addDecodedSound(std::unique_ptr<ActiveSound> newSound, unsigned int *hash)
+{
+    if (!mInited)
     {
         *hash = 0;
+        return backendNotInited;
     }
-    else
+
+    *hash = newSound.get()->soundHash;
+    /// another load of the same file could have been completed meanwhile
+    if (findByHash(*hash) != nullptr)
+        return fileAlreadyLoaded;
+
+    /// or the same content under another name: keep the first decoded one
+    if (newSound.get()->contentHash != 0)
     {
-        *hash = newHash;
-        newSound.get()->filters = std::make_unique<Filters>(&soloud, newSound.get());
-        sounds.push_back(std::move(newSound));
+        ActiveSound *const same = findByContent(newSound.get()->contentHash, newSound.get()->loadMode);
+        if (same != nullptr)
+            newSound.get()->sound = same->sound;
     }
 
-    return (PlayerErrors)result;
+    newSound.get()->filters = std::make_unique<Filters>(&soloud, newSound.get());
+    addSound(std::move(newSound));
+    return noError;
+}
+
+void Player::setContentDedup(bool enabled)
+{
+    mContentDedup = enabled;
+}
+
+bool Player::getContentDedup() const
+{
+    return mContentDedup;
+}
+
+uint64_t Player::getContentHash(const std::string &completeFileName)
+{
+    uint64_t contentHash = 0;
+    if (!hashFileContent(completeFileName.c_str(), &contentHash))
+        return 0;
+    return contentHash;
+}
+
+bool Player::addSharedSound(
+    const std::string &completeFileName,
+    unsigned int soundHash,
+    uint64_t contentHash,
+    LoadMode loadMode)
+{
+    ActiveSound *const same = findByContent(contentHash, loadMode);
+    if (same == nullptr)
+        return false;
+
+    auto newSound = std::make_unique<ActiveSound>();
+    newSound.get()->completeFileName = completeFileName;
+    newSound.get()->soundHash = soundHash;
+    newSound.get()->sound = same->sound;
+    newSound.get()->soundType = same->soundType;
+    newSound.get()->contentHash = contentHash;
+    newSound.get()->loadMode = loadMode;
+    newSound.get()->filters = std::make_unique<Filters>(&soloud, newSound.get());
+    addSound(std::move(newSound));
+    return true;
 }
 
 PlayerErrors Player::loadMem(
     const std::string &uniqueName,
     unsigned char *mem,
     int length,
-    bool loadIntoMem,
+    LoadMode loadMode,
     unsigned int &hash)
 {
     if (!mInited)
@@ -312,16 +507,35 @@ PlayerErrors Player::loadMem(
         return fileAlreadyLoaded;
     }
 
+    uint64_t contentHash = 0;
+    if (mContentDedup && mem != nullptr && length > 0)
+    {
+        contentHash = hashContent(mem, length);
+        if (addSharedSound(uniqueName, newHash, contentHash, loadMode))
+        {
+            // The WavStream would have taken the ownership of [mem].
+            if ((loadMode == LOAD_MODE_DISK || loadMode == LOAD_MODE_MEMORY_COMPRESSED) && !__WEB__)
+                delete[] mem;
+            hash = newHash;
+            return noError;
+        }
+    }
+
     auto newSound = std::make_unique<ActiveSound>();
     newSound.get()->completeFileName = std::string(uniqueName);
     hash = newHash;
     newSound.get()->soundHash = newHash;
+    newSound.get()->contentHash = contentHash;
+    newSound.get()->loadMode = loadMode;
     SoLoud::result result;
-    if (loadIntoMem || __WEB__)
+    // The WavStream keeps [mem], so LOAD_MODE_DISK and LOAD_MODE_MEMORY_COMPRESSED are the same here.
+    if ((loadMode != LOAD_MODE_DISK && loadMode != LOAD_MODE_MEMORY_COMPRESSED) || __WEB__)
     {
         newSound.get()->sound = std::make_unique<SoLoud::Wav>();
         newSound.get()->soundType = TYPE_WAV;
-        result = static_cast<SoLoud::Wav *>(newSound.get()->sound.get())->loadMem(mem, length, true, true);
+        SoLoud::Wav *wav = static_cast<SoLoud::Wav *>(newSound.get()->sound.get());
+        wav->setCompactStorage(loadMode == LOAD_MODE_MEMORY_COMPACT);
+        result = wav->loadMem(mem, length, true, true);
     }
     else
     {
@@ -333,7 +547,7 @@ PlayerErrors Player::loadMem(
     if (result == SoLoud::SO_NO_ERROR)
     {
         newSound.get()->filters = std::make_unique<Filters>(&soloud, newSound.get());
-        sounds.push_back(std::move(newSound));
+        addSound(std::move(newSound));
     }
 
     return (PlayerErrors)result;
@@ -374,7 +588,7 @@ PlayerErrors Player::setBufferStream(
         onMetadataCallback);
 
     newSound.get()->filters = std::make_unique<Filters>(&soloud, newSound.get());
-    sounds.push_back(std::move(newSound));
+    addSound(std::move(newSound));
 
     return e;
 }
@@ -451,7 +665,7 @@ PlayerErrors Player::getBufferSize(unsigned int hash, unsigned int *sizeInBytes)
     if (s == nullptr || s->soundType != SoundType::TYPE_BUFFER_STREAM)
         return PlayerErrors::soundHashNotFound;
 
-    *sizeInBytes = static_cast<SoLoud::BufferStream *>(s->sound.get())->mBuffer.buffer.size() +
+    *sizeInBytes = static_cast<SoLoud::BufferStream *>(s->sound.get())->mBuffer.getFloatsBufferSize() * sizeof(float) +
         static_cast<SoLoud::BufferStream *>(s->sound.get())->buffer.size();
     return PlayerErrors::noError;
 }
@@ -474,12 +688,13 @@ PlayerErrors Player::loadWaveform(
 
     hash = dist(g);
 
-    sounds.push_back(std::make_unique<ActiveSound>());
-    sounds.back().get()->completeFileName = "";
-    sounds.back().get()->soundHash = hash;
-    sounds.back().get()->sound = std::make_unique<Basicwave>((SoLoud::Soloud::WAVEFORM)waveform, superWave, detune, scale);
-    sounds.back().get()->soundType = TYPE_SYNTH;
-    sounds.back().get()->filters = std::make_unique<Filters>(&soloud, sounds.back().get());
+    auto newSound = std::make_unique<ActiveSound>();
+    newSound.get()->completeFileName = "";
+    newSound.get()->soundHash = hash;
+    newSound.get()->sound = std::make_unique<Basicwave>((SoLoud::Soloud::WAVEFORM)waveform, superWave, detune, scale);
+    newSound.get()->soundType = TYPE_SYNTH;
+    newSound.get()->filters = std::make_unique<Filters>(&soloud, newSound.get());
+    addSound(std::move(newSound));
 
     return noError;
 }
@@ -569,12 +784,8 @@ float Player::getRelativePlaySpeed(unsigned int handle)
 
 unsigned int Player::getActiveVoiceCount_internal()
 {
-    unsigned int count = 0;
-    for (auto &s : sounds)
-    {
-        count += s->handle.size();
-    }
-    return count;
+    std::lock_guard<std::mutex> guard(remove_handle_mutex);
+    return (unsigned int)soundsByHandle.size();
 }
 
 PlayerErrors Player::play(
@@ -584,13 +795,23 @@ PlayerErrors Player::play(
     float pan,
     bool paused,
     bool looping,
-    double loopingStartAt)
+    double loopingStartAt,
+    unsigned int bus)
 {
     ActiveSound *sound = findByHash(soundHash);
 
     if (sound == nullptr)
         return soundHashNotFound;
 
+    // A bus has a single voice, started by `createBus`. Playing it again
+    // would restart it and stop the voices played on it.
+    if (sound->soundType == TYPE_BUS)
+        return invalidParameter;
+
+    PlayerErrors busError = checkBus(bus);
+    if (busError != noError)
+        return busError;
+
     // A BufferStream using `release` buffer type can only have one instance.
     if (sound->soundType == SoundType::TYPE_BUFFER_STREAM &&
         static_cast<SoLoud::BufferStream *>(sound->sound.get())->getBufferingType() == BufferingType::RELEASED &&
@@ -620,9 +841,9 @@ PlayerErrors Player::play(
 
     handle = 0;
     SoLoud::handle newHandle = soloud.play(
-        *sound->sound.get(), volume, pan, paused, 0);
+        *sound->sound.get(), volume, pan, paused, bus);
     if (newHandle != 0) {
-        sound->handle.push_back({newHandle, MAX_DOUBLE});
+        addHandle(sound, newHandle);
         // Check if this buffer has enough data to be played
         if (sound->soundType == SoundType::TYPE_BUFFER_STREAM)
         {
@@ -646,47 +867,79 @@ void Player::stop(unsigned int handle)
 
 void Player::removeHandle(unsigned int handle)
 {
-    if (sounds.empty()) {
+    std::lock_guard<std::mutex> guard(remove_handle_mutex);
+    auto const h = soundsByHandle.find(handle);
+    if (h == soundsByHandle.end())
         return;
-    }
 
-    bool found = false;
-    size_t i = 0;
-    while (i < sounds.size() && !found) {
-        auto const& sound = sounds[i];
-        if (sound) {  // Check if unique_ptr is valid
-            size_t n = 0;
-            while (n < sound->handle.size() && !found) {
-                if (sound->handle[n].handle == handle) {
-                    sound->handle.erase(sound->handle.begin() + n);
-                    found = true;
-                }
-                ++n;
-            }
-        }
-        ++i;
-    }
+    // Keep the handles order (the first is the oldest one, see `play`) and
+    // shift the slot of the handles after the removed one.
+    ActiveSound *sound = h->second.sound;
+    size_t slot = h->second.slot;
+    soundsByHandle.erase(h);
+    sound->handle.erase(sound->handle.begin() + slot);
+    for (size_t n = slot; n < sound->handle.size(); ++n)
+        soundsByHandle[sound->handle[n].handle].slot = n;
 }
 
 void Player::disposeSound(unsigned int soundHash)
 {
-    if (sounds.empty())
+    std::unique_ptr<ActiveSound> sound;
     {
-        return;
+        std::lock_guard<std::mutex> guard(sounds_mutex);
+        auto const s = soundsByHash.find(soundHash);
+        if (s == soundsByHash.end())
+            return;
+
+        const size_t index = s->second;
+        const size_t last = sounds.size() - 1;
+        soundsByHash.erase(s);
+        sound = std::move(sounds[index]);
+        // Move the last sound into the hole instead of shifting all the
+        // following ones, and update its index.
+        if (index != last)
+        {
+            sounds[index] = std::move(sounds[last]);
+            ActiveSound *moved = sounds[index].get();
+            if (moved != nullptr)
+            {
+                auto const m = soundsByHash.find(moved->soundHash);
+                if (m != soundsByHash.end() && m->second == last)
+                    m->second = index;
+            }
+        }
+        sounds.pop_back();
     }
 
-    auto it = std::find_if(sounds.begin(), sounds.end(),
-                           [soundHash](const std::unique_ptr<ActiveSound> &sound) 
-                           {
-                               return sound->soundHash == soundHash;
-                           });
+    disposeSound(std::move(sound));
+}
 
-    if (it != sounds.end())
+void Player::disposeSound(std::unique_ptr<ActiveSound> activeSound)
+{
+    ActiveSound *sound = activeSound.get();
+    if (sound != nullptr)
     {
+        // Forget the handles before deleting the sound: deleting the audio source
+        // stops its voices and `voiceEndedCallback` must not find them anymore.
+        std::vector<ActiveHandle> handles;
+        {
+            std::lock_guard<std::mutex> guard(remove_handle_mutex);
+            for (auto const &h : sound->handle)
+                soundsByHandle.erase(h.handle);
+            handles.swap(sound->handle);
+        }
+        // An audio source shared with other sounds outlives this one, so stop
+        // only the voices of this sound.
+        if (sound->sound.use_count() > 1)
+        {
+            for (auto const &h : handles)
+                soloud.stop(h.handle);
+        }
+
         // Free filters
-        if (it->get()->filters)
+        if (sound->filters)
         {
-            Filters *f = it->get()->filters.release();
+            Filters *f = sound->filters.release();
             if (f != nullptr)
             {
                 // TODO: deleting "f" when running on Web will crash with segmentation fault.
@@ -695,18 +948,24 @@ void Player::disposeSound(unsigned int soundHash)
                 // This behavior can be tested by running "testAllInstancesFinished" in tests.dart.
                 // delete f;
             }
-            it->get()->filters.reset();
+            sound->filters.reset();
         }
-        sounds.erase(it);
     }
 }
 
 void Player::disposeAllSound()
 {
     soloud.stopAll();
-    while (sounds.size() > 0)
+    std::vector<std::unique_ptr<ActiveSound>> all;
     {
-        disposeSound(sounds[0]->soundHash);
+        std::lock_guard<std::mutex> guard(sounds_mutex);
+        all.swap(sounds);
+        soundsByHash.clear();
+    }
+    while (all.size() > 0)
+    {
+        disposeSound(std::move(all.back()));
+        all.pop_back();
     }
 }
 
@@ -738,19 +997,23 @@ PlayerErrors Player::textToSpeech(const std::string &textToSpeech, unsigned int
     // Ensure miniaudio device is started if it's stopped, ie by an interruption.
     soloud.miniaudio_ensureDeviceStarted();
 
-    sounds.push_back(std::make_unique<ActiveSound>());
-    sounds.back().get()->completeFileName = std::string("");
+    auto newSound = std::make_unique<ActiveSound>();
+    ActiveSound *added = newSound.get();
+    added->completeFileName = std::string("");
     SoLoud::result result = speech.setText(textToSpeech.c_str());
     if (result == SoLoud::SO_NO_ERROR)
     {
         handle = soloud.play(speech);
-        sounds.back().get()->filters = std::make_unique<Filters>(&soloud, sounds.back().get());
-        sounds.back().get()->handle.push_back({handle, MAX_DOUBLE});
+        added->filters = std::make_unique<Filters>(&soloud, added);
     }
-    else
     {
-        sounds.emplace_back();
+        std::lock_guard<std::mutex> guard(sounds_mutex);
+        sounds.push_back(std::move(newSound));
+        if (result != SoLoud::SO_NO_ERROR)
+            sounds.emplace_back();
     }
+    if (result == SoLoud::SO_NO_ERROR)
+        addHandle(added, handle);
     return (PlayerErrors)result;
 }
 
@@ -830,7 +1093,8 @@ PlayerErrors Player::seek(SoLoud::handle handle, float time)
     }
 
     bool isGroupHandle = soloud.isVoiceGroup(handle);
-    if ((sound == nullptr || sound->soundType == TYPE_SYNTH) && !isGroupHandle)
+    if ((sound == nullptr || sound->soundType == TYPE_SYNTH || sound->soundType == TYPE_BUS) &&
+        !isGroupHandle)
         return invalidParameter;
 
     SoLoud::result result = soloud.seek(handle, time);
@@ -892,18 +1156,23 @@ int Player::countAudioSource(unsigned int soundHash)
 
     if (s == nullptr)
         return 0;
+    // The audio source of a sound deduplicated by content is shared with
+    // other sounds, whose voices would be counted too.
+    if (s->sound.use_count() > 1)
+        return -1;
 
     SoLoud::AudioSource *as;
     switch (s->soundType)
     {
-    case TYPE_SYNTH:
-        return 0;
     case TYPE_WAV:
         as = static_cast<SoLoud::Wav *>(s->sound.get());
+        break;
     case TYPE_WAVSTREAM:
         as = static_cast<SoLoud::WavStream *>(s->sound.get());
+        break;
     case TYPE_BUFFER_STREAM:
         as = static_cast<SoLoud::BufferStream *>(s->sound.get());
+        break;
     default:
         return 0;
     }
@@ -940,39 +1209,108 @@ void Player::setMaxActiveVoiceCount(unsigned int maxVoiceCount)
     soloud.setMaxActiveVoiceCount(maxVoiceCount);
 }
 
+PlayerErrors Player::setMixThreadCount(unsigned int threadCount)
+{
+    SoLoud::result result = soloud.setMixThreadCount(threadCount);
+    if (result == SoLoud::INVALID_PARAMETER)
+        return invalidParameter;
+    return result == SoLoud::SO_NO_ERROR ? noError : unknownError;
+}
+
+PlayerErrors Player::setPrefetch(unsigned int soundHash, unsigned int milliseconds)
+{
+    auto const s = findByHash(soundHash);
+
+    if (s == nullptr)
+        return soundHashNotFound;
+    if (s->soundType != TYPE_WAVSTREAM)
+        return invalidParameter;
+    // The audio source of a sound deduplicated by content is shared with
+    // other sounds, which would be prefetched too.
+    if (s->sound.use_count() > 1)
+        return invalidParameter;
+
+    static_cast<SoLoud::WavStream *>(s->sound.get())->setPrefetch(milliseconds);
+    return noError;
+}
+
+unsigned int Player::getPrefetchUnderrunCount()
+{
+    return SoLoud::WavStream::getPrefetchUnderrunCount();
+}
+
+void Player::setPerfCountersEnabled(bool enabled)
+{
+    soloud.setPerfCountersEnabled(enabled);
+}
+
+void Player::getPerfSnapshot(SoLoud::PerfSnapshot *snapshot)
+{
+    soloud.getPerfSnapshot(*snapshot);
+}
+
+void Player::resetPerfCounters()
+{
+    soloud.resetPerfCounters();
+}
+
 ActiveSound *Player::findByHandle(SoLoud::handle handle)
 {
-    int i = 0;
-    while (i < (int)sounds.size())
+    std::lock_guard<std::mutex> guard(remove_handle_mutex);
+    auto const h = soundsByHandle.find(handle);
+    if (h == soundsByHandle.end())
+        return nullptr;
+
+    return h->second.sound;
+}
+
+ActiveSound *Player::findByContent(uint64_t contentHash, LoadMode loadMode)
+{
+    if (contentHash == 0)
+        return nullptr;
+
+    std::lock_guard<std::mutex> guard(sounds_mutex);
+    for (auto const &s : sounds)
     {
-        int index = 0;
-        while (sounds[i].get() && index < (int)sounds[i].get()->handle.size())
-        {
-            if (sounds[i].get()->handle[index].handle == handle)
-            {
-                return sounds[i].get();
-            }
-            ++index;
-        }
-        ++i;
+        // The filters and the prefetch of a sound are set on its audio source.
+        if (s.get()->contentHash == contentHash &&
+            s.get()->loadMode == loadMode &&
+            s.get()->filters &&
+            !s.get()->filters->hasFilters() &&
+            (s.get()->soundType != TYPE_WAVSTREAM ||
+             static_cast<SoLoud::WavStream *>(s.get()->sound.get())->mPrefetchMs == 0))
+            return s.get();
     }
-
     return nullptr;
 }
 
 ActiveSound *Player::findByHash(unsigned int soundHash)
 {
-    auto const &s = std::find_if(sounds.begin(), sounds.end(),
-                                 [&](std::unique_ptr<ActiveSound> const &f) 
-                                 { return f->soundHash == soundHash; });
-    if (s == sounds.end())
+    std::lock_guard<std::mutex> guard(sounds_mutex);
+    auto const s = soundsByHash.find(soundHash);
+    if (s == soundsByHash.end())
         return nullptr;
 
-    return s->get();
+    return sounds[s->second].get();
+}
+
+void Player::addSound(std::unique_ptr<ActiveSound> newSound)
+{
+    std::lock_guard<std::mutex> guard(sounds_mutex);
+    soundsByHash[newSound.get()->soundHash] = sounds.size();
+    sounds.push_back(std::move(newSound));
+}
+
+void Player::addHandle(ActiveSound *sound, SoLoud::handle handle)
+{
+    std::lock_guard<std::mutex> guard(remove_handle_mutex);
+    sound->handle.push_back({handle, MAX_DOUBLE});
+    soundsByHandle[handle] = {sound, sound->handle.size() - 1};
 }
 
 void Player::debug()
 {
+    std::lock_guard<std::mutex> guard(sounds_mutex);
     int n = 0;
     for (auto &sound : sounds)
     {
@@ -1015,6 +1353,68 @@ bool Player::isVoiceGroupEmpty(SoLoud::handle handle)
     return soloud.isVoiceGroupEmpty(handle);
 }
 
+/////////////////////////////////////////
+/// buses
+/////////////////////////////////////////
+
+PlayerErrors Player::createBus(unsigned int &hash, unsigned int &handle)
+{
+    if (!mInited)
+        return backendNotInited;
+
+    hash = 0;
+    handle = 0;
+
+    std::random_device rd;
+    std::mt19937 g(rd());
+    std::uniform_int_distribution<unsigned int> dist(0, INT32_MAX);
+
+    unsigned int newHash = dist(g);
+    while (findByHash(newHash) != nullptr)
+        newHash = dist(g);
+
+    auto bus = std::make_shared<SoLoud::Bus>();
+    // Mix with the channels of the output, so the voices keep their
+    // panning and the surround channels.
+    bus->setChannels(mChannels);
+
+    auto newSound = std::make_unique<ActiveSound>();
+    newSound.get()->completeFileName = "";
+    newSound.get()->soundHash = newHash;
+    newSound.get()->sound = bus;
+    newSound.get()->soundType = TYPE_BUS;
+    newSound.get()->filters = std::make_unique<Filters>(&soloud, newSound.get());
+
+    soloud.miniaudio_ensureDeviceStarted();
+
+    // The bus instance is protected and keeps ticking when inaudible, so it
+    // is never stopped to make room for other voices.
+    SoLoud::handle newHandle = soloud.play(*bus);
+    if (newHandle == 0)
+        return unknownError;
+    // The bus mixes the voices playing on its handle, which it looks up
+    // only when a sound is played with `Bus::play`.
+    bus->findBusHandle();
+
+    ActiveSound *added = newSound.get();
+    addSound(std::move(newSound));
+    addHandle(added, newHandle);
+
+    hash = newHash;
+    handle = newHandle;
+    return noError;
+}
+
+PlayerErrors Player::checkBus(unsigned int bus)
+{
+    if (bus == 0)
+        return noError;
+    ActiveSound *sound = findByHandle(bus);
+    if (sound == nullptr || sound->soundType != TYPE_BUS)
+        return handleIsNotABus;
+    return noError;
+}
+
 /////////////////////////////////////////
 /// faders
 /////////////////////////////////////////
@@ -1097,6 +1497,13 @@ PlayerErrors Player::play3d(
     if (sound == 0)
         return soundHashNotFound;
 
+    if (sound->soundType == TYPE_BUS)
+        return invalidParameter;
+
+    PlayerErrors busError = checkBus(bus);
+    if (busError != noError)
+        return busError;
+
     // A BufferStream using `release` buffer type can only have one instance.
     if (sound->soundType == SoundType::TYPE_BUFFER_STREAM &&
         static_cast<SoLoud::BufferStream *>(sound->sound.get())->getBufferingType() == BufferingType::RELEASED &&
@@ -1133,7 +1540,7 @@ PlayerErrors Player::play3d(
         paused,
         bus);
     if (newHandle != 0)
-        sound->handle.push_back({newHandle, MAX_DOUBLE});
+        addHandle(sound, newHandle);
     if (looping)
     {
         seek(newHandle, loopingStartAt);
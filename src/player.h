@@ -16,11 +16,20 @@
 #include <iostream>
 #include <vector>
 #include <map>
+#include <unordered_map>
 #include <mutex>
 #include <memory>
 #include <atomic>
 #include <thread>
 
+/// Where a voice handle is stored: the sound owning it and the index
+/// of the handle inside [ActiveSound::handle].
+struct HandleSlot
+{
+    ActiveSound *sound;
+    size_t slot;
+};
+
 struct PlaybackDevice
 {
     char *name;
@@ -43,6 +52,29 @@ public:
     /// @return Returns [PlayerErrors.SO_NO_ERROR] if success.
     PlayerErrors init(unsigned int sampleRate, unsigned int bufferSize, unsigned int channels, int deviceID = -1);
 
+    /// @brief Initialize the player without an audio device. Nothing is played:
+    /// the audio is mixed only by [renderOffline] and [renderOfflineToWav], as
+    /// fast as the CPU allows.
+    /// @param sampleRate sample rate of the rendered audio.
+    /// @param bufferSize the number of frames mixed at once, as a device would ask.
+    /// @param channels 1)mono, 2)stereo 4)quad 6)5.1 8)7.1
+    /// @return Returns [PlayerErrors.SO_NO_ERROR] if success.
+    PlayerErrors initOffline(unsigned int sampleRate, unsigned int bufferSize, unsigned int channels);
+
+    /// @brief Return true if the player has been initialized with [initOffline].
+    bool isOffline();
+
+    /// @brief Mix the next [frames] frames of audio.
+    /// @param buffer receives [frames] * channels interleaved samples.
+    /// @return invalidParameter if the player is not offline.
+    PlayerErrors renderOffline(float *buffer, unsigned int frames);
+
+    /// @brief Mix the next [frames] frames of audio into a 32 bit float WAV file.
+    /// @param path the file to create or overwrite.
+    /// @return invalidParameter if the player is not offline or if the file
+    /// can't be created.
+    PlayerErrors renderOfflineToWav(const std::string &path, unsigned int frames);
+
     /// @brief Change the playback device.
     /// @param deviceID the device ID. -1 for default OS output device.
     PlayerErrors changeDevice(int deviceID);
@@ -71,12 +103,16 @@ public:
 
     /// @brief Load a new sound to be played once or multiple times later.
     /// @param completeFileName the complete file path + file name.
-    /// @param loadIntoMem if true Soloud::wav will be used which loads
+    /// @param loadMode if LOAD_MODE_MEMORY Soloud::wav will be used which loads
     /// all raw audio data into memory. This will be useful when
     /// the audio is short, ie for game sounds, mainly used to prevent
     /// gaps or lags when starting a sound (less CPU, more memory allocated).
     /// (https://solhsa.com/soloud/wav.html)
-    /// If false, the audio data is loaded from the given file when
+    /// LOAD_MODE_MEMORY_COMPACT does the same storing 16 bit samples, which
+    /// halves the memory allocated.
+    /// LOAD_MODE_MEMORY_COMPRESSED keeps the file bytes in memory and each
+    /// voice decodes them when needed, like LOAD_MODE_DISK without the disk I/O.
+    /// If LOAD_MODE_DISK, the audio data is loaded from the given file when
     /// needed (more CPU less memory allocated). (https://solhsa.com/soloud/wavstream.html)
     /// @param hash return the hash of the sound.
     /// @return Returns [PlayerErrors.SO_NO_ERROR] if success
@@ -86,20 +122,72 @@ public:
     /// ref: https://github.com/nothings/stb/issues/676
     PlayerErrors loadFile(
         const std::string &completeFileName,
-        const bool loadIntoMem,
+        LoadMode loadMode,
         unsigned int *hash);
 
+    /// @brief Decode a file into a new sound without adding it to the loaded sounds.
+    /// It doesn't use the player state, so it can run on any thread while the
+    /// player is used. The sound is then added with [addDecodedSound].
+    /// @param completeFileName the complete file path + file name.
+    /// @param loadMode see [loadFile].
+    /// @param newSound return the decoded sound, or null on error.
+    static PlayerErrors decodeFile(
+        const std::string &completeFileName,
+        LoadMode loadMode,
+        std::unique_ptr<ActiveSound> &newSound);
+
+    /// @brief Add a sound decoded by [decodeFile] to the loaded sounds.
+    /// @param hash return the hash of the sound.
+    /// @return [fileAlreadyLoaded] if the same file has been loaded meanwhile,
+    /// in which case [newSound] is discarded.
+    PlayerErrors addDecodedSound(std::unique_ptr<ActiveSound> newSound, unsigned int *hash);
+
+    /// @brief The hash identifying the sound loaded from [completeFileName].
+    static unsigned int getFileHash(const std::string &completeFileName);
+
+    /// @brief Share the audio source of the sounds loaded from the same bytes.
+    /// When enabled, [loadFile] and [loadMem] hash the content of the file, and
+    /// a sound with the same content and load mode already loaded under another
+    /// name is not decoded again. The new sound gets its own hash and handles,
+    /// and the audio source is freed when the last of them is disposed.
+    /// @param enabled false by default. Only the sounds loaded while it is
+    /// enabled are deduplicated.
+    ///
+    /// NOTE: the sounds sharing an audio source also share its settings, like
+    /// the prefetch. Filters can't be added to them.
+    void setContentDedup(bool enabled);
+
+    /// @brief Return true if the sounds are deduplicated by content.
+    bool getContentDedup() const;
+
+    /// @brief Hash the content of [completeFileName] for the deduplication.
+    /// It doesn't use the player state, so it can run on any thread.
+    /// @return 0 if the file can't be read.
+    static uint64_t getContentHash(const std::string &completeFileName);
+
+    /// @brief Add a sound sharing the audio source of a loaded sound with the
+    /// same [contentHash] and [loadMode], without decoding it again.
+    /// @param completeFileName the name of the new sound.
+    /// @param soundHash the hash of the new sound.
+    /// @return false if there is no sound to share.
+    bool addSharedSound(
+        const std::string &completeFileName,
+        unsigned int soundHash,
+        uint64_t contentHash,
+        LoadMode loadMode);
+
     /// @brief Load a new sound stored into [mem] to be played once or multiple times later.
     /// Mainly used on web because the browsers are not allowed to read files directly.
     /// @param uniqueName the unique name of the sound. Used only to have the [hash].
     /// @param mem the audio data. These contains the audio file bytes.
     /// @param length the length of [mem].
+    /// @param loadMode see [loadFile].
     /// @param hash return the hash of the sound.
     PlayerErrors loadMem(
         const std::string &uniqueName,
         unsigned char *mem,
         int length,
-        bool loadIntoMem,
+        LoadMode loadMode,
         unsigned int &hash);
 
     /// @brief Set up an audio stream.
@@ -234,6 +322,8 @@ public:
     /// the start of the stream. The loop start point can be set with this parameter, and
     /// current loop point can be queried with [getLoopingPoint] and
     /// changed by [setLoopingPoint].
+    /// @param bus the handle of a bus created with [createBus] to play the
+    /// sound through, 0 to play it directly.
     /// @return the handle of the sound, 0 if error.
     PlayerErrors play(
         unsigned int soundHash,
@@ -242,7 +332,8 @@ public:
         float pan = 0.0f,
         bool paused = false,
         bool looping = false,
-        double loopingStartAt = 0.0);
+        double loopingStartAt = 0.0,
+        unsigned int bus = 0);
 
     /// @brief Stop already loaded sound identified by [handle] and clear it.
     /// @param handle handle of the sound.
@@ -311,9 +402,9 @@ public:
     /// @param time the time to seek in seconds.
     /// @return Returns [PlayerErrors.SO_NO_ERROR] if success.
     ///
-    /// WARNING: when seeking an mp3 file loaded using `loadIntoMem`=false
-    /// the seek operation is not performed due to the problem explained
-    /// in souloud_wavstream.cpp in `WavStreamInstance::seek` function.
+    /// NOTE: mp3 files loaded using `loadMode`=LOAD_MODE_DISK are indexed
+    /// when loaded, so the seek only decodes a few frames. See
+    /// `WavStream::buildMp3SeekTable` in souloud_wavstream.cpp.
     PlayerErrors seek(SoLoud::handle handle, float time);
 
     /// @brief Get current sound position in seconds.
@@ -366,6 +457,7 @@ public:
     unsigned int getActiveVoiceCount_internal();
 
     /// @brief Returns the number of concurrent sounds that are playing a specific audio source.
+    /// Returns -1 if the audio source is shared with other sounds by the content deduplication.
     int countAudioSource(unsigned int soundHash);
 
     /// @brief Returns the number of voices the application has told SoLoud to play.
@@ -410,12 +502,47 @@ public:
     /// probably going to make some serious changes in any case.
     void setMaxActiveVoiceCount(unsigned int maxVoiceCount);
 
-    /// @brief Find a sound by its handle.
+    /// @brief Set the number of worker threads that render the voices
+    /// along with the audio thread.
+    /// @param threadCount the number of workers. 0 renders all the voices
+    /// on the audio thread.
+    /// @return Returns [PlayerErrors.SO_NO_ERROR] if success.
+    ///
+    /// NOTE: Only voices playing sounds loaded from files or memory and
+    /// waveforms are rendered by the workers. Their output is then summed
+    /// in the same order, so the result doesn't change with the count.
+    PlayerErrors setMixThreadCount(unsigned int threadCount);
+
+    /// @brief Decode the sound ahead of its voices on a background thread.
+    /// @param soundHash the hash of a sound loaded with [LoadMode.disk].
+    /// @param milliseconds how much audio is kept decoded for each voice.
+    /// 0 decodes on the audio thread.
+    /// @return Returns [PlayerErrors.SO_NO_ERROR] if success, [PlayerErrors.invalidParameter]
+    /// if the sound is not a WavStream or its audio source is shared with other sounds.
+    ///
+    /// NOTE: Only the voices started after this call are prefetched.
+    PlayerErrors setPrefetch(unsigned int soundHash, unsigned int milliseconds);
+
+    /// @brief Get the number of times a prefetched voice played silence
+    /// because its audio was not decoded in time.
+    unsigned int getPrefetchUnderrunCount();
+
+    /// @brief Enable or disable the timing of the audio callback, of the
+    /// resampling and of the filters. Disabled by default.
+    void setPerfCountersEnabled(bool enabled);
+
+    /// @brief Copy the performance counters of the mixing to [snapshot].
+    void getPerfSnapshot(SoLoud::PerfSnapshot *snapshot);
+
+    /// @brief Zero the performance counters.
+    void resetPerfCounters();
+
+    /// @brief Find a sound by its handle. This is a constant time lookup.
     /// @param handle the handle to search.
     /// @return If not found, return nullptr.
     ActiveSound *findByHandle(SoLoud::handle handle);
 
-    /// @brief Find a sound by its handle.
+    /// @brief Find a sound by its hash. This is a constant time lookup.
     /// @param hash the hash to search.
     /// @return If not found, return nullptr.
     ActiveSound *findByHash(unsigned int hash);
@@ -449,6 +576,25 @@ public:
     /// @return true if the group handle doesn't have any voices.
     bool isVoiceGroupEmpty(SoLoud::handle handle);
 
+    /////////////////////////////////////////
+    /// buses
+    /////////////////////////////////////////
+
+    /// @brief Create a bus and start it. The voices played on the bus are
+    /// mixed together before its filters, so a filter added to the bus runs
+    /// once for all of them instead of once per voice.
+    /// The bus is a sound like the others: its filters are added with its
+    /// [hash], its volume, pan and filter parameters are set with its
+    /// [handle], and [disposeSound] stops it and the voices played on it.
+    /// @param hash return the hash of the bus.
+    /// @param handle return the handle of the bus voice, to pass to [play].
+    /// @return Returns [PlayerErrors.SO_NO_ERROR] if success.
+    PlayerErrors createBus(unsigned int &hash, unsigned int &handle);
+
+    /// @brief Check that [bus] is 0 or the handle of a bus created with [createBus].
+    /// @return [handleIsNotABus] if not.
+    PlayerErrors checkBus(unsigned int bus);
+
     /////////////////////////////////////////
     /// faders & oscillators
     /////////////////////////////////////////
@@ -527,6 +673,8 @@ public:
     /// the start of the stream. The loop start point can be set with this parameter, and
     /// current loop point can be queried with [getLoopingPoint] and
     /// changed by [setLoopingPoint].
+    /// @param bus the handle of a bus created with [createBus] to play the
+    /// sound through, 0 to play it directly.
     /// @return the handle of the sound, 0 if error.
     PlayerErrors play3d(
         unsigned int soundHash,
@@ -599,12 +747,19 @@ public:
                                   float dopplerFactor);
 
 public:
-    /// all the sounds loaded
+    /// all the sounds loaded, in no particular order: [disposeSound] moves
+    /// the last one into the slot it frees.
     std::vector<std::unique_ptr<ActiveSound>> sounds;
 
     /// true when the backend is initialized
     bool mInited;
 
+    /// true when initialized with the null driver by [initOffline]
+    bool mOffline;
+
+    /// true when the loaded sounds are deduplicated by content
+    bool mContentDedup;
+
     /// main SoLoud engine
     SoLoud::Soloud soloud;
 
@@ -619,8 +774,35 @@ public:
     unsigned int mChannels;
 
 private:
+    /// @brief Move [newSound] into [sounds] and index it by its hash.
+    void addSound(std::unique_ptr<ActiveSound> newSound);
+
+    /// @brief Dispose [activeSound], already removed from [sounds] and
+    /// [soundsByHash].
+    void disposeSound(std::unique_ptr<ActiveSound> activeSound);
+
+    /// @brief Store the new voice [handle] in [sound] and index it.
+    void addHandle(ActiveSound *sound, SoLoud::handle handle);
+
+    /// @brief Find a sound which can share its audio source with a sound
+    /// loaded from [contentHash] with [loadMode].
+    ActiveSound *findByContent(uint64_t contentHash, LoadMode loadMode);
+
+    /// hash -> index in [sounds] lookup, kept in sync with [sounds].
+    std::unordered_map<unsigned int, size_t> soundsByHash;
+
+    /// handle -> owning sound and slot lookup, kept in sync with the
+    /// `handle` list of every sound in [sounds].
+    std::unordered_map<SoLoud::handle, HandleSlot> soundsByHandle;
+
     ma_device_info *pPlaybackInfos;
+    /// Guards [soundsByHandle] and the `handle` lists. Handles are removed
+    /// by `voiceEndedCallback` which can be called from the audio thread.
     std::mutex remove_handle_mutex;
+    /// Guards [sounds] and [soundsByHash]. Sounds are added by the load pool
+    /// threads (see `loadFileJob` in bindings.cpp) while the main isolate
+    /// looks them up, plays and disposes them.
+    std::mutex sounds_mutex;
     unsigned int mBufferSize;
 };
 
@@ -70,6 +70,8 @@ freely, subject to the following restrictions:
 #if !defined(DISABLE_SIMD)
 #if defined(__x86_64__) || defined( _M_X64 ) || defined( __i386 ) || defined( _M_IX86 )
 #define SOLOUD_SSE_INTRINSICS
+#elif defined(__ARM_NEON) || defined(__aarch64__) || defined(_M_ARM64)
+#define SOLOUD_NEON_INTRINSICS
 #endif
 #endif
 
@@ -91,6 +93,9 @@ freely, subject to the following restrictions:
 // 1)mono, 2)stereo 4)quad 6)5.1 8)7.1
 #define MAX_CHANNELS 8
 
+// Mono-mixed output samples kept for visualization (power of two)
+#define VISUALIZATION_HISTORY_SIZE 8192
+
 // Default resampler for both main and bus mixers
 #define SOLOUD_DEFAULT_RESAMPLER SoLoud::Soloud::RESAMPLER_LINEAR
 
@@ -103,6 +108,7 @@ freely, subject to the following restrictions:
 namespace SoLoud
 {
 	class Soloud;
+	class MixPool;
 	typedef void (*mutexCallFunction)(void *aMutexPtr);
 	typedef void (*soloudCallFunction)(Soloud *aSoloud);
 	typedef unsigned int result;
@@ -145,6 +151,7 @@ namespace SoLoud
 
 #include "soloud_filter.h"
 #include "soloud_fader.h"
+#include "soloud_perf.h"
 #include "soloud_audiosource.h"
 #include "soloud_bus.h"
 #include "soloud_queue.h"
@@ -299,13 +306,17 @@ namespace SoLoud
 		// Count voices that play this audio source
 		int countAudioSource(AudioSource &aSound);
 
-		// Set a live filter parameter. Use 0 for the global filters.
+		// Set a live filter parameter. Use 0 for the global filters: their values
+		// are posted without locking the audio thread, and set at its next mix.
+		// The voice filters live on the voices, so their parameters still take the
+		// audio mutex, as do their fades and oscillations.
 		void setFilterParameter(handle aVoiceHandle, unsigned int aFilterId, unsigned int aAttributeId, float aValue);
 		// Get a live filter parameter. Use 0 for the global filters.
 		float getFilterParameter(handle aVoiceHandle, unsigned int aFilterId, unsigned int aAttributeId);
-		// Fade a live filter parameter. Use 0 for the global filters.
+		// Fade a live filter parameter. Use 0 for the global filters: the fade is
+		// posted as setFilterParameter does, and starts at the next mix.
 		void fadeFilterParameter(handle aVoiceHandle, unsigned int aFilterId, unsigned int aAttributeId, float aTo, time aTime);
-		// Oscillate a live filter parameter. Use 0 for the global filters.
+		// Oscillate a live filter parameter. Use 0 for the global filters, posted as for fadeFilterParameter.
 		void oscillateFilterParameter(handle aVoiceHandle, unsigned int aFilterId, unsigned int aAttributeId, float aFrom, float aTo, time aTime);
 
 		// Get current play time, in seconds.
@@ -328,6 +339,8 @@ namespace SoLoud
 		unsigned int getActiveVoiceCount();
 		// Get the current number of voices in SoLoud
 		unsigned int getVoiceCount();
+		// Get a copy of the performance counters, see setPerfCountersEnabled.
+		void getPerfSnapshot(PerfSnapshot &aSnapshot) const;
 		// Check if the handle is still valid, or if the sound has stopped.
 		bool isValidVoiceHandle(handle aVoiceHandle);
 		// Get current relative play speed.
@@ -355,6 +368,14 @@ namespace SoLoud
 		void setAutoStop(handle aVoiceHandle, bool aAutoStop);
 		// Set current maximum active voice setting
 		result setMaxActiveVoiceCount(unsigned int aVoiceCount);
+		// Set the number of worker threads that render voices along with the audio thread.
+		// Only the instances flagged CONCURRENT_MIX are rendered on the workers. 0 (default)
+		// renders every voice on the audio thread.
+		result setMixThreadCount(unsigned int aThreadCount);
+		// Enable or disable the timing of the mixing, see getPerfSnapshot. Disabled by default.
+		void setPerfCountersEnabled(bool aEnabled);
+		// Zero the performance counters.
+		void resetPerfCounters();
 		// Set behavior for inaudible sounds
 		void setInaudibleBehavior(handle aVoiceHandle, bool aMustTick, bool aKill);
 		// Set the global volume
@@ -418,6 +439,9 @@ namespace SoLoud
 		// Get 256 floats of wave data for visualization. Visualization has to be enabled before use.
 		float *getWave();
 
+		// Copy the latest aSamples (up to VISUALIZATION_HISTORY_SIZE) mono-mixed output samples to aBuffer, oldest first. Visualization has to be enabled before use.
+		void getWaveHistory(float *aBuffer, unsigned int aSamples);
+
 		// Get approximate output volume for a channel for visualization. Visualization has to be enabled before use.
 		float getApproximateVolume(unsigned int aChannel);
 
@@ -488,6 +512,10 @@ namespace SoLoud
 		void mapResampleBuffers_internal();
 		// Perform mixing for a specific bus
 		void mixBus_internal(float *aBuffer, unsigned int aSamplesToRead, unsigned int aBufferSize, float *aScratch, unsigned int aBus, float aSamplerate, unsigned int aChannels, unsigned int aResampler);
+		// Get, filter and resample the audio of a voice into aScratch. Doesn't pan it.
+		void renderVoice_internal(AudioSourceInstance *aVoice, float *aScratch, unsigned int aSamplesToRead, unsigned int aBufferSize, float aSamplerate, unsigned int aResampler, float *aSeekScratch, unsigned int aSeekScratchSize);
+		// Render the CONCURRENT_MIX voices of a bus on the mix pool. Returns false if nothing was rendered.
+		bool renderVoicesConcurrently_internal(unsigned int aSamplesToRead, unsigned int aBufferSize, unsigned int aBus, float aSamplerate, unsigned int aResampler);
 		// Find a free voice, stopping the oldest if no free voice is found.
 		int findFreeVoice_internal();
 		// Converts handle to voice, if the handle is valid. Returns -1 if not.
@@ -538,6 +566,18 @@ namespace SoLoud
 		AlignedFloatBuffer mResampleDataBuffer;
 		// Owners of the resample data
 		AudioSourceInstance **mResampleDataOwner;
+		// Worker pool and tasks for concurrent mixing, NULL if disabled.
+		MixPool *mMixPool;
+		// Scratch of the voices rendered by the mix pool.
+		AlignedFloatBuffer mMixScratch;
+		// Voice rendered by the mix pool at each active voice index, 0 for the voices mixed serially.
+		AudioSourceInstance *mMixVoice[VOICE_COUNT];
+		// Output of each voice rendered by the mix pool, in mMixScratch.
+		float *mMixVoiceScratch[VOICE_COUNT];
+		// True while the voices rendered by the mix pool are being panned.
+		bool mMixingConcurrently;
+		// Performance counters of the mixing.
+		PerfCounters mPerf;
 		// Audio voices.
 		AudioSourceInstance *mVoice[VOICE_COUNT];
 		// Resampler for the main bus
@@ -572,6 +612,8 @@ namespace SoLoud
 		Filter *mFilter[FILTERS_PER_STREAM];
 		// Global filter instance
 		FilterInstance *mFilterInstance[FILTERS_PER_STREAM];
+		// Parameters posted to the global filters, delivered before they filter
+		FilterParamMailbox mFilterParamMailbox[FILTERS_PER_STREAM];
 
 		// Approximate volume for channels.
 		float mVisualizationChannelVolume[MAX_CHANNELS];
@@ -581,6 +623,10 @@ namespace SoLoud
 		float mFFTData[256];
 		// Snapshot of wave data for visualization
 		float mWaveData[256];
+		// Ring of the latest mono-mixed output samples for visualization
+		float mVisualizationHistory[VISUALIZATION_HISTORY_SIZE];
+		// Where the next sample goes in mVisualizationHistory
+		unsigned int mVisualizationHistoryPos;
 
 		// 3d listener position
 		float m3dPosition[3];
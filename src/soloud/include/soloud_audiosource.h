@@ -121,7 +121,10 @@ namespace SoLoud
 			// If inaudible, should still be ticked (default = pause)
 			INAUDIBLE_TICK = 128,
 			// Don't auto-stop sound
-			DISABLE_AUTOSTOP = 256
+			DISABLE_AUTOSTOP = 256,
+			// getAudio, seek and the filters can run on a mix pool worker
+			// (see Soloud::setMixThreadCount)
+			CONCURRENT_MIX = 512
 		};
 		// Ctor
 		AudioSourceInstance();
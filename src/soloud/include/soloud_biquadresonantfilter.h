@@ -53,6 +53,7 @@ namespace SoLoud
 
 		BiquadResonantFilter *mParent;
 		void calcBQRParams();
+		void calcBQRParams(float aFrequency, float aResonance);
 	public:
 		virtual void filterChannel(float *aBuffer, unsigned int aSamples, float aSamplerate, time aTime, unsigned int aChannel, unsigned int aChannels);
 		virtual ~BiquadResonantFilterInstance();
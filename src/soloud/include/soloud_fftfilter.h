@@ -42,6 +42,10 @@ namespace SoLoud
 		unsigned int mMixOffset[MAX_CHANNELS];
 		unsigned int mReadOffset[MAX_CHANNELS];
 		FFTFilter *mParent;
+	protected:
+		// Where the frame given to fftFilterChannel ends in the current block,
+		// from 0 to 1, to ramp the parameters with getParamAt.
+		float mBlockPosition;
 	public:
 		virtual void fftFilterChannel(float *aFFTBuffer, unsigned int aSamples, float aSamplerate, time aTime, unsigned int aChannel, unsigned int aChannels);
 		virtual void filterChannel(float *aBuffer, unsigned int aSamples, float aSamplerate, time aTime, unsigned int aChannel, unsigned int aChannels);
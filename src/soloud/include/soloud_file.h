@@ -85,6 +85,23 @@ namespace SoLoud
 		result openToMem(const char *aFilename);
 		result openFileToMem(File *aFile);
 	};
+
+	// A file mapped in memory. The decoders read it like a MemoryFile
+	// without the file being copied to the heap, and the OS loads the pages
+	// as they are read. The file must not be truncated while it is mapped.
+	class MappedFile : public MemoryFile
+	{
+	public:
+		virtual ~MappedFile();
+		MappedFile();
+		// Fails on empty files and where mapping is not supported: use a
+		// DiskFile then.
+		result open(const char *aFilename);
+	private:
+		void unmap();
+		void *mMapBase;
+		unsigned int mMapLength;
+	};
 };
 
 #endif
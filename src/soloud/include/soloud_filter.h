@@ -27,6 +27,8 @@ freely, subject to the following restrictions:
 
 #include "soloud.h"
 
+#include <atomic>
+
 namespace SoLoud
 {
 	class Fader;
@@ -38,7 +40,11 @@ namespace SoLoud
 		unsigned int mParamChanged;
 		float *mParam;
 		Fader *mParamFader;
-		
+		// Values of the parameters at the previous block, where the ramps of
+		// the current block start, and at the last updateParams.
+		float *mParamFrom;
+		float *mParamLast;
+		bool mParamLastValid;
 
 		FilterInstance();
 		virtual result initParams(int aNumParams);
@@ -46,12 +52,58 @@ namespace SoLoud
 		virtual void filter(float *aBuffer, unsigned int aSamples, unsigned int aBufferSize, unsigned int aChannels, float aSamplerate, time aTime);
 		virtual void filterChannel(float *aBuffer, unsigned int aSamples, float aSamplerate, time aTime, unsigned int aChannel, unsigned int aChannels);
 		virtual float getFilterParameter(unsigned int aAttributeId);
+		// Value of a parameter at [aFraction] of the current block, going
+		// linearly from its value at the previous block (0) to the current one (1).
+		float getParamAt(unsigned int aAttributeId, float aFraction);
+		// Write to [aRamp] the values of a parameter at the samples [aOffset] + 1
+		// to [aOffset] + [aCount] of a block of [aSamples], the last sample of the
+		// block having the current value. Filters use it to change a parameter
+		// within the block instead of stepping at its start.
+		void getParamRamp(unsigned int aAttributeId, float *aRamp, unsigned int aOffset, unsigned int aCount, unsigned int aSamples);
 		virtual void setFilterParameter(unsigned int aAttributeId, float aValue);
 		virtual void fadeFilterParameter(unsigned int aAttributeId, float aTo, time aTime, time aStartTime);
 		virtual void oscillateFilterParameter(unsigned int aAttributeId, float aFrom, float aTo, time aTime, time aStartTime);
 		virtual ~FilterInstance();
 	};
 
+	// Lock-free mailbox of filter parameter values, fades and oscillations:
+	// any thread posts them, and the audio thread delivers them before
+	// filtering its next block. A value, or a fade or oscillation, posted
+	// again before its delivery replaces the previous one.
+	class FilterParamMailbox
+	{
+	public:
+		// One bit per parameter, as in FilterInstance::mParamChanged.
+		enum { MAX_PARAMS = 32 };
+
+		FilterParamMailbox();
+		// Cancels the fade or oscillation of [aAttributeId] not delivered yet.
+		void post(unsigned int aAttributeId, float aValue);
+		void postFade(unsigned int aAttributeId, float aTo, time aTime);
+		void postOscillate(unsigned int aAttributeId, float aFrom, float aTo, time aTime);
+		// Return true and set [aValue] if a value of [aAttributeId] is waiting.
+		bool peek(unsigned int aAttributeId, float &aValue) const;
+		// Set the waiting values to [aInstance], then start the waiting fades and
+		// oscillations at [aStreamTime], on the audio thread or with the audio mutex held.
+		void deliver(FilterInstance *aInstance, time aStreamTime);
+		void clear();
+
+	private:
+		void postFade_internal(unsigned int aAttributeId, bool aOscillate, float aFrom, float aTo, time aTime);
+
+		std::atomic<float> mValue[MAX_PARAMS];
+		std::atomic<unsigned int> mPending;
+		// The fade or oscillation of each parameter is written between two
+		// increments of its sequence, which is odd meanwhile: the audio thread
+		// skips it if the sequence is odd or changes while reading it.
+		std::atomic<unsigned int> mFadeSeq[MAX_PARAMS];
+		std::atomic<bool> mFadeOscillate[MAX_PARAMS];
+		std::atomic<float> mFadeFrom[MAX_PARAMS];
+		std::atomic<float> mFadeTo[MAX_PARAMS];
+		std::atomic<double> mFadeTime[MAX_PARAMS];
+		std::atomic<unsigned int> mFadePending;
+	};
+
 	class Filter
 	{
 	public:
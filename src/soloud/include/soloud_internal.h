@@ -25,10 +25,75 @@ freely, subject to the following restrictions:
 #ifndef SOLOUD_INTERNAL_H
 #define SOLOUD_INTERNAL_H
 
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
 #include "soloud.h"
 
 namespace SoLoud
 {
+	// Renders one voice on the mix pool. See Soloud::setMixThreadCount.
+	class MixVoiceTask
+	{
+	public:
+		Soloud *mSoloud;
+		AudioSourceInstance *mVoice;
+		float *mScratch;
+		float *mSeekScratch;
+		unsigned int mSeekScratchSize;
+		unsigned int mSamplesToRead;
+		unsigned int mBufferSize;
+		float mSamplerate;
+		unsigned int mResampler;
+
+		void work()
+		{
+			mSoloud->renderVoice_internal(mVoice, mScratch, mSamplesToRead, mBufferSize, mSamplerate, mResampler, mSeekScratch, mSeekScratchSize);
+		}
+	};
+
+	// Workers and per-voice tasks of the concurrent mixing. The workers sleep on
+	// a condition variable between two mixes, and the audio thread sleeps on
+	// another one until the last task of a mix is done.
+	class MixPool
+	{
+	public:
+		MixPool(unsigned int aThreadCount);
+		// Stops and joins the workers. Must not be called during a run().
+		~MixPool();
+		// Runs mTask[0..aCount) on the workers and the calling thread, and returns when all are done.
+		void run(unsigned int aCount);
+
+		MixVoiceTask mTask[VOICE_COUNT];
+		unsigned int mThreadCount;
+
+	private:
+		void workerLoop();
+		// Runs the tasks of the current run not taken yet.
+		void runTasks(unsigned int aCount);
+
+		std::vector<std::thread> mThreads;
+		std::mutex mMutex;
+		// Signalled when a run starts, or the workers must quit.
+		std::condition_variable mWorkReady;
+		// Signalled when the last task of a run is done, and when the last worker leaves it.
+		std::condition_variable mWorkDone;
+		// Next task to take in the current run.
+		std::atomic<unsigned int> mNext;
+		// Tasks not yet done in the current run.
+		std::atomic<unsigned int> mPending;
+		// The following are guarded by mMutex.
+		// Number of tasks of the current run.
+		unsigned int mCount;
+		// Incremented at each run, so that the workers tell a new run from a spurious wakeup.
+		unsigned int mGeneration;
+		// Workers that may still take tasks of the current run.
+		unsigned int mBusyWorkers;
+		bool mQuit;
+	};
+
 	// SDL1 back-end initialization call
 	result sdl1_init(SoLoud::Soloud *aSoloud, unsigned int aFlags = Soloud::CLIP_ROUNDOFF, unsigned int aSamplerate = 44100, unsigned int aBuffer = 2048, unsigned int aChannels = 2);
 
@@ -0,0 +1,252 @@
+/*
+SoLoud audio engine
+Copyright (c) 2013-2020 Jari Komppa
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+#ifndef SOLOUD_PERF_H
+#define SOLOUD_PERF_H
+
+#include <atomic>
+#include <chrono>
+#include <stdint.h>
+
+// Number of global filter slots, same as FILTERS_PER_STREAM.
+#define PERF_FILTER_SLOTS 8
+// Buckets of the mix time histogram: 8 per power of two, up to about 1 second.
+#define PERF_HISTOGRAM_SUB_BITS 3
+#define PERF_HISTOGRAM_BUCKETS 144
+
+namespace SoLoud
+{
+	// Copy of the performance counters, see Soloud::getPerfSnapshot.
+	// The times are in nanoseconds.
+	struct PerfSnapshot
+	{
+		// Mix calls, their total and longest time.
+		uint64_t mixCount;
+		uint64_t mixTotalNs;
+		uint64_t mixMaxNs;
+		// Total duration of the audio mixed. mixTotalNs / bufferTotalNs is the average load.
+		uint64_t bufferTotalNs;
+		// Mix calls which took longer than the audio they mixed.
+		uint64_t mixOverruns;
+		// Mix calls which started more than 1.5 buffers after the previous one: the
+		// device most likely played silence in between.
+		uint64_t lateMixes;
+		// Time spent resampling the voices, and running their filters.
+		uint64_t resampleTotalNs;
+		uint64_t voiceFilterTotalNs;
+		// Time spent in each global filter slot.
+		uint64_t globalFilterTotalNs[PERF_FILTER_SLOTS];
+		// Reads of streams which had not enough data and were not ended.
+		uint64_t streamUnderruns;
+		// Load of the last mix and the highest one, in percent of the buffer duration.
+		float lastLoad;
+		float maxLoad;
+		// Playing voices mixed in the last mix, and the ones left out because
+		// they were inaudible or over the maximum active voice count.
+		uint32_t activeVoices;
+		uint32_t virtualVoices;
+		// Mix calls by time, see PerfCounters::bucketStart.
+		uint32_t mixHistogram[PERF_HISTOGRAM_BUCKETS];
+	};
+
+	// Engine performance counters. They are written by the audio thread and,
+	// when setMixThreadCount() started a MixPool, by its worker threads while
+	// they mix voices. Any thread reads them with snapshot(), without locks.
+	class PerfCounters
+	{
+	public:
+		typedef std::chrono::steady_clock Clock;
+
+		PerfCounters() : mEnabled(false)
+		{
+			reset();
+		}
+
+		// Return the histogram bucket counting the mix calls which took [aMicroseconds].
+		// Buckets below 8 are 1 microsecond wide, then each power of two is split in 8,
+		// so a bucket is at most 12.5% wide.
+		static unsigned int bucketOf(uint64_t aMicroseconds)
+		{
+			if (aMicroseconds < (1 << PERF_HISTOGRAM_SUB_BITS))
+				return (unsigned int)aMicroseconds;
+			unsigned int msb = 0;
+			while ((aMicroseconds >> (msb + 1)) != 0)
+				msb++;
+			unsigned int sub = (unsigned int)(aMicroseconds >> (msb - PERF_HISTOGRAM_SUB_BITS)) & ((1 << PERF_HISTOGRAM_SUB_BITS) - 1);
+			unsigned int bucket = ((msb - PERF_HISTOGRAM_SUB_BITS + 1) << PERF_HISTOGRAM_SUB_BITS) + sub;
+			return bucket < PERF_HISTOGRAM_BUCKETS ? bucket : PERF_HISTOGRAM_BUCKETS - 1;
+		}
+
+		// Return the lowest time in microseconds counted by [aBucket].
+		static uint64_t bucketStart(unsigned int aBucket)
+		{
+			if (aBucket < (1 << PERF_HISTOGRAM_SUB_BITS))
+				return aBucket;
+			unsigned int msb = (aBucket >> PERF_HISTOGRAM_SUB_BITS) + PERF_HISTOGRAM_SUB_BITS - 1;
+			uint64_t sub = aBucket & ((1 << PERF_HISTOGRAM_SUB_BITS) - 1);
+			return ((1 << PERF_HISTOGRAM_SUB_BITS) + sub) << (msb - PERF_HISTOGRAM_SUB_BITS);
+		}
+
+		static uint64_t elapsedNs(Clock::time_point aStart, Clock::time_point aEnd)
+		{
+			return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(aEnd - aStart).count();
+		}
+
+		bool isEnabled() const
+		{
+			return mEnabled.load(std::memory_order_relaxed);
+		}
+
+		void setEnabled(bool aEnabled)
+		{
+			mEnabled.store(aEnabled, std::memory_order_relaxed);
+			// Don't count the gap since the last mix measured.
+			mLastMixStartValid.store(false, std::memory_order_relaxed);
+		}
+
+		// Count a mix of [aBufferNs] of audio which started at [aStart] and ended at [aEnd].
+		// Only called by the audio thread.
+		void countMix(Clock::time_point aStart, Clock::time_point aEnd, uint64_t aBufferNs, unsigned int aActiveVoices, unsigned int aPlayingVoices)
+		{
+			uint64_t ns = elapsedNs(aStart, aEnd);
+			add(mMixCount, 1);
+			add(mMixTotalNs, ns);
+			add(mBufferTotalNs, aBufferNs);
+			if (ns > mMixMaxNs.load(std::memory_order_relaxed))
+				mMixMaxNs.store(ns, std::memory_order_relaxed);
+			if (ns > aBufferNs)
+				add(mMixOverruns, 1);
+			if (mLastMixStartValid.load(std::memory_order_relaxed) && elapsedNs(mLastMixStart, aStart) > aBufferNs + aBufferNs / 2)
+				add(mLateMixes, 1);
+			mLastMixStart = aStart;
+			mLastMixStartValid.store(true, std::memory_order_relaxed);
+
+			float load = aBufferNs > 0 ? 100.0f * ns / aBufferNs : 0;
+			mLastLoad.store(load, std::memory_order_relaxed);
+			if (load > mMaxLoad.load(std::memory_order_relaxed))
+				mMaxLoad.store(load, std::memory_order_relaxed);
+			mActiveVoices.store(aActiveVoices, std::memory_order_relaxed);
+			mVirtualVoices.store(aPlayingVoices > aActiveVoices ? aPlayingVoices - aActiveVoices : 0, std::memory_order_relaxed);
+			mMixHistogram[bucketOf(ns / 1000)].fetch_add(1, std::memory_order_relaxed);
+		}
+
+		// These are called for each mixed voice, so the MixPool workers and the
+		// audio thread can call them at the same time during a MixPool::run().
+		void addResampleTime(uint64_t aNs)
+		{
+			mResampleTotalNs.fetch_add(aNs, std::memory_order_relaxed);
+		}
+
+		void addVoiceFilterTime(uint64_t aNs)
+		{
+			mVoiceFilterTotalNs.fetch_add(aNs, std::memory_order_relaxed);
+		}
+
+		void addGlobalFilterTime(unsigned int aSlot, uint64_t aNs)
+		{
+			if (aSlot < PERF_FILTER_SLOTS)
+				mGlobalFilterTotalNs[aSlot].fetch_add(aNs, std::memory_order_relaxed);
+		}
+
+		// Counted whether the counters are enabled or not: it's rare and cheap.
+		void countStreamUnderrun()
+		{
+			mStreamUnderruns.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		void snapshot(PerfSnapshot &aSnapshot) const
+		{
+			aSnapshot.mixCount = mMixCount.load(std::memory_order_relaxed);
+			aSnapshot.mixTotalNs = mMixTotalNs.load(std::memory_order_relaxed);
+			aSnapshot.mixMaxNs = mMixMaxNs.load(std::memory_order_relaxed);
+			aSnapshot.bufferTotalNs = mBufferTotalNs.load(std::memory_order_relaxed);
+			aSnapshot.mixOverruns = mMixOverruns.load(std::memory_order_relaxed);
+			aSnapshot.lateMixes = mLateMixes.load(std::memory_order_relaxed);
+			aSnapshot.resampleTotalNs = mResampleTotalNs.load(std::memory_order_relaxed);
+			aSnapshot.voiceFilterTotalNs = mVoiceFilterTotalNs.load(std::memory_order_relaxed);
+			for (unsigned int i = 0; i < PERF_FILTER_SLOTS; i++)
+				aSnapshot.globalFilterTotalNs[i] = mGlobalFilterTotalNs[i].load(std::memory_order_relaxed);
+			aSnapshot.streamUnderruns = mStreamUnderruns.load(std::memory_order_relaxed);
+			aSnapshot.lastLoad = mLastLoad.load(std::memory_order_relaxed);
+			aSnapshot.maxLoad = mMaxLoad.load(std::memory_order_relaxed);
+			aSnapshot.activeVoices = mActiveVoices.load(std::memory_order_relaxed);
+			aSnapshot.virtualVoices = mVirtualVoices.load(std::memory_order_relaxed);
+			for (unsigned int i = 0; i < PERF_HISTOGRAM_BUCKETS; i++)
+				aSnapshot.mixHistogram[i] = mMixHistogram[i].load(std::memory_order_relaxed);
+		}
+
+		// Zero the counters. A mix running meanwhile can be partly counted.
+		void reset()
+		{
+			mMixCount = 0;
+			mMixTotalNs = 0;
+			mMixMaxNs = 0;
+			mBufferTotalNs = 0;
+			mMixOverruns = 0;
+			mLateMixes = 0;
+			mResampleTotalNs = 0;
+			mVoiceFilterTotalNs = 0;
+			for (unsigned int i = 0; i < PERF_FILTER_SLOTS; i++)
+				mGlobalFilterTotalNs[i] = 0;
+			mStreamUnderruns = 0;
+			mLastLoad = 0;
+			mMaxLoad = 0;
+			mActiveVoices = 0;
+			mVirtualVoices = 0;
+			for (unsigned int i = 0; i < PERF_HISTOGRAM_BUCKETS; i++)
+				mMixHistogram[i] = 0;
+			mLastMixStartValid.store(false, std::memory_order_relaxed);
+		}
+
+	private:
+		// Increment a counter with a single writer, without a locked instruction.
+		static void add(std::atomic<uint64_t> &aCounter, uint64_t aValue)
+		{
+			aCounter.store(aCounter.load(std::memory_order_relaxed) + aValue, std::memory_order_relaxed);
+		}
+
+		std::atomic<bool> mEnabled;
+		std::atomic<uint64_t> mMixCount;
+		std::atomic<uint64_t> mMixTotalNs;
+		std::atomic<uint64_t> mMixMaxNs;
+		std::atomic<uint64_t> mBufferTotalNs;
+		std::atomic<uint64_t> mMixOverruns;
+		std::atomic<uint64_t> mLateMixes;
+		std::atomic<uint64_t> mResampleTotalNs;
+		std::atomic<uint64_t> mVoiceFilterTotalNs;
+		std::atomic<uint64_t> mGlobalFilterTotalNs[PERF_FILTER_SLOTS];
+		std::atomic<uint64_t> mStreamUnderruns;
+		std::atomic<float> mLastLoad;
+		std::atomic<float> mMaxLoad;
+		std::atomic<unsigned int> mActiveVoices;
+		std::atomic<unsigned int> mVirtualVoices;
+		std::atomic<uint32_t> mMixHistogram[PERF_HISTOGRAM_BUCKETS];
+		// Start of the previous mix, only used by the audio thread.
+		Clock::time_point mLastMixStart;
+		// Cleared by the other threads to skip the next gap check.
+		std::atomic<bool> mLastMixStartValid;
+	};
+};
+
+#endif
@@ -54,12 +54,22 @@ namespace SoLoud
 		result loadmp3(MemoryFile *aReader);
 		result loadflac(MemoryFile *aReader);
 		result testAndLoadFile(MemoryFile *aReader);
+		// Replace the float samples with 16 bit ones when compact storage is on.
+		void compactData();
+		void freeData();
+		bool mCompact;
 	public:
 		float *mData;
+		// Samples stored as 16 bit integers when compact storage is on. Only
+		// one of mData and mData16 is set.
+		short *mData16;
 		unsigned int mSampleCount;
 
 		Wav();
 		virtual ~Wav();
+		// Store the samples of the next loads as 16 bit integers, halving the
+		// memory used. They are converted back to float while mixing.
+		void setCompactStorage(bool aCompact);
 		result load(const char *aFilename);
 		result loadMem(const unsigned char *aMem, unsigned int aLength, bool aCopy = false, bool aTakeOwnership = true);
 		result loadFile(File *aFile);
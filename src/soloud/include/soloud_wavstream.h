@@ -26,6 +26,7 @@ freely, subject to the following restrictions:
 #define SOLOUD_WAVSTREAM_H
 
 #include <stdio.h>
+#include <atomic>
 #include <chrono>
 #include "soloud.h"
 
@@ -44,6 +45,9 @@ namespace SoLoud
 {
 	class WavStream;
 	class File;
+	struct Mp3SeekTable;
+	class WavStreamPrefetcher;
+	class WavStreamPrefetchInstance;
 
 	class WavStreamInstance : public AudioSourceInstance
 	{
@@ -60,7 +64,46 @@ namespace SoLoud
 		unsigned int mOggFrameSize;
 		unsigned int mOggFrameOffset;
 		float **mOggOutputs;
-		
+
+		// Prefetch ring, see WavStream::setPrefetch. A prefetching instance is
+		// only the decoder of a WavStreamPrefetchInstance: after the
+		// constructor, only the I/O thread decodes into the ring, and the
+		// voice only reads it.
+		friend class WavStream;
+		friend class WavStreamPrefetcher;
+		friend class WavStreamPrefetchInstance;
+		float *mRing;
+		unsigned int mRingFrames;
+		unsigned int mRingChannels;
+		std::atomic<unsigned int> mRingRead;
+		std::atomic<unsigned int> mRingWrite;
+		// Set when the decoder reached the end at mRingEnd. If mRingLooped, the
+		// frames after mRingEnd have been decoded from mRingLoopedTo.
+		std::atomic<bool> mRingEndPending;
+		unsigned int mRingEnd;
+		bool mRingLooped;
+		int mRingLoopedTo;
+		// Loop point frame the I/O thread jumps to at the end, -1 if not looping.
+		std::atomic<int> mRingLoopFrame;
+		// Seek posted by the voice. The I/O thread seeks the decoder to
+		// mRingSeekFrame and refills the ring when mRingSeekRequest differs
+		// from mRingSeekDone, and the voice plays silence until they match.
+		std::atomic<int> mRingSeekFrame;
+		std::atomic<unsigned int> mRingSeekRequest;
+		std::atomic<unsigned int> mRingSeekDone;
+		bool mDecoderEnded;
+		// Next instance to free on the I/O thread, see WavStreamPrefetcher::retire.
+		WavStreamInstance *mRetiredNext;
+
+		unsigned int decode(float *aBuffer, unsigned int aSamplesToRead, unsigned int aBufferSize, unsigned int aChannels);
+		result seekDecoder(int aFrame);
+		// Decode a chunk into the ring. Returns false if there was nothing to do.
+		bool prefetchChunk();
+		// Apply the seek posted by the voice, if any. Returns false if there was none.
+		bool applySeek();
+		void publishRingEnd();
+		void prefill(unsigned int aFrames);
+
 	public:
 		WavStreamInstance(WavStream *aParent);
 		virtual unsigned int getAudio(float *aBuffer, unsigned int aSamplesToRead, unsigned int aBufferSize);
@@ -70,6 +113,26 @@ namespace SoLoud
 		virtual ~WavStreamInstance();
 	};
 
+	// Voice of a prefetching WavStream. It reads the ring of its decoder and
+	// posts the seeks to the I/O thread, so that it never waits for the
+	// file, and the I/O thread frees the decoder after the voice is gone.
+	class WavStreamPrefetchInstance : public AudioSourceInstance
+	{
+		WavStreamInstance *mDecoder;
+
+		// True from a seek until the I/O thread refilled the ring.
+		bool isSeeking();
+		void postSeek(int aFrame);
+
+	public:
+		WavStreamPrefetchInstance(WavStreamInstance *aDecoder);
+		virtual unsigned int getAudio(float *aBuffer, unsigned int aSamplesToRead, unsigned int aBufferSize);
+		virtual result seek(double aSeconds, float* mScratch, unsigned int mScratchSize);
+		virtual result rewind();
+		virtual bool hasEnded();
+		virtual ~WavStreamPrefetchInstance();
+	};
+
 	enum WAVSTREAM_FILETYPE
 	{
 		WAVSTREAM_WAV = 0,
@@ -84,12 +147,19 @@ namespace SoLoud
 		result loadogg(File *fp);
 		result loadflac(File *fp);
 		result loadmp3(File *fp);
+		// Index the MP3 frames of fp so that the instances seek without
+		// decoding from the start of the stream.
+		void buildMp3SeekTable(File *fp);
 	public:
 		int mFiletype;
 		char *mFilename;
 		File *mMemFile;
 		File *mStreamFile;
 		unsigned int mSampleCount;
+		// Shared by the decoders of all the instances, NULL if not built.
+		Mp3SeekTable *mMp3SeekTable;
+		// Milliseconds decoded ahead by the I/O thread, 0 to decode on the audio thread.
+		unsigned int mPrefetchMs;
 
 		WavStream();
 		virtual ~WavStream();
@@ -101,6 +171,15 @@ namespace SoLoud
 		virtual AudioSourceInstance *createInstance();
 		time getLength();
 
+		// Decode the instances created from now on [aMilliseconds] ahead on a
+		// background I/O thread, so that the audio thread never waits for the
+		// file. 0 (default) decodes on the audio thread.
+		// Only sources loaded from a file name or from memory are prefetched.
+		result setPrefetch(unsigned int aMilliseconds);
+		// Number of times a prefetching instance ran out of decoded audio and
+		// played silence, since the start of the process.
+		static unsigned int getPrefetchUnderrunCount();
+
 	public:
 		result parse(File *aFile);
 	};
@@ -2477,7 +2477,11 @@ DRMP3_API void drmp3dec_f32_to_s16(const float *in, drmp3_int16 *out, size_t num
 
 /* Options. */
 #ifndef DRMP3_SEEK_LEADING_MP3_FRAMES
-#define DRMP3_SEEK_LEADING_MP3_FRAMES   2
+/*
+Modified for SoLoud: was 2. The bit reservoir of a frame can start up to 511 bytes before it, which spans several frames
+at low bitrates, and one more frame is needed to fill the MDCT overlap. 8 frames make table seeks sample exact.
+*/
+#define DRMP3_SEEK_LEADING_MP3_FRAMES   8
 #endif
 
 #define DRMP3_MIN_DATA_CHUNK_SIZE   16384
@@ -2728,6 +2732,27 @@ static void drmp3__on_meta(drmp3* pMP3, drmp3_metadata_type type, const void* pR
 }
 
 
+/*
+Modified for SoLoud: a layer III frame whose bit reservoir refers to data before the point where decoding started (after a
+seek) can't be decoded. Instead of skipping it, which shifts every following frame and breaks the frame counting of the
+seeks, it is returned as a frame of silence. The decoder header is still valid only in this case.
+*/
+static drmp3_uint32 drmp3__silence_unrestorable_frame(drmp3* pMP3, drmp3_uint32 pcmFramesRead, const drmp3dec_frame_info* pInfo, drmp3d_sample_t* pPCMFrames)
+{
+    drmp3_uint32 frameSamples;
+
+    if (pcmFramesRead > 0 || pInfo->frame_bytes == 0 || pMP3->decoder.header[0] != 0xFF || pInfo->layer != 3) {
+        return pcmFramesRead;
+    }
+
+    frameSamples = drmp3_hdr_frame_samples(pMP3->decoder.header);
+    if (pPCMFrames != NULL) {
+        DRMP3_ZERO_MEMORY(pPCMFrames, sizeof(drmp3d_sample_t) * frameSamples * pInfo->channels);
+    }
+
+    return frameSamples;
+}
+
 static drmp3_uint32 drmp3_decode_next_frame_ex__callbacks(drmp3* pMP3, drmp3d_sample_t* pPCMFrames, drmp3dec_frame_info* pMP3FrameInfo, const drmp3_uint8** ppMP3FrameData)
 {
     drmp3_uint32 pcmFramesRead = 0;
@@ -2793,6 +2818,7 @@ static drmp3_uint32 drmp3_decode_next_frame_ex__callbacks(drmp3* pMP3, drmp3d_sa
         }
 
         pcmFramesRead = drmp3dec_decode_frame(&pMP3->decoder, pMP3->pData + pMP3->dataConsumed, (int)pMP3->dataSize, pPCMFrames, &info);    /* <-- Safe size_t -> int conversion thanks to the check above. */
+        pcmFramesRead = drmp3__silence_unrestorable_frame(pMP3, pcmFramesRead, &info, pPCMFrames);
 
         /* Consume the data. */
         pMP3->dataConsumed += (size_t)info.frame_bytes;
@@ -2867,6 +2893,7 @@ static drmp3_uint32 drmp3_decode_next_frame_ex__memory(drmp3* pMP3, drmp3d_sampl
 
     for (;;) {
         pcmFramesRead = drmp3dec_decode_frame(&pMP3->decoder, pMP3->memory.pData + pMP3->memory.currentReadPos, (int)(pMP3->memory.dataSize - pMP3->memory.currentReadPos), pPCMFrames, &info);
+        pcmFramesRead = drmp3__silence_unrestorable_frame(pMP3, pcmFramesRead, &info, pPCMFrames);
         if (pcmFramesRead > 0) {
             pcmFramesRead = drmp3_hdr_frame_samples(pMP3->decoder.header);
             pMP3->pcmFramesConsumedInMP3Frame  = 0;
@@ -4345,11 +4372,25 @@ static drmp3_bool32 drmp3_seek_forward_by_pcm_frames__brute_force(drmp3* pMP3, d
     return DRMP3_TRUE;
 }
 
+/*
+Modified for SoLoud: the frame indices given to drmp3_seek_to_pcm_frame() are the ones returned by the read functions,
+which skip the encoder delay, while currentPCMFrame counts the delay too. Mixing them made forward seeks land
+delayInPCMFrames too early.
+*/
+static drmp3_uint64 drmp3__current_output_pcm_frame(drmp3* pMP3)
+{
+    if (pMP3->currentPCMFrame <= pMP3->delayInPCMFrames) {
+        return 0;
+    }
+
+    return pMP3->currentPCMFrame - pMP3->delayInPCMFrames;
+}
+
 static drmp3_bool32 drmp3_seek_to_pcm_frame__brute_force(drmp3* pMP3, drmp3_uint64 frameIndex)
 {
     DRMP3_ASSERT(pMP3 != NULL);
 
-    if (frameIndex == pMP3->currentPCMFrame) {
+    if (frameIndex == drmp3__current_output_pcm_frame(pMP3)) {
         return DRMP3_TRUE;
     }
 
@@ -4357,15 +4398,15 @@ static drmp3_bool32 drmp3_seek_to_pcm_frame__brute_force(drmp3* pMP3, drmp3_uint
     If we're moving foward we just read from where we're at. Otherwise we need to move back to the start of
     the stream and read from the beginning.
     */
-    if (frameIndex < pMP3->currentPCMFrame) {
+    if (frameIndex < drmp3__current_output_pcm_frame(pMP3)) {
         /* Moving backward. Move to the start of the stream and then move forward. */
         if (!drmp3_seek_to_start_of_stream(pMP3)) {
             return DRMP3_FALSE;
         }
     }
 
-    DRMP3_ASSERT(frameIndex >= pMP3->currentPCMFrame);
-    return drmp3_seek_forward_by_pcm_frames__brute_force(pMP3, (frameIndex - pMP3->currentPCMFrame));
+    DRMP3_ASSERT(frameIndex >= drmp3__current_output_pcm_frame(pMP3));
+    return drmp3_seek_forward_by_pcm_frames__brute_force(pMP3, (frameIndex - drmp3__current_output_pcm_frame(pMP3)));
 }
 
 static drmp3_bool32 drmp3_find_closest_seek_point(drmp3* pMP3, drmp3_uint64 frameIndex, drmp3_uint32* pSeekPointIndex)
@@ -4380,13 +4421,19 @@ static drmp3_bool32 drmp3_find_closest_seek_point(drmp3* pMP3, drmp3_uint64 fram
         return DRMP3_FALSE;
     }
 
-    /* Linear search for simplicity to begin with while I'm getting this thing working. Once it's all working change this to a binary search. */
-    for (iSeekPoint = 0; iSeekPoint < pMP3->seekPointCount; ++iSeekPoint) {
-        if (pMP3->pSeekPoints[iSeekPoint].pcmFrameIndex > frameIndex) {
-            break;  /* Found it. */
+    /* Modified for SoLoud: binary search of the last seek point at or before frameIndex. */
+    {
+        drmp3_uint32 lo = 0;
+        drmp3_uint32 hi = pMP3->seekPointCount;
+        while (hi - lo > 1) {
+            iSeekPoint = lo + (hi - lo) / 2;
+            if (pMP3->pSeekPoints[iSeekPoint].pcmFrameIndex > frameIndex) {
+                hi = iSeekPoint;
+            } else {
+                lo = iSeekPoint;
+            }
         }
-
-        *pSeekPointIndex = iSeekPoint;
+        *pSeekPointIndex = lo;
     }
 
     return DRMP3_TRUE;
@@ -4404,10 +4451,11 @@ static drmp3_bool32 drmp3_seek_to_pcm_frame__seek_table(drmp3* pMP3, drmp3_uint6
     DRMP3_ASSERT(pMP3->seekPointCount > 0);
 
     /* If there is no prior seekpoint it means the target PCM frame comes before the first seek point. Just assume a seekpoint at the start of the file in this case. */
-    if (drmp3_find_closest_seek_point(pMP3, frameIndex, &priorSeekPointIndex)) {
+    /* The seek points count the encoder delay, frameIndex doesn't. */
+    if (drmp3_find_closest_seek_point(pMP3, frameIndex + pMP3->delayInPCMFrames, &priorSeekPointIndex)) {
         seekPoint = pMP3->pSeekPoints[priorSeekPointIndex];
     } else {
-        seekPoint.seekPosInBytes     = 0;
+        seekPoint.seekPosInBytes     = pMP3->streamStartOffset;  /* Modified for SoLoud: skip the ID3 and VBR tags. */
         seekPoint.pcmFrameIndex      = 0;
         seekPoint.mp3FramesToDiscard = 0;
         seekPoint.pcmFramesToDiscard = 0;
@@ -4426,11 +4474,11 @@ static drmp3_bool32 drmp3_seek_to_pcm_frame__seek_table(drmp3* pMP3, drmp3_uint6
         drmp3_uint32 pcmFramesRead;
         drmp3d_sample_t* pPCMFrames;
 
-        /* Pass in non-null for the last frame because we want to ensure the sample rate converter is preloaded correctly. */
-        pPCMFrames = NULL;
-        if (iMP3Frame == seekPoint.mp3FramesToDiscard-1) {
-            pPCMFrames = (drmp3d_sample_t*)pMP3->pcmFrames;
-        }
+        /*
+        Modified for SoLoud: decode all the frames, not only the last one. A frame decoded without output doesn't update the
+        MDCT overlap and the synthesis filter, so the first frames after the seek differed from a continuous decode.
+        */
+        pPCMFrames = (drmp3d_sample_t*)pMP3->pcmFrames;
 
         /* We first need to decode the next frame. */
         pcmFramesRead = drmp3_decode_next_frame_ex(pMP3, pPCMFrames, NULL, NULL);
@@ -4446,7 +4494,7 @@ static drmp3_bool32 drmp3_seek_to_pcm_frame__seek_table(drmp3* pMP3, drmp3_uint6
     Now at this point we can follow the same process as the brute force technique where we just skip over unnecessary MP3 frames and then
     read-and-discard at least 2 whole MP3 frames.
     */
-    leftoverFrames = frameIndex - pMP3->currentPCMFrame;
+    leftoverFrames = frameIndex - drmp3__current_output_pcm_frame(pMP3);
     return drmp3_seek_forward_by_pcm_frames__brute_force(pMP3, leftoverFrames);
 }
 
@@ -4489,7 +4537,7 @@ DRMP3_API drmp3_bool32 drmp3_get_mp3_and_pcm_frame_count(drmp3* pMP3, drmp3_uint
     }
 
     /* We'll need to seek back to where we were, so grab the PCM frame we're currently sitting on so we can restore later. */
-    currentPCMFrame = pMP3->currentPCMFrame;
+    currentPCMFrame = drmp3__current_output_pcm_frame(pMP3);  /* Modified for SoLoud: restored with drmp3_seek_to_pcm_frame(). */
 
     if (!drmp3_seek_to_start_of_stream(pMP3)) {
         return DRMP3_FALSE;
@@ -4611,7 +4659,7 @@ DRMP3_API drmp3_bool32 drmp3_calculate_seek_points(drmp3* pMP3, drmp3_uint32* pS
     }
 
     /* We'll need to seek back to the current sample after calculating the seekpoints so we need to go ahead and grab the current location at the top. */
-    currentPCMFrame = pMP3->currentPCMFrame;
+    currentPCMFrame = drmp3__current_output_pcm_frame(pMP3);  /* Modified for SoLoud: restored with drmp3_seek_to_pcm_frame(). */
 
     /* We never do more than the total number of MP3 frames and we limit it to 32-bits. */
     if (!drmp3_get_mp3_and_pcm_frame_count(pMP3, &totalMP3FrameCount, &totalPCMFrameCount)) {
@@ -4681,11 +4729,21 @@ DRMP3_API drmp3_bool32 drmp3_calculate_seek_points(drmp3* pMP3, drmp3_uint32* pS
 
             for (;;) {
                 if (nextTargetPCMFrame < runningPCMFrameCount) {
-                    /* The next seek point is in the current MP3 frame. */
+                    /*
+                    The next seek point is in the current MP3 frame.
+
+                    Modified for SoLoud: in the first frames of the stream the target can come before the leading frames, which made
+                    pcmFramesToDiscard wrap around. Then decode from the start of the stream up to the frame containing the target.
+                    */
+                    drmp3_uint32 iLeadingFrame = DRMP3_SEEK_LEADING_MP3_FRAMES-1;
+                    while (iLeadingFrame > 0 && mp3FrameInfo[iLeadingFrame].pcmFrameIndex > nextTargetPCMFrame) {
+                        iLeadingFrame -= 1;
+                    }
+
                     pSeekPoints[iSeekPoint].seekPosInBytes     = mp3FrameInfo[0].bytePos;
                     pSeekPoints[iSeekPoint].pcmFrameIndex      = nextTargetPCMFrame;
-                    pSeekPoints[iSeekPoint].mp3FramesToDiscard = DRMP3_SEEK_LEADING_MP3_FRAMES;
-                    pSeekPoints[iSeekPoint].pcmFramesToDiscard = (drmp3_uint16)(nextTargetPCMFrame - mp3FrameInfo[DRMP3_SEEK_LEADING_MP3_FRAMES-1].pcmFrameIndex);
+                    pSeekPoints[iSeekPoint].mp3FramesToDiscard = (drmp3_uint16)(iLeadingFrame+1);
+                    pSeekPoints[iSeekPoint].pcmFramesToDiscard = (drmp3_uint16)(nextTargetPCMFrame - mp3FrameInfo[iLeadingFrame].pcmFrameIndex);
                     break;
                 } else {
                     size_t i;
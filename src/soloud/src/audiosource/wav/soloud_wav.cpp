@@ -33,17 +33,57 @@ freely, subject to the following restrictions:
 #include "dr_wav.h"
 #include "dr_flac.h"
 
+#ifdef SOLOUD_SSE_INTRINSICS
+#include <emmintrin.h>
+#endif
+
+#ifdef SOLOUD_NEON_INTRINSICS
+#include <arm_neon.h>
+#endif
+
 namespace SoLoud
 {
+	static void convertInt16ToFloat(const short *aSrc, float *aDst, unsigned int aCount)
+	{
+		const float scale = 1.0f / 0x8000;
+		unsigned int i = 0;
+#if defined(SOLOUD_SSE_INTRINSICS)
+		__m128 scale4 = _mm_set1_ps(scale);
+		for (; i + 8 <= aCount; i += 8)
+		{
+			__m128i s = _mm_loadu_si128((const __m128i *)(aSrc + i));
+			// Put each sample in the high half of a 32 bit lane, then shift
+			// it down keeping the sign.
+			__m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(s, s), 16);
+			__m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(s, s), 16);
+			_mm_storeu_ps(aDst + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale4));
+			_mm_storeu_ps(aDst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale4));
+		}
+#elif defined(SOLOUD_NEON_INTRINSICS)
+		for (; i + 8 <= aCount; i += 8)
+		{
+			int16x8_t s = vld1q_s16(aSrc + i);
+			float32x4_t lo = vcvtq_f32_s32(vmovl_s16(vget_low_s16(s)));
+			float32x4_t hi = vcvtq_f32_s32(vmovl_s16(vget_high_s16(s)));
+			vst1q_f32(aDst + i, vmulq_n_f32(lo, scale));
+			vst1q_f32(aDst + i + 4, vmulq_n_f32(hi, scale));
+		}
+#endif
+		for (; i < aCount; i++)
+			aDst[i] = aSrc[i] * scale;
+	}
+
 	WavInstance::WavInstance(Wav *aParent)
 	{
 		mParent = aParent;
 		mOffset = 0;
+		// Only reads the parent's immutable sample data.
+		mFlags |= CONCURRENT_MIX;
 	}
 
 	unsigned int WavInstance::getAudio(float *aBuffer, unsigned int aSamplesToRead, unsigned int aBufferSize)
 	{		
-		if (mParent->mData == NULL)
+		if (mParent->mData == NULL && mParent->mData16 == NULL)
 			return 0;
 
 		unsigned int dataleft = mParent->mSampleCount - mOffset;
@@ -54,7 +94,10 @@ namespace SoLoud
 		unsigned int i;
 		for (i = 0; i < mChannels; i++)
 		{
-			memcpy(aBuffer + i * aBufferSize, mParent->mData + mOffset + i * mParent->mSampleCount, sizeof(float) * copylen);
+			if (mParent->mData16)
+				convertInt16ToFloat(mParent->mData16 + mOffset + i * mParent->mSampleCount, aBuffer + i * aBufferSize, copylen);
+			else
+				memcpy(aBuffer + i * aBufferSize, mParent->mData + mOffset + i * mParent->mSampleCount, sizeof(float) * copylen);
 		}
 
 		mOffset += copylen;
@@ -108,13 +151,48 @@ namespace SoLoud
 	Wav::Wav()
 	{
 		mData = NULL;
+		mData16 = NULL;
 		mSampleCount = 0;
+		mCompact = false;
 	}
 	
 	Wav::~Wav()
 	{
 		stop();
+		freeData();
+	}
+
+	void Wav::setCompactStorage(bool aCompact)
+	{
+		mCompact = aCompact;
+	}
+
+	void Wav::freeData()
+	{
 		delete[] mData;
+		mData = NULL;
+		delete[] mData16;
+		mData16 = NULL;
+	}
+
+	void Wav::compactData()
+	{
+		if (!mCompact || mData == NULL)
+			return;
+		unsigned int count = mSampleCount * mChannels;
+		mData16 = new short[count];
+		unsigned int i;
+		for (i = 0; i < count; i++)
+		{
+			float v = mData[i] * 0x8000;
+			if (v > 0x7fff)
+				v = 0x7fff;
+			if (v < -0x8000)
+				v = -0x8000;
+			mData16[i] = (short)(v < 0 ? v - 0.5f : v + 0.5f);
+		}
+		delete[] mData;
+		mData = NULL;
 	}
 
 #define MAKEDWORD(a,b,c,d) (((d) << 24) | ((c) << 16) | ((b) << 8) | (a))
@@ -293,30 +371,32 @@ namespace SoLoud
 
     result Wav::testAndLoadFile(MemoryFile *aReader)
     {
-		delete[] mData;
-		mData = 0;
+		freeData();
 		mSampleCount = 0;
 		mChannels = 1;
         int tag = aReader->read32();
+		result res = FILE_LOAD_FAILED;
 		if (tag == MAKEDWORD('O','g','g','S')) 
         {
-			return loadogg(aReader);
+			res = loadogg(aReader);
 
 		} 
         else if (tag == MAKEDWORD('R','I','F','F')) 
         {
-			return loadwav(aReader);
+			res = loadwav(aReader);
 		}
 		else if (tag == MAKEDWORD('f', 'L', 'a', 'C'))
 		{
-			return loadflac(aReader);
+			res = loadflac(aReader);
 		}
 		else if (loadmp3(aReader) == SO_NO_ERROR)
 		{
-			return SO_NO_ERROR;
+			res = SO_NO_ERROR;
 		}
 
-		return FILE_LOAD_FAILED;
+		if (res == SO_NO_ERROR)
+			compactData();
+		return res;
     }
 
 	result Wav::load(const char *aFilename)
@@ -324,6 +404,10 @@ namespace SoLoud
 		if (aFilename == 0)
 			return INVALID_PARAMETER;
 		stop();
+		// Decode straight from the mapped file instead of copying it to the heap.
+		MappedFile mf;
+		if (mf.open(aFilename) == SO_NO_ERROR)
+			return testAndLoadFile(&mf);
 		DiskFile dr;
 		int res = dr.open(aFilename);
 		if (res == SO_NO_ERROR)
@@ -375,12 +459,19 @@ namespace SoLoud
 		if (aMem == 0 || aLength == 0 || aSamplerate <= 0 || aChannels < 1)
 			return INVALID_PARAMETER;
 		stop();
-		delete[] mData;
-		mData = new float[aLength];	
+		freeData();
 		mSampleCount = aLength / aChannels;
 		mChannels = aChannels;
 		mBaseSamplerate = aSamplerate;
 		unsigned int i;
+		if (mCompact)
+		{
+			mData16 = new short[aLength];
+			for (i = 0; i < aLength; i++)
+				mData16[i] = (short)(((signed)aMem[i] - 128) * 0x100);
+			return SO_NO_ERROR;
+		}
+		mData = new float[aLength];	
 		for (i = 0; i < aLength; i++)
 			mData[i] = ((signed)aMem[i] - 128) / (float)0x80;
 		return SO_NO_ERROR;
@@ -391,11 +482,17 @@ namespace SoLoud
 		if (aMem == 0 || aLength == 0 || aSamplerate <= 0 || aChannels < 1)
 			return INVALID_PARAMETER;
 		stop();
-		delete[] mData;
-		mData = new float[aLength];
+		freeData();
 		mSampleCount = aLength / aChannels;
 		mChannels = aChannels;
 		mBaseSamplerate = aSamplerate;
+		if (mCompact)
+		{
+			mData16 = new short[aLength];
+			memcpy(mData16, aMem, sizeof(short) * aLength);
+			return SO_NO_ERROR;
+		}
+		mData = new float[aLength];
 		unsigned int i;
 		for (i = 0; i < aLength; i++)
 			mData[i] = ((signed short)aMem[i]) / (float)0x8000;
@@ -407,7 +504,7 @@ namespace SoLoud
 		if (aMem == 0 || aLength == 0 || aSamplerate <= 0 || aChannels < 1)
 			return INVALID_PARAMETER;
 		stop();
-		delete[] mData;
+		freeData();
 		if (aCopy == true || aTakeOwndership == false)
 		{
 			mData = new float[aLength];
@@ -420,6 +517,7 @@ namespace SoLoud
 		mSampleCount = aLength / aChannels;
 		mChannels = aChannels;
 		mBaseSamplerate = aSamplerate;
+		compactData();
 		return SO_NO_ERROR;
 	}
 };
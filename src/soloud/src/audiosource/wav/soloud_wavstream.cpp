@@ -33,9 +33,171 @@ freely, subject to the following restrictions:
 #include "soloud_wavstream.h"
 #include "soloud_file.h"
 #include "stb_vorbis.h"
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 namespace SoLoud
 {
+	// PCM frames between two MP3 seek points. A seek decodes at most this
+	// many frames plus DRMP3_SEEK_LEADING_MP3_FRAMES MP3 frames.
+	static const unsigned int MP3_SEEK_POINT_INTERVAL = 8192;
+
+	struct Mp3SeekTable
+	{
+		std::vector<drmp3_seek_point> mPoints;
+	};
+
+	// Frames decoded at once by the prefetch I/O thread, and decoded after a
+	// seek before the voice plays again.
+	static const unsigned int PREFETCH_CHUNK_FRAMES = 512;
+	static const unsigned int PREFETCH_SEEK_FRAMES = 4 * PREFETCH_CHUNK_FRAMES;
+
+	// The I/O thread shared by all the prefetching instances. It is started
+	// by the first one and waits without polling while there are none.
+	class WavStreamPrefetcher
+	{
+	public:
+		WavStreamPrefetcher() : mIntervalMs(20), mRetired(0), mFreeing(false), mUnderruns(0) {}
+
+		void add(WavStreamInstance *aInstance, unsigned int aMilliseconds)
+		{
+			{
+				std::lock_guard<std::mutex> lock(mMutex);
+				mInstances.push_back(aInstance);
+				// Wake up often enough to refill a quarter of the smallest ring.
+				unsigned int interval = aMilliseconds / 4;
+				if (interval < 1)
+					interval = 1;
+				if (mInstances.size() == 1 || interval < mIntervalMs)
+					mIntervalMs = interval;
+				if (!mThread.joinable())
+					mThread = std::thread(&WavStreamPrefetcher::run, this);
+			}
+			mWakeUp.notify_one();
+		}
+
+		// Hand [aInstance] over to the I/O thread, which frees it once done
+		// with the chunk it may be decoding. Doesn't wait for the I/O thread
+		// nor allocate, so that the audio thread can stop a voice.
+		void retire(WavStreamInstance *aInstance)
+		{
+			{
+				std::lock_guard<std::mutex> lock(mMutex);
+				for (size_t i = 0; i < mInstances.size(); i++)
+				{
+					if (mInstances[i] == aInstance)
+					{
+						mInstances.erase(mInstances.begin() + i);
+						break;
+					}
+				}
+				aInstance->mRetiredNext = mRetired;
+				mRetired = aInstance;
+			}
+			mWakeUp.notify_one();
+		}
+
+		// Wait until the retired instances of [aParent] are freed, as they
+		// read its data until then.
+		void waitForRetired(const WavStream *aParent)
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mRetiredFreed.wait(lock, [&] {
+				if (mFreeing)
+					return false;
+				for (WavStreamInstance *instance = mRetired; instance; instance = instance->mRetiredNext)
+				{
+					if (instance->mParent == aParent)
+						return false;
+				}
+				return true;
+			});
+		}
+
+		void wakeUp()
+		{
+			mWakeUp.notify_one();
+		}
+
+		void countUnderrun()
+		{
+			mUnderruns.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		unsigned int getUnderrunCount()
+		{
+			return mUnderruns.load(std::memory_order_relaxed);
+		}
+
+	private:
+		void run()
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			for (;;)
+			{
+				// An instance is retired after the voice is gone, and only
+				// this thread decodes into it: it is idle here.
+				if (mRetired)
+				{
+					WavStreamInstance *instance = mRetired;
+					mRetired = 0;
+					mFreeing = true;
+					lock.unlock();
+					while (instance)
+					{
+						WavStreamInstance *next = instance->mRetiredNext;
+						delete instance;
+						instance = next;
+					}
+					lock.lock();
+					mFreeing = false;
+					mRetiredFreed.notify_all();
+				}
+
+				// Decode a chunk or apply a seek per instance and pass, so
+				// that the other voices don't wait for a long seek.
+				bool busy = false;
+				for (size_t i = 0; i < mInstances.size(); i++)
+				{
+					WavStreamInstance *instance = mInstances[i];
+					lock.unlock();
+					if (instance->applySeek() || instance->prefetchChunk())
+						busy = true;
+					lock.lock();
+				}
+				if (!busy && !mRetired)
+				{
+					if (mInstances.empty())
+						mWakeUp.wait(lock);
+					else
+						mWakeUp.wait_for(lock, std::chrono::milliseconds(mIntervalMs));
+				}
+			}
+		}
+
+		std::vector<WavStreamInstance *> mInstances;
+		std::thread mThread;
+		std::mutex mMutex;
+		std::condition_variable mWakeUp;
+		unsigned int mIntervalMs;
+		// Instances to free, linked by mRetiredNext.
+		WavStreamInstance *mRetired;
+		// True while this thread frees retired instances.
+		bool mFreeing;
+		std::condition_variable mRetiredFreed;
+		std::atomic<unsigned int> mUnderruns;
+	};
+
+	// Never destroyed: voices can still be deleted by the static destructors
+	// at exit, and the thread is then left waiting.
+	static WavStreamPrefetcher &getPrefetcher()
+	{
+		static WavStreamPrefetcher *prefetcher = new WavStreamPrefetcher;
+		return *prefetcher;
+	}
+
 	size_t drflac_read_func(void* pUserData, void* pBufferOut, size_t bytesToRead)
 	{
 		File *fp = (File*)pUserData;
@@ -82,6 +244,8 @@ namespace SoLoud
 	}
 
 	WavStreamInstance::WavStreamInstance(WavStream *aParent)
+		: mRingRead(0), mRingWrite(0), mRingEndPending(false), mRingLoopFrame(-1),
+		  mRingSeekFrame(0), mRingSeekRequest(0), mRingSeekDone(0)
 	{
 		mOggFrameSize = 0;
 		mParent = aParent;
@@ -89,18 +253,40 @@ namespace SoLoud
 		mCodec.mOgg = 0;
 		mCodec.mFlac = 0;
 		mFile = 0;
+		mRing = 0;
+		mRingFrames = 0;
+		mRingChannels = aParent->mChannels;
+		mRingEnd = 0;
+		mRingLooped = false;
+		mRingLoopedTo = 0;
+		mDecoderEnded = false;
+		mRetiredNext = 0;
 		if (aParent->mMemFile)
 		{
 			MemoryFile *mf = new MemoryFile();
 			mFile = mf;
 			mf->openMem(aParent->mMemFile->getMemPtr(), aParent->mMemFile->length(), false, false);
+			// The instance owns its file and decoder.
+			mFlags |= CONCURRENT_MIX;
 		}
 		else
 		if (aParent->mFilename)
 		{
-			DiskFile *df = new DiskFile;
-			mFile = df;
-			df->open(aParent->mFilename);
+			// The instances share the file pages in the OS cache, and reading
+			// them doesn't need a system call.
+			MappedFile *mf = new MappedFile;
+			if (mf->open(aParent->mFilename) == SO_NO_ERROR)
+			{
+				mFile = mf;
+			}
+			else
+			{
+				delete mf;
+				DiskFile *df = new DiskFile;
+				mFile = df;
+				df->open(aParent->mFilename);
+			}
+			mFlags |= CONCURRENT_MIX;
 		}
 		else
 		if (aParent->mStreamFile)
@@ -167,6 +353,12 @@ namespace SoLoud
 						delete mFile;
 					mFile = 0;
 				}
+				else
+				if (mParent->mMp3SeekTable)
+				{
+					std::vector<drmp3_seek_point> &points = mParent->mMp3SeekTable->mPoints;
+					drmp3_bind_seek_table(mCodec.mMp3, (drmp3_uint32)points.size(), points.data());
+				}
 			}
 			else
 			{
@@ -176,10 +368,28 @@ namespace SoLoud
 				return;
 			}
 		}
+
+		// A stream file is shared by the instances, which must then all
+		// decode on the audio thread.
+		if (mFile && mParent->mPrefetchMs > 0 && mFile != mParent->mStreamFile)
+		{
+			// Round the ring up to a power of two so that the positions can
+			// wrap around.
+			unsigned int frames = (unsigned int)(mParent->mBaseSamplerate * mParent->mPrefetchMs / 1000);
+			mRingFrames = PREFETCH_SEEK_FRAMES;
+			while (mRingFrames < frames)
+				mRingFrames *= 2;
+			mRing = new float[mRingFrames * mRingChannels];
+			if (mParent->mFlags & AudioSource::SHOULD_LOOP)
+				mRingLoopFrame = (int)floor(mParent->mBaseSamplerate * mParent->mLoopPoint);
+			prefill(PREFETCH_SEEK_FRAMES);
+			getPrefetcher().add(this, mParent->mPrefetchMs);
+		}
 	}
 
 	WavStreamInstance::~WavStreamInstance()
 	{
+		delete[] mRing;
 		switch (mParent->mFiletype)
 		{
 		case WAVSTREAM_OGG:
@@ -239,7 +449,12 @@ namespace SoLoud
 	
 
 	unsigned int WavStreamInstance::getAudio(float *aBuffer, unsigned int aSamplesToRead, unsigned int aBufferSize)
-	{			
+	{
+		return decode(aBuffer, aSamplesToRead, aBufferSize, mChannels);
+	}
+
+	unsigned int WavStreamInstance::decode(float *aBuffer, unsigned int aSamplesToRead, unsigned int aBufferSize, unsigned int aChannels)
+	{
 		unsigned int offset = 0;
 		float tmp[512 * MAX_CHANNELS];
 		if (mFile == NULL)
@@ -257,7 +472,7 @@ namespace SoLoud
 
 					for (j = 0; j < blockSize; j++)
 					{
-						for (k = 0; k < mChannels; k++)
+						for (k = 0; k < aChannels; k++)
 						{
 							aBuffer[k * aSamplesToRead + i + j] = tmp[j * mCodec.mFlac->channels + k];
 						}
@@ -278,7 +493,7 @@ namespace SoLoud
 
 					for (j = 0; j < blockSize; j++)
 					{
-						for (k = 0; k < mChannels; k++)
+						for (k = 0; k < aChannels; k++)
 						{
 							aBuffer[k * aSamplesToRead + i + j] = tmp[j * mCodec.mMp3->channels + k];
 						}
@@ -292,7 +507,7 @@ namespace SoLoud
 			{
 				if (mOggFrameOffset < mOggFrameSize)
 				{
-					int b = getOggData(mOggOutputs, aBuffer, aSamplesToRead, aBufferSize, mOggFrameSize, mOggFrameOffset, mChannels);
+					int b = getOggData(mOggOutputs, aBuffer, aSamplesToRead, aBufferSize, mOggFrameSize, mOggFrameOffset, aChannels);
 					mOffset += b;
 					offset += b;
 					mOggFrameOffset += b;
@@ -302,7 +517,7 @@ namespace SoLoud
 				{
 					mOggFrameSize = stb_vorbis_get_frame_float(mCodec.mOgg, NULL, &mOggOutputs);
 					mOggFrameOffset = 0;
-					int b = getOggData(mOggOutputs, aBuffer + offset, aSamplesToRead - offset, aBufferSize, mOggFrameSize, mOggFrameOffset, mChannels);
+					int b = getOggData(mOggOutputs, aBuffer + offset, aSamplesToRead - offset, aBufferSize, mOggFrameSize, mOggFrameOffset, aChannels);
 					mOffset += b;
 					offset += b;
 					mOggFrameOffset += b;
@@ -326,7 +541,7 @@ namespace SoLoud
 
 					for (j = 0; j < blockSize; j++)
 					{
-						for (k = 0; k < mChannels; k++)
+						for (k = 0; k < aChannels; k++)
 						{
 							aBuffer[k * aSamplesToRead + i + j] = tmp[j * mCodec.mWav->channels + k];
 						}
@@ -342,53 +557,268 @@ namespace SoLoud
 
 	result WavStreamInstance::seek(double aSeconds, float *mScratch, unsigned int mScratchSize)
 	{
-		if (mCodec.mOgg)
+		if (!mCodec.mOgg)
+		{
+			return AudioSourceInstance::seek(aSeconds, mScratch, mScratchSize);
+		}
+		result res = seekDecoder((int)floor(mBaseSamplerate * aSeconds));
+		if (res == SO_NO_ERROR)
 		{
-			int pos = (int)floor(mBaseSamplerate * aSeconds);
-			double newPosition;
+			mStreamPosition = mOffset / mBaseSamplerate;
+		}
+		return res;
+	}
 
-			switch (mParent->mFiletype)
+	result WavStreamInstance::seekDecoder(int aFrame)
+	{
+		int pos = aFrame;
+		switch (mParent->mFiletype)
+		{
+		case WAVSTREAM_OGG:
+			// stb_vorbis_seek() leaves the rest of the frame containing [pos]
+			// in its own buffer, which stb_vorbis_get_frame_float() skips.
+			// Decode that frame here and start from [pos] inside it.
+			mOggFrameSize = 0;
+			mOggFrameOffset = 0;
+			if (stb_vorbis_seek_frame(mCodec.mOgg, pos))
 			{
-			case WAVSTREAM_OGG:
-				stb_vorbis_seek(mCodec.mOgg, pos);
-				// Since the position that we just sought to might not be *exactly*
-				// the position we asked for, we're re-calculating the position just
-				// for the sake of correctness.
-				mOffset = stb_vorbis_get_sample_offset(mCodec.mOgg);
-				newPosition = float(mOffset / mBaseSamplerate);
-				mStreamPosition = newPosition;
-				return 0;
-			case WAVSTREAM_FLAC:
-				drflac_seek_to_pcm_frame(mCodec.mFlac, pos);
-				mOffset = pos;
-				mStreamPosition = float(pos / mBaseSamplerate);
-				return 0;
-			case WAVSTREAM_MP3:
-				// When using TYPE_WAVSTREAM for mp3 and seeking backward,
-				// dr_mp3.h uses `drmp3_seek_to_pcm_frame__brute_force()` function which
-				// move to the start of the stream and then move forward to [time]. This
-				// implies some lag and queue subsequent seeks request if the previous seek is not yet
-				// complete (especially when using a slider) impacting the main UI thread.
-				// To have no lags, please use TYPE_WAV instead if possible!
-				drmp3_seek_to_pcm_frame(mCodec.mMp3, pos);
-				mOffset = pos;
-				mStreamPosition = float(pos / mBaseSamplerate);
-				return 0;
-			case WAVSTREAM_WAV:
-				drwav_seek_to_pcm_frame(mCodec.mWav, pos);
-				mOffset = pos;
-				mStreamPosition = float(pos / mBaseSamplerate);
-				return 0;
-			default:
-				break;
+				int frameStart = stb_vorbis_get_sample_offset(mCodec.mOgg);
+				mOggFrameSize = stb_vorbis_get_frame_float(mCodec.mOgg, NULL, &mOggOutputs);
+				if (pos - frameStart < (int)mOggFrameSize)
+					mOggFrameOffset = pos - frameStart;
+				else
+					mOggFrameOffset = mOggFrameSize;
 			}
+			// Since the position that we just sought to might not be *exactly*
+			// the position we asked for, we're re-calculating the position just
+			// for the sake of correctness.
+			mOffset = stb_vorbis_get_sample_offset(mCodec.mOgg) - (mOggFrameSize - mOggFrameOffset);
+			return 0;
+		case WAVSTREAM_FLAC:
+			drflac_seek_to_pcm_frame(mCodec.mFlac, pos);
+			mOffset = pos;
+			return 0;
+		case WAVSTREAM_MP3:
+			// With a seek table dr_mp3 starts decoding from the closest seek
+			// point. Without it, seeking backward uses
+			// `drmp3_seek_to_pcm_frame__brute_force()` which moves to the start
+			// of the stream and then decodes forward to [time]. This
+			// implies some lag and queue subsequent seeks request if the previous seek is not yet
+			// complete (especially when using a slider) impacting the main UI thread.
+			drmp3_seek_to_pcm_frame(mCodec.mMp3, pos);
+			mOffset = pos;
+			return 0;
+		case WAVSTREAM_WAV:
+			drwav_seek_to_pcm_frame(mCodec.mWav, pos);
+			mOffset = pos;
+			return 0;
+		default:
+			break;
+		}
+		return NOT_IMPLEMENTED;
+	}
+
+	bool WavStreamInstance::prefetchChunk()
+	{
+		if (mDecoderEnded)
+		{
+			// Only one end can be pending: wait for the audio thread to
+			// reach the previous one.
+			if (mRingEndPending.load(std::memory_order_acquire))
+				return false;
+			publishRingEnd();
+			if (mDecoderEnded)
+				return false;
+		}
+
+		unsigned int write = mRingWrite.load(std::memory_order_relaxed);
+		unsigned int used = write - mRingRead.load(std::memory_order_acquire);
+		if (mRingFrames - used < PREFETCH_CHUNK_FRAMES)
+			return false;
+
+		float tmp[PREFETCH_CHUNK_FRAMES * MAX_CHANNELS];
+		unsigned int frames = decode(tmp, PREFETCH_CHUNK_FRAMES, PREFETCH_CHUNK_FRAMES, mRingChannels);
+		unsigned int start = write & (mRingFrames - 1);
+		unsigned int first = mRingFrames - start < frames ? mRingFrames - start : frames;
+		unsigned int k;
+		for (k = 0; k < mRingChannels; k++)
+		{
+			float *ring = mRing + k * mRingFrames;
+			memcpy(ring + start, tmp + k * PREFETCH_CHUNK_FRAMES, sizeof(float) * first);
+			memcpy(ring, tmp + k * PREFETCH_CHUNK_FRAMES + first, sizeof(float) * (frames - first));
+		}
+		mRingWrite.store(write + frames, std::memory_order_release);
+
+		if (frames < PREFETCH_CHUNK_FRAMES)
+		{
+			mDecoderEnded = true;
+			if (!mRingEndPending.load(std::memory_order_acquire))
+				publishRingEnd();
+		}
+		return true;
+	}
+
+	void WavStreamInstance::publishRingEnd()
+	{
+		// When looping, keep decoding from the loop point so that the seek
+		// done by the audio thread at the end doesn't touch the file.
+		mRingEnd = mRingWrite.load(std::memory_order_relaxed);
+		int loopFrame = mRingLoopFrame.load(std::memory_order_relaxed);
+		mRingLooped = loopFrame >= 0 && (unsigned int)loopFrame < mParent->mSampleCount &&
+					  seekDecoder(loopFrame) == SO_NO_ERROR;
+		mRingLoopedTo = loopFrame;
+		mDecoderEnded = !mRingLooped;
+		mRingEndPending.store(true, std::memory_order_release);
+	}
+
+	void WavStreamInstance::prefill(unsigned int aFrames)
+	{
+		while (mRingWrite.load(std::memory_order_relaxed) - mRingRead.load(std::memory_order_relaxed) < aFrames &&
+			   prefetchChunk())
+		{
+		}
+	}
+
+	bool WavStreamInstance::applySeek()
+	{
+		unsigned int request = mRingSeekRequest.load(std::memory_order_acquire);
+		if (request == mRingSeekDone.load(std::memory_order_relaxed))
+			return false;
+
+		// The voice doesn't read the ring until mRingSeekDone is updated.
+		mRingRead.store(0, std::memory_order_relaxed);
+		mRingWrite.store(0, std::memory_order_relaxed);
+		mRingEndPending.store(false, std::memory_order_relaxed);
+		if (seekDecoder(mRingSeekFrame.load(std::memory_order_relaxed)) == SO_NO_ERROR)
+		{
+			// Decode a few chunks right away, so that the voice doesn't
+			// underrun as soon as it plays again.
+			mDecoderEnded = false;
+			prefill(PREFETCH_SEEK_FRAMES);
 		}
 		else
 		{
-			return AudioSourceInstance::seek(aSeconds, mScratch, mScratchSize);
+			// The voice ends.
+			mRingEnd = 0;
+			mRingLooped = false;
+			mDecoderEnded = true;
+			mRingEndPending.store(true, std::memory_order_relaxed);
 		}
+		mRingSeekDone.store(request, std::memory_order_release);
+		return true;
+	}
 
-		return NOT_IMPLEMENTED;
+	WavStreamPrefetchInstance::WavStreamPrefetchInstance(WavStreamInstance *aDecoder)
+	{
+		mDecoder = aDecoder;
+		// Only reads the ring.
+		mFlags |= CONCURRENT_MIX;
+	}
+
+	WavStreamPrefetchInstance::~WavStreamPrefetchInstance()
+	{
+		getPrefetcher().retire(mDecoder);
+	}
+
+	bool WavStreamPrefetchInstance::isSeeking()
+	{
+		// Only the voice posts seeks.
+		return mDecoder->mRingSeekRequest.load(std::memory_order_relaxed) !=
+			   mDecoder->mRingSeekDone.load(std::memory_order_acquire);
+	}
+
+	void WavStreamPrefetchInstance::postSeek(int aFrame)
+	{
+		mDecoder->mRingSeekFrame.store(aFrame, std::memory_order_relaxed);
+		mDecoder->mRingSeekRequest.fetch_add(1, std::memory_order_release);
+		mStreamPosition = aFrame / mBaseSamplerate;
+		getPrefetcher().wakeUp();
+	}
+
+	unsigned int WavStreamPrefetchInstance::getAudio(float *aBuffer, unsigned int aSamplesToRead, unsigned int aBufferSize)
+	{
+		WavStreamInstance *d = mDecoder;
+		unsigned int k;
+		if (isSeeking())
+		{
+			for (k = 0; k < d->mRingChannels; k++)
+			{
+				memset(aBuffer + k * aBufferSize, 0, sizeof(float) * aSamplesToRead);
+			}
+			return aSamplesToRead;
+		}
+
+		// Tell the I/O thread where to continue after the end.
+		d->mRingLoopFrame.store((mFlags & LOOPING) ? (int)floor(mBaseSamplerate * mLoopPoint) : -1, std::memory_order_relaxed);
+
+		// The end is published before any frame past it, so it is seen
+		// whenever the frames read reach it.
+		unsigned int read = d->mRingRead.load(std::memory_order_relaxed);
+		unsigned int available = d->mRingWrite.load(std::memory_order_acquire) - read;
+		bool atEnd = false;
+		if (d->mRingEndPending.load(std::memory_order_acquire) && d->mRingEnd - read <= available)
+		{
+			available = d->mRingEnd - read;
+			atEnd = true;
+		}
+
+		unsigned int frames = available < aSamplesToRead ? available : aSamplesToRead;
+		unsigned int start = read & (d->mRingFrames - 1);
+		unsigned int first = d->mRingFrames - start < frames ? d->mRingFrames - start : frames;
+		for (k = 0; k < d->mRingChannels; k++)
+		{
+			const float *ring = d->mRing + k * d->mRingFrames;
+			memcpy(aBuffer + k * aBufferSize, ring + start, sizeof(float) * first);
+			memcpy(aBuffer + k * aBufferSize + first, ring, sizeof(float) * (frames - first));
+		}
+		d->mRingRead.store(read + frames, std::memory_order_release);
+
+		if (frames < aSamplesToRead && !atEnd)
+		{
+			// The I/O thread is late: play silence rather than wait for it.
+			for (k = 0; k < d->mRingChannels; k++)
+			{
+				memset(aBuffer + k * aBufferSize + frames, 0, sizeof(float) * (aSamplesToRead - frames));
+			}
+			getPrefetcher().countUnderrun();
+			return aSamplesToRead;
+		}
+		return frames;
+	}
+
+	result WavStreamPrefetchInstance::seek(double aSeconds, float *mScratch, unsigned int mScratchSize)
+	{
+		WavStreamInstance *d = mDecoder;
+		int pos = (int)floor(mBaseSamplerate * aSeconds);
+
+		// Looping at the end: the loop point follows the end in the ring.
+		if (!isSeeking() && d->mRingEndPending.load(std::memory_order_acquire) && d->mRingLooped &&
+			d->mRingRead.load(std::memory_order_relaxed) == d->mRingEnd && pos == d->mRingLoopedTo)
+		{
+			d->mRingEndPending.store(false, std::memory_order_release);
+			mStreamPosition = pos / mBaseSamplerate;
+			// A short sound may be waiting to loop again.
+			getPrefetcher().wakeUp();
+			return SO_NO_ERROR;
+		}
+
+		// Otherwise the I/O thread seeks and refills the ring, and the voice
+		// plays silence meanwhile.
+		postSeek(pos);
+		return SO_NO_ERROR;
+	}
+
+	result WavStreamPrefetchInstance::rewind()
+	{
+		postSeek(0);
+		return SO_NO_ERROR;
+	}
+
+	bool WavStreamPrefetchInstance::hasEnded()
+	{
+		WavStreamInstance *d = mDecoder;
+		return !isSeeking() && d->mRingEndPending.load(std::memory_order_acquire) &&
+			   d->mRingRead.load(std::memory_order_relaxed) == d->mRingEnd;
 	}
 
 
@@ -400,6 +830,8 @@ namespace SoLoud
 			if (mCodec.mOgg)
 			{
 				stb_vorbis_seek_start(mCodec.mOgg);
+				mOggFrameSize = 0;
+				mOggFrameOffset = 0;
 			}
 			break;
 		case WAVSTREAM_FLAC:
@@ -442,15 +874,32 @@ namespace SoLoud
 		mFiletype = WAVSTREAM_WAV;
 		mMemFile = 0;
 		mStreamFile = 0;
+		mMp3SeekTable = 0;
+		mPrefetchMs = 0;
 	}
 	
 	WavStream::~WavStream()
 	{
 		stop();
+		// The decoders of the prefetching voices read the file until the
+		// I/O thread frees them.
+		getPrefetcher().waitForRetired(this);
 		delete[] mFilename;
 		delete mMemFile;
+		delete mMp3SeekTable;
 	}
 	
+	result WavStream::setPrefetch(unsigned int aMilliseconds)
+	{
+		mPrefetchMs = aMilliseconds;
+		return SO_NO_ERROR;
+	}
+
+	unsigned int WavStream::getPrefetchUnderrunCount()
+	{
+		return getPrefetcher().getUnderrunCount();
+	}
+
 #define MAKEDWORD(a,b,c,d) (((d) << 24) | ((c) << 16) | ((b) << 8) | (a))
 
 	result WavStream::loadwav(File * fp)
@@ -542,9 +991,38 @@ namespace SoLoud
 		mFiletype = WAVSTREAM_MP3;
 		drmp3_uninit(&decoder);
 
+		// Index the frames now, while loading, so that seeking never has to
+		// decode from the start of the stream on the audio thread.
+		buildMp3SeekTable(fp);
+
 		return SO_NO_ERROR;
 	}
 
+	void WavStream::buildMp3SeekTable(File *fp)
+	{
+		delete mMp3SeekTable;
+		mMp3SeekTable = 0;
+
+		fp->seek(0);
+		drmp3 decoder;
+		if (!drmp3_init(&decoder, drmp3_read_func, drmp3_seek_func, NULL, NULL, (void*)fp, NULL))
+			return;
+
+		Mp3SeekTable *table = new Mp3SeekTable;
+		drmp3_uint32 count = mSampleCount / MP3_SEEK_POINT_INTERVAL + 1;
+		table->mPoints.resize(count);
+		if (drmp3_calculate_seek_points(&decoder, &count, table->mPoints.data()) && count > 0)
+		{
+			table->mPoints.resize(count);
+			mMp3SeekTable = table;
+		}
+		else
+		{
+			delete table;
+		}
+		drmp3_uninit(&decoder);
+	}
+
 	result WavStream::load(const char *aFilename)
 	{
 		delete[] mFilename;
@@ -552,8 +1030,17 @@ namespace SoLoud
 		mMemFile = 0;
 		mFilename = 0;
 		mSampleCount = 0;
-		DiskFile fp;
-		int res = fp.open(aFilename);
+		delete mMp3SeekTable;
+		mMp3SeekTable = 0;
+		MappedFile mf;
+		DiskFile df;
+		File *fp = &mf;
+		int res = mf.open(aFilename);
+		if (res != SO_NO_ERROR)
+		{
+			fp = &df;
+			res = df.open(aFilename);
+		}
 		if (res != SO_NO_ERROR)
 			return res;
 		
@@ -562,7 +1049,7 @@ namespace SoLoud
 		memcpy(mFilename, aFilename, len);
 		mFilename[len] = 0;
 		
-		res = parse(&fp);
+		res = parse(fp);
 
 		if (res != SO_NO_ERROR)
 		{
@@ -582,6 +1069,8 @@ namespace SoLoud
 		mMemFile = 0;
 		mFilename = 0;
 		mSampleCount = 0;
+		delete mMp3SeekTable;
+		mMp3SeekTable = 0;
 
 		if (aData == NULL || aDataLen == 0)
 			return INVALID_PARAMETER;
@@ -626,6 +1115,8 @@ namespace SoLoud
 		mMemFile = 0;
 		mFilename = 0;
 		mSampleCount = 0;
+		delete mMp3SeekTable;
+		mMp3SeekTable = 0;
 
 		int res = parse(aFile);
 
@@ -647,6 +1138,8 @@ namespace SoLoud
 		mMemFile = 0;
 		mFilename = 0;
 		mSampleCount = 0;
+		delete mMp3SeekTable;
+		mMp3SeekTable = 0;
 
 		MemoryFile *mf = new MemoryFile();
 		int res = mf->openFileToMem(aFile);
@@ -702,7 +1195,10 @@ namespace SoLoud
 
 	AudioSourceInstance *WavStream::createInstance()
 	{
-		return new WavStreamInstance(this);
+		WavStreamInstance *instance = new WavStreamInstance(this);
+		if (instance->mRing)
+			return new WavStreamPrefetchInstance(instance);
+		return instance;
 	}
 
 	double WavStream::getLength()
@@ -30,13 +30,16 @@ freely, subject to the following restrictions:
 #include "soloud_internal.h"
 #include "soloud_thread.h"
 #include "soloud_fft.h"
+#include "soloud_resample.h"
 
 
 #ifdef SOLOUD_SSE_INTRINSICS
 #include <xmmintrin.h>
-#ifdef _M_IX86
 #include <emmintrin.h>
 #endif
+
+#ifdef SOLOUD_NEON_INTRINSICS
+#include <arm_neon.h>
 #endif
 
 //#define FLOATING_POINT_DEBUG
@@ -141,6 +144,11 @@ namespace SoLoud
 			mVisualizationWaveData[i] = 0;
 			mWaveData[i] = 0;
 		}
+		for (i = 0; i < VISUALIZATION_HISTORY_SIZE; i++)
+		{
+			mVisualizationHistory[i] = 0;
+		}
+		mVisualizationHistoryPos = 0;
 		for (i = 0; i < MAX_CHANNELS; i++)
 		{
 			mVisualizationChannelVolume[i] = 0;
@@ -169,6 +177,8 @@ namespace SoLoud
 		mHighestVoice = 0;
 		mResampleData = NULL;
 		mResampleDataOwner = NULL;
+		mMixPool = NULL;
+		mMixingConcurrently = false;
 		for (i = 0; i < 3 * MAX_CHANNELS; i++)
 			m3dSpeakerPosition[i] = 0;
 	}
@@ -203,6 +213,9 @@ namespace SoLoud
 		if (mAudioThreadMutex)
 			Thread::destroyMutex(mAudioThreadMutex);
 		mAudioThreadMutex = NULL;
+		// The backend is gone, so no mix can be using the pool.
+		delete mMixPool;
+		mMixPool = NULL;
 	}
 
 	// Change output device.
@@ -758,6 +771,21 @@ namespace SoLoud
 		return mWaveData;
 	}
 
+	void Soloud::getWaveHistory(float *aBuffer, unsigned int aSamples)
+	{
+		if (aSamples > VISUALIZATION_HISTORY_SIZE)
+			aSamples = VISUALIZATION_HISTORY_SIZE;
+		lockAudioMutex_internal();
+		unsigned int pos = (mVisualizationHistoryPos - aSamples) & (VISUALIZATION_HISTORY_SIZE - 1);
+		unsigned int i;
+		for (i = 0; i < aSamples; i++)
+		{
+			aBuffer[i] = mVisualizationHistory[pos];
+			pos = (pos + 1) & (VISUALIZATION_HISTORY_SIZE - 1);
+		}
+		unlockAudioMutex_internal();
+	}
+
 	float Soloud::getApproximateVolume(unsigned int aChannel)
 	{
 		if (aChannel > mChannels)
@@ -965,120 +993,6 @@ namespace SoLoud
 }
 #endif
 
-#define FIXPOINT_FRAC_BITS 20
-#define FIXPOINT_FRAC_MUL (1 << FIXPOINT_FRAC_BITS)
-#define FIXPOINT_FRAC_MASK ((1 << FIXPOINT_FRAC_BITS) - 1)
-
-	static float catmullrom(float t, float p0, float p1, float p2, float p3)
-	{
-		return 0.5f * (
-			(2 * p1) +
-			(-p0 + p2) * t +
-			(2 * p0 - 5 * p1 + 4 * p2 - p3) * t * t +
-			(-p0 + 3 * p1 - 3 * p2 + p3) * t * t * t
-			);
-	}
-
-	static void resample_catmullrom(float* aSrc,
-		float* aSrc1,
-		float* aDst,
-		int aSrcOffset,
-		int aDstSampleCount,
-		int aStepFixed)
-	{
-		int i;
-		int pos = aSrcOffset;
-
-		for (i = 0; i < aDstSampleCount; i++, pos += aStepFixed)
-		{
-			int p = pos >> FIXPOINT_FRAC_BITS;
-			int f = pos & FIXPOINT_FRAC_MASK;
-
-			float s0, s1, s2, s3;
-
-			if (p < 3)
-			{
-				s3 = aSrc1[512 + p - 3];
-			}
-			else
-			{
-				s3 = aSrc[p - 3];
-			}
-
-			if (p < 2)
-			{
-				s2 = aSrc1[512 + p - 2];
-			}
-			else
-			{
-				s2 = aSrc[p - 2];
-			}
-
-			if (p < 1)
-			{
-				s1 = aSrc1[512 + p - 1];
-			}
-			else
-			{
-				s1 = aSrc[p - 1];
-			}
-
-			s0 = aSrc[p];
-
-			aDst[i] = catmullrom(f / (float)FIXPOINT_FRAC_MUL, s3, s2, s1, s0);
-		}
-	}
-
-	static void resample_linear(float* aSrc,
-		float* aSrc1,
-		float* aDst,
-		int aSrcOffset,
-		int aDstSampleCount,
-		int aStepFixed)
-	{
-		int i;
-		int pos = aSrcOffset;
-
-		for (i = 0; i < aDstSampleCount; i++, pos += aStepFixed)
-		{
-			int p = pos >> FIXPOINT_FRAC_BITS;
-			int f = pos & FIXPOINT_FRAC_MASK;
-#ifdef _DEBUG
-			if (p >= SAMPLE_GRANULARITY || p < 0)
-			{
-				// This should never actually happen
-				p = SAMPLE_GRANULARITY - 1;
-			}
-#endif
-			float s1 = aSrc1[SAMPLE_GRANULARITY - 1];
-			float s2 = aSrc[p];
-			if (p != 0)
-			{
-				s1 = aSrc[p - 1];
-			}
-			aDst[i] = s1 + (s2 - s1) * f * (1 / (float)FIXPOINT_FRAC_MUL);
-		}
-	}
-
-	static void resample_point(float* aSrc,
-		float* aSrc1,
-		float* aDst,
-		int aSrcOffset,
-		int aDstSampleCount,
-		int aStepFixed)
-	{
-		int i;
-		int pos = aSrcOffset;
-
-		for (i = 0; i < aDstSampleCount; i++, pos += aStepFixed)
-		{
-			int p = pos >> FIXPOINT_FRAC_BITS;
-			aDst[i] = aSrc[p];
-		}
-	}
-
-
-
 	void panAndExpand(AudioSourceInstance *aVoice, float *aBuffer, unsigned int aSamplesToRead, unsigned int aBufferSize, float *aScratch, unsigned int aChannels)
 	{
 #ifdef SOLOUD_SSE_INTRINSICS
@@ -1628,199 +1542,244 @@ namespace SoLoud
 			aVoice->mCurrentChannelVolume[k] = pand[k];
 	}
 
-	void Soloud::mixBus_internal(float *aBuffer, unsigned int aSamplesToRead, unsigned int aBufferSize, float *aScratch, unsigned int aBus, float aSamplerate, unsigned int aChannels, unsigned int aResampler)
+	void Soloud::renderVoice_internal(AudioSourceInstance *aVoice, float *aScratch, unsigned int aSamplesToRead, unsigned int aBufferSize, float aSamplerate, unsigned int aResampler, float *aSeekScratch, unsigned int aSeekScratchSize)
 	{
-		unsigned int i, j;
-		// Clear accumulation buffer
-		for (i = 0; i < aSamplesToRead; i++)
+		unsigned int j;
+		const ResampleKernels &kernels = getResampleKernels();
+		float step = aVoice->mSamplerate / aSamplerate;
+		// avoid step overflow
+		if (step > (1 << (32 - FIXPOINT_FRAC_BITS)))
+			step = 0;
+		unsigned int step_fixed = (int)floor(step * FIXPOINT_FRAC_MUL);
+		unsigned int outofs = 0;
+
+		// Time the resampling, and the filters if there are any.
+		const bool timeResample = mPerf.isEnabled();
+		bool timeFilters = false;
+		for (j = 0; timeResample && j < FILTERS_PER_STREAM; j++)
+			timeFilters |= aVoice->mFilter[j] != NULL;
+		uint64_t resampleNs = 0, filterNs = 0;
+		PerfCounters::Clock::time_point start;
+		
+		if (aVoice->mDelaySamples)
 		{
-			for (j = 0; j < aChannels; j++)
+			if (aVoice->mDelaySamples > aSamplesToRead)
 			{
-				aBuffer[i + j * aBufferSize] = 0;
+				outofs = aSamplesToRead;
+				aVoice->mDelaySamples -= aSamplesToRead;
 			}
-		}
+			else
+			{
+				outofs = aVoice->mDelaySamples;
+				aVoice->mDelaySamples = 0;
+			}
+			
+			// Clear scratch where we're skipping
+			unsigned int k;
+			for (k = 0; k < aVoice->mChannels; k++)
+			{
+				memset(aScratch + k * aBufferSize, 0, sizeof(float) * outofs); 
+			}
+		}												
 
-		// Accumulate sound sources		
-		for (i = 0; i < mActiveVoiceCount; i++)
+		while (step_fixed != 0 && outofs < aSamplesToRead)
 		{
-			AudioSourceInstance *voice = mVoice[mActiveVoice[i]];
-			if (voice &&
-				voice->mBusHandle == aBus &&
-				!(voice->mFlags & AudioSourceInstance::PAUSED) &&
-				!(voice->mFlags & AudioSourceInstance::INAUDIBLE))
+			if (aVoice->mLeftoverSamples == 0)
 			{
-				float step = voice->mSamplerate / aSamplerate;
-				// avoid step overflow
-				if (step > (1 << (32 - FIXPOINT_FRAC_BITS)))
-					step = 0;
-				unsigned int step_fixed = (int)floor(step * FIXPOINT_FRAC_MUL);
-				unsigned int outofs = 0;
-			
-				if (voice->mDelaySamples)
-				{
-					if (voice->mDelaySamples > aSamplesToRead)
-					{
-						outofs = aSamplesToRead;
-						voice->mDelaySamples -= aSamplesToRead;
-					}
-					else
-					{
-						outofs = voice->mDelaySamples;
-						voice->mDelaySamples = 0;
-					}
-					
-					// Clear scratch where we're skipping
-					unsigned int k;
-					for (k = 0; k < voice->mChannels; k++)
-					{
-						memset(aScratch + k * aBufferSize, 0, sizeof(float) * outofs); 
-					}
-				}												
+				// Swap resample buffers (ping-pong)
+				float * t = aVoice->mResampleData[0];
+				aVoice->mResampleData[0] = aVoice->mResampleData[1];
+				aVoice->mResampleData[1] = t;
 
-				while (step_fixed != 0 && outofs < aSamplesToRead)
+				// Get a block of source data
+
+				int readcount = 0;
+				if (!aVoice->hasEnded() || aVoice->mFlags & AudioSourceInstance::LOOPING)
 				{
-					if (voice->mLeftoverSamples == 0)
+					readcount = aVoice->getAudio(aVoice->mResampleData[0], SAMPLE_GRANULARITY, SAMPLE_GRANULARITY);
+					if (readcount < SAMPLE_GRANULARITY)
 					{
-						// Swap resample buffers (ping-pong)
-						float * t = voice->mResampleData[0];
-						voice->mResampleData[0] = voice->mResampleData[1];
-						voice->mResampleData[1] = t;
-
-						// Get a block of source data
-
-						int readcount = 0;
-						if (!voice->hasEnded() || voice->mFlags & AudioSourceInstance::LOOPING)
+						if (aVoice->mFlags & AudioSourceInstance::LOOPING)
 						{
-							readcount = voice->getAudio(voice->mResampleData[0], SAMPLE_GRANULARITY, SAMPLE_GRANULARITY);
-							if (readcount < SAMPLE_GRANULARITY)
+							while (readcount < SAMPLE_GRANULARITY && aVoice->seek(aVoice->mLoopPoint, aSeekScratch, aSeekScratchSize) == SO_NO_ERROR)
 							{
-								if (voice->mFlags & AudioSourceInstance::LOOPING)
-								{
-									while (readcount < SAMPLE_GRANULARITY && voice->seek(voice->mLoopPoint, mScratch.mData, mScratchSize) == SO_NO_ERROR)
-									{
-										voice->mLoopCount++;
-										int inc = voice->getAudio(voice->mResampleData[0] + readcount, SAMPLE_GRANULARITY - readcount, SAMPLE_GRANULARITY);
-										readcount += inc;
-										if (inc == 0) break;
-									}
-								}
+								aVoice->mLoopCount++;
+								int inc = aVoice->getAudio(aVoice->mResampleData[0] + readcount, SAMPLE_GRANULARITY - readcount, SAMPLE_GRANULARITY);
+								readcount += inc;
+								if (inc == 0) break;
 							}
 						}
+					}
+				}
 
                         // Clear remaining of the resample data if the full scratch wasn't used
-						if (readcount < SAMPLE_GRANULARITY)
-						{
-							unsigned int k;
-							for (k = 0; k < voice->mChannels; k++)
-								memset(voice->mResampleData[0] + readcount + SAMPLE_GRANULARITY * k, 0, sizeof(float) * (SAMPLE_GRANULARITY - readcount));
-						}
+				if (readcount < SAMPLE_GRANULARITY)
+				{
+					unsigned int k;
+					for (k = 0; k < aVoice->mChannels; k++)
+						memset(aVoice->mResampleData[0] + readcount + SAMPLE_GRANULARITY * k, 0, sizeof(float) * (SAMPLE_GRANULARITY - readcount));
+				}
 
-						// If we go past zero, crop to zero (a bit of a kludge)
-						if (voice->mSrcOffset < SAMPLE_GRANULARITY * FIXPOINT_FRAC_MUL)
-						{
-							voice->mSrcOffset = 0;
-						}
-						else
-						{
-							// We have new block of data, move pointer backwards
-							voice->mSrcOffset -= SAMPLE_GRANULARITY * FIXPOINT_FRAC_MUL;
-						}
+				// If we go past zero, crop to zero (a bit of a kludge)
+				if (aVoice->mSrcOffset < SAMPLE_GRANULARITY * FIXPOINT_FRAC_MUL)
+				{
+					aVoice->mSrcOffset = 0;
+				}
+				else
+				{
+					// We have new block of data, move pointer backwards
+					aVoice->mSrcOffset -= SAMPLE_GRANULARITY * FIXPOINT_FRAC_MUL;
+				}
 
-					
-						// Run the per-stream filters to get our source data
+			
+				// Run the per-stream filters to get our source data
 
-						for (j = 0; j < FILTERS_PER_STREAM; j++)
-						{
-							if (voice->mFilter[j])
-							{
-								voice->mFilter[j]->filter(
-									voice->mResampleData[0],
-									SAMPLE_GRANULARITY,
-									SAMPLE_GRANULARITY,
-									voice->mChannels,
-									voice->mSamplerate,
-									mStreamTime);
-							}
-						}
-					}
-					else
+				if (timeFilters)
+					start = PerfCounters::Clock::now();
+				for (j = 0; j < FILTERS_PER_STREAM; j++)
+				{
+					if (aVoice->mFilter[j])
 					{
-						voice->mLeftoverSamples = 0;
+						aVoice->mFilter[j]->filter(
+							aVoice->mResampleData[0],
+							SAMPLE_GRANULARITY,
+							SAMPLE_GRANULARITY,
+							aVoice->mChannels,
+							aVoice->mSamplerate,
+							mStreamTime);
 					}
+				}
+				if (timeFilters)
+					filterNs += PerfCounters::elapsedNs(start, PerfCounters::Clock::now());
+			}
+			else
+			{
+				aVoice->mLeftoverSamples = 0;
+			}
 
-					// Figure out how many samples we can generate from this source data.
-					// The value may be zero.
+			// Figure out how many samples we can generate from this source data.
+			// The value may be zero.
 
-					unsigned int writesamples = 0;
+			unsigned int writesamples = 0;
 
-					if (voice->mSrcOffset < SAMPLE_GRANULARITY * FIXPOINT_FRAC_MUL)
-					{
-						writesamples = ((SAMPLE_GRANULARITY * FIXPOINT_FRAC_MUL) - voice->mSrcOffset) / step_fixed + 1;
+			if (aVoice->mSrcOffset < SAMPLE_GRANULARITY * FIXPOINT_FRAC_MUL)
+			{
+				writesamples = ((SAMPLE_GRANULARITY * FIXPOINT_FRAC_MUL) - aVoice->mSrcOffset) / step_fixed + 1;
 
-						// avoid reading past the current buffer..
-						if (((writesamples * step_fixed + voice->mSrcOffset) >> FIXPOINT_FRAC_BITS) >= SAMPLE_GRANULARITY)
-							writesamples--;
-					}
+				// avoid reading past the current buffer..
+				if (((writesamples * step_fixed + aVoice->mSrcOffset) >> FIXPOINT_FRAC_BITS) >= SAMPLE_GRANULARITY)
+					writesamples--;
+			}
 
 
-					// If this is too much for our output buffer, don't write that many:
-					if (writesamples + outofs > aSamplesToRead)
-					{
-						voice->mLeftoverSamples = (writesamples + outofs) - aSamplesToRead;
-						writesamples = aSamplesToRead - outofs;
-					}
+			// If this is too much for our output buffer, don't write that many:
+			if (writesamples + outofs > aSamplesToRead)
+			{
+				aVoice->mLeftoverSamples = (writesamples + outofs) - aSamplesToRead;
+				writesamples = aSamplesToRead - outofs;
+			}
 
-					// Call resampler to generate the samples, once per channel
-					if (writesamples)
+			// Call resampler to generate the samples, once per channel
+			if (writesamples)
+			{
+				if (timeResample)
+					start = PerfCounters::Clock::now();
+				for (j = 0; j < aVoice->mChannels; j++)
+				{
+					switch (aResampler)
 					{
-						for (j = 0; j < voice->mChannels; j++)
-						{
-							switch (aResampler)
-							{
-							case RESAMPLER_POINT:
-								resample_point(voice->mResampleData[0] + SAMPLE_GRANULARITY * j,
-									voice->mResampleData[1] + SAMPLE_GRANULARITY * j,
-									aScratch + aBufferSize * j + outofs,
-									voice->mSrcOffset,
-									writesamples,
-									/*voice->mSamplerate,
-									aSamplerate,*/
-									step_fixed);
-								break;
-							case RESAMPLER_CATMULLROM:
-								resample_catmullrom(voice->mResampleData[0] + SAMPLE_GRANULARITY * j,
-									voice->mResampleData[1] + SAMPLE_GRANULARITY * j,
-									aScratch + aBufferSize * j + outofs,
-									voice->mSrcOffset,
-									writesamples,
-									/*voice->mSamplerate,
-									aSamplerate,*/
-									step_fixed);
-								break;
-							default:
-							//case RESAMPLER_LINEAR:
-								resample_linear(voice->mResampleData[0] + SAMPLE_GRANULARITY * j,
-									voice->mResampleData[1] + SAMPLE_GRANULARITY * j,
-									aScratch + aBufferSize * j + outofs,
-									voice->mSrcOffset,
-									writesamples,
-									/*voice->mSamplerate,
-									aSamplerate,*/
-									step_fixed);
-								break;
-							}
-						}
+					case RESAMPLER_POINT:
+						kernels.mPoint(aVoice->mResampleData[0] + SAMPLE_GRANULARITY * j,
+							aVoice->mResampleData[1] + SAMPLE_GRANULARITY * j,
+							aScratch + aBufferSize * j + outofs,
+							aVoice->mSrcOffset,
+							writesamples,
+							/*aVoice->mSamplerate,
+							aSamplerate,*/
+							step_fixed);
+						break;
+					case RESAMPLER_CATMULLROM:
+						kernels.mCatmullrom(aVoice->mResampleData[0] + SAMPLE_GRANULARITY * j,
+							aVoice->mResampleData[1] + SAMPLE_GRANULARITY * j,
+							aScratch + aBufferSize * j + outofs,
+							aVoice->mSrcOffset,
+							writesamples,
+							/*aVoice->mSamplerate,
+							aSamplerate,*/
+							step_fixed);
+						break;
+					default:
+					//case RESAMPLER_LINEAR:
+						kernels.mLinear(aVoice->mResampleData[0] + SAMPLE_GRANULARITY * j,
+							aVoice->mResampleData[1] + SAMPLE_GRANULARITY * j,
+							aScratch + aBufferSize * j + outofs,
+							aVoice->mSrcOffset,
+							writesamples,
+							/*aVoice->mSamplerate,
+							aSamplerate,*/
+							step_fixed);
+						break;
 					}
+				}
+				if (timeResample)
+					resampleNs += PerfCounters::elapsedNs(start, PerfCounters::Clock::now());
+			}
 
-					// Keep track of how many samples we've written so far
-					outofs += writesamples;
+			// Keep track of how many samples we've written so far
+			outofs += writesamples;
 
-					// Move source pointer onwards (writesamples may be zero)
-					voice->mSrcOffset += writesamples * step_fixed;
+			// Move source pointer onwards (writesamples may be zero)
+			aVoice->mSrcOffset += writesamples * step_fixed;
+		}
+
+		if (timeResample)
+		{
+			mPerf.addResampleTime(resampleNs);
+			if (timeFilters)
+				mPerf.addVoiceFilterTime(filterNs);
+		}
+	}
+
+	void Soloud::mixBus_internal(float *aBuffer, unsigned int aSamplesToRead, unsigned int aBufferSize, float *aScratch, unsigned int aBus, float aSamplerate, unsigned int aChannels, unsigned int aResampler)
+	{
+		unsigned int i, j;
+		// Clear accumulation buffer
+		for (i = 0; i < aSamplesToRead; i++)
+		{
+			for (j = 0; j < aChannels; j++)
+			{
+				aBuffer[i + j * aBufferSize] = 0;
+			}
+		}
+
+		// Render the voices that allow it on the mix pool. Only the outermost bus
+		// is forked: nested buses are mixed by their BusInstance, serially.
+		bool forked = false;
+		if (mMixPool && !mMixingConcurrently)
+			forked = renderVoicesConcurrently_internal(aSamplesToRead, aBufferSize, aBus, aSamplerate, aResampler);
+
+		// Accumulate sound sources		
+		for (i = 0; i < mActiveVoiceCount; i++)
+		{
+			AudioSourceInstance *voice = mVoice[mActiveVoice[i]];
+			if (voice &&
+				voice->mBusHandle == aBus &&
+				!(voice->mFlags & AudioSourceInstance::PAUSED) &&
+				!(voice->mFlags & AudioSourceInstance::INAUDIBLE))
+			{
+				// Voices rendered by the mix pool are only panned here. Doesn't touch
+				// the pool: getAudio of a serially mixed voice may release the mutex,
+				// and setMixThreadCount may delete the pool meanwhile.
+				if (forked && mMixVoice[i] == voice)
+				{
+					panAndExpand(voice, aBuffer, aSamplesToRead, aBufferSize, mMixVoiceScratch[i], aChannels);
+				}
+				else
+				{
+					renderVoice_internal(voice, aScratch, aSamplesToRead, aBufferSize, aSamplerate, aResampler, mScratch.mData, mScratchSize);
+					// Handle panning and channel expansion (and/or shrinking)
+					panAndExpand(voice, aBuffer, aSamplesToRead, aBufferSize, aScratch, aChannels);
 				}
-				
-				// Handle panning and channel expansion (and/or shrinking)
-				panAndExpand(voice, aBuffer, aSamplesToRead, aBufferSize, aScratch, aChannels);
 
 				// clear voice if the sound is over
 				if (!(voice->mFlags & (AudioSourceInstance::LOOPING | AudioSourceInstance::DISABLE_AUTOSTOP)) && voice->hasEnded())
@@ -1938,6 +1897,150 @@ namespace SoLoud
 				}
 			}
 		}
+
+		if (forked)
+			mMixingConcurrently = false;
+	}
+
+	bool Soloud::renderVoicesConcurrently_internal(unsigned int aSamplesToRead, unsigned int aBufferSize, unsigned int aBus, float aSamplerate, unsigned int aResampler)
+	{
+		// Read once: the pool may only change while the mutex is released.
+		MixPool *pool = mMixPool;
+		unsigned int i;
+		unsigned int count = 0;
+		unsigned int scratchSize = 0;
+		for (i = 0; i < mActiveVoiceCount; i++)
+		{
+			AudioSourceInstance *voice = mVoice[mActiveVoice[i]];
+			mMixVoice[i] = 0;
+			if (voice &&
+				voice->mBusHandle == aBus &&
+				(voice->mFlags & AudioSourceInstance::CONCURRENT_MIX) &&
+				!(voice->mFlags & AudioSourceInstance::PAUSED) &&
+				!(voice->mFlags & AudioSourceInstance::INAUDIBLE))
+			{
+				mMixVoice[i] = voice;
+				// Output plus a scratch for seeking when looping.
+				scratchSize += voice->mChannels * (aBufferSize + SAMPLE_GRANULARITY);
+				count++;
+			}
+		}
+
+		// Not worth a fork for a single voice
+		if (count < 2)
+			return false;
+
+		// Only grows when more voices than ever are rendered at once.
+		if (mMixScratch.mFloats < (int)scratchSize)
+			mMixScratch.init(scratchSize * 2);
+
+		float *scratch = mMixScratch.mData;
+		unsigned int task = 0;
+		for (i = 0; i < mActiveVoiceCount; i++)
+		{
+			AudioSourceInstance *voice = mMixVoice[i];
+			if (!voice)
+				continue;
+			MixVoiceTask *t = &pool->mTask[task++];
+			t->mSoloud = this;
+			t->mVoice = voice;
+			t->mScratch = scratch;
+			t->mSeekScratch = scratch + voice->mChannels * aBufferSize;
+			t->mSeekScratchSize = voice->mChannels * SAMPLE_GRANULARITY;
+			t->mSamplesToRead = aSamplesToRead;
+			t->mBufferSize = aBufferSize;
+			t->mSamplerate = aSamplerate;
+			t->mResampler = aResampler;
+			mMixVoiceScratch[i] = scratch;
+			scratch += voice->mChannels * (aBufferSize + SAMPLE_GRANULARITY);
+		}
+
+		pool->run(count);
+
+		mMixingConcurrently = true;
+		return true;
+	}
+
+	MixPool::MixPool(unsigned int aThreadCount)
+	{
+		mThreadCount = aThreadCount;
+		mNext = 0;
+		mPending = 0;
+		mCount = 0;
+		mGeneration = 0;
+		mBusyWorkers = 0;
+		mQuit = false;
+		unsigned int i;
+		for (i = 0; i < aThreadCount; i++)
+			mThreads.push_back(std::thread(&MixPool::workerLoop, this));
+	}
+
+	MixPool::~MixPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mQuit = true;
+		}
+		mWorkReady.notify_all();
+		unsigned int i;
+		for (i = 0; i < mThreads.size(); i++)
+			mThreads[i].join();
+	}
+
+	void MixPool::run(unsigned int aCount)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			// A worker woken late by the previous run may still be looking for
+			// tasks. It must not take the tasks of this one with the old count.
+			mWorkDone.wait(lock, [this] { return mBusyWorkers == 0; });
+			mCount = aCount;
+			mNext.store(0, std::memory_order_relaxed);
+			mPending.store(aCount, std::memory_order_relaxed);
+			mGeneration++;
+		}
+		mWorkReady.notify_all();
+
+		// This thread renders too, then sleeps until the workers are done.
+		runTasks(aCount);
+		std::unique_lock<std::mutex> lock(mMutex);
+		mWorkDone.wait(lock, [this] { return mPending.load(std::memory_order_acquire) == 0; });
+	}
+
+	void MixPool::runTasks(unsigned int aCount)
+	{
+		unsigned int task;
+		while ((task = mNext.fetch_add(1, std::memory_order_relaxed)) < aCount)
+		{
+			mTask[task].work();
+			// The last task wakes the audio thread. Locking orders the notify
+			// after the wait predicate check, so the wakeup can't be missed.
+			if (mPending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			{
+				std::lock_guard<std::mutex> lock(mMutex);
+				mWorkDone.notify_all();
+			}
+		}
+	}
+
+	void MixPool::workerLoop()
+	{
+		unsigned int generation = 0;
+		std::unique_lock<std::mutex> lock(mMutex);
+		for (;;)
+		{
+			mWorkReady.wait(lock, [&] { return mQuit || mGeneration != generation; });
+			if (mQuit)
+				return;
+			generation = mGeneration;
+			const unsigned int count = mCount;
+			mBusyWorkers++;
+			lock.unlock();
+			runTasks(count);
+			lock.lock();
+			if (--mBusyWorkers == 0)
+				mWorkDone.notify_all();
+		}
 	}
 
 	void Soloud::mapResampleBuffers_internal()
@@ -2140,6 +2243,12 @@ namespace SoLoud
 		}
 #endif
 
+		const bool timeMix = mPerf.isEnabled();
+		PerfCounters::Clock::time_point mixStart;
+		if (timeMix)
+			mixStart = PerfCounters::Clock::now();
+		unsigned int playingVoices = 0;
+
 		float buffertime = aSamples / (float)mSamplerate;
 		float globalVolume[2];
 		mStreamTime += buffertime;
@@ -2162,6 +2271,8 @@ namespace SoLoud
 			{
 				float volume[2];
 
+				playingVoices++;
+
 				mVoice[i]->mActiveFader = 0;
 
 				if (mGlobalVolumeFader.mActive > 0)
@@ -2223,12 +2334,19 @@ namespace SoLoud
 			calcActiveVoices_internal();
 	
 		mixBus_internal(mOutputScratch.mData, aSamples, aStride, mScratch.mData, 0, (float)mSamplerate, mChannels, mResampler);
+		unsigned int activeVoices = mActiveVoiceCount;
 
 		for (i = 0; i < FILTERS_PER_STREAM; i++)
 		{
+			mFilterParamMailbox[i].deliver(mFilterInstance[i], mStreamTime);
 			if (mFilterInstance[i])
 			{
+				PerfCounters::Clock::time_point filterStart;
+				if (timeMix)
+					filterStart = PerfCounters::Clock::now();
 				mFilterInstance[i]->filter(mOutputScratch.mData, aSamples, aStride, mChannels, (float)mSamplerate, mStreamTime);
+				if (timeMix)
+					mPerf.addGlobalFilterTime(i, PerfCounters::elapsedNs(filterStart, PerfCounters::Clock::now()));
 			}
 		}
 
@@ -2277,7 +2395,22 @@ namespace SoLoud
 					}
 				}
 			}
+
+			unsigned int pos = mVisualizationHistoryPos;
+			for (i = 0; i < (signed)aSamples; i++)
+			{
+				int j;
+				float sample = 0;
+				for (j = 0; j < (signed)mChannels; j++)
+					sample += mScratch.mData[i + j * aStride];
+				mVisualizationHistory[pos] = sample;
+				pos = (pos + 1) & (VISUALIZATION_HISTORY_SIZE - 1);
+			}
+			mVisualizationHistoryPos = pos;
 		}
+
+		if (timeMix)
+			mPerf.countMix(mixStart, PerfCounters::Clock::now(), (uint64_t)aSamples * 1000000000 / mSamplerate, activeVoices, playingVoices);
 	}
 
 	void Soloud::mix(float *aBuffer, unsigned int aSamples)
@@ -36,6 +36,8 @@ namespace SoLoud
 		lockAudioMutex_internal();
 		delete mFilterInstance[aFilterId];
 		mFilterInstance[aFilterId] = 0;
+		// The values posted to the previous filter don't apply to this one.
+		mFilterParamMailbox[aFilterId].clear();
 		
 		mFilter[aFilterId] = aFilter;
 		if (aFilter)
@@ -53,6 +55,11 @@ namespace SoLoud
 
 		if (aVoiceHandle == 0)
 		{
+			// A value not delivered yet is the one the filter will have.
+			float posted;
+			if (mFilterParamMailbox[aFilterId].peek(aAttributeId, posted))
+				return posted;
+
 			lockAudioMutex_internal();
 			if (mFilterInstance[aFilterId])
 			{
@@ -85,12 +92,9 @@ namespace SoLoud
 
 		if (aVoiceHandle == 0)
 		{
-			lockAudioMutex_internal();
-			if (mFilterInstance[aFilterId])
-			{
-				mFilterInstance[aFilterId]->setFilterParameter(aAttributeId, aValue);
-			}
-			unlockAudioMutex_internal();
+			// Lock-free: the UI can automate the global filters at its frame
+			// rate without waiting for a mix, nor making the mix wait.
+			mFilterParamMailbox[aFilterId].post(aAttributeId, aValue);
 			return;
 		}
 
@@ -110,12 +114,8 @@ namespace SoLoud
 
 		if (aVoiceHandle == 0)
 		{
-			lockAudioMutex_internal();
-			if (mFilterInstance[aFilterId])
-			{
-				mFilterInstance[aFilterId]->fadeFilterParameter(aAttributeId, aTo, aTime, mStreamTime);
-			}
-			unlockAudioMutex_internal();
+			// Lock-free as setFilterParameter. The fade starts at the next mix.
+			mFilterParamMailbox[aFilterId].postFade(aAttributeId, aTo, aTime);
 			return;
 		}
 
@@ -135,12 +135,7 @@ namespace SoLoud
 
 		if (aVoiceHandle == 0)
 		{
-			lockAudioMutex_internal();
-			if (mFilterInstance[aFilterId])
-			{
-				mFilterInstance[aFilterId]->oscillateFilterParameter(aAttributeId, aFrom, aTo, aTime, mStreamTime);
-			}
-			unlockAudioMutex_internal();
+			mFilterParamMailbox[aFilterId].postOscillate(aAttributeId, aFrom, aTo, aTime);
 			return;
 		}
 
@@ -107,6 +107,11 @@ namespace SoLoud
 		return c;
 	}
 
+	void Soloud::getPerfSnapshot(PerfSnapshot &aSnapshot) const
+	{
+		mPerf.snapshot(aSnapshot);
+	}
+
 	bool Soloud::isValidVoiceHandle(handle aVoiceHandle)
 	{
 		// voice groups are not valid voice handles
@@ -91,6 +91,40 @@ namespace SoLoud
 		return SO_NO_ERROR;
 	}
 
+	result Soloud::setMixThreadCount(unsigned int aThreadCount)
+	{
+		if (aThreadCount > 64)
+			return INVALID_PARAMETER;
+		if ((mMixPool ? mMixPool->mThreadCount : 0) == aThreadCount)
+			return SO_NO_ERROR;
+
+		MixPool *pool = NULL;
+		if (aThreadCount > 0)
+		{
+			pool = new MixPool(aThreadCount);
+		}
+
+		// The mix holds the mutex while it runs the pool, and doesn't use the
+		// pool after: the old one is idle once swapped.
+		lockAudioMutex_internal();
+		MixPool *old = mMixPool;
+		mMixPool = pool;
+		unlockAudioMutex_internal();
+		// Waits for its workers to stop.
+		delete old;
+		return SO_NO_ERROR;
+	}
+
+	void Soloud::setPerfCountersEnabled(bool aEnabled)
+	{
+		mPerf.setEnabled(aEnabled);
+	}
+
+	void Soloud::resetPerfCounters()
+	{
+		mPerf.reset();
+	}
+
 	void Soloud::setPauseAll(bool aPause)
 	{
 		lockAudioMutex_internal();
@@ -27,6 +27,14 @@ distribution.
 
 #include <stdio.h>
 #include <string.h>
+#if defined(_WIN32)||defined(_WIN64)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 #include "soloud.h"
 #include "soloud_file.h"
 
@@ -242,6 +250,90 @@ mFileHandle(fp)
 			return 1;
 		return 0;
 	}
+
+	MappedFile::MappedFile()
+	{
+		mMapBase = 0;
+		mMapLength = 0;
+	}
+
+	MappedFile::~MappedFile()
+	{
+		unmap();
+	}
+
+	void MappedFile::unmap()
+	{
+		if (!mMapBase)
+			return;
+#if defined(_WIN32)||defined(_WIN64)
+		UnmapViewOfFile(mMapBase);
+#else
+		munmap(mMapBase, mMapLength);
+#endif
+		mMapBase = 0;
+		mMapLength = 0;
+	}
+
+	result MappedFile::open(const char *aFilename)
+	{
+		if (!aFilename)
+			return INVALID_PARAMETER;
+		if (mDataOwned)
+			delete[] mDataPtr;
+		unmap();
+		mDataPtr = 0;
+		mDataLength = 0;
+		mOffset = 0;
+		mDataOwned = false;
+
+#if defined(_WIN32)||defined(_WIN64)
+		HANDLE file = CreateFileA(aFilename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+		if (file == INVALID_HANDLE_VALUE)
+			return FILE_NOT_FOUND;
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(file, &size) || size.QuadPart == 0 || size.QuadPart > 0xffffffff)
+		{
+			CloseHandle(file);
+			return FILE_LOAD_FAILED;
+		}
+		// The view keeps the file open after the handles are closed.
+		HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+		CloseHandle(file);
+		if (!mapping)
+			return FILE_LOAD_FAILED;
+		void *base = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		CloseHandle(mapping);
+		if (!base)
+			return FILE_LOAD_FAILED;
+		mMapLength = (unsigned int)size.QuadPart;
+#else
+		int fd = ::open(aFilename, O_RDONLY);
+		if (fd < 0)
+			return FILE_NOT_FOUND;
+		struct stat st;
+		if (fstat(fd, &st) != 0 || st.st_size == 0 || (unsigned long long)st.st_size > 0xffffffffULL)
+		{
+			close(fd);
+			return FILE_LOAD_FAILED;
+		}
+		// The mapping keeps the file open after the descriptor is closed.
+		void *base = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		close(fd);
+		if (base == MAP_FAILED)
+			return FILE_LOAD_FAILED;
+		mMapLength = (unsigned int)st.st_size;
+#if defined(MADV_SEQUENTIAL)
+		// Decoders read front to back: read ahead, and let the pages already
+		// read go first under memory pressure.
+		madvise(base, mMapLength, MADV_SEQUENTIAL);
+#endif
+#endif
+		mMapBase = base;
+		mDataPtr = (const unsigned char *)base;
+		mDataLength = mMapLength;
+		return SO_NO_ERROR;
+	}
 }
 
 extern "C"
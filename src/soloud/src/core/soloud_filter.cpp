@@ -24,6 +24,10 @@ freely, subject to the following restrictions:
 
 #include "soloud.h"
 
+#ifdef SOLOUD_SSE_INTRINSICS
+#include <xmmintrin.h>
+#endif
+
 namespace SoLoud
 {
 
@@ -66,6 +70,9 @@ namespace SoLoud
 		mParamChanged = 0;
 		mParam = 0;
 		mParamFader = 0;
+		mParamFrom = 0;
+		mParamLast = 0;
+		mParamLastValid = false;
 	}
 
 	result FilterInstance::initParams(int aNumParams)
@@ -73,15 +80,24 @@ namespace SoLoud
 		mNumParams = aNumParams;
 		delete[] mParam;
 		delete[] mParamFader;
+		delete[] mParamFrom;
+		delete[] mParamLast;
 		mParam = new float[mNumParams];
 		mParamFader = new Fader[mNumParams];
+		mParamFrom = new float[mNumParams];
+		mParamLast = new float[mNumParams];
+		mParamLastValid = false;
 
-		if (mParam == NULL || mParamFader == NULL)
+		if (mParam == NULL || mParamFader == NULL || mParamFrom == NULL || mParamLast == NULL)
 		{
 			delete[] mParam;
 			delete[] mParamFader;
+			delete[] mParamFrom;
+			delete[] mParamLast;
 			mParam = NULL;
 			mParamFader = NULL;
+			mParamFrom = NULL;
+			mParamLast = NULL;
 			mNumParams = 0;
 			return OUT_OF_MEMORY;
 		}
@@ -108,12 +124,23 @@ namespace SoLoud
 				mParam[i] = mParamFader[i].get(aTime);
 			}
 		}
+
+		// The ramps of this block go from the values of the previous one. The
+		// first block has no ramp: the values were set by the constructor.
+		for (i = 0; i < mNumParams; i++)
+		{
+			mParamFrom[i] = mParamLastValid ? mParamLast[i] : mParam[i];
+			mParamLast[i] = mParam[i];
+		}
+		mParamLastValid = true;
 	}
 
 	FilterInstance::~FilterInstance()
 	{
 		delete[] mParam;
 		delete[] mParamFader;
+		delete[] mParamFrom;
+		delete[] mParamLast;
 	}
 
 	void FilterInstance::setFilterParameter(unsigned int aAttributeId, float aValue)
@@ -150,6 +177,47 @@ namespace SoLoud
 		return mParam[aAttributeId];
 	}
 
+	float FilterInstance::getParamAt(unsigned int aAttributeId, float aFraction)
+	{
+		if (aAttributeId >= mNumParams)
+			return 0;
+
+		return mParamFrom[aAttributeId] + (mParam[aAttributeId] - mParamFrom[aAttributeId]) * aFraction;
+	}
+
+	void FilterInstance::getParamRamp(unsigned int aAttributeId, float *aRamp, unsigned int aOffset, unsigned int aCount, unsigned int aSamples)
+	{
+		if (aAttributeId >= mNumParams || aSamples == 0)
+			return;
+
+		const float to = mParam[aAttributeId];
+		const float from = mParamFrom[aAttributeId];
+		unsigned int i = 0;
+		if (from == to)
+		{
+			for (i = 0; i < aCount; i++)
+				aRamp[i] = to;
+			return;
+		}
+
+		const float step = (to - from) / aSamples;
+		const float start = from + step * (aOffset + 1);
+#ifdef SOLOUD_SSE_INTRINSICS
+		const __m128 step4 = _mm_set1_ps(step * 4);
+		__m128 value = _mm_add_ps(_mm_set1_ps(start), _mm_mul_ps(_mm_set1_ps(step), _mm_setr_ps(0, 1, 2, 3)));
+		for (; i + 4 <= aCount; i += 4)
+		{
+			_mm_storeu_ps(aRamp + i, value);
+			value = _mm_add_ps(value, step4);
+		}
+#endif
+		for (; i < aCount; i++)
+			aRamp[i] = start + step * i;
+		// Don't let the rounding miss the target.
+		if (aOffset + aCount == aSamples && aCount > 0)
+			aRamp[aCount - 1] = to;
+	}
+
 	void FilterInstance::filter(float *aBuffer, unsigned int aSamples, unsigned int aBufferSize, unsigned int aChannels, float aSamplerate, double aTime)
 	{
 		unsigned int i;
@@ -163,5 +231,115 @@ namespace SoLoud
 	{
 	}
 
-};
 
+	FilterParamMailbox::FilterParamMailbox()
+	{
+		clear();
+	}
+
+	void FilterParamMailbox::post(unsigned int aAttributeId, float aValue)
+	{
+		if (aAttributeId >= MAX_PARAMS)
+			return;
+
+		// Setting a parameter stops its fade: drop the one not delivered yet.
+		mFadePending.fetch_and(~(1u << aAttributeId), std::memory_order_relaxed);
+		mValue[aAttributeId].store(aValue, std::memory_order_relaxed);
+		// Publishes the value with the bit.
+		mPending.fetch_or(1u << aAttributeId, std::memory_order_release);
+	}
+
+	void FilterParamMailbox::postFade(unsigned int aAttributeId, float aTo, time aTime)
+	{
+		postFade_internal(aAttributeId, false, 0, aTo, aTime);
+	}
+
+	void FilterParamMailbox::postOscillate(unsigned int aAttributeId, float aFrom, float aTo, time aTime)
+	{
+		postFade_internal(aAttributeId, true, aFrom, aTo, aTime);
+	}
+
+	void FilterParamMailbox::postFade_internal(unsigned int aAttributeId, bool aOscillate, float aFrom, float aTo, time aTime)
+	{
+		if (aAttributeId >= MAX_PARAMS)
+			return;
+
+		// Posting threads take turns to make the sequence odd. The audio thread
+		// never waits here.
+		std::atomic<unsigned int> &seq = mFadeSeq[aAttributeId];
+		unsigned int s = seq.load(std::memory_order_relaxed);
+		while ((s & 1) || !seq.compare_exchange_weak(s, s + 1, std::memory_order_acquire, std::memory_order_relaxed))
+			s = seq.load(std::memory_order_relaxed);
+
+		mFadeOscillate[aAttributeId].store(aOscillate, std::memory_order_relaxed);
+		mFadeFrom[aAttributeId].store(aFrom, std::memory_order_relaxed);
+		mFadeTo[aAttributeId].store(aTo, std::memory_order_relaxed);
+		mFadeTime[aAttributeId].store(aTime, std::memory_order_relaxed);
+		seq.store(s + 2, std::memory_order_release);
+		// Set after the sequence is even again, so a fade skipped while written
+		// is delivered next time.
+		mFadePending.fetch_or(1u << aAttributeId, std::memory_order_release);
+	}
+
+	bool FilterParamMailbox::peek(unsigned int aAttributeId, float &aValue) const
+	{
+		if (aAttributeId >= MAX_PARAMS ||
+			!(mPending.load(std::memory_order_acquire) & (1u << aAttributeId)))
+			return false;
+
+		aValue = mValue[aAttributeId].load(std::memory_order_relaxed);
+		return true;
+	}
+
+	void FilterParamMailbox::deliver(FilterInstance *aInstance, time aStreamTime)
+	{
+		if (mPending.load(std::memory_order_relaxed) == 0 &&
+			mFadePending.load(std::memory_order_relaxed) == 0)
+			return;
+
+		// The values first: a value posted before a fade is where the fade starts,
+		// and a value posted after it has dropped it.
+		unsigned int pending = mPending.exchange(0, std::memory_order_acquire);
+		unsigned int fades = mFadePending.exchange(0, std::memory_order_acquire);
+		if (aInstance == 0)
+			return;
+
+		// A value posted meanwhile is either read now or delivered next time.
+		unsigned int i;
+		for (i = 0; pending != 0; i++, pending >>= 1)
+		{
+			if (pending & 1)
+				aInstance->setFilterParameter(i, mValue[i].load(std::memory_order_relaxed));
+		}
+
+		for (i = 0; fades != 0; i++, fades >>= 1)
+		{
+			if (!(fades & 1))
+				continue;
+			unsigned int s = mFadeSeq[i].load(std::memory_order_acquire);
+			if (s & 1)
+				continue;
+			bool oscillate = mFadeOscillate[i].load(std::memory_order_relaxed);
+			float from = mFadeFrom[i].load(std::memory_order_relaxed);
+			float to = mFadeTo[i].load(std::memory_order_relaxed);
+			time fadeTime = mFadeTime[i].load(std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (mFadeSeq[i].load(std::memory_order_relaxed) != s)
+				continue;
+
+			if (oscillate)
+				aInstance->oscillateFilterParameter(i, from, to, fadeTime, aStreamTime);
+			else
+				aInstance->fadeFilterParameter(i, to, fadeTime, aStreamTime);
+		}
+	}
+
+	void FilterParamMailbox::clear()
+	{
+		unsigned int i;
+		for (i = 0; i < MAX_PARAMS; i++)
+			mValue[i].store(0, std::memory_order_relaxed);
+		mPending.store(0, std::memory_order_release);
+		mFadePending.store(0, std::memory_order_release);
+	}
+};
@@ -0,0 +1,501 @@
+/*
+SoLoud audio engine
+Copyright (c) 2013-2020 Jari Komppa
+
+This software is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any damages
+arising from the use of this software.
+
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it
+freely, subject to the following restrictions:
+
+   1. The origin of this software must not be misrepresented; you must not
+   claim that you wrote the original software. If you use this software
+   in a product, an acknowledgment in the product documentation would be
+   appreciated but is not required.
+
+   2. Altered source versions must be plainly marked as such, and must not be
+   misrepresented as being the original software.
+
+   3. This notice may not be removed or altered from any source
+   distribution.
+*/
+
+#ifndef SOLOUD_RESAMPLE_H
+#define SOLOUD_RESAMPLE_H
+
+// Resamplers used by Soloud::mixBus_internal, with their SSE, AVX2 and NEON
+// kernels. Only included by soloud.cpp and by benchmark/resampler_test.cpp,
+// which checks the vector kernels against the scalar ones.
+
+#include "soloud.h"
+
+#ifdef SOLOUD_SSE_INTRINSICS
+#include <emmintrin.h>
+#include <immintrin.h> // AVX2 resamplers, picked at runtime
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h> // __cpuid
+#endif
+#endif
+
+#ifdef SOLOUD_NEON_INTRINSICS
+#include <arm_neon.h>
+#endif
+
+namespace SoLoud
+{
+#define FIXPOINT_FRAC_BITS 20
+#define FIXPOINT_FRAC_MUL (1 << FIXPOINT_FRAC_BITS)
+#define FIXPOINT_FRAC_MASK ((1 << FIXPOINT_FRAC_BITS) - 1)
+
+	static float catmullrom(float t, float p0, float p1, float p2, float p3)
+	{
+		return 0.5f * (
+			(2 * p1) +
+			(-p0 + p2) * t +
+			(2 * p0 - 5 * p1 + 4 * p2 - p3) * t * t +
+			(-p0 + 3 * p1 - 3 * p2 + p3) * t * t * t
+			);
+	}
+
+	static void resample_catmullrom(float* aSrc,
+		float* aSrc1,
+		float* aDst,
+		int aSrcOffset,
+		int aDstSampleCount,
+		int aStepFixed)
+	{
+		int i;
+		int pos = aSrcOffset;
+
+		for (i = 0; i < aDstSampleCount; i++, pos += aStepFixed)
+		{
+			int p = pos >> FIXPOINT_FRAC_BITS;
+			int f = pos & FIXPOINT_FRAC_MASK;
+
+			float s0, s1, s2, s3;
+
+			if (p < 3)
+			{
+				s3 = aSrc1[512 + p - 3];
+			}
+			else
+			{
+				s3 = aSrc[p - 3];
+			}
+
+			if (p < 2)
+			{
+				s2 = aSrc1[512 + p - 2];
+			}
+			else
+			{
+				s2 = aSrc[p - 2];
+			}
+
+			if (p < 1)
+			{
+				s1 = aSrc1[512 + p - 1];
+			}
+			else
+			{
+				s1 = aSrc[p - 1];
+			}
+
+			s0 = aSrc[p];
+
+			aDst[i] = catmullrom(f / (float)FIXPOINT_FRAC_MUL, s3, s2, s1, s0);
+		}
+	}
+
+	static void resample_linear(float* aSrc,
+		float* aSrc1,
+		float* aDst,
+		int aSrcOffset,
+		int aDstSampleCount,
+		int aStepFixed)
+	{
+		int i;
+		int pos = aSrcOffset;
+
+		for (i = 0; i < aDstSampleCount; i++, pos += aStepFixed)
+		{
+			int p = pos >> FIXPOINT_FRAC_BITS;
+			int f = pos & FIXPOINT_FRAC_MASK;
+#ifdef _DEBUG
+			if (p >= SAMPLE_GRANULARITY || p < 0)
+			{
+				// This should never actually happen
+				p = SAMPLE_GRANULARITY - 1;
+			}
+#endif
+			float s1 = aSrc1[SAMPLE_GRANULARITY - 1];
+			float s2 = aSrc[p];
+			if (p != 0)
+			{
+				s1 = aSrc[p - 1];
+			}
+			aDst[i] = s1 + (s2 - s1) * f * (1 / (float)FIXPOINT_FRAC_MUL);
+		}
+	}
+
+	static void resample_point(float* aSrc,
+		float* aSrc1,
+		float* aDst,
+		int aSrcOffset,
+		int aDstSampleCount,
+		int aStepFixed)
+	{
+		int i;
+		int pos = aSrcOffset;
+
+		for (i = 0; i < aDstSampleCount; i++, pos += aStepFixed)
+		{
+			int p = pos >> FIXPOINT_FRAC_BITS;
+			aDst[i] = aSrc[p];
+		}
+	}
+
+
+	typedef void (*resampleFunction)(float *aSrc, float *aSrc1, float *aDst, int aSrcOffset, int aDstSampleCount, int aStepFixed);
+
+	// Number of leading output samples whose source reaches aHistory samples
+	// back, into the previous block. The vector kernels leave these to the
+	// scalar resamplers, so they only ever gather from aSrc.
+	static int resample_history_count(int aSrcOffset, int aDstSampleCount, int aStepFixed, int aHistory)
+	{
+		int limit = aHistory << FIXPOINT_FRAC_BITS;
+		// A step this large overflows the positions, leave it all to the scalar code
+		if (aStepFixed <= 0)
+			return aDstSampleCount;
+		if (aSrcOffset >= limit)
+			return 0;
+		int count = (limit - aSrcOffset + aStepFixed - 1) / aStepFixed;
+		return count < aDstSampleCount ? count : aDstSampleCount;
+	}
+
+	// The vector kernels evaluate the same expressions as the scalar ones in the
+	// same order, without fused multiply-adds, so the results are bit-exact.
+	// The division by FIXPOINT_FRAC_MUL is a multiplication by its exact
+	// reciprocal, as it's a power of two.
+
+#if defined(SOLOUD_SSE_INTRINSICS)
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#define SOLOUD_AVX2_TARGET
+#else
+#define SOLOUD_AVX2_TARGET __attribute__((target("avx2")))
+#endif
+
+	static bool cpuHasAvx2()
+	{
+#if defined(_MSC_VER) && !defined(__clang__)
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7)
+			return false;
+		__cpuid(info, 1);
+		// OSXSAVE and AVX, then the OS must save the ymm registers
+		if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0)
+			return false;
+		if ((_xgetbv(0) & 6) != 6)
+			return false;
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+#else
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx2") != 0;
+#endif
+	}
+
+	// Positions of 4 consecutive output samples
+	static inline __m128i resample_positions_sse(int aPos, int aStepFixed)
+	{
+		return _mm_setr_epi32(aPos, aPos + aStepFixed, aPos + 2 * aStepFixed, aPos + 3 * aStepFixed);
+	}
+
+	static inline __m128 resample_gather_sse(const float *aSrc, __m128i aIndex)
+	{
+		alignas(16) int index[4];
+		_mm_store_si128((__m128i *)index, aIndex);
+		return _mm_setr_ps(aSrc[index[0]], aSrc[index[1]], aSrc[index[2]], aSrc[index[3]]);
+	}
+
+	static void resample_point_sse(float *aSrc, float *aSrc1, float *aDst, int aSrcOffset, int aDstSampleCount, int aStepFixed)
+	{
+		int i = resample_history_count(aSrcOffset, aDstSampleCount, aStepFixed, 0);
+		resample_point(aSrc, aSrc1, aDst, aSrcOffset, i, aStepFixed);
+		int pos = aSrcOffset + i * aStepFixed;
+		__m128i vpos = resample_positions_sse(pos, aStepFixed);
+		__m128i vstep = _mm_set1_epi32(4 * aStepFixed);
+		for (; i + 4 <= aDstSampleCount; i += 4, pos += 4 * aStepFixed)
+		{
+			_mm_storeu_ps(aDst + i, resample_gather_sse(aSrc, _mm_srli_epi32(vpos, FIXPOINT_FRAC_BITS)));
+			vpos = _mm_add_epi32(vpos, vstep);
+		}
+		resample_point(aSrc, aSrc1, aDst + i, pos, aDstSampleCount - i, aStepFixed);
+	}
+
+	static void resample_linear_sse(float *aSrc, float *aSrc1, float *aDst, int aSrcOffset, int aDstSampleCount, int aStepFixed)
+	{
+		int i = resample_history_count(aSrcOffset, aDstSampleCount, aStepFixed, 1);
+		resample_linear(aSrc, aSrc1, aDst, aSrcOffset, i, aStepFixed);
+		int pos = aSrcOffset + i * aStepFixed;
+		__m128i vpos = resample_positions_sse(pos, aStepFixed);
+		const __m128i vstep = _mm_set1_epi32(4 * aStepFixed);
+		const __m128i mask = _mm_set1_epi32(FIXPOINT_FRAC_MASK);
+		const __m128i one = _mm_set1_epi32(1);
+		const __m128 scale = _mm_set1_ps(1 / (float)FIXPOINT_FRAC_MUL);
+		for (; i + 4 <= aDstSampleCount; i += 4, pos += 4 * aStepFixed)
+		{
+			__m128i p = _mm_srli_epi32(vpos, FIXPOINT_FRAC_BITS);
+			__m128 f = _mm_cvtepi32_ps(_mm_and_si128(vpos, mask));
+			__m128 s1 = resample_gather_sse(aSrc, _mm_sub_epi32(p, one));
+			__m128 s2 = resample_gather_sse(aSrc, p);
+			__m128 d = _mm_mul_ps(_mm_mul_ps(_mm_sub_ps(s2, s1), f), scale);
+			_mm_storeu_ps(aDst + i, _mm_add_ps(s1, d));
+			vpos = _mm_add_epi32(vpos, vstep);
+		}
+		resample_linear(aSrc, aSrc1, aDst + i, pos, aDstSampleCount - i, aStepFixed);
+	}
+
+	static inline __m128 catmullrom_sse(__m128 t, __m128 p0, __m128 p1, __m128 p2, __m128 p3)
+	{
+		const __m128 c2 = _mm_set1_ps(2), c3 = _mm_set1_ps(3), c4 = _mm_set1_ps(4), c5 = _mm_set1_ps(5);
+		__m128 a = _mm_mul_ps(c2, p1);
+		__m128 b = _mm_mul_ps(_mm_sub_ps(p2, p0), t);
+		__m128 c = _mm_sub_ps(_mm_add_ps(_mm_sub_ps(_mm_mul_ps(c2, p0), _mm_mul_ps(c5, p1)), _mm_mul_ps(c4, p2)), p3);
+		c = _mm_mul_ps(_mm_mul_ps(c, t), t);
+		__m128 d = _mm_add_ps(_mm_sub_ps(_mm_sub_ps(_mm_mul_ps(c3, p1), p0), _mm_mul_ps(c3, p2)), p3);
+		d = _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(d, t), t), t);
+		return _mm_mul_ps(_mm_set1_ps(0.5f), _mm_add_ps(_mm_add_ps(_mm_add_ps(a, b), c), d));
+	}
+
+	static void resample_catmullrom_sse(float *aSrc, float *aSrc1, float *aDst, int aSrcOffset, int aDstSampleCount, int aStepFixed)
+	{
+		int i = resample_history_count(aSrcOffset, aDstSampleCount, aStepFixed, 3);
+		resample_catmullrom(aSrc, aSrc1, aDst, aSrcOffset, i, aStepFixed);
+		int pos = aSrcOffset + i * aStepFixed;
+		__m128i vpos = resample_positions_sse(pos, aStepFixed);
+		const __m128i vstep = _mm_set1_epi32(4 * aStepFixed);
+		const __m128i mask = _mm_set1_epi32(FIXPOINT_FRAC_MASK);
+		const __m128 scale = _mm_set1_ps(1 / (float)FIXPOINT_FRAC_MUL);
+		for (; i + 4 <= aDstSampleCount; i += 4, pos += 4 * aStepFixed)
+		{
+			__m128i p = _mm_srli_epi32(vpos, FIXPOINT_FRAC_BITS);
+			__m128 t = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(vpos, mask)), scale);
+			__m128 s3 = resample_gather_sse(aSrc - 3, p);
+			__m128 s2 = resample_gather_sse(aSrc - 2, p);
+			__m128 s1 = resample_gather_sse(aSrc - 1, p);
+			__m128 s0 = resample_gather_sse(aSrc, p);
+			_mm_storeu_ps(aDst + i, catmullrom_sse(t, s3, s2, s1, s0));
+			vpos = _mm_add_epi32(vpos, vstep);
+		}
+		resample_catmullrom(aSrc, aSrc1, aDst + i, pos, aDstSampleCount - i, aStepFixed);
+	}
+
+	static inline SOLOUD_AVX2_TARGET __m256i resample_positions_avx2(int aPos, int aStepFixed)
+	{
+		return _mm256_add_epi32(_mm256_set1_epi32(aPos), _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(aStepFixed)));
+	}
+
+	static SOLOUD_AVX2_TARGET void resample_point_avx2(float *aSrc, float *aSrc1, float *aDst, int aSrcOffset, int aDstSampleCount, int aStepFixed)
+	{
+		int i = resample_history_count(aSrcOffset, aDstSampleCount, aStepFixed, 0);
+		resample_point(aSrc, aSrc1, aDst, aSrcOffset, i, aStepFixed);
+		int pos = aSrcOffset + i * aStepFixed;
+		__m256i vpos = resample_positions_avx2(pos, aStepFixed);
+		const __m256i vstep = _mm256_set1_epi32(8 * aStepFixed);
+		for (; i + 8 <= aDstSampleCount; i += 8, pos += 8 * aStepFixed)
+		{
+			_mm256_storeu_ps(aDst + i, _mm256_i32gather_ps(aSrc, _mm256_srli_epi32(vpos, FIXPOINT_FRAC_BITS), 4));
+			vpos = _mm256_add_epi32(vpos, vstep);
+		}
+		resample_point(aSrc, aSrc1, aDst + i, pos, aDstSampleCount - i, aStepFixed);
+	}
+
+	static SOLOUD_AVX2_TARGET void resample_linear_avx2(float *aSrc, float *aSrc1, float *aDst, int aSrcOffset, int aDstSampleCount, int aStepFixed)
+	{
+		int i = resample_history_count(aSrcOffset, aDstSampleCount, aStepFixed, 1);
+		resample_linear(aSrc, aSrc1, aDst, aSrcOffset, i, aStepFixed);
+		int pos = aSrcOffset + i * aStepFixed;
+		__m256i vpos = resample_positions_avx2(pos, aStepFixed);
+		const __m256i vstep = _mm256_set1_epi32(8 * aStepFixed);
+		const __m256i mask = _mm256_set1_epi32(FIXPOINT_FRAC_MASK);
+		const __m256 scale = _mm256_set1_ps(1 / (float)FIXPOINT_FRAC_MUL);
+		for (; i + 8 <= aDstSampleCount; i += 8, pos += 8 * aStepFixed)
+		{
+			__m256i p = _mm256_srli_epi32(vpos, FIXPOINT_FRAC_BITS);
+			__m256 f = _mm256_cvtepi32_ps(_mm256_and_si256(vpos, mask));
+			__m256 s1 = _mm256_i32gather_ps(aSrc - 1, p, 4);
+			__m256 s2 = _mm256_i32gather_ps(aSrc, p, 4);
+			__m256 d = _mm256_mul_ps(_mm256_mul_ps(_mm256_sub_ps(s2, s1), f), scale);
+			_mm256_storeu_ps(aDst + i, _mm256_add_ps(s1, d));
+			vpos = _mm256_add_epi32(vpos, vstep);
+		}
+		resample_linear(aSrc, aSrc1, aDst + i, pos, aDstSampleCount - i, aStepFixed);
+	}
+
+	static inline SOLOUD_AVX2_TARGET __m256 catmullrom_avx2(__m256 t, __m256 p0, __m256 p1, __m256 p2, __m256 p3)
+	{
+		const __m256 c2 = _mm256_set1_ps(2), c3 = _mm256_set1_ps(3), c4 = _mm256_set1_ps(4), c5 = _mm256_set1_ps(5);
+		__m256 a = _mm256_mul_ps(c2, p1);
+		__m256 b = _mm256_mul_ps(_mm256_sub_ps(p2, p0), t);
+		__m256 c = _mm256_sub_ps(_mm256_add_ps(_mm256_sub_ps(_mm256_mul_ps(c2, p0), _mm256_mul_ps(c5, p1)), _mm256_mul_ps(c4, p2)), p3);
+		c = _mm256_mul_ps(_mm256_mul_ps(c, t), t);
+		__m256 d = _mm256_add_ps(_mm256_sub_ps(_mm256_sub_ps(_mm256_mul_ps(c3, p1), p0), _mm256_mul_ps(c3, p2)), p3);
+		d = _mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(d, t), t), t);
+		return _mm256_mul_ps(_mm256_set1_ps(0.5f), _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(a, b), c), d));
+	}
+
+	static SOLOUD_AVX2_TARGET void resample_catmullrom_avx2(float *aSrc, float *aSrc1, float *aDst, int aSrcOffset, int aDstSampleCount, int aStepFixed)
+	{
+		int i = resample_history_count(aSrcOffset, aDstSampleCount, aStepFixed, 3);
+		resample_catmullrom(aSrc, aSrc1, aDst, aSrcOffset, i, aStepFixed);
+		int pos = aSrcOffset + i * aStepFixed;
+		__m256i vpos = resample_positions_avx2(pos, aStepFixed);
+		const __m256i vstep = _mm256_set1_epi32(8 * aStepFixed);
+		const __m256i mask = _mm256_set1_epi32(FIXPOINT_FRAC_MASK);
+		const __m256 scale = _mm256_set1_ps(1 / (float)FIXPOINT_FRAC_MUL);
+		for (; i + 8 <= aDstSampleCount; i += 8, pos += 8 * aStepFixed)
+		{
+			__m256i p = _mm256_srli_epi32(vpos, FIXPOINT_FRAC_BITS);
+			__m256 t = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(vpos, mask)), scale);
+			__m256 s3 = _mm256_i32gather_ps(aSrc - 3, p, 4);
+			__m256 s2 = _mm256_i32gather_ps(aSrc - 2, p, 4);
+			__m256 s1 = _mm256_i32gather_ps(aSrc - 1, p, 4);
+			__m256 s0 = _mm256_i32gather_ps(aSrc, p, 4);
+			_mm256_storeu_ps(aDst + i, catmullrom_avx2(t, s3, s2, s1, s0));
+			vpos = _mm256_add_epi32(vpos, vstep);
+		}
+		resample_catmullrom(aSrc, aSrc1, aDst + i, pos, aDstSampleCount - i, aStepFixed);
+	}
+
+#elif defined(SOLOUD_NEON_INTRINSICS)
+
+	static inline int32x4_t resample_positions_neon(int aPos, int aStepFixed)
+	{
+		alignas(16) const int lane[4] = { 0, 1, 2, 3 };
+		return vmlaq_n_s32(vdupq_n_s32(aPos), vld1q_s32(lane), aStepFixed);
+	}
+
+	static inline float32x4_t resample_gather_neon(const float *aSrc, int32x4_t aIndex)
+	{
+		float32x4_t r = vdupq_n_f32(aSrc[vgetq_lane_s32(aIndex, 0)]);
+		r = vld1q_lane_f32(aSrc + vgetq_lane_s32(aIndex, 1), r, 1);
+		r = vld1q_lane_f32(aSrc + vgetq_lane_s32(aIndex, 2), r, 2);
+		return vld1q_lane_f32(aSrc + vgetq_lane_s32(aIndex, 3), r, 3);
+	}
+
+	static void resample_point_neon(float *aSrc, float *aSrc1, float *aDst, int aSrcOffset, int aDstSampleCount, int aStepFixed)
+	{
+		int i = resample_history_count(aSrcOffset, aDstSampleCount, aStepFixed, 0);
+		resample_point(aSrc, aSrc1, aDst, aSrcOffset, i, aStepFixed);
+		int pos = aSrcOffset + i * aStepFixed;
+		int32x4_t vpos = resample_positions_neon(pos, aStepFixed);
+		const int32x4_t vstep = vdupq_n_s32(4 * aStepFixed);
+		for (; i + 4 <= aDstSampleCount; i += 4, pos += 4 * aStepFixed)
+		{
+			vst1q_f32(aDst + i, resample_gather_neon(aSrc, vshrq_n_s32(vpos, FIXPOINT_FRAC_BITS)));
+			vpos = vaddq_s32(vpos, vstep);
+		}
+		resample_point(aSrc, aSrc1, aDst + i, pos, aDstSampleCount - i, aStepFixed);
+	}
+
+	static void resample_linear_neon(float *aSrc, float *aSrc1, float *aDst, int aSrcOffset, int aDstSampleCount, int aStepFixed)
+	{
+		int i = resample_history_count(aSrcOffset, aDstSampleCount, aStepFixed, 1);
+		resample_linear(aSrc, aSrc1, aDst, aSrcOffset, i, aStepFixed);
+		int pos = aSrcOffset + i * aStepFixed;
+		int32x4_t vpos = resample_positions_neon(pos, aStepFixed);
+		const int32x4_t vstep = vdupq_n_s32(4 * aStepFixed);
+		const int32x4_t mask = vdupq_n_s32(FIXPOINT_FRAC_MASK);
+		for (; i + 4 <= aDstSampleCount; i += 4, pos += 4 * aStepFixed)
+		{
+			int32x4_t p = vshrq_n_s32(vpos, FIXPOINT_FRAC_BITS);
+			float32x4_t f = vcvtq_f32_s32(vandq_s32(vpos, mask));
+			float32x4_t s1 = resample_gather_neon(aSrc - 1, p);
+			float32x4_t s2 = resample_gather_neon(aSrc, p);
+			float32x4_t d = vmulq_n_f32(vmulq_f32(vsubq_f32(s2, s1), f), 1 / (float)FIXPOINT_FRAC_MUL);
+			vst1q_f32(aDst + i, vaddq_f32(s1, d));
+			vpos = vaddq_s32(vpos, vstep);
+		}
+		resample_linear(aSrc, aSrc1, aDst + i, pos, aDstSampleCount - i, aStepFixed);
+	}
+
+	static inline float32x4_t catmullrom_neon(float32x4_t t, float32x4_t p0, float32x4_t p1, float32x4_t p2, float32x4_t p3)
+	{
+		float32x4_t a = vmulq_n_f32(p1, 2);
+		float32x4_t b = vmulq_f32(vsubq_f32(p2, p0), t);
+		float32x4_t c = vsubq_f32(vaddq_f32(vsubq_f32(vmulq_n_f32(p0, 2), vmulq_n_f32(p1, 5)), vmulq_n_f32(p2, 4)), p3);
+		c = vmulq_f32(vmulq_f32(c, t), t);
+		float32x4_t d = vaddq_f32(vsubq_f32(vsubq_f32(vmulq_n_f32(p1, 3), p0), vmulq_n_f32(p2, 3)), p3);
+		d = vmulq_f32(vmulq_f32(vmulq_f32(d, t), t), t);
+		return vmulq_n_f32(vaddq_f32(vaddq_f32(vaddq_f32(a, b), c), d), 0.5f);
+	}
+
+	static void resample_catmullrom_neon(float *aSrc, float *aSrc1, float *aDst, int aSrcOffset, int aDstSampleCount, int aStepFixed)
+	{
+		int i = resample_history_count(aSrcOffset, aDstSampleCount, aStepFixed, 3);
+		resample_catmullrom(aSrc, aSrc1, aDst, aSrcOffset, i, aStepFixed);
+		int pos = aSrcOffset + i * aStepFixed;
+		int32x4_t vpos = resample_positions_neon(pos, aStepFixed);
+		const int32x4_t vstep = vdupq_n_s32(4 * aStepFixed);
+		const int32x4_t mask = vdupq_n_s32(FIXPOINT_FRAC_MASK);
+		for (; i + 4 <= aDstSampleCount; i += 4, pos += 4 * aStepFixed)
+		{
+			int32x4_t p = vshrq_n_s32(vpos, FIXPOINT_FRAC_BITS);
+			float32x4_t t = vmulq_n_f32(vcvtq_f32_s32(vandq_s32(vpos, mask)), 1 / (float)FIXPOINT_FRAC_MUL);
+			float32x4_t s3 = resample_gather_neon(aSrc - 3, p);
+			float32x4_t s2 = resample_gather_neon(aSrc - 2, p);
+			float32x4_t s1 = resample_gather_neon(aSrc - 1, p);
+			float32x4_t s0 = resample_gather_neon(aSrc, p);
+			vst1q_f32(aDst + i, catmullrom_neon(t, s3, s2, s1, s0));
+			vpos = vaddq_s32(vpos, vstep);
+		}
+		resample_catmullrom(aSrc, aSrc1, aDst + i, pos, aDstSampleCount - i, aStepFixed);
+	}
+
+#endif
+
+	// Resamplers picked once for the running CPU
+	struct ResampleKernels
+	{
+		resampleFunction mPoint;
+		resampleFunction mLinear;
+		resampleFunction mCatmullrom;
+	};
+
+	static ResampleKernels pickResampleKernels()
+	{
+		ResampleKernels kernels = { resample_point, resample_linear, resample_catmullrom };
+#if defined(SOLOUD_SSE_INTRINSICS)
+		if (cpuHasAvx2())
+		{
+			kernels.mPoint = resample_point_avx2;
+			kernels.mLinear = resample_linear_avx2;
+			kernels.mCatmullrom = resample_catmullrom_avx2;
+		}
+		else
+		{
+			kernels.mPoint = resample_point_sse;
+			kernels.mLinear = resample_linear_sse;
+			kernels.mCatmullrom = resample_catmullrom_sse;
+		}
+#elif defined(SOLOUD_NEON_INTRINSICS)
+		kernels.mPoint = resample_point_neon;
+		kernels.mLinear = resample_linear_neon;
+		kernels.mCatmullrom = resample_catmullrom_neon;
+#endif
+		return kernels;
+	}
+
+	static const ResampleKernels &getResampleKernels()
+	{
+		static const ResampleKernels kernels = pickResampleKernels();
+		return kernels;
+	}
+}
+
+#endif // SOLOUD_RESAMPLE_H
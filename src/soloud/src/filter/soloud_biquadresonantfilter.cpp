@@ -32,16 +32,25 @@ Phil Burk, Game Programming Gems 3, p. 606
 #include "soloud.h"
 #include "soloud_biquadresonantfilter.h"
 
+// Samples between two coefficient updates while the frequency or the
+// resonance ramp to new values. Must be even.
+#define BQR_RAMP_SAMPLES 16
+
 namespace SoLoud
 {
 	void BiquadResonantFilterInstance::calcBQRParams()
+	{
+		calcBQRParams(mParam[FREQUENCY], mParam[RESONANCE]);
+	}
+
+	void BiquadResonantFilterInstance::calcBQRParams(float aFrequency, float aResonance)
 	{
 		mDirty = 0;
 
-		float omega = (float)((2.0f * M_PI * mParam[FREQUENCY]) / mSamplerate);
+		float omega = (float)((2.0f * M_PI * aFrequency) / mSamplerate);
 		float sin_omega = (float)sin(omega);
 		float cos_omega = (float)cos(omega);
-		float alpha = sin_omega / (2.0f * mParam[RESONANCE]);
+		float alpha = sin_omega / (2.0f * aResonance);
 		float scalar = 1.0f / (1.0f + alpha);
 
 		switch ((int)(mParam[TYPE]))
@@ -111,33 +120,54 @@ namespace SoLoud
 			mParamChanged = 0;			
 		}		
 		float x;
-		unsigned int i;
-		int c = 0;
+		unsigned int c = 0;
 
 		BQRStateData &s = mState[aChannel];
 
 		// make sure we access pairs of samples (one sample may be skipped)
 		aSamples = aSamples & ~1; 
 
-		for (i = 0; i < aSamples; i +=2, c++)
+		// The parameters set since the previous block ramp along this one
+		// instead of stepping, which would click.
+		const bool ramp = mParamFrom[FREQUENCY] != mParam[FREQUENCY] || mParamFrom[RESONANCE] != mParam[RESONANCE];
+		const float wetStep = osamples > 0 ? (mParam[WET] - mParamFrom[WET]) / osamples : 0;
+		float wet = mParamFrom[WET];
+
+		while (c < aSamples)
 		{
-			// Generate outputs by filtering inputs.
-			x = aBuffer[c];
-			s.mY2 = (mA0 * x) + (mA1 * s.mX1) + (mA2 * s.mX2) - (mB1 * s.mY1) - (mB2 * s.mY2);
-			aBuffer[c] += (s.mY2 - aBuffer[c]) * mParam[WET];
-
-			c++;
-
-			// Permute filter operations to reduce data movement.
-			// Just substitute variables instead of doing mX1=x, etc.
-			s.mX2 = aBuffer[c];
-			s.mY1 = (mA0 * s.mX2) + (mA1 * x) + (mA2 * s.mX1) - (mB1 * s.mY2) - (mB2 * s.mY1);
-			aBuffer[c] += (s.mY1 - aBuffer[c]) * mParam[WET];
-
-			// Only move a little data.
-			s.mX1 = s.mX2;
-			s.mX2 = x;
+			unsigned int end = aSamples;
+			if (ramp)
+			{
+				end = c + BQR_RAMP_SAMPLES < aSamples ? c + BQR_RAMP_SAMPLES : aSamples;
+				const float fraction = (float)end / osamples;
+				calcBQRParams(getParamAt(FREQUENCY, fraction), getParamAt(RESONANCE, fraction));
+			}
+
+			for (; c < end; c++)
+			{
+				// Generate outputs by filtering inputs.
+				x = aBuffer[c];
+				s.mY2 = (mA0 * x) + (mA1 * s.mX1) + (mA2 * s.mX2) - (mB1 * s.mY1) - (mB2 * s.mY2);
+				wet += wetStep;
+				aBuffer[c] += (s.mY2 - aBuffer[c]) * wet;
+
+				c++;
+
+				// Permute filter operations to reduce data movement.
+				// Just substitute variables instead of doing mX1=x, etc.
+				s.mX2 = aBuffer[c];
+				s.mY1 = (mA0 * s.mX2) + (mA1 * x) + (mA2 * s.mX1) - (mB1 * s.mY2) - (mB2 * s.mY1);
+				wet += wetStep;
+				aBuffer[c] += (s.mY1 - aBuffer[c]) * wet;
+
+				// Only move a little data.
+				s.mX1 = s.mX2;
+				s.mX2 = x;
+			}
 		}
+		// End on the coefficients of the current values, even with an odd block.
+		if (ramp)
+			calcBQRParams();
 		// If we skipped a sample earlier, patch it by just copying the previous.
 		if (osamples != aSamples)
 			aBuffer[c] = aBuffer[c - 1];
@@ -59,7 +59,14 @@ namespace SoLoud
 	void EqFilterInstance::fftFilterChannel(float *aFFTBuffer, unsigned int aSamples, float /*aSamplerate*/, time /*aTime*/, unsigned int /*aChannel*/, unsigned int /*aChannels*/)
 	{
 		comp2MagPhase(aFFTBuffer, aSamples / 2);
-		unsigned int p;		
+
+		// The band volumes ramp from their values at the previous block, a
+		// step per frame.
+		float band[8];
+		unsigned int p;
+		for (p = 0; p < 8; p++)
+			band[p] = getParamAt(BAND1 + p, mBlockPosition);
+
 		for (p = 0; p < aSamples / 2; p++)
 		{
 			int i = (int)floor(sqrt(p / (float)(aSamples / 2)) * (aSamples / 2));
@@ -71,7 +78,7 @@ namespace SoLoud
 			if (p0 < 0) p0 = 0;
 			if (p3 > 7) p3 = 7;
 			float v = (float)(i % (aSamples / 16)) / (float)(aSamples / 16);
-			aFFTBuffer[p * 2] *= catmullrom(v, mParam[p0 + 1], mParam[p1 + 1], mParam[p2 + 1], mParam[p3 + 1]);
+			aFFTBuffer[p * 2] *= catmullrom(v, band[p0], band[p1], band[p2], band[p3]);
 		}
 		memset(aFFTBuffer + aSamples, 0, sizeof(float) * aSamples);
 		magPhase2Comp(aFFTBuffer, aSamples / 2);
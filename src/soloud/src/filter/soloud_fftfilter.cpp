@@ -56,6 +56,7 @@ namespace SoLoud
 		mLastPhase = 0;
 		mSumPhase = 0;
 		mParent = 0;
+		mBlockPosition = 1;
 		int i;
 		for (i = 0; i < MAX_CHANNELS; i++)
 		{
@@ -128,6 +129,7 @@ namespace SoLoud
 				FFT::fft(mTemp, STFT_WINDOW_SIZE);
 
 				// do magic
+				mBlockPosition = (float)(ofs + samples) / aSamples;
 				fftFilterChannel(mTemp, STFT_WINDOW_HALF, aSamplerate, aTime, aChannel, aChannels);
 
 				FFT::ifft(mTemp, STFT_WINDOW_SIZE);
@@ -143,7 +145,9 @@ namespace SoLoud
 			
 			for (i = 0; i < samples; i++)
 			{
-				aBuffer[ofs + i] += (mMixBuffer[chofs + (readofs & (STFT_WINDOW_TWICE - 1))] - aBuffer[ofs + i]) * mParam[0];
+				// The wet level ramps from its value at the previous block.
+				float wet = getParamAt(0, (float)(ofs + i + 1) / aSamples);
+				aBuffer[ofs + i] += (mMixBuffer[chofs + (readofs & (STFT_WINDOW_TWICE - 1))] - aBuffer[ofs + i]) * wet;
 				readofs++;
 			}
 			
@@ -33,6 +33,8 @@ BasicwaveInstance::BasicwaveInstance(Basicwave *aParent)
     mT = 0;
     mPhase = 0;
     mCurrentFrequency = mParent->mFreq;
+    // Only reads the parent's parameters.
+    mFlags |= CONCURRENT_MIX;
 }
 
 unsigned int BasicwaveInstance::getAudio(float *aBuffer, unsigned int aSamplesToRead, unsigned int aBufferSize)
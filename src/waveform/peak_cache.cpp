@@ -0,0 +1,291 @@
+#include "peak_cache.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace Waveform
+{
+    namespace
+    {
+        inline int16_t toInt16(float v)
+        {
+            v = std::min(1.f, std::max(-1.f, v));
+            return (int16_t)lrintf(v * 32767.f);
+        }
+    }
+
+    PeakCache::PeakCache() : mFile(NULL)
+    {
+        memset(&mHeader, 0, sizeof(mHeader));
+    }
+
+    PeakCache::~PeakCache()
+    {
+        if (mFile != NULL)
+            fclose(mFile);
+    }
+
+    std::string PeakCache::pathFor(const char *cacheDir, uint64_t contentHash)
+    {
+        char name[32];
+        snprintf(name, sizeof(name), "%016llx.peaks", (unsigned long long)contentHash);
+        std::string path = cacheDir;
+        if (!path.empty() && path.back() != '/' && path.back() != '\\')
+            path += '/';
+        return path + name;
+    }
+
+    bool PeakCache::open(const std::string &path, uint64_t contentHash)
+    {
+        FILE *file = fopen(path.c_str(), "rb");
+        if (file == NULL)
+            return false;
+
+        PeakCacheHeader header;
+        bool valid = fread(&header, sizeof(header), 1, file) == 1 &&
+                     memcmp(header.magic, "SLPC", 4) == 0 &&
+                     header.version == VERSION &&
+                     header.contentHash == contentHash &&
+                     header.baseBlockFrames == BASE_BLOCK_FRAMES &&
+                     header.sampleRate != 0 &&
+                     header.levelCount != 0 && header.levelCount <= 64;
+        std::vector<PeakCacheLevel> levels;
+        if (valid)
+        {
+            levels.resize(header.levelCount);
+            valid = fread(levels.data(), sizeof(PeakCacheLevel), levels.size(), file) == levels.size();
+        }
+        if (valid)
+        {
+            // Make sure the file has not been truncated.
+            const PeakCacheLevel &last = levels.back();
+            valid = fseek(file, (long)(last.offset + last.blockCount * sizeof(PeakCacheEntry)) - 1, SEEK_SET) == 0 &&
+                    fgetc(file) != EOF;
+        }
+        if (!valid)
+        {
+            fclose(file);
+            return false;
+        }
+
+        if (mFile != NULL)
+            fclose(mFile);
+        mFile = file;
+        mHeader = header;
+        mLevels.swap(levels);
+        mEntries.clear();
+        return true;
+    }
+
+    void PeakCache::beginBuild(uint64_t contentHash, uint32_t sampleRate, uint32_t channels)
+    {
+        if (mFile != NULL)
+            fclose(mFile);
+        mFile = NULL;
+        memset(&mHeader, 0, sizeof(mHeader));
+        memcpy(mHeader.magic, "SLPC", 4);
+        mHeader.version = VERSION;
+        mHeader.contentHash = contentHash;
+        mHeader.sampleRate = sampleRate;
+        mHeader.channels = channels;
+        mHeader.baseBlockFrames = BASE_BLOCK_FRAMES;
+        mLevels.clear();
+        mEntries.clear();
+        mMeanSquares.clear();
+        mBlockMin = 0.f;
+        mBlockMax = 0.f;
+        mBlockSquares = 0.0;
+        mBlockFrames = 0;
+    }
+
+    void PeakCache::addFrames(const float *frames, uint64_t frameCount)
+    {
+        const uint32_t channels = mHeader.channels;
+        while (frameCount > 0)
+        {
+            uint64_t count = std::min<uint64_t>(frameCount, BASE_BLOCK_FRAMES - mBlockFrames);
+            if (mBlockFrames == 0)
+                mBlockMin = mBlockMax = frames[0];
+            for (uint64_t i = 0; i < count * channels; i++)
+            {
+                float v = frames[i];
+                mBlockMin = std::min(mBlockMin, v);
+                mBlockMax = std::max(mBlockMax, v);
+                mBlockSquares += v * v;
+            }
+            frames += count * channels;
+            frameCount -= count;
+            mBlockFrames += count;
+            mHeader.frameCount += count;
+
+            if (mBlockFrames == BASE_BLOCK_FRAMES)
+                closeBlock();
+        }
+    }
+
+    void PeakCache::closeBlock()
+    {
+        double meanSquare = mBlockSquares / (mBlockFrames * mHeader.channels);
+        mEntries.push_back({toInt16(mBlockMin), toInt16(mBlockMax),
+                            (uint16_t)lrint(std::min(1.0, sqrt(meanSquare)) * 65535.0)});
+        mMeanSquares.push_back(meanSquare);
+        mBlockSquares = 0.0;
+        mBlockFrames = 0;
+    }
+
+    void PeakCache::finishBuild()
+    {
+        if (mBlockFrames > 0)
+            closeBlock();
+        if (mEntries.empty())
+            return;
+
+        // Reduce each level by pairs of blocks down to a single one.
+        mLevels.push_back({0, mEntries.size()});
+        while (mLevels.back().blockCount > 1)
+        {
+            const uint32_t level = (uint32_t)mLevels.size() - 1;
+            const uint64_t first = mLevels.back().offset;
+            const uint64_t count = mLevels.back().blockCount;
+            const uint64_t blockFrames = (uint64_t)BASE_BLOCK_FRAMES << level;
+            for (uint64_t i = 0; i < count; i += 2)
+            {
+                PeakCacheEntry entry = mEntries[first + i];
+                double squares = mMeanSquares[first + i] * blockFrames;
+                uint64_t frames = blockFrames;
+                if (i + 1 < count)
+                {
+                    const PeakCacheEntry &next = mEntries[first + i + 1];
+                    uint64_t nextFrames = std::min(blockFrames, mHeader.frameCount - (i + 1) * blockFrames);
+                    entry.min = std::min(entry.min, next.min);
+                    entry.max = std::max(entry.max, next.max);
+                    squares += mMeanSquares[first + i + 1] * nextFrames;
+                    frames += nextFrames;
+                }
+                else
+                    frames = mHeader.frameCount - i * blockFrames;
+                double meanSquare = squares / frames;
+                entry.rms = (uint16_t)lrint(std::min(1.0, sqrt(meanSquare)) * 65535.0);
+                mEntries.push_back(entry);
+                mMeanSquares.push_back(meanSquare);
+            }
+            mLevels.push_back({first + count, (count + 1) / 2});
+        }
+        mMeanSquares.clear();
+        mMeanSquares.shrink_to_fit();
+
+        // Turn the entry indices into file offsets.
+        mHeader.levelCount = (uint32_t)mLevels.size();
+        const uint64_t entriesOffset = sizeof(PeakCacheHeader) + mLevels.size() * sizeof(PeakCacheLevel);
+        for (PeakCacheLevel &level : mLevels)
+            level.offset = entriesOffset + level.offset * sizeof(PeakCacheEntry);
+    }
+
+    bool PeakCache::save(const std::string &path) const
+    {
+        if (mLevels.empty())
+            return false;
+        // Write to a temporary file first, so that a reader never sees a
+        // partially written cache.
+        std::string tempPath = path + ".tmp";
+        FILE *file = fopen(tempPath.c_str(), "wb");
+        if (file == NULL)
+            return false;
+        bool ok = fwrite(&mHeader, sizeof(mHeader), 1, file) == 1 &&
+                  fwrite(mLevels.data(), sizeof(PeakCacheLevel), mLevels.size(), file) == mLevels.size() &&
+                  fwrite(mEntries.data(), sizeof(PeakCacheEntry), mEntries.size(), file) == mEntries.size();
+        ok = fclose(file) == 0 && ok;
+        if (ok)
+        {
+            // rename() doesn't replace an existing file on Windows.
+            remove(path.c_str());
+            ok = rename(tempPath.c_str(), path.c_str()) == 0;
+        }
+        if (!ok)
+            remove(tempPath.c_str());
+        return ok;
+    }
+
+    bool PeakCache::readEntries(uint32_t level, uint64_t first, uint64_t count, PeakCacheEntry *entries)
+    {
+        const PeakCacheLevel &l = mLevels[level];
+        if (first + count > l.blockCount)
+            return false;
+        uint64_t offset = l.offset + first * sizeof(PeakCacheEntry);
+        if (mFile == NULL)
+        {
+            const uint64_t entriesOffset = sizeof(PeakCacheHeader) + mLevels.size() * sizeof(PeakCacheLevel);
+            memcpy(entries, &mEntries[(offset - entriesOffset) / sizeof(PeakCacheEntry)], count * sizeof(PeakCacheEntry));
+            return true;
+        }
+        return fseek(mFile, (long)offset, SEEK_SET) == 0 &&
+               fread(entries, sizeof(PeakCacheEntry), count, mFile) == count;
+    }
+
+    bool PeakCache::readSamples(
+        uint64_t startFrame,
+        uint64_t stepFrames,
+        unsigned long numSamplesNeeded,
+        bool average,
+        float *pSamples)
+    {
+        if (mLevels.empty() || stepFrames < BASE_BLOCK_FRAMES)
+            return false;
+
+        // Use the coarsest level that still has a few blocks per sample.
+        uint32_t level = 0;
+        while (level + 1 < mLevels.size() && ((uint64_t)BASE_BLOCK_FRAMES << (level + 1)) * 4 <= stepFrames)
+            level++;
+        const uint64_t blockFrames = (uint64_t)BASE_BLOCK_FRAMES << level;
+        const uint64_t frameCount = mHeader.frameCount;
+
+        memset(pSamples, 0, numSamplesNeeded * sizeof(float));
+        if (startFrame >= frameCount)
+            return true;
+        uint64_t endFrame = std::min(frameCount, startFrame + stepFrames * numSamplesNeeded);
+        uint64_t firstBlock = startFrame / blockFrames;
+        uint64_t lastBlock = (endFrame - 1) / blockFrames;
+        std::vector<PeakCacheEntry> entries(lastBlock - firstBlock + 1);
+        if (!readEntries(level, firstBlock, entries.size(), entries.data()))
+            return false;
+
+        for (unsigned long id = 0; id < numSamplesNeeded; id++)
+        {
+            uint64_t from = startFrame + id * stepFrames;
+            if (from >= frameCount)
+                break;
+            uint64_t to = std::min(frameCount, from + stepFrames);
+            // All the blocks touching the range.
+            uint64_t b0 = from / blockFrames - firstBlock;
+            uint64_t b1 = (to - 1) / blockFrames - firstBlock;
+            if (average)
+            {
+                double squares = 0.0;
+                uint64_t frames = 0;
+                for (uint64_t b = b0; b <= b1; b++)
+                {
+                    // Weight the blocks by how much of them is in the range.
+                    uint64_t blockStart = (firstBlock + b) * blockFrames;
+                    uint64_t n = std::min(to, blockStart + blockFrames) - std::max(from, blockStart);
+                    double rms = entries[b].rms / 65535.0;
+                    squares += rms * rms * n;
+                    frames += n;
+                }
+                pSamples[id] = (float)sqrt(squares / frames);
+            }
+            else
+            {
+                int16_t min = entries[b0].min;
+                int16_t max = entries[b0].max;
+                for (uint64_t b = b0 + 1; b <= b1; b++)
+                {
+                    min = std::min(min, entries[b].min);
+                    max = std::max(max, entries[b].max);
+                }
+                pSamples[id] = (-min > max ? min : max) / 32767.f;
+            }
+        }
+        return true;
+    }
+}
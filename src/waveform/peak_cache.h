@@ -0,0 +1,116 @@
+#ifndef PEAK_CACHE_H
+#define PEAK_CACHE_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace Waveform
+{
+    /// Multi-resolution peak cache of an audio file, stored on disk so that
+    /// waveforms at any zoom level can be read without decoding the audio.
+    ///
+    /// The file is named after the hash of the audio content and laid out as
+    /// plain little-endian structures, so a level can be read (or mapped) with
+    /// a single offset:
+    ///
+    ///   PeakCacheHeader
+    ///   PeakCacheLevel[levelCount]
+    ///   PeakCacheEntry[] of level 0, then level 1, ...
+    ///
+    /// Each entry of level 0 covers [baseBlockFrames] frames, and each level
+    /// halves the number of entries of the previous one until a single entry
+    /// covers the whole audio.
+    class PeakCache
+    {
+    public:
+        static const uint32_t VERSION = 1;
+        static const uint32_t BASE_BLOCK_FRAMES = 256;
+
+        struct PeakCacheHeader
+        {
+            char magic[4];
+            uint32_t version;
+            uint64_t contentHash;
+            uint64_t frameCount;
+            uint32_t sampleRate;
+            uint32_t channels;
+            uint32_t baseBlockFrames;
+            uint32_t levelCount;
+        };
+
+        struct PeakCacheLevel
+        {
+            /// Offset in bytes of the first entry from the start of the file.
+            uint64_t offset;
+            uint64_t blockCount;
+        };
+
+        /// Minimum, maximum and RMS of all the channels in a block, as
+        /// normalized 16 bit values.
+        struct PeakCacheEntry
+        {
+            int16_t min;
+            int16_t max;
+            uint16_t rms;
+        };
+
+        PeakCache();
+        ~PeakCache();
+
+        /// Path of the cache file of the audio with [contentHash] in [cacheDir].
+        static std::string pathFor(const char *cacheDir, uint64_t contentHash);
+
+        /// Open the cache file at [path] and check it belongs to [contentHash].
+        /// Only the header and the level table are read.
+        bool open(const std::string &path, uint64_t contentHash);
+
+        /// Start building a cache. Add the decoded frames with [addFrames] and
+        /// complete it with [finishBuild].
+        void beginBuild(uint64_t contentHash, uint32_t sampleRate, uint32_t channels);
+        void addFrames(const float *frames, uint64_t frameCount);
+        void finishBuild();
+
+        /// Write the cache built in memory to [path].
+        bool save(const std::string &path) const;
+
+        uint32_t getSampleRate() const { return mHeader.sampleRate; }
+        uint64_t getFrameCount() const { return mHeader.frameCount; }
+
+        /// Fill [pSamples] with [numSamplesNeeded] values, one every
+        /// [stepFrames] frames from [startFrame]. With [average] the values
+        /// are the RMS of their range, otherwise the sample of the range with
+        /// the largest magnitude.
+        /// Returns false if the cache resolution is too low for [stepFrames].
+        bool readSamples(
+            uint64_t startFrame,
+            uint64_t stepFrames,
+            unsigned long numSamplesNeeded,
+            bool average,
+            float *pSamples);
+
+    private:
+        /// Add the level 0 block being accumulated to the entries.
+        void closeBlock();
+
+        bool readEntries(uint32_t level, uint64_t first, uint64_t count, PeakCacheEntry *entries);
+
+        PeakCacheHeader mHeader;
+        std::vector<PeakCacheLevel> mLevels;
+
+        /// The opened cache file, or NULL when the cache has been built in
+        /// memory and the entries are in [mEntries].
+        FILE *mFile;
+        std::vector<PeakCacheEntry> mEntries;
+
+        /// Level 0 block being accumulated while building.
+        float mBlockMin;
+        float mBlockMax;
+        double mBlockSquares;
+        uint64_t mBlockFrames;
+        std::vector<double> mMeanSquares;
+    };
+}
+
+#endif // PEAK_CACHE_H
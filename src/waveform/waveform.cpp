@@ -4,58 +4,72 @@
 #endif
 #include "common.h"
 #include "waveform.h"
+#include "peak_cache.h"
+#include "soloud_file.h"
 
+#include <algorithm>
 #include <cstdio>
 #include <cstring>
 #include <cmath>
+#include <thread>
+#include <vector>
 
 namespace Waveform
 {
+#if !defined(NO_OPUS_OGG_LIBS)
+    // Create a static backend vtable to ensure it persists
+    static ma_decoding_backend_vtable* pCustomBackendVTables[] = {
+        ma_decoding_backend_libvorbis
+    };
+#endif
+
+    /// What is needed to open more decoders on the same audio data.
+    struct DecoderSource
+    {
+        const char *filePath;
+        const unsigned char *buffer;
+        unsigned long dataSize;
+        /// NULL to use the decoder defaults.
+        const ma_decoder_config *config;
+    };
+
+    ma_result initDecoder(const DecoderSource &source, const ma_decoder_config *config, ma_decoder *decoder)
+    {
+        if (source.filePath != NULL)
+            return ma_decoder_init_file(source.filePath, config, decoder);
+        return ma_decoder_init_memory(source.buffer, source.dataSize, config, decoder);
+    }
+
+    /// Read [count] samples, one every [stepFrames] frames starting at [firstFrame].
     ReadSamplesErrors readSamplesFromDecoder(
         ma_decoder *decoder,
-        float startTime,
-        float endTime,
-        unsigned long numSamplesNeeded,
+        ma_uint64 firstFrame,
+        ma_uint64 stepFrames,
+        unsigned long count,
         bool average,
         float *pSamples)
     {
-        ma_uint32 sampleRate = decoder->outputSampleRate;
         ma_uint32 channels = decoder->outputChannels;
 
-        // Calculate start and end frames based on startTime and endTime
-        ma_uint64 startFrame = (ma_uint64)(startTime * sampleRate);
-        ma_uint64 endFrame;
-        if (endTime == -1)
-            ma_decoder_get_length_in_pcm_frames(decoder, &endFrame);
-        else
-            endFrame = (ma_uint64)(endTime * sampleRate);
-            
-        ma_uint64 totalFrames = endFrame - startFrame;
-        ma_uint64 stepFrames = totalFrames / numSamplesNeeded;
-
         // Move decoder to start frame
-        ma_result result = ma_decoder_seek_to_pcm_frame(decoder, startFrame);
+        ma_result result = ma_decoder_seek_to_pcm_frame(decoder, firstFrame);
         if (result != MA_SUCCESS)
         {
             printf("Failed to seek to start time.\n");
-            ma_decoder_uninit(decoder);
             return failedToSeekPcm;
         }
 
-        // Allocate temporary memory for all frames between startTime and endTime
+        // Allocate temporary memory for the frames of one sample
         float *tempBuffer = (float *)malloc(stepFrames * channels * sizeof(float));
-        // Read all PCM data between startFrame and endFrame
-        int id = 0;
-        for (int i = 0; i < totalFrames; i += stepFrames, id++)
+        for (unsigned long id = 0; id < count; id++)
         {
             ma_uint64 framesRead;
             result = ma_decoder_read_pcm_frames(decoder, tempBuffer, stepFrames, &framesRead);
             if (result != MA_SUCCESS && result != MA_AT_END)
             {
                 printf("Failed to read PCM frames.\n");
-                ma_decoder_uninit(decoder);
-                if (result != MA_AT_END)
-                    return failedToReadPcmFrames;
+                free(tempBuffer);
+                return failedToReadPcmFrames;
             }
 
             if (framesRead == 0)
@@ -64,7 +78,7 @@ namespace Waveform
             if (average)
             {
                 double sum = 0.0;
-                for (int j = 0; j < framesRead * channels; j++)
+                for (ma_uint64 j = 0; j < framesRead * channels; j++)
                 {
                     // Square the sample value
                     sum += tempBuffer[j] * tempBuffer[j];
@@ -73,12 +87,112 @@ namespace Waveform
                 pSamples[id] = sqrtf(sum / (framesRead * channels));
             }
             else
-                pSamples[id] = tempBuffer[0];
+            {
+                // The sample with the largest magnitude, as read from the
+                // peak cache.
+                float min = tempBuffer[0];
+                float max = tempBuffer[0];
+                for (ma_uint64 j = 1; j < framesRead * channels; j++)
+                {
+                    min = std::min(min, tempBuffer[j]);
+                    max = std::max(max, tempBuffer[j]);
+                }
+                pSamples[id] = -min > max ? min : max;
+            }
         }
         free(tempBuffer);
         return readSamplesNoError;
     }
 
+    /// Split the samples in [threadCount] contiguous chunks. The first one is read
+    /// with [decoder], the others by workers with their own decoder seeking to the
+    /// first frame of their chunk. Every sample is computed from the same frames
+    /// as when reading them all sequentially, so the result doesn't change.
+    ReadSamplesErrors readSamplesConcurrently(
+        const DecoderSource &source,
+        ma_decoder *decoder,
+        ma_uint64 startFrame,
+        ma_uint64 stepFrames,
+        unsigned long numSamplesNeeded,
+        bool average,
+        float *pSamples,
+        unsigned int threadCount)
+    {
+        std::vector<ReadSamplesErrors> errors(threadCount, readSamplesNoError);
+        std::vector<std::thread> workers;
+        workers.reserve(threadCount - 1);
+        for (unsigned int i = 1; i < threadCount; i++)
+        {
+            unsigned long first = numSamplesNeeded * i / threadCount;
+            unsigned long count = numSamplesNeeded * (i + 1) / threadCount - first;
+            workers.emplace_back([&, i, first, count]()
+            {
+                ma_decoder chunkDecoder;
+                if (initDecoder(source, source.config, &chunkDecoder) != MA_SUCCESS)
+                {
+                    errors[i] = noBackend;
+                    return;
+                }
+                errors[i] = readSamplesFromDecoder(
+                    &chunkDecoder, startFrame + first * stepFrames, stepFrames,
+                    count, average, pSamples + first);
+                ma_decoder_uninit(&chunkDecoder);
+            });
+        }
+
+        errors[0] = readSamplesFromDecoder(
+            decoder, startFrame, stepFrames, numSamplesNeeded / threadCount, average, pSamples);
+
+        for (std::thread &worker : workers)
+            worker.join();
+        for (ReadSamplesErrors error : errors)
+            if (error != readSamplesNoError)
+                return error;
+        return readSamplesNoError;
+    }
+
+    /// Answer a query from the peak [cache], with the same time to frame
+    /// conversion as when decoding.
+    /// Returns false when the cache resolution is too low for the query.
+    bool readSamplesFromCache(
+        PeakCache &cache,
+        float startTime,
+        float endTime,
+        unsigned long numSamplesNeeded,
+        bool average,
+        float *pSamples)
+    {
+        ma_uint64 startFrame = (ma_uint64)(startTime * cache.getSampleRate());
+        ma_uint64 endFrame = endTime == -1 ? cache.getFrameCount() : (ma_uint64)(endTime * cache.getSampleRate());
+        ma_uint64 totalFrames = endFrame > startFrame ? endFrame - startFrame : 0;
+        ma_uint64 stepFrames = totalFrames / numSamplesNeeded;
+        if (stepFrames == 0)
+            return true;
+        return cache.readSamples(startFrame, stepFrames, numSamplesNeeded, average, pSamples);
+    }
+
+    /// Decode all the audio of [decoder] into [cache].
+    bool buildPeakCache(ma_decoder *decoder, uint64_t contentHash, PeakCache &cache)
+    {
+        if (ma_decoder_seek_to_pcm_frame(decoder, 0) != MA_SUCCESS)
+            return false;
+        const ma_uint64 chunkFrames = 4096;
+        std::vector<float> chunk(chunkFrames * decoder->outputChannels);
+        cache.beginBuild(contentHash, decoder->outputSampleRate, decoder->outputChannels);
+        for (;;)
+        {
+            ma_uint64 framesRead = 0;
+            ma_result result = ma_decoder_read_pcm_frames(decoder, chunk.data(), chunkFrames, &framesRead);
+            cache.addFrames(chunk.data(), framesRead);
+            if (result == MA_AT_END || framesRead == 0)
+                break;
+            if (result != MA_SUCCESS)
+                return false;
+        }
+        cache.finishBuild();
+        return cache.getFrameCount() > 0;
+    }
+
     ReadSamplesErrors readSamples(
         const char *filePath,
         const unsigned char *buffer,
@@ -87,39 +201,76 @@ namespace Waveform
         float endTime,
         unsigned long numSamplesNeeded,
         bool average,
-        float *pSamples)
+        float *pSamples,
+        unsigned int threadCount,
+        const char *cacheDir,
+        bool buildCache)
     {
         // Clear memory
         memset(pSamples, 0, numSamplesNeeded * sizeof(float));
+        if (numSamplesNeeded == 0)
+            return readSamplesNoError;
+
+        // Look for a peak cache of this audio content
+        PeakCache cache;
+        uint64_t contentHash = 0;
+        std::string cachePath;
+        if (cacheDir != NULL)
+        {
+            bool hashed = true;
+            if (filePath != NULL)
+                hashed = hashFileContent(filePath, &contentHash);
+            else
+                contentHash = hashContent(buffer, dataSize);
+            if (hashed)
+            {
+                cachePath = PeakCache::pathFor(cacheDir, contentHash);
+                if (cache.open(cachePath, contentHash))
+                {
+                    buildCache = false;
+                    if (readSamplesFromCache(cache, startTime, endTime, numSamplesNeeded, average, pSamples))
+                        return readSamplesNoError;
+                }
+            }
+            else
+                buildCache = false;
+        }
+
+        // Decode the mapped file as a buffer: the decoders, one per thread,
+        // then share its pages instead of each reading the file.
+        SoLoud::MappedFile mappedFile;
+        if (filePath != NULL && mappedFile.open(filePath) == SoLoud::SO_NO_ERROR)
+        {
+            buffer = mappedFile.getMemPtr();
+            dataSize = mappedFile.length();
+            filePath = NULL;
+        }
 
         ma_decoder decoder;
         ma_decoder_config decoderConfig = ma_decoder_config_init_default();
         ma_result result;
         bool isOgg = false;
 
-#if !defined(NO_OPUS_OGG_LIBS)
-        // Create a static backend vtable to ensure it persists
-        static ma_decoding_backend_vtable* pCustomBackendVTables[] = {
-            ma_decoding_backend_libvorbis
-        };
-#endif
-
-        // Check if the file is an OGG file by reading the header
+        // Read the header of the file or buffer to check its format
+        unsigned char header[4] = {0, 0, 0, 0};
         if (filePath != NULL)
         {
             FILE *file = fopen(filePath, "rb");
             if (file)
             {
-                unsigned char header[4];
                 fread(header, 1, 4, file);
-                if (header[0] == 'O' && header[1] == 'g' && header[2] == 'g' && header[3] == 'S')
-                    isOgg = true;
                 fclose(file);
             }
         }
-        // Check if buffer is an OGG file
-        else if (buffer[0] == 'O' && buffer[1] == 'g' && buffer[2] == 'g' && buffer[3] == 'S')
+        else if (dataSize >= 4)
+            memcpy(header, buffer, 4);
+
+        // Check if it is an OGG file
+        if (header[0] == 'O' && header[1] == 'g' && header[2] == 'g' && header[3] == 'S')
             isOgg = true;
+        // Check if it is an MP3 file, starting with an ID3 tag or a frame sync
+        bool isMp3 = (header[0] == 'I' && header[1] == 'D' && header[2] == '3') ||
+                     (header[0] == 0xFF && (header[1] & 0xE0) == 0xE0);
 
 #if defined(NO_OPUS_OGG_LIBS)
         if (isOgg)
@@ -137,12 +288,10 @@ namespace Waveform
             decoderConfig.customBackendCount = sizeof(pCustomBackendVTables) / sizeof(pCustomBackendVTables[0]);
         }
 #endif
-        
+
         // Init the decoder with file or memory
-        if (filePath != NULL)
-            result = ma_decoder_init_file(filePath, isOgg ? &decoderConfig : NULL, &decoder);
-        else
-            result = ma_decoder_init_memory(buffer, dataSize, isOgg ? &decoderConfig : NULL, &decoder);
+        DecoderSource source = {filePath, buffer, dataSize, isOgg ? &decoderConfig : NULL};
+        result = initDecoder(source, source.config, &decoder);
 
         if (result != MA_SUCCESS)
         {
@@ -166,17 +315,15 @@ namespace Waveform
         if (format != ma_format_f32)
         {
             ma_decoder_uninit(&decoder);
-            
+
             // Update config with format settings
             decoderConfig.format = ma_format_f32;
             decoderConfig.channels = channels;
             decoderConfig.sampleRate = sampleRate;
 
             // Re-init with updated config
-            if (filePath != NULL)
-                result = ma_decoder_init_file(filePath, &decoderConfig, &decoder);
-            else
-                result = ma_decoder_init_memory(buffer, dataSize, &decoderConfig, &decoder);
+            source.config = &decoderConfig;
+            result = initDecoder(source, source.config, &decoder);
 
             if (result != MA_SUCCESS)
             {
@@ -185,8 +332,62 @@ namespace Waveform
             }
         }
 
-        ReadSamplesErrors ret = readSamplesFromDecoder(&decoder, startTime, endTime, numSamplesNeeded, average, pSamples);
+        if (cacheDir != NULL && buildCache)
+        {
+            if (buildPeakCache(&decoder, contentHash, cache))
+            {
+                if (!cache.save(cachePath))
+                    printf("Failed to write the peak cache %s.\n", cachePath.c_str());
+                if (readSamplesFromCache(cache, startTime, endTime, numSamplesNeeded, average, pSamples))
+                {
+                    ma_decoder_uninit(&decoder);
+                    return readSamplesNoError;
+                }
+            }
+            else
+                printf("Failed to build the peak cache.\n");
+        }
+
+        sampleRate = decoder.outputSampleRate;
+
+        // Calculate start and end frames based on startTime and endTime
+        ma_uint64 startFrame = (ma_uint64)(startTime * sampleRate);
+        ma_uint64 endFrame;
+        if (endTime == -1)
+            ma_decoder_get_length_in_pcm_frames(&decoder, &endFrame);
+        else
+            endFrame = (ma_uint64)(endTime * sampleRate);
+
+        ma_uint64 totalFrames = endFrame > startFrame ? endFrame - startFrame : 0;
+        ma_uint64 stepFrames = totalFrames / numSamplesNeeded;
+        if (stepFrames == 0)
+        {
+            ma_decoder_uninit(&decoder);
+            return readSamplesNoError;
+        }
+
+#if defined(__EMSCRIPTEN__)
+        // No threads on the web
+        threadCount = 1;
+#else
+        if (threadCount == 0)
+            threadCount = std::thread::hardware_concurrency();
+#endif
+        if (threadCount > numSamplesNeeded)
+            threadCount = numSamplesNeeded;
+        // MP3 seeks by decoding everything from the beginning, so a worker would
+        // decode the whole file up to its chunk. Its seek table is not usable
+        // either: it lands a couple of frames away from the requested one when
+        // the bit reservoir is used, which would shift the chunks.
+        if (isMp3)
+            threadCount = 1;
+
+        ReadSamplesErrors ret;
+        if (threadCount > 1)
+            ret = readSamplesConcurrently(source, &decoder, startFrame, stepFrames, numSamplesNeeded, average, pSamples, threadCount);
+        else
+            ret = readSamplesFromDecoder(&decoder, startFrame, stepFrames, numSamplesNeeded, average, pSamples);
         ma_decoder_uninit(&decoder);
         return ret;
     }
-};
\ No newline at end of file
+};
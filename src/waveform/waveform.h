@@ -4,6 +4,18 @@
 #include "../enums.h"
 
 namespace Waveform {
+    /// Read [numSamplesNeeded] samples equally spaced between [startTime] and
+    /// [endTime]. With [threadCount] > 1 the range is split in chunks read
+    /// concurrently by independent decoders, 0 uses all the CPU cores. The
+    /// result is the same regardless of [threadCount]. MP3 is always read by
+    /// a single decoder since it cannot seek without decoding from the start.
+    ///
+    /// When [cacheDir] is not NULL, the query is answered from the peak cache
+    /// of the audio content stored there, if any. With [buildCache] a missing
+    /// cache is built by decoding the whole audio once. Queries with less than
+    /// [PeakCache::BASE_BLOCK_FRAMES] frames per sample are always decoded.
+    /// From the cache, without [average] the values are the peak of their
+    /// range instead of its first sample.
     ReadSamplesErrors readSamples(
         const char *filePath,
         const unsigned char *buffer,
@@ -12,7 +24,10 @@ namespace Waveform {
         float endTime,
         unsigned long numSamplesNeeded,
         bool average,
-        float *pSamples);
+        float *pSamples,
+        unsigned int threadCount = 1,
+        const char *cacheDir = nullptr,
+        bool buildCache = false);
 }
 
 #endif // WAVEFORM_H
\ No newline at end of file
@@ -139,6 +139,7 @@ SOURCES=(
     ../src/soloud/src/audiosource/wav/*.c*
     ../src/common.cpp
     ../src/bindings.cpp
+    ../src/event_queue.cpp
     ../src/player.cpp
     ../src/analyzer.cpp
     ../src/synth/*.cpp